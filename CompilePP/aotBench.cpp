@@ -0,0 +1,256 @@
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include "aotBench.hpp"
+#include "aotCompiler.hpp"
+#include "bytecodeCompiler.hpp"
+#include "vm.hpp"
+#include "irBuilder.hpp"
+#include "irPasses.hpp"
+#include "lexer.hpp"
+#include "astParser.hpp"
+#include "diagnostics.hpp"
+#include "newVector.cpp"
+
+#if defined(__x86_64__) && defined(__linux__)
+#include <sys/wait.h>
+#define AOT_SUPPORTED 1
+#endif
+
+namespace {
+    struct Workload {
+        const char* name;
+        const char* source;
+    };
+
+    const Workload workloads[] = {
+        { "fib",
+            "int fib(int n) {\n"
+            "    if (n < 2) return n;\n"
+            "    return fib(n - 1) + fib(n - 2);\n"
+            "}\n"
+            "int main() {\n"
+            "    print(fib(30));\n"
+            "    return 0;\n"
+            "}\n" },
+        { "loops",
+            "int main() {\n"
+            "    int sum = 0;\n"
+            "    for (int i = 0; i < 3000; i++) {\n"
+            "        int j = 0;\n"
+            "        while (j < 3000) {\n"
+            "            sum = sum + (i ^ j) % 7 - (j >> 3);\n"
+            "            j++;\n"
+            "        }\n"
+            "    }\n"
+            "    print(sum);\n"
+            "    return sum & 127;\n"
+            "}\n" },
+        { "sieve",
+            "int main() {\n"
+            "    int count = 0;\n"
+            "    for (int round = 0; round < 40; round++) {\n"
+            "        int composite[100000];\n"
+            "        count = 0;\n"
+            "        for (int i = 2; i < 100000; i++) {\n"
+            "            if (composite[i] == 0) {\n"
+            "                count++;\n"
+            "                for (int j = i + i; j < 100000; j += i) {\n"
+            "                    composite[j] = 1;\n"
+            "                }\n"
+            "            }\n"
+            "        }\n"
+            "    }\n"
+            "    print(count);\n"
+            "    return 0;\n"
+            "}\n" },
+        { "float-math",
+            "double integrate(int steps) {\n"
+            "    double sum = 0.0;\n"
+            "    double dx = 1.0 / steps;\n"
+            "    for (int i = 0; i < steps; i++) {\n"
+            "        double x = (i + 0.5) * dx;\n"
+            "        sum += 4.0 / (1.0 + x * x);\n"
+            "    }\n"
+            "    return sum * dx;\n"
+            "}\n"
+            "int main() {\n"
+            "    print(integrate(5000000));\n"
+            "    return 0;\n"
+            "}\n" },
+        { "matrix",
+            "double a[6400];\n"
+            "double b[6400];\n"
+            "double c[6400];\n"
+            "int main() {\n"
+            "    int n = 80;\n"
+            "    for (int i = 0; i < n * n; i++) {\n"
+            "        a[i] = i % 17 - 8;\n"
+            "        b[i] = (i * 7) % 13 - 6;\n"
+            "    }\n"
+            "    for (int round = 0; round < 20; round++) {\n"
+            "        for (int i = 0; i < n; i++) {\n"
+            "            for (int j = 0; j < n; j++) {\n"
+            "                double sum = 0.0;\n"
+            "                for (int k = 0; k < n; k++) {\n"
+            "                    sum += a[i * n + k] * b[k * n + j];\n"
+            "                }\n"
+            "                c[i * n + j] = sum + round;\n"
+            "            }\n"
+            "        }\n"
+            "    }\n"
+            "    print(c[0], c[n * n - 1], c[1234]);\n"
+            "    return 0;\n"
+            "}\n" },
+        { "many-args",
+            "double mix(int a, double b, int c, double d, int e, double f, int g, double h, int i,\n"
+            "           double j, int k, double l, int m, double n, int o, double p, int q, double r) {\n"
+            "    return a * b - c * d + e * f - g * h + i * j - k * l + m * n - o * p + q * r;\n"
+            "}\n"
+            "int main() {\n"
+            "    double total = 0.0;\n"
+            "    for (int i = 0; i < 500000; i++) {\n"
+            "        total += mix(i, 0.5, i + 1, 1.5, i + 2, 2.5, i + 3, 3.5, i + 4,\n"
+            "                     4.5, i + 5, 5.5, i + 6, 6.5, i + 7, 7.5, i + 8, 8.5);\n"
+            "    }\n"
+            "    print(total);\n"
+            "    return 0;\n"
+            "}\n" },
+    };
+
+#ifdef AOT_SUPPORTED
+    struct NativeRun {
+        bool ok = false;
+        double secondsPerRun = 0.0;
+        size_t instructions = 0;
+        size_t spilled = 0;
+        std::string problem;
+    };
+
+    // 编译、链接并执行iterations次，检查每次的输出和退出状态
+    NativeRun runNative(const IrModule& module, RegisterStrategy strategy, const std::string& stem, size_t iterations,
+        const std::string& expectedOutput, int32_t expectedResult) {
+        NativeRun run;
+        std::string assemblyPath = stem + ".s";
+        std::string executablePath = stem + ".out";
+        std::string outputPath = stem + ".txt";
+        AotCompiler compiler(strategy);
+        {
+            std::ofstream file(assemblyPath);
+            compiler.compile(module, file);
+        }
+        run.instructions = compiler.statistics().instructions;
+        run.spilled = compiler.statistics().spilled;
+        try {
+            linkExecutable(assemblyPath, executablePath);
+        }
+        catch (const RuntimeError& error) {
+            run.problem = error.what();
+            return run;
+        }
+        std::string command = "\"" + executablePath + "\" > \"" + outputPath + "\"";
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; i++) {
+            int status = std::system(command.c_str());
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != (static_cast<uint32_t>(expectedResult) & 0xff)) {
+                run.problem = "unexpected exit status " + std::to_string(WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+                return run;
+            }
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        run.secondsPerRun = elapsed.count() / static_cast<double>(iterations);
+        std::ifstream output(outputPath);
+        std::stringstream contents;
+        contents << output.rdbuf();
+        if (contents.str() != expectedOutput) {
+            run.problem = "output differs from the vm";
+            return run;
+        }
+        std::filesystem::remove(assemblyPath);
+        std::filesystem::remove(executablePath);
+        std::filesystem::remove(outputPath);
+        run.ok = true;
+        return run;
+    }
+#endif
+}
+
+void runAotBenchmark(size_t iterations, std::ostream& os) {
+#ifndef AOT_SUPPORTED
+    (void)iterations;
+    os << "Native code benchmark needs Linux on x86-64\n";
+#else
+    if (iterations == 0) {
+        iterations = 1;
+    }
+    os << "Native code benchmark: " << iterations << " iteration(s)\n";
+    os << std::left << std::setw(14) << "workload" << std::right
+        << std::setw(14) << "vm ms/run" << std::setw(14) << "stack ms/run" << std::setw(12) << "insns"
+        << std::setw(14) << "linear ms/run" << std::setw(12) << "insns" << std::setw(10) << "spilled"
+        << std::setw(10) << "speedup" << "\n";
+    std::string directory = std::filesystem::temp_directory_path().string();
+    for (const Workload& workload : workloads) {
+        DiagnosticEngine diagnostics;
+        std::string source = workload.source;
+        Lexer lexer(source, diagnostics);
+        newVector<Token> tokens = lexer.lex();
+        Parser parser(tokens, diagnostics);
+        ASTNode* ast = parser.buildAST();
+        if (diagnostics.hasErrors() || ast == nullptr) {
+            os << std::left << std::setw(14) << workload.name << " failed to parse\n";
+            diagnostics.render(os, DiagnosticFormat::Text);
+            delete ast;
+            continue;
+        }
+
+        try {
+            // 虚拟机的输出和返回值是基准
+            BytecodeCompiler bytecodeCompiler;
+            BytecodeProgram program = bytecodeCompiler.compile(ast);
+            std::ostringstream expected;
+            VirtualMachine vm(program, expected);
+            int32_t result = vm.run();
+            std::ostringstream discarded;
+            VirtualMachine timed(program, discarded);
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < iterations; i++) {
+                timed.run();
+            }
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            double vmSecondsPerRun = elapsed.count() / static_cast<double>(iterations);
+
+            IrBuilder builder;
+            IrModule module = builder.build(ast);
+            IrPassManager passes;
+            passes.addDefaultPipeline();
+            passes.run(module);
+
+            std::string stem = directory + "/cpp_aot_" + workload.name;
+            NativeRun stack = runNative(module, RegisterStrategy::Stack, stem + "_stack", iterations, expected.str(), result);
+            NativeRun linear = runNative(module, RegisterStrategy::LinearScan, stem + "_linear", iterations, expected.str(), result);
+
+            os << std::left << std::setw(14) << workload.name << std::right << std::fixed
+                << std::setw(14) << std::setprecision(3) << vmSecondsPerRun * 1000.0
+                << std::setw(14) << stack.secondsPerRun * 1000.0 << std::setw(12) << stack.instructions
+                << std::setw(14) << linear.secondsPerRun * 1000.0 << std::setw(12) << linear.instructions
+                << std::setw(10) << linear.spilled
+                << std::setw(9) << std::setprecision(1) << (linear.secondsPerRun > 0 ? stack.secondsPerRun / linear.secondsPerRun : 0.0) << "x";
+            if (!stack.ok) {
+                os << "  (stack: " << stack.problem << ")";
+            }
+            if (!linear.ok) {
+                os << "  (linear: " << linear.problem << ")";
+            }
+            os << "\n";
+        }
+        catch (const RuntimeError& error) {
+            os << std::left << std::setw(14) << workload.name << " runtime error: " << error.what() << "\n";
+        }
+        delete ast;
+    }
+#endif
+}
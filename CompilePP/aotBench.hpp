@@ -0,0 +1,8 @@
+#pragma once
+#include <iostream>
+
+// 提前编译的执行基准：内置程序先在虚拟机上执行得到输出和返回值，
+// 再用朴素的栈式代码生成和线性扫描寄存器分配分别编译成可执行文件（IR都经过默认的优化流水线），
+// 各执行iterations次，检查输出和退出状态与虚拟机一致，报告每次执行的耗时和线性扫描相对栈式代码的加速比。
+// 需要Linux x86-64和系统的cc
+void runAotBenchmark(size_t iterations, std::ostream& os);
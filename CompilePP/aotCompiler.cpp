@@ -0,0 +1,1263 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <sstream>
+#include <utility>
+#include <vector>
+#include "aotCompiler.hpp"
+#include "runtimeValue.hpp"
+
+namespace {
+    const char* const names64[16] = {
+        "%rax", "%rcx", "%rdx", "%rbx", "%rsp", "%rbp", "%rsi", "%rdi",
+        "%r8", "%r9", "%r10", "%r11", "%r12", "%r13", "%r14", "%r15"
+    };
+    const char* const names32[16] = {
+        "%eax", "%ecx", "%edx", "%ebx", "%esp", "%ebp", "%esi", "%edi",
+        "%r8d", "%r9d", "%r10d", "%r11d", "%r12d", "%r13d", "%r14d", "%r15d"
+    };
+
+    enum : int32_t { Rax = 0, Rcx = 1, Rdx = 2 };
+
+    // 分配器的通用寄存器编号 -> 硬件编号。rax、rcx、rdx不参与分配，留给除法、移位、数组访问和并行移动中的环
+    const int32_t generalRegisters[] = { 7, 6, 8, 9, 10, 11, 3, 12, 13, 14, 15 };
+    // xmm0到xmm13参与分配，xmm14、xmm15是临时寄存器
+    constexpr int32_t floatScratch = 15;
+    constexpr int32_t floatMemoryScratch = 14;
+    // rbx、r12到r15是被调用者保存的；xmm寄存器都是调用者保存的
+    const RegisterSet x86Registers = { { 11, 14 }, { 0x7c0, 0 } };
+
+    const int32_t integerArguments[] = { 7, 6, 2, 1, 8, 9 };
+    constexpr size_t floatArguments = 8;
+
+    const char* const runtimeSource =
+        "# 运行时：数组分配、double到int的转换和错误退出\n"
+        "\t.text\n"
+        "# ecx = 长度，返回rax = 第一个元素的地址，只改变rax、rcx、rdx\n"
+        "cpp_rt_newarray:\n"
+        "\ttestl\t%ecx, %ecx\n"
+        "\tjle\tcpp_rt_array_length\n"
+        "\tpushq\t%rdi\n"
+        "\tmovslq\t%ecx, %rcx\n"
+        "\tmovq\tcpp_array_top(%rip), %rdi\n"
+        "\tleaq\t8(%rdi,%rcx,8), %rdx\n"
+        "\tleaq\tcpp_arrays_end(%rip), %rax\n"
+        "\tcmpq\t%rax, %rdx\n"
+        "\tja\tcpp_rt_array_storage\n"
+        "\tmovq\t%rdx, cpp_array_top(%rip)\n"
+        "\tmovq\t%rcx, (%rdi)\n"
+        "\taddq\t$8, %rdi\n"
+        "\tmovq\t%rdi, %rdx\n"
+        "\txorl\t%eax, %eax\n"
+        "\trep stosq\n"
+        "\tmovq\t%rdx, %rax\n"
+        "\tpopq\t%rdi\n"
+        "\tret\n"
+        "# xmm15 -> eax，NaN为0，超出范围时饱和，与doubleToInt一致；只改变rax\n"
+        "cpp_rt_dtoi:\n"
+        "\tucomisd\t%xmm15, %xmm15\n"
+        "\tjp\t1f\n"
+        "\tucomisd\t.Lcpp_dtoi_max(%rip), %xmm15\n"
+        "\tjae\t2f\n"
+        "\tucomisd\t.Lcpp_dtoi_min(%rip), %xmm15\n"
+        "\tjbe\t3f\n"
+        "\tcvttsd2siq\t%xmm15, %rax\n"
+        "\tret\n"
+        "1:\txorl\t%eax, %eax\n"
+        "\tret\n"
+        "2:\tmovl\t$0x7fffffff, %eax\n"
+        "\tret\n"
+        "3:\tmovl\t$0x80000000, %eax\n"
+        "\tret\n"
+        "cpp_rt_div_zero:\n"
+        "\tleaq\t.Lcpp_msg_div_zero(%rip), %rdi\n"
+        "\tjmp\tcpp_rt_fail\n"
+        "cpp_rt_div_overflow:\n"
+        "\tleaq\t.Lcpp_msg_div_overflow(%rip), %rdi\n"
+        "\tjmp\tcpp_rt_fail\n"
+        "cpp_rt_shift:\n"
+        "\tleaq\t.Lcpp_msg_shift(%rip), %rdi\n"
+        "\tjmp\tcpp_rt_fail\n"
+        "cpp_rt_array_length:\n"
+        "\tleaq\t.Lcpp_msg_array_length(%rip), %rdi\n"
+        "\tjmp\tcpp_rt_fail\n"
+        "cpp_rt_array_storage:\n"
+        "\tleaq\t.Lcpp_msg_array_storage(%rip), %rdi\n"
+        "\tjmp\tcpp_rt_fail\n"
+        "# rdi = 信息；先刷新stdout，保证错误之前的输出完整\n"
+        "cpp_rt_fail:\n"
+        "\tandq\t$-16, %rsp\n"
+        "\tpushq\t%rdi\n"
+        "\tpushq\t%rdi\n"
+        "\txorl\t%edi, %edi\n"
+        "\tcall\tfflush@PLT\n"
+        "\tpopq\t%rdx\n"
+        "\tpopq\t%rdx\n"
+        "\tmovl\t$2, %edi\n"
+        "\tleaq\t.Lcpp_fmt_error(%rip), %rsi\n"
+        "\txorl\t%eax, %eax\n"
+        "\tcall\tdprintf@PLT\n"
+        "\tmovl\t$1, %edi\n"
+        "\tcall\texit@PLT\n"
+        "# ecx = 下标，edx = 长度\n"
+        "cpp_rt_index_error:\n"
+        "\tandq\t$-16, %rsp\n"
+        "\tpushq\t%rcx\n"
+        "\tpushq\t%rdx\n"
+        "\txorl\t%edi, %edi\n"
+        "\tcall\tfflush@PLT\n"
+        "\tpopq\t%rcx\n"
+        "\tpopq\t%rdx\n"
+        "\tmovl\t$2, %edi\n"
+        "\tleaq\t.Lcpp_fmt_index(%rip), %rsi\n"
+        "\txorl\t%eax, %eax\n"
+        "\tcall\tdprintf@PLT\n"
+        "\tmovl\t$1, %edi\n"
+        "\tcall\texit@PLT\n"
+        "\n"
+        "\t.section\t.rodata\n"
+        ".Lcpp_fmt_int:\n\t.string\t\"%d\"\n"
+        ".Lcpp_fmt_double:\n\t.string\t\"%g\"\n"
+        ".Lcpp_fmt_error:\n\t.string\t\"Runtime error: %s\\n\"\n"
+        ".Lcpp_fmt_index:\n\t.string\t\"Runtime error: array index %d out of bounds [0, %d)\\n\"\n"
+        ".Lcpp_msg_div_zero:\n\t.string\t\"integer division by zero\"\n"
+        ".Lcpp_msg_div_overflow:\n\t.string\t\"integer overflow in division\"\n"
+        ".Lcpp_msg_shift:\n\t.string\t\"shift count out of range\"\n"
+        ".Lcpp_msg_array_length:\n\t.string\t\"array length must be a positive integer\"\n"
+        ".Lcpp_msg_array_storage:\n\t.string\t\"array storage exhausted\"\n"
+        "\t.p2align\t3\n"
+        ".Lcpp_dtoi_max:\n\t.double\t9.2e18\n"
+        ".Lcpp_dtoi_min:\n\t.double\t-9.2e18\n"
+        "\t.p2align\t4\n"
+        ".Lcpp_sign_mask:\n\t.quad\t0x8000000000000000, 0\n"
+        "\n"
+        "\t.data\n"
+        "\t.p2align\t3\n"
+        "cpp_array_top:\n\t.quad\tcpp_arrays\n"
+        "\n"
+        "\t.bss\n"
+        "\t.p2align\t4\n"
+        "cpp_arrays:\n\t.zero\t268435456\n"
+        "cpp_arrays_end:\n";
+
+    // 值所在的位置，也是并行移动的源和目标
+    struct Location {
+        enum class Kind : uint8_t { Register, Memory, Immediate, Constant } kind;
+        RegisterClass registerClass;
+        bool wide;            // 通用寄存器中的64位值（数组、数组栈顶）
+        int32_t value;        // 硬件寄存器编号、相对rbp的偏移或者立即数
+        std::string label;    // double常量在常量池中的标号
+
+        static Location general(int32_t reg, bool wide) {
+            return { Kind::Register, RegisterClass::General, wide, reg, {} };
+        }
+        static Location floating(int32_t reg) {
+            return { Kind::Register, RegisterClass::Float, false, reg, {} };
+        }
+        static Location memory(int32_t offset, RegisterClass registerClass, bool wide) {
+            return { Kind::Memory, registerClass, wide, offset, {} };
+        }
+
+        bool operator==(const Location& other) const {
+            if (kind != other.kind || value != other.value) {
+                return false;
+            }
+            return kind != Kind::Register || registerClass == other.registerClass;
+        }
+
+        std::string text() const {
+            switch (kind) {
+            case Kind::Register:
+                if (registerClass == RegisterClass::Float) {
+                    return "%xmm" + std::to_string(value);
+                }
+                return wide ? names64[value] : names32[value];
+            case Kind::Memory:
+                return std::to_string(value) + "(%rbp)";
+            case Kind::Immediate:
+                return "$" + std::to_string(value);
+            case Kind::Constant:
+                return label + "(%rip)";
+            }
+            return "";
+        }
+    };
+
+    struct Move {
+        Location from;
+        Location to;
+    };
+
+    bool isWide(IrType type) {
+        return type == IrType::Array || type == IrType::Mark;
+    }
+
+    std::string functionSymbol(const IrModule& module, uint32_t function) {
+        // 用户的标识符里没有'.'，<init>不会和名为init的函数冲突
+        return function == module.initFunction ? "cpp.init" : "cpp_fn_" + module.functions[function].name;
+    }
+
+    // double常量在常量池中的标号由位模式决定，与函数的生成顺序无关
+    std::string constantName(uint64_t bits) {
+        char label[32];
+        std::snprintf(label, sizeof(label), ".Lcpp_const_%016llx", static_cast<unsigned long long>(bits));
+        return label;
+    }
+
+    // 一个工作线程生成的各函数共用的状态：用到的double常量和统计，所有函数生成完之后合并
+    struct ModuleState {
+        const IrModule& module;
+        RegisterStrategy strategy;
+        AotStatistics statistics;
+        std::set<uint64_t> constants;
+
+        std::string constantLabel(double value) {
+            uint64_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            constants.insert(bits);
+            return constantName(bits);
+        }
+    };
+
+    class FunctionEmitter {
+    public:
+        FunctionEmitter(ModuleState& module, uint32_t index, std::ostream& os)
+            : module_(module), function_(module.module.functions[index]), index_(index), os_(os) {}
+
+        void emit();
+
+    private:
+        ModuleState& module_;
+        const IrFunction& function_;
+        uint32_t index_;
+        std::ostream& os_;
+        RegisterAllocation allocation_;
+        std::vector<bool> inlined_;        // 直接编码成立即数或常量池操作数的常量
+        std::vector<bool> fused_;          // 和后面的Branch合并成cmp + jcc的比较
+        std::vector<int32_t> saved_;       // 压栈保存的被调用者保存寄存器（硬件编号）
+        int32_t arrayTopSlot_ = 0;         // 保存进入函数时的数组栈顶，0表示函数不分配数组
+        std::vector<std::pair<uint32_t, size_t>> edges_;  // 需要移动的Branch出边：块和后继下标
+        std::string prefix_;
+
+        void instruction(const std::string& mnemonic) {
+            os_ << "\t" << mnemonic << "\n";
+            module_.statistics.instructions++;
+        }
+        void instruction(const std::string& mnemonic, const std::string& operand) {
+            os_ << "\t" << mnemonic << "\t" << operand << "\n";
+            module_.statistics.instructions++;
+        }
+        void instruction(const std::string& mnemonic, const std::string& source, const std::string& target) {
+            os_ << "\t" << mnemonic << "\t" << source << ", " << target << "\n";
+            module_.statistics.instructions++;
+        }
+
+        int32_t slotOffset(int32_t slot) const {
+            return -8 * static_cast<int32_t>(saved_.size()) - 8 * (slot + 1);
+        }
+        std::string blockLabel(uint32_t block) const {
+            return prefix_ + std::to_string(block);
+        }
+        std::string edgeLabel(uint32_t block, size_t successor) const {
+            return prefix_ + std::to_string(block) + "_" + std::to_string(successor);
+        }
+        bool hasLocation(uint32_t value) const {
+            return allocation_.registers[value] >= 0 || allocation_.slots[value] >= 0;
+        }
+        bool needsEdgeMoves(uint32_t successor) const {
+            const IrBlock& block = function_.blocks[successor];
+            return !block.instructions.empty() && function_.values[block.instructions[0]].op == IrOp::Phi;
+        }
+
+        Location locationOf(uint32_t value);
+        Location scratchFor(uint32_t value);
+        void move(const Location& from, const Location& to);
+        void parallelMove(std::vector<Move> moves);
+        std::vector<uint32_t> liveAcross(uint32_t value) const;
+        void saveAcross(const std::vector<uint32_t>& values, bool restore);
+
+        void emitPrologue();
+        void emitEpilogue();
+        void emitBlock(size_t position);
+        void emitInstruction(uint32_t value);
+        void emitIntegerBinary(const char* mnemonic, uint32_t value, bool commutative);
+        void emitFloatBinary(const char* mnemonic, uint32_t value, bool commutative);
+        void emitDivision(uint32_t value);
+        void emitShift(uint32_t value);
+        std::string emitIntegerCompare(const IrInstruction& compare);
+        void emitFloatCompare(const IrInstruction& compare);
+        void emitCompare(uint32_t value);
+        void emitTruthTest(uint32_t value, bool isTrue);
+        void emitElementAddress(const IrInstruction& access, std::string& base);
+        void emitCall(uint32_t value);
+        void emitPrint(uint32_t value);
+        void emitBranch(uint32_t block, uint32_t terminator, uint32_t next);
+        void emitEdge(uint32_t block, size_t successor);
+    };
+
+    Location FunctionEmitter::locationOf(uint32_t value) {
+        const IrInstruction& instruction = function_.values[value];
+        RegisterClass registerClass = registerClassOf(instruction.type);
+        if (inlined_[value]) {
+            if (registerClass == RegisterClass::Float) {
+                return { Location::Kind::Constant, registerClass, false, 0, module_.constantLabel(instruction.doubleValue) };
+            }
+            return { Location::Kind::Immediate, registerClass, isWide(instruction.type), instruction.intValue, {} };
+        }
+        int32_t reg = allocation_.registers[value];
+        if (reg >= 0) {
+            if (registerClass == RegisterClass::Float) {
+                return Location::floating(reg);
+            }
+            return Location::general(generalRegisters[reg], isWide(instruction.type));
+        }
+        return Location::memory(slotOffset(allocation_.slots[value]), registerClass, isWide(instruction.type));
+    }
+
+    // 结果先算到寄存器里：值分配了寄存器时就是它，否则是临时寄存器，最后再写回栈槽
+    Location FunctionEmitter::scratchFor(uint32_t value) {
+        Location location = locationOf(value);
+        if (location.kind == Location::Kind::Register) {
+            return location;
+        }
+        if (location.registerClass == RegisterClass::Float) {
+            return Location::floating(floatScratch);
+        }
+        return Location::general(Rax, location.wide);
+    }
+
+    void FunctionEmitter::move(const Location& from, const Location& to) {
+        if (from == to) {
+            return;
+        }
+        bool fromRegister = from.kind == Location::Kind::Register;
+        bool toRegister = to.kind == Location::Kind::Register;
+        if (to.registerClass == RegisterClass::Float) {
+            if (fromRegister && toRegister) {
+                instruction("movapd", from.text(), to.text());
+            }
+            else if (fromRegister || toRegister) {
+                instruction("movsd", from.text(), to.text());
+            }
+            else {
+                Location scratch = Location::floating(floatMemoryScratch);
+                instruction("movsd", from.text(), scratch.text());
+                instruction("movsd", scratch.text(), to.text());
+            }
+            return;
+        }
+        if (from.kind == Location::Kind::Memory && to.kind == Location::Kind::Memory) {
+            // 内存之间借xmm14中转，rax可能正被并行移动用来打破环
+            Location scratch = Location::floating(floatMemoryScratch);
+            instruction("movq", from.text(), scratch.text());
+            instruction("movq", scratch.text(), to.text());
+            return;
+        }
+        if (from.kind == Location::Kind::Immediate && from.value == 0 && toRegister) {
+            instruction("xorl", names32[to.value], names32[to.value]);
+            return;
+        }
+        instruction(to.wide ? "movq" : "movl", from.text(), to.text());
+    }
+
+    // 所有移动同时发生：先做目标不再被读的移动，剩下的都在环上时借临时寄存器打破一个环，
+    // 源是立即数和常量的移动不会阻塞别的移动，放在最后
+    void FunctionEmitter::parallelMove(std::vector<Move> moves) {
+        std::vector<Move> pending;
+        std::vector<Move> constants;
+        for (Move& entry : moves) {
+            if (entry.from == entry.to) {
+                continue;
+            }
+            bool constant = entry.from.kind == Location::Kind::Immediate || entry.from.kind == Location::Kind::Constant;
+            (constant ? constants : pending).push_back(std::move(entry));
+        }
+        while (!pending.empty()) {
+            bool progress = false;
+            for (size_t i = 0; i < pending.size() && !progress; i++) {
+                bool blocked = false;
+                for (size_t j = 0; j < pending.size() && !blocked; j++) {
+                    blocked = j != i && pending[j].from == pending[i].to;
+                }
+                if (!blocked) {
+                    move(pending[i].from, pending[i].to);
+                    pending.erase(pending.begin() + static_cast<std::ptrdiff_t>(i));
+                    progress = true;
+                }
+            }
+            if (!progress) {
+                Location target = pending[0].to;
+                Location scratch = target.registerClass == RegisterClass::Float ? Location::floating(floatScratch) : Location::general(Rax, target.wide);
+                move(target, scratch);
+                for (Move& entry : pending) {
+                    if (entry.from == target) {
+                        entry.from = scratch;
+                    }
+                }
+            }
+        }
+        for (const Move& entry : constants) {
+            move(entry.from, entry.to);
+        }
+    }
+
+    // 跨过value这条调用、放在调用者保存的寄存器里的值
+    std::vector<uint32_t> FunctionEmitter::liveAcross(uint32_t value) const {
+        std::vector<uint32_t> values;
+        uint32_t position = allocation_.position[value];
+        for (const LiveInterval& interval : allocation_.intervals) {
+            if (interval.start >= position) {
+                break;
+            }
+            if (interval.end > position && allocation_.registers[interval.value] >= 0 && allocation_.slots[interval.value] >= 0) {
+                values.push_back(interval.value);
+            }
+        }
+        return values;
+    }
+
+    void FunctionEmitter::saveAcross(const std::vector<uint32_t>& values, bool restore) {
+        for (uint32_t value : values) {
+            Location reg = locationOf(value);
+            Location slot = Location::memory(slotOffset(allocation_.slots[value]), reg.registerClass, reg.wide);
+            if (restore) {
+                move(slot, reg);
+            }
+            else {
+                move(reg, slot);
+            }
+        }
+    }
+
+    void FunctionEmitter::emit() {
+        const IrModule& module = module_.module;
+        bool stack = module_.strategy == RegisterStrategy::Stack;
+        size_t count = function_.values.size();
+        std::vector<size_t> uses(count, 0);
+        for (const IrInstruction& instruction : function_.values) {
+            for (uint32_t operand : instruction.operands) {
+                uses[operand]++;
+            }
+        }
+        // 紧挨着Branch、只被它使用的比较直接设置标志位
+        inlined_.assign(count, false);
+        fused_.assign(count, false);
+        for (const IrBlock& block : function_.blocks) {
+            size_t size = block.instructions.size();
+            if (stack || size < 2) {
+                continue;
+            }
+            const IrInstruction& terminator = function_.values[block.instructions[size - 1]];
+            uint32_t condition = block.instructions[size - 2];
+            IrOp op = function_.values[condition].op;
+            if (terminator.op == IrOp::Branch && terminator.operands[0] == condition && uses[condition] == 1 &&
+                (op == IrOp::Lt || op == IrOp::Le || op == IrOp::Eq || op == IrOp::Ne)) {
+                fused_[condition] = true;
+            }
+        }
+        std::vector<bool> needsLocation(count, false);
+        std::vector<bool> clobbers(count, false);
+        bool allocatesArrays = false;
+        for (uint32_t value = 0; value < count; value++) {
+            const IrInstruction& instruction = function_.values[value];
+            inlined_[value] = instruction.op == IrOp::Const;
+            needsLocation[value] = !instruction.removed && instruction.type != IrType::Void && !inlined_[value] && !fused_[value];
+            clobbers[value] = instruction.op == IrOp::Call || instruction.op == IrOp::Print || instruction.op == IrOp::PrintChar;
+            allocatesArrays = allocatesArrays || (!instruction.removed && instruction.op == IrOp::NewArray);
+        }
+        allocation_ = allocateRegisters(function_, needsLocation, clobbers, x86Registers, stack);
+        for (uint32_t reg = 0; reg < 32; reg++) {
+            if (((allocation_.usedRegisters[0] & x86Registers.calleeSaved[0]) >> reg) & 1) {
+                saved_.push_back(generalRegisters[reg]);
+            }
+        }
+        // 返回时释放函数分配的数组；<init>分配的全局数组一直保留
+        if (allocatesArrays && index_ != module.initFunction) {
+            arrayTopSlot_ = static_cast<int32_t>(allocation_.slotCount) + 1;
+        }
+        prefix_ = ".L" + std::to_string(index_) + "_";
+
+        module_.statistics.functions++;
+        module_.statistics.values += allocation_.intervals.size();
+        module_.statistics.spilled += allocation_.spilled;
+
+        std::string symbol = functionSymbol(module, index_);
+        os_ << "\n# " << function_.name << ": " << allocation_.intervals.size() << " values, "
+            << allocation_.spilled << " spilled, " << allocation_.slotCount << " stack slots\n";
+        os_ << "\t.p2align\t4\n";
+        os_ << "\t.type\t" << symbol << ", @function\n";
+        os_ << symbol << ":\n";
+        emitPrologue();
+        for (size_t i = 0; i < allocation_.order.size(); i++) {
+            emitBlock(i);
+        }
+        emitEpilogue();
+        for (const auto& [block, successor] : edges_) {
+            os_ << edgeLabel(block, successor) << ":\n";
+            emitEdge(block, successor);
+            instruction("jmp", blockLabel(function_.blocks[block].successors[successor]));
+        }
+        os_ << "\t.size\t" << symbol << ", .-" << symbol << "\n";
+    }
+
+    void FunctionEmitter::emitPrologue() {
+        instruction("pushq", "%rbp");
+        instruction("movq", "%rsp", "%rbp");
+        for (int32_t reg : saved_) {
+            instruction("pushq", names64[reg]);
+        }
+        // 调用指令处rsp要16字节对齐
+        size_t slots = allocation_.slotCount + (arrayTopSlot_ != 0 ? 1 : 0);
+        size_t frame = 8 * slots;
+        if ((8 * saved_.size() + frame) % 16 != 0) {
+            frame += 8;
+        }
+        if (frame != 0) {
+            instruction("subq", "$" + std::to_string(frame), "%rsp");
+        }
+        if (arrayTopSlot_ != 0) {
+            instruction("movq", "cpp_array_top(%rip)", "%rax");
+            instruction("movq", "%rax", std::to_string(slotOffset(arrayTopSlot_ - 1)) + "(%rbp)");
+        }
+
+        // 把参数从System V规定的位置移动到分配的位置
+        std::vector<uint32_t> parameters(function_.parameters.size(), UINT32_MAX);
+        for (uint32_t value : function_.blocks[0].instructions) {
+            const IrInstruction& instruction = function_.values[value];
+            if (instruction.op == IrOp::Param && hasLocation(value)) {
+                parameters[instruction.immediate] = value;
+            }
+        }
+        std::vector<Move> moves;
+        size_t integers = 0;
+        size_t floats = 0;
+        int32_t stackOffset = 16;
+        for (size_t i = 0; i < function_.parameters.size(); i++) {
+            IrType type = function_.parameters[i];
+            Location incoming;
+            if (type == IrType::Double) {
+                incoming = floats < floatArguments ? Location::floating(static_cast<int32_t>(floats++)) : Location::memory(stackOffset, RegisterClass::Float, false);
+            }
+            else {
+                incoming = integers < 6 ? Location::general(integerArguments[integers++], isWide(type)) : Location::memory(stackOffset, RegisterClass::General, isWide(type));
+            }
+            if (incoming.kind == Location::Kind::Memory) {
+                stackOffset += 8;
+            }
+            if (parameters[i] != UINT32_MAX) {
+                moves.push_back({ incoming, locationOf(parameters[i]) });
+            }
+        }
+        parallelMove(std::move(moves));
+    }
+
+    void FunctionEmitter::emitEpilogue() {
+        os_ << prefix_ << "ret:\n";
+        if (arrayTopSlot_ != 0) {
+            instruction("movq", std::to_string(slotOffset(arrayTopSlot_ - 1)) + "(%rbp)", "%rcx");
+            instruction("movq", "%rcx", "cpp_array_top(%rip)");
+        }
+        if (!saved_.empty()) {
+            instruction("leaq", std::to_string(-8 * static_cast<int32_t>(saved_.size())) + "(%rbp)", "%rsp");
+            for (size_t i = saved_.size(); i-- > 0;) {
+                instruction("popq", names64[saved_[i]]);
+            }
+        }
+        else {
+            instruction("movq", "%rbp", "%rsp");
+        }
+        instruction("popq", "%rbp");
+        instruction("ret");
+    }
+
+    void FunctionEmitter::emitBlock(size_t position) {
+        uint32_t block = allocation_.order[position];
+        uint32_t next = position + 1 < allocation_.order.size() ? allocation_.order[position + 1] : UINT32_MAX;
+        os_ << blockLabel(block) << ":\n";
+        const IrBlock& current = function_.blocks[block];
+        for (uint32_t value : current.instructions) {
+            const IrInstruction& instruction = function_.values[value];
+            switch (instruction.op) {
+            case IrOp::Jump: {
+                uint32_t target = current.successors[0];
+                if (needsEdgeMoves(target)) {
+                    emitEdge(block, 0);
+                }
+                if (target != next) {
+                    this->instruction("jmp", blockLabel(target));
+                }
+                break;
+            }
+            case IrOp::Branch:
+                emitBranch(block, value, next);
+                break;
+            case IrOp::Return:
+                if (!instruction.operands.empty()) {
+                    Location result = function_.returnType == IrType::Double ? Location::floating(0) : Location::general(Rax, false);
+                    move(locationOf(instruction.operands[0]), result);
+                }
+                else if (function_.returnType == IrType::Double) {
+                    this->instruction("xorpd", "%xmm0", "%xmm0");
+                }
+                else if (function_.returnType != IrType::Void) {
+                    this->instruction("xorl", "%eax", "%eax");
+                }
+                if (next != UINT32_MAX) {
+                    this->instruction("jmp", prefix_ + "ret");
+                }
+                break;
+            default:
+                emitInstruction(value);
+                break;
+            }
+        }
+        // Branch的边上有Phi需要的移动时，先跳到边上做完移动再去后继；边放在函数末尾，不打断块之间的落入
+        const IrInstruction& terminator = function_.values[current.instructions.back()];
+        if (terminator.op == IrOp::Branch) {
+            for (size_t i = 0; i < current.successors.size(); i++) {
+                if (needsEdgeMoves(current.successors[i])) {
+                    edges_.push_back({ block, i });
+                }
+            }
+        }
+    }
+
+    // block的第successor条出边：后继的Phi读这条边对应的操作数
+    void FunctionEmitter::emitEdge(uint32_t block, size_t successor) {
+        const IrBlock& current = function_.blocks[block];
+        uint32_t target = current.successors[successor];
+        // 同一对块之间可能有两条边（Branch的两个后继相同），按出现的次序对应
+        size_t occurrence = 0;
+        for (size_t i = 0; i < successor; i++) {
+            occurrence += current.successors[i] == target ? 1 : 0;
+        }
+        const IrBlock& next = function_.blocks[target];
+        size_t index = 0;
+        for (; index < next.predecessors.size(); index++) {
+            if (next.predecessors[index] == block && occurrence-- == 0) {
+                break;
+            }
+        }
+        std::vector<Move> moves;
+        for (uint32_t value : next.instructions) {
+            const IrInstruction& phi = function_.values[value];
+            if (phi.op != IrOp::Phi) {
+                break;
+            }
+            moves.push_back({ locationOf(phi.operands[index]), locationOf(value) });
+        }
+        parallelMove(std::move(moves));
+    }
+
+    void FunctionEmitter::emitBranch(uint32_t block, uint32_t terminator, uint32_t next) {
+        const IrBlock& current = function_.blocks[block];
+        uint32_t trueBlock = current.successors[0];
+        uint32_t falseBlock = current.successors[1];
+        std::string whenTrue = needsEdgeMoves(trueBlock) ? edgeLabel(block, 0) : blockLabel(trueBlock);
+        std::string whenFalse = needsEdgeMoves(falseBlock) ? edgeLabel(block, 1) : blockLabel(falseBlock);
+        bool fallTrue = !needsEdgeMoves(trueBlock) && trueBlock == next;
+        bool fallFalse = !needsEdgeMoves(falseBlock) && falseBlock == next;
+
+        uint32_t condition = function_.values[terminator].operands[0];
+        const IrInstruction& compare = function_.values[condition];
+        std::string taken = "ne";
+        std::string inverse = "e";
+        if (fused_[condition]) {
+            if (registerClassOf(function_.values[compare.operands[0]].type) == RegisterClass::Float) {
+                emitFloatCompare(compare);
+                if (compare.op == IrOp::Eq || compare.op == IrOp::Ne) {
+                    // 无序（NaN）时PF为1：==为假、!=为真
+                    std::string exit = compare.op == IrOp::Eq ? whenFalse : whenTrue;
+                    instruction("jne", exit);
+                    instruction("jp", exit);
+                    bool fall = compare.op == IrOp::Eq ? fallTrue : fallFalse;
+                    if (!fall) {
+                        instruction("jmp", compare.op == IrOp::Eq ? whenTrue : whenFalse);
+                    }
+                    return;
+                }
+                taken = compare.op == IrOp::Lt ? "a" : "ae";
+                inverse = compare.op == IrOp::Lt ? "be" : "b";
+            }
+            else {
+                static const std::pair<const char*, const char*> inverses[] = {
+                    { "l", "ge" }, { "le", "g" }, { "g", "le" }, { "ge", "l" }, { "e", "ne" }, { "ne", "e" }
+                };
+                taken = emitIntegerCompare(compare);
+                for (const auto& entry : inverses) {
+                    if (taken == entry.first) {
+                        inverse = entry.second;
+                    }
+                }
+            }
+        }
+        else {
+            Location location = locationOf(condition);
+            if (location.kind == Location::Kind::Immediate) {
+                bool target = location.value != 0;
+                if (!(target ? fallTrue : fallFalse)) {
+                    instruction("jmp", target ? whenTrue : whenFalse);
+                }
+                return;
+            }
+            if (location.kind == Location::Kind::Register) {
+                instruction("testl", location.text(), location.text());
+            }
+            else {
+                instruction("cmpl", "$0", location.text());
+            }
+        }
+        if (fallTrue) {
+            instruction("j" + inverse, whenFalse);
+            return;
+        }
+        instruction("j" + taken, whenTrue);
+        if (!fallFalse) {
+            instruction("jmp", whenFalse);
+        }
+    }
+
+    // 比较两个int，返回条件为真时的条件码
+    std::string FunctionEmitter::emitIntegerCompare(const IrInstruction& compare) {
+        Location left = locationOf(compare.operands[0]);
+        Location right = locationOf(compare.operands[1]);
+        bool swapped = false;
+        if (left.kind == Location::Kind::Immediate && right.kind != Location::Kind::Immediate) {
+            std::swap(left, right);
+            swapped = true;
+        }
+        else if (left.kind != Location::Kind::Register && (left.kind == Location::Kind::Immediate || right.kind == Location::Kind::Memory)) {
+            Location scratch = Location::general(Rax, false);
+            move(left, scratch);
+            left = scratch;
+        }
+        instruction("cmpl", right.text(), left.text());
+        switch (compare.op) {
+        case IrOp::Lt: return swapped ? "g" : "l";
+        case IrOp::Le: return swapped ? "ge" : "le";
+        case IrOp::Eq: return "e";
+        default: return "ne";
+        }
+    }
+
+    // ucomisd a, b按b与a的大小设置标志：a < b即"above"，无序时CF、ZF、PF都为1
+    void FunctionEmitter::emitFloatCompare(const IrInstruction& compare) {
+        Location left = locationOf(compare.operands[0]);
+        Location right = locationOf(compare.operands[1]);
+        if (right.kind != Location::Kind::Register) {
+            Location scratch = Location::floating(floatScratch);
+            move(right, scratch);
+            right = scratch;
+        }
+        instruction("ucomisd", left.text(), right.text());
+    }
+
+    void FunctionEmitter::emitCompare(uint32_t value) {
+        const IrInstruction& compare = function_.values[value];
+        Location target = scratchFor(value);
+        if (registerClassOf(function_.values[compare.operands[0]].type) == RegisterClass::Float) {
+            emitFloatCompare(compare);
+            switch (compare.op) {
+            case IrOp::Lt:
+                instruction("seta", "%al");
+                break;
+            case IrOp::Le:
+                instruction("setae", "%al");
+                break;
+            case IrOp::Eq:
+                instruction("sete", "%al");
+                instruction("setnp", "%cl");
+                instruction("andb", "%cl", "%al");
+                break;
+            default:
+                instruction("setne", "%al");
+                instruction("setp", "%cl");
+                instruction("orb", "%cl", "%al");
+                break;
+            }
+        }
+        else {
+            instruction("set" + emitIntegerCompare(compare), "%al");
+        }
+        instruction("movzbl", "%al", target.text());
+        move(target, locationOf(value));
+    }
+
+    // Not和ToBool：操作数为零（isTrue为false）或不为零时结果为1
+    void FunctionEmitter::emitTruthTest(uint32_t value, bool isTrue) {
+        const IrInstruction& test = function_.values[value];
+        Location operand = locationOf(test.operands[0]);
+        Location target = scratchFor(value);
+        if (operand.registerClass == RegisterClass::Float) {
+            instruction("xorpd", "%xmm15", "%xmm15");
+            instruction("ucomisd", operand.text(), "%xmm15");
+            if (isTrue) {
+                instruction("setne", "%al");
+                instruction("setp", "%cl");
+                instruction("orb", "%cl", "%al");
+            }
+            else {
+                instruction("sete", "%al");
+                instruction("setnp", "%cl");
+                instruction("andb", "%cl", "%al");
+            }
+        }
+        else {
+            if (operand.kind == Location::Kind::Immediate) {
+                move(operand, Location::general(Rax, false));
+                operand = Location::general(Rax, false);
+            }
+            instruction("cmpl", "$0", operand.text());
+            instruction(isTrue ? "setne" : "sete", "%al");
+        }
+        instruction("movzbl", "%al", target.text());
+        move(target, locationOf(value));
+    }
+
+    void FunctionEmitter::emitIntegerBinary(const char* mnemonic, uint32_t value, bool commutative) {
+        const IrInstruction& instruction = function_.values[value];
+        Location target = locationOf(value);
+        Location left = locationOf(instruction.operands[0]);
+        Location right = locationOf(instruction.operands[1]);
+        if (commutative && right == target) {
+            std::swap(left, right);
+        }
+        // 右操作数就在结果的寄存器里时不能先把左操作数写进去
+        Location work = target.kind == Location::Kind::Register && !(right == target) ? target : Location::general(Rax, false);
+        move(left, work);
+        this->instruction(mnemonic, right.text(), work.text());
+        move(work, target);
+    }
+
+    void FunctionEmitter::emitFloatBinary(const char* mnemonic, uint32_t value, bool commutative) {
+        const IrInstruction& instruction = function_.values[value];
+        Location target = locationOf(value);
+        Location left = locationOf(instruction.operands[0]);
+        Location right = locationOf(instruction.operands[1]);
+        if (commutative && right == target) {
+            std::swap(left, right);
+        }
+        Location work = target.kind == Location::Kind::Register && !(right == target) ? target : Location::floating(floatScratch);
+        move(left, work);
+        this->instruction(mnemonic, right.text(), work.text());
+        move(work, target);
+    }
+
+    // idiv的被除数在edx:eax中，商在eax、余数在edx；除数为零和INT_MIN / -1都跳到运行时报错
+    void FunctionEmitter::emitDivision(uint32_t value) {
+        const IrInstruction& division = function_.values[value];
+        Location left = locationOf(division.operands[0]);
+        Location right = locationOf(division.operands[1]);
+        move(left, Location::general(Rax, false));
+        if (right.kind == Location::Kind::Immediate && right.value == 0) {
+            instruction("jmp", "cpp_rt_div_zero");
+            return;
+        }
+        move(right, Location::general(Rcx, false));
+        if (right.kind != Location::Kind::Immediate) {
+            instruction("testl", "%ecx", "%ecx");
+            instruction("je", "cpp_rt_div_zero");
+        }
+        if (right.kind != Location::Kind::Immediate || right.value == -1) {
+            instruction("cmpl", "$-1", "%ecx");
+            instruction("jne", "1f");
+            instruction("cmpl", "$-2147483648", "%eax");
+            instruction("je", "cpp_rt_div_overflow");
+            os_ << "1:\n";
+        }
+        instruction("cltd");
+        instruction("idivl", "%ecx");
+        move(Location::general(division.op == IrOp::Div ? Rax : Rdx, false), locationOf(value));
+    }
+
+    // 移位数不在[0, 32)时报错（按无符号比较，负数也会超过31）；Shr是算术右移
+    void FunctionEmitter::emitShift(uint32_t value) {
+        const IrInstruction& shift = function_.values[value];
+        const char* mnemonic = shift.op == IrOp::Shl ? "shll" : "sarl";
+        Location right = locationOf(shift.operands[1]);
+        std::string count = "%cl";
+        if (right.kind == Location::Kind::Immediate) {
+            if (right.value < 0 || right.value >= 32) {
+                instruction("jmp", "cpp_rt_shift");
+                return;
+            }
+            count = right.text();
+        }
+        else {
+            move(right, Location::general(Rcx, false));
+            instruction("cmpl", "$31", "%ecx");
+            instruction("ja", "cpp_rt_shift");
+        }
+        Location work = scratchFor(value);
+        move(locationOf(shift.operands[0]), work);
+        instruction(mnemonic, count, work.text());
+        move(work, locationOf(value));
+    }
+
+    // 数组放在base寄存器中，下标在rcx中并且已经检查过范围；越界时rcx是下标、rdx是长度
+    void FunctionEmitter::emitElementAddress(const IrInstruction& access, std::string& base) {
+        Location array = locationOf(access.operands[0]);
+        if (array.kind != Location::Kind::Register) {
+            move(array, Location::general(Rax, true));
+            array = Location::general(Rax, true);
+        }
+        base = array.text();
+        Location index = locationOf(access.operands[1]);
+        if (index.kind == Location::Kind::Immediate) {
+            instruction("movq", index.text(), "%rcx");
+        }
+        else {
+            instruction("movslq", index.text(), "%rcx");
+        }
+        instruction("movq", "-8(" + base + ")", "%rdx");
+        instruction("cmpq", "%rdx", "%rcx");
+        instruction("jae", "cpp_rt_index_error");
+    }
+
+    void FunctionEmitter::emitCall(uint32_t value) {
+        const IrInstruction& call = function_.values[value];
+        std::vector<uint32_t> live = liveAcross(value);
+        saveAcross(live, false);
+
+        const IrFunction& callee = module_.module.functions[call.immediate];
+        std::vector<Move> moves;
+        std::vector<Location> stackArguments;
+        size_t integers = 0;
+        size_t floats = 0;
+        for (size_t i = 0; i < call.operands.size(); i++) {
+            IrType type = i < callee.parameters.size() ? callee.parameters[i] : function_.values[call.operands[i]].type;
+            Location argument = locationOf(call.operands[i]);
+            if (type == IrType::Double && floats < floatArguments) {
+                moves.push_back({ argument, Location::floating(static_cast<int32_t>(floats++)) });
+            }
+            else if (type != IrType::Double && integers < 6) {
+                moves.push_back({ argument, Location::general(integerArguments[integers++], isWide(type)) });
+            }
+            else {
+                stackArguments.push_back(argument);
+            }
+        }
+        // 栈上的参数从右向左压入，个数为奇数时先补8字节保持对齐
+        size_t stackBytes = 8 * stackArguments.size();
+        if (stackArguments.size() % 2 != 0) {
+            instruction("subq", "$8", "%rsp");
+            stackBytes += 8;
+        }
+        for (size_t i = stackArguments.size(); i-- > 0;) {
+            const Location& argument = stackArguments[i];
+            if (argument.registerClass == RegisterClass::Float && argument.kind != Location::Kind::Memory) {
+                Location reg = argument;
+                if (argument.kind != Location::Kind::Register) {
+                    reg = Location::floating(floatScratch);
+                    move(argument, reg);
+                }
+                instruction("subq", "$8", "%rsp");
+                instruction("movsd", reg.text(), "(%rsp)");
+            }
+            else if (argument.kind == Location::Kind::Register) {
+                instruction("pushq", names64[argument.value]);
+            }
+            else {
+                instruction("pushq", argument.text());
+            }
+        }
+        parallelMove(std::move(moves));
+        instruction("call", functionSymbol(module_.module, call.immediate));
+        if (stackBytes != 0) {
+            instruction("addq", "$" + std::to_string(stackBytes), "%rsp");
+        }
+        if (hasLocation(value)) {
+            Location result = call.type == IrType::Double ? Location::floating(0) : Location::general(Rax, isWide(call.type));
+            move(result, locationOf(value));
+        }
+        saveAcross(live, true);
+    }
+
+    void FunctionEmitter::emitPrint(uint32_t value) {
+        const IrInstruction& print = function_.values[value];
+        std::vector<uint32_t> live = liveAcross(value);
+        saveAcross(live, false);
+        if (print.op == IrOp::PrintChar) {
+            instruction("movl", "$" + std::to_string(print.immediate), "%edi");
+            instruction("call", "putchar@PLT");
+        }
+        else if (function_.values[print.operands[0]].type == IrType::Double) {
+            move(locationOf(print.operands[0]), Location::floating(0));
+            instruction("leaq", ".Lcpp_fmt_double(%rip)", "%rdi");
+            instruction("movl", "$1", "%eax");
+            instruction("call", "printf@PLT");
+        }
+        else {
+            move(locationOf(print.operands[0]), Location::general(6, false));
+            instruction("leaq", ".Lcpp_fmt_int(%rip)", "%rdi");
+            instruction("xorl", "%eax", "%eax");
+            instruction("call", "printf@PLT");
+        }
+        saveAcross(live, true);
+    }
+
+    void FunctionEmitter::emitInstruction(uint32_t value) {
+        const IrInstruction& instruction = function_.values[value];
+        if (instruction.removed) {
+            return;
+        }
+        bool floating = instruction.type == IrType::Double;
+        switch (instruction.op) {
+        case IrOp::Const:
+        case IrOp::Param:
+        case IrOp::Phi:
+            // 常量直接编码在使用处，参数在入口、Phi在前驱的出边上移动到位
+            break;
+        case IrOp::Add:
+            floating ? emitFloatBinary("addsd", value, true) : emitIntegerBinary("addl", value, true);
+            break;
+        case IrOp::Sub:
+            floating ? emitFloatBinary("subsd", value, false) : emitIntegerBinary("subl", value, false);
+            break;
+        case IrOp::Mul:
+            floating ? emitFloatBinary("mulsd", value, true) : emitIntegerBinary("imull", value, true);
+            break;
+        case IrOp::Div:
+            floating ? emitFloatBinary("divsd", value, false) : emitDivision(value);
+            break;
+        case IrOp::Mod:
+            emitDivision(value);
+            break;
+        case IrOp::Shl:
+        case IrOp::Shr:
+            emitShift(value);
+            break;
+        case IrOp::And:
+            emitIntegerBinary("andl", value, true);
+            break;
+        case IrOp::Or:
+            emitIntegerBinary("orl", value, true);
+            break;
+        case IrOp::Xor:
+            emitIntegerBinary("xorl", value, true);
+            break;
+        case IrOp::Lt:
+        case IrOp::Le:
+        case IrOp::Eq:
+        case IrOp::Ne:
+            if (!fused_[value]) {
+                emitCompare(value);
+            }
+            break;
+        case IrOp::Neg: {
+            Location work = scratchFor(value);
+            move(locationOf(instruction.operands[0]), work);
+            if (floating) {
+                this->instruction("xorpd", ".Lcpp_sign_mask(%rip)", work.text());
+            }
+            else {
+                this->instruction("negl", work.text());
+            }
+            move(work, locationOf(value));
+            break;
+        }
+        case IrOp::BitNot: {
+            Location work = scratchFor(value);
+            move(locationOf(instruction.operands[0]), work);
+            this->instruction("notl", work.text());
+            move(work, locationOf(value));
+            break;
+        }
+        case IrOp::Not:
+            emitTruthTest(value, false);
+            break;
+        case IrOp::ToBool:
+            emitTruthTest(value, true);
+            break;
+        case IrOp::IntToDouble: {
+            Location operand = locationOf(instruction.operands[0]);
+            if (operand.kind == Location::Kind::Immediate) {
+                move(operand, Location::general(Rax, false));
+                operand = Location::general(Rax, false);
+            }
+            Location work = scratchFor(value);
+            // 先清零，避免cvtsi2sd依赖目标寄存器原来的值
+            this->instruction("xorpd", work.text(), work.text());
+            this->instruction("cvtsi2sdl", operand.text(), work.text());
+            move(work, locationOf(value));
+            break;
+        }
+        case IrOp::DoubleToInt:
+            move(locationOf(instruction.operands[0]), Location::floating(floatScratch));
+            this->instruction("call", "cpp_rt_dtoi");
+            move(Location::general(Rax, false), locationOf(value));
+            break;
+        case IrOp::RoundFloat: {
+            Location work = scratchFor(value);
+            this->instruction("cvtsd2ss", locationOf(instruction.operands[0]).text(), "%xmm15");
+            this->instruction("cvtss2sd", "%xmm15", work.text());
+            move(work, locationOf(value));
+            break;
+        }
+        case IrOp::TruncChar: {
+            Location work = scratchFor(value);
+            move(locationOf(instruction.operands[0]), Location::general(Rax, false));
+            this->instruction("movsbl", "%al", work.text());
+            move(work, locationOf(value));
+            break;
+        }
+        case IrOp::LoadGlobal: {
+            Location global = { Location::Kind::Constant, registerClassOf(instruction.type), isWide(instruction.type), 0,
+                "cpp_global_" + std::to_string(instruction.immediate) };
+            Location work = scratchFor(value);
+            move(global, work);
+            move(work, locationOf(value));
+            break;
+        }
+        case IrOp::StoreGlobal: {
+            Location source = locationOf(instruction.operands[0]);
+            Location global = { Location::Kind::Constant, source.registerClass, source.wide, 0, "cpp_global_" + std::to_string(instruction.immediate) };
+            if (source.kind != Location::Kind::Register && !(source.kind == Location::Kind::Immediate && !source.wide)) {
+                Location work = source.registerClass == RegisterClass::Float ? Location::floating(floatScratch) : Location::general(Rax, source.wide);
+                move(source, work);
+                source = work;
+            }
+            if (source.registerClass == RegisterClass::Float) {
+                this->instruction("movsd", source.text(), global.text());
+            }
+            else {
+                this->instruction(source.wide ? "movq" : "movl", source.text(), global.text());
+            }
+            break;
+        }
+        case IrOp::NewArray:
+            move(locationOf(instruction.operands[0]), Location::general(Rcx, false));
+            this->instruction("call", "cpp_rt_newarray");
+            move(Location::general(Rax, true), locationOf(value));
+            break;
+        case IrOp::LoadElement: {
+            std::string base;
+            emitElementAddress(instruction, base);
+            Location work = scratchFor(value);
+            this->instruction(floating ? "movsd" : "movl", "(" + base + ",%rcx,8)", work.text());
+            move(work, locationOf(value));
+            break;
+        }
+        case IrOp::StoreElement: {
+            std::string base;
+            emitElementAddress(instruction, base);
+            Location source = locationOf(instruction.operands[2]);
+            std::string element = "(" + base + ",%rcx,8)";
+            if (source.registerClass == RegisterClass::Float) {
+                if (source.kind != Location::Kind::Register) {
+                    move(source, Location::floating(floatScratch));
+                    source = Location::floating(floatScratch);
+                }
+                this->instruction("movsd", source.text(), element);
+            }
+            else {
+                if (source.kind == Location::Kind::Memory) {
+                    move(source, Location::general(Rdx, false));
+                    source = Location::general(Rdx, false);
+                }
+                this->instruction("movl", source.text(), element);
+            }
+            break;
+        }
+        case IrOp::ArrayMark: {
+            Location work = scratchFor(value);
+            this->instruction("movq", "cpp_array_top(%rip)", work.text());
+            move(work, locationOf(value));
+            break;
+        }
+        case IrOp::ArrayRelease: {
+            Location mark = locationOf(instruction.operands[0]);
+            if (mark.kind != Location::Kind::Register) {
+                move(mark, Location::general(Rax, true));
+                mark = Location::general(Rax, true);
+            }
+            this->instruction("movq", mark.text(), "cpp_array_top(%rip)");
+            break;
+        }
+        case IrOp::Call:
+            emitCall(value);
+            break;
+        case IrOp::Print:
+        case IrOp::PrintChar:
+            emitPrint(value);
+            break;
+        default:
+            throw RuntimeError(std::string("cannot compile IR instruction '") + irOpName(instruction.op) + "'");
+        }
+    }
+}
+
+AotCompiler::AotCompiler(RegisterStrategy strategy) : strategy_(strategy) {}
+
+void AotCompiler::compile(const IrModule& module, std::ostream& os) {
+    ParallelPassManager sequential;
+    compile(module, os, sequential);
+}
+
+void AotCompiler::compile(const IrModule& module, std::ostream& os, ParallelPassManager& passes) {
+    std::vector<ModuleState> states;
+    for (size_t i = 0; i < passes.jobs(); i++) {
+        states.push_back({ module, strategy_, {}, {} });
+    }
+    // 每个函数先生成到自己的缓冲区，再按函数编号依次输出
+    std::vector<std::string> functions(module.functions.size());
+    passes.run(module.functions.size(), [&](size_t index, size_t worker) {
+        std::ostringstream text;
+        FunctionEmitter(states[worker], static_cast<uint32_t>(index), text).emit();
+        functions[index] = text.str();
+    });
+    statistics_ = AotStatistics();
+    std::set<uint64_t> constants;
+    for (const ModuleState& state : states) {
+        statistics_.functions += state.statistics.functions;
+        statistics_.values += state.statistics.values;
+        statistics_.spilled += state.statistics.spilled;
+        statistics_.instructions += state.statistics.instructions;
+        constants.insert(state.constants.begin(), state.constants.end());
+    }
+
+    os << "# generated by CompilePP (" << (strategy_ == RegisterStrategy::Stack ? "stack" : "linear scan") << ")\n";
+    os << "\t.text\n";
+    for (const std::string& text : functions) {
+        os << text;
+    }
+
+    // C的入口：先初始化全局变量，再以main的返回值作为退出状态
+    os << "\n\t.globl\tmain\n";
+    os << "\t.type\tmain, @function\n";
+    os << "main:\n";
+    os << "\tpushq\t%rbp\n";
+    os << "\tmovq\t%rsp, %rbp\n";
+    os << "\tcall\t" << functionSymbol(module, module.initFunction) << "\n";
+    os << "\tcall\t" << functionSymbol(module, module.mainFunction) << "\n";
+    os << "\tpopq\t%rbp\n";
+    os << "\tret\n";
+    os << "\t.size\tmain, .-main\n\n";
+    os << runtimeSource;
+
+    if (!constants.empty()) {
+        os << "\n\t.section\t.rodata\n";
+        os << "\t.p2align\t3\n";
+        for (uint64_t bits : constants) {
+            double value;
+            std::memcpy(&value, &bits, sizeof(value));
+            os << constantName(bits) << ":\n\t.quad\t" << bits << "\t# " << value << "\n";
+        }
+    }
+    if (!module.globals.empty()) {
+        os << "\n\t.bss\n";
+        os << "\t.p2align\t3\n";
+        for (size_t i = 0; i < module.globals.size(); i++) {
+            os << "cpp_global_" << i << ":\n\t.zero\t8\n";
+        }
+    }
+    os << "\n\t.section\t.note.GNU-stack,\"\",@progbits\n";
+}
+
+void linkExecutable(const std::string& assemblyPath, const std::string& executablePath) {
+    std::string command = "cc -o \"" + executablePath + "\" \"" + assemblyPath + "\"";
+    if (std::system(command.c_str()) != 0) {
+        throw RuntimeError("'" + command + "' failed");
+    }
+}
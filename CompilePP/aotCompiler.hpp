@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include "ir.hpp"
+#include "parallelPasses.hpp"
+#include "regAlloc.hpp"
+
+// 值放在哪里：线性扫描分配寄存器，或者作为对照的朴素栈式代码生成——
+// 每个值都有自己的栈槽，每条指令把操作数读进临时寄存器、算完再写回，比较和分支也不合并
+enum class RegisterStrategy : uint8_t
+{
+    LinearScan,
+    Stack
+};
+
+struct AotStatistics {
+    size_t functions = 0;
+    size_t values = 0;          // 需要位置的SSA值
+    size_t spilled = 0;         // 其中放在栈槽中的
+    size_t instructions = 0;    // 生成的机器指令条数
+};
+
+// 把IR模块提前编译成GNU as（AT&T语法）的x86-64汇编，得到的文件用cc汇编、链接后就是独立的可执行文件。
+// 函数之间按System V调用约定传参（前6个整数参数和前8个double参数用寄存器，其余压栈），
+// 输出调用libc的printf和putchar，运行时错误在stderr上输出与虚拟机相同的信息后以状态1退出。
+// 数组放在一块静态的数组栈中，数组值是指向第一个元素的指针，长度存在它前面的8个字节里。
+// 与虚拟机不同，生成的代码不限制调用深度
+class AotCompiler {
+public:
+    explicit AotCompiler(RegisterStrategy strategy = RegisterStrategy::LinearScan);
+
+    AotCompiler(const AotCompiler&) = delete;
+    AotCompiler& operator=(const AotCompiler&) = delete;
+
+    void compile(const IrModule& module, std::ostream& os);
+    // 每个函数作为一个任务生成，输出与顺序生成时完全相同
+    void compile(const IrModule& module, std::ostream& os, ParallelPassManager& passes);
+
+    const AotStatistics& statistics() const {
+        return statistics_;
+    }
+
+private:
+    RegisterStrategy strategy_;
+    AotStatistics statistics_;
+};
+
+// 调用系统的cc把汇编文件汇编并链接成可执行文件，失败时抛出RuntimeError
+void linkExecutable(const std::string& assemblyPath, const std::string& executablePath);
@@ -1,6 +1,12 @@
 #pragma once
 #include <iostream>
 #include <vector>
+#include "memoryAccounting.hpp"
+
+// 名字解析之后的各阶段（类型检查、解释执行、字节码和IR生成）逐层递归遍历AST，能处理的最大深度。
+// 每层最多用几百字节的栈；右结合的链和很长的二元运算链不计入Parser的嵌套上限，由这个上限保护
+constexpr size_t astDepthLimit = 4096;
+
 // AST节点的类定义
 class ASTNode {
 public:
@@ -8,17 +14,42 @@ public:
     std::string value; // 节点值
     std::vector<ASTNode*> children; // 子节点列表
 
+    // 节点本身和两个字符串都记到AstNode分配点：委托构造时的临时AllocationScope一直存活到成员初始化完成
     ASTNode(const std::string& type, const std::string& value)
-        : type(type), value(value) {
+        : ASTNode(type, value, AllocationScope(AllocationSite::AstNode)) {
+    }
+
+    static void* operator new(size_t size) {
+        AllocationScope site(AllocationSite::AstNode);
+        return ::operator new(size);
+    }
+    static void operator delete(void* memory) {
+        ::operator delete(memory);
     }
 
     void addChild(ASTNode* child) {
+        AllocationScope site(AllocationSite::AstChildren);
         children.push_back(child);
     }
 
+    // 用显式的栈删除后代，很长的表达式链等很深的AST也不会因为递归析构耗尽栈
     ~ASTNode() {
-        for (auto child : children) {
-            delete child;
+        std::vector<ASTNode*> pending;
+        pending.swap(children);
+        while (!pending.empty()) {
+            ASTNode* node = pending.back();
+            pending.pop_back();
+            if (node == nullptr) {
+                continue;
+            }
+            pending.insert(pending.end(), node->children.begin(), node->children.end());
+            node->children.clear();
+            delete node;
         }
     }
+
+private:
+    ASTNode(const std::string& type, const std::string& value, const AllocationScope&)
+        : type(type), value(value) {
+    }
 };
@@ -0,0 +1,45 @@
+#include <array>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "astKind.hpp"
+
+namespace {
+    const char* const kindNames[] = {
+#define AST_NODE(name) #name,
+#include "astKind.def"
+#undef AST_NODE
+        "Token"
+    };
+
+    // 按长度分桶：大多数长度只有一两个候选，记号叶子的长度通常没有候选，比散列整个字符串快
+    constexpr size_t maxNameLength = 32;
+    using KindTable = std::array<std::vector<std::pair<std::string_view, NodeKind>>, maxNameLength + 1>;
+
+    KindTable buildKindTable() {
+        KindTable table;
+        for (size_t i = 0; i + 1 < nodeKindCount; i++) {
+            std::string_view name = kindNames[i];
+            table[name.size()].push_back({ name, static_cast<NodeKind>(i) });
+        }
+        return table;
+    }
+}
+
+NodeKind nodeKindOf(const ASTNode* node) {
+    static const KindTable table = buildKindTable();
+    const std::string& type = node->type;
+    if (type.size() > maxNameLength) {
+        return NodeKind::Token;
+    }
+    for (const auto& [name, kind] : table[type.size()]) {
+        if (name == type) {
+            return kind;
+        }
+    }
+    return NodeKind::Token;
+}
+
+const char* nodeKindName(NodeKind kind) {
+    return kindNames[static_cast<size_t>(kind)];
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <cstdint>
+#include "ast.hpp"
+
+// AST节点类型的枚举形式，遍历时每个节点只把type字符串换算一次，之后都按枚举值分派
+enum class NodeKind : uint8_t
+{
+#define AST_NODE(name) name,
+#include "astKind.def"
+#undef AST_NODE
+    Token
+};
+
+constexpr size_t nodeKindCount = static_cast<size_t>(NodeKind::Token) + 1;
+
+NodeKind nodeKindOf(const ASTNode* node);
+const char* nodeKindName(NodeKind kind);
@@ -1,46 +1,104 @@
 //hallo github
 #include "astParser.hpp"  // 语法分析器产生的头文件
 #include "newVector.cpp"
+#include "tokenSet.hpp"
 
 // 符号表见 https://www.runoob.com/cplusplus/cpp-operators.html
 // 公共接口，启动语法分析
 void Parser::parse() {
+    buildAST();
+}
+
+ASTNode* Parser::buildAST() {
     // 开始符号的递归调用
     translationUnit();
 
     // 判断是否成功解析了整个输入
     // 最后一个token是EOF
-    if (index == tokens.size() - 1) {
-        // 解析成功
-        std::cout << "Parsing successful!" << std::endl;
+    if (!stopped_ && getCurrentToken().type != TokenType::END_OF_FILE) {
+        // 解析失败，记录错误信息
+        error("P000", "Parsing failed! Unexpected token: " + tokens[index].lexeme);
     }
-    else {
-        // 解析失败，打印错误信息
-        std::cout << "Parsing failed! Unexpected token: "
-            << tokens[index].lexeme << std::endl;
+    if constexpr (parserProfilingEnabled) {
+        mergeParserProfile(profile_);
+        profile_ = {};
+    }
+    return ast;
+}
+
+// 从Token来源拉取，直到index处有Token
+void Parser::fetchTokens() {
+    while (index >= tokens.size() && source != nullptr) {
+        if (!source->fetch(tokens)) {
+            source = nullptr;
+        }
+    }
+    if (index >= tokens.size()) {
+        // 来源异常结束，补一个EOF保证分析能终止
+        size_t line = tokens.size() == 0 ? 1 : tokens[tokens.size() - 1].line;
+        tokens.push_back({ TokenType::END_OF_FILE, "EOF", line, 0, 0 });
+        index = tokens.size() - 1;
+    }
+}
+
+// 流水线模式下丢弃已经分析完的Token，使内存占用与文件大小无关
+// 只在外部声明之间调用，此时不会再回退到之前的Token
+void Parser::discardConsumedTokens() {
+    newVector<Token> rest;
+    rest.reserve(tokens.size() - index);
+    for (size_t i = index; i < tokens.size(); i++) {
+        rest.push_back(std::move(tokens[i]));
     }
+    tokens = std::move(rest);
+    index = 0;
 }
 
 // 辅助函数，获取当前标记
-Token Parser::getCurrentToken() const {
+const Token& Parser::getCurrentToken() {
+    if (index >= tokens.size()) {
+        fetchTokens();
+    }
     return tokens[index];
 }
 
 // 辅助函数，移动到下一个标记
 void Parser::consumeToken() {
-    index++;
+    if (index >= tokens.size()) {
+        fetchTokens();
+    }
+    // 停留在EOF上，错误恢复时不会越界
+    if (tokens[index].type != TokenType::END_OF_FILE) {
+        index++;
+        if constexpr (parserProfilingEnabled) {
+            consumed_++;
+        }
+    }
+}
+
+// 向前扫描后回到position，剖析时记一次回退
+void Parser::rewind(size_t position) {
+    if constexpr (parserProfilingEnabled) {
+        consumed_ -= index - position;
+        profile_.backtrack(index - position);
+    }
+    index = position;
 }
 
 // 辅助函数，移动到上一个标记
 void Parser::putBackToken() {
     index--;
+    if constexpr (parserProfilingEnabled) {
+        consumed_--;
+        profile_.backtrack(1);
+    }
 }
 
 DeclarationType Parser::isDeclarationOrFunctionDefinition() {
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::isDeclarationOrFunctionDefinition, consumed_);
     // 备份当前的标记位置
     size_t currentPosition = index;
 
-    if (getCurrentToken().type <= TokenType::NULLPTR && getCurrentToken().type >= TokenType::INTEGER) {
+    if (TokenSets::typeSpecifiers.contains(getCurrentToken().type)) {
         consumeToken();
     }
     else {
@@ -57,21 +115,145 @@ DeclarationType Parser::isDeclarationOrFunctionDefinition() {
 
     // 解析函数定义的声明符
     if (getCurrentToken().type == TokenType::LEFT_PAREN) {
-        index = currentPosition;
-        return DeclarationType::FunctionDefinition; // 是函数定义
+        // 跳过参数列表，后面是 '{' 的才是函数定义，否则是函数原型声明
+        // 遇到 ';'、'{'、'}' 时停止，参数列表不完整时扫描也不会越过当前声明
+        size_t depth = 0;
+        while (true) {
+            TokenType type = getCurrentToken().type;
+            if (type == TokenType::END_OF_FILE || type == TokenType::SEMICOLON
+                || type == TokenType::LEFT_BRACE || type == TokenType::RIGHT_BRACE) {
+                break;
+            }
+            consumeToken();
+            if (type == TokenType::LEFT_PAREN) {
+                depth++;
+            }
+            else if (type == TokenType::RIGHT_PAREN && --depth == 0) {
+                break;
+            }
+        }
+        bool isDefinition = getCurrentToken().type == TokenType::LEFT_BRACE;
+        rewind(currentPosition);
+        return isDefinition ? DeclarationType::FunctionDefinition : DeclarationType::Declaration;
     }
     //回退到之前的位置
-    index = currentPosition;
+    rewind(currentPosition);
     return DeclarationType::Declaration; // 是声明
 }
 
+// 在当前标记处记录一条语法错误
+void Parser::error(const std::string& code, const std::string& message) {
+    // 超过嵌套上限后分析直接跳到了末尾，各层缺少的 ')' '}' 等不再是有意义的错误
+    if (nestingExceeded_) {
+        return;
+    }
+    if (index >= tokens.size()) {
+        fetchTokens();
+    }
+    const Token& token = tokens[index];
+    diagnostics.report(Severity::Error, code, { token.line, token.column, token.line, token.column + token.lexeme.size() }, message);
+}
+
 // 创建AST节点
 ASTNode* Parser::createASTNode(const std::string& type, const std::string& value = "") {
     return new ASTNode(type, value);
 }
 
+// 进入一层嵌套的作用域，离开时恢复层数
+class Parser::NestingScope {
+public:
+    explicit NestingScope(Parser& parser) : parser_(parser), withinLimit_(parser.enterNesting()) {
+    }
+    ~NestingScope() {
+        parser_.nesting_--;
+    }
+
+    NestingScope(const NestingScope&) = delete;
+    NestingScope& operator=(const NestingScope&) = delete;
+
+    bool withinLimit() const {
+        return withinLimit_;
+    }
+
+private:
+    Parser& parser_;
+    bool withinLimit_;
+};
+
+// 层数加一；第一次超过上限时在当前Token处报告错误，并跳到输入末尾让各层尽快返回
+bool Parser::enterNesting() {
+    if (++nesting_ <= nestingLimit_) {
+        return true;
+    }
+    if (!nestingExceeded_) {
+        error("P028", "Nesting too deep: statements and expressions are nested more than "
+            + std::to_string(nestingLimit_) + " levels.");
+        nestingExceeded_ = true;
+        skipToEnd();
+    }
+    return false;
+}
+
+// 停在EOF上；流水线模式下不再拉取，剩下的Token由Token来源的所有者丢弃
+void Parser::skipToEnd() {
+    source = nullptr;
+    if (tokens.size() != 0 && tokens[tokens.size() - 1].type == TokenType::END_OF_FILE) {
+        index = tokens.size() - 1;
+        return;
+    }
+    index = tokens.size();
+    fetchTokens();
+}
+
+// 从栈顶到base，把node依次接到等待的父节点中，返回最外层的节点
+ASTNode* Parser::reducePending(size_t base, ASTNode* node) {
+    while (pending_.size() > base) {
+        PendingNode& pending = pending_.back();
+        ASTNode* parent = nullptr;
+        switch (pending.kind) {
+        case PendingKind::Assignment:
+            parent = createASTNode("AssignmentExpression", "");
+            parent->addChild(pending.first);
+            parent->addChild(createASTNode(pending.lexeme));
+            parent->addChild(node);
+            break;
+        case PendingKind::Conditional:
+            parent = createASTNode("ConditionalExpression");
+            parent->addChild(pending.first);
+            parent->addChild(pending.second);
+            parent->addChild(node);
+            break;
+        case PendingKind::Cast:
+            parent = createASTNode("CastExpression");
+            parent->addChild(createASTNode("("));
+            parent->addChild(pending.first);
+            parent->addChild(createASTNode(")"));
+            parent->addChild(node);
+            break;
+        case PendingKind::Unary:
+            parent = createASTNode("UnaryExpression");
+            parent->addChild(createASTNode(pending.lexeme));
+            parent->addChild(node);
+            break;
+        case PendingKind::Sizeof:
+            parent = createASTNode("SizeofExpression");
+            parent->addChild(createASTNode(pending.lexeme));
+            parent->addChild(node);
+            break;
+        case PendingKind::ElseIf:
+            parent = pending.first;
+            parent->addChild(node);
+            break;
+        }
+        pending_.pop_back();
+        node = parent;
+    }
+    return node;
+}
+
 // 连接子节点到父节点
 void Parser::connectChildren(ASTNode* parent, const std::vector<ASTNode*>& children) {
+    AllocationScope site(AllocationSite::AstChildren);
     for (auto child : children) {
         parent->children.push_back(child);
     }
@@ -79,14 +261,29 @@ void Parser::connectChildren(ASTNode* parent, const std::vector<ASTNode*>& child
 
 // 产生式规则：translation_unit -> external_declaration
 void Parser::translationUnit() {
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::translationUnit, consumed_);
     ast = createASTNode("ExternalDeclaration", "");
-    while (index < tokens.size() - 1) {
+    while (getCurrentToken().type != TokenType::END_OF_FILE) {
+        // 错误过多时停止分析，避免级联错误淹没输出
+        if (diagnostics.limitReached()) {
+            break;
+        }
+        if (source != nullptr) {
+            if (source->stopBefore(tokens[index])) {
+                stopped_ = true;
+                break;
+            }
+            if (index >= 4096) {
+                discardConsumedTokens();
+            }
+        }
         externalDeclaration();
     }
 }
 
 // 产生式规则：external_declaration -> function_definition | declaration
 void Parser::externalDeclaration() {
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::externalDeclaration, consumed_);
     ASTNode* functionDefinitionNode = createASTNode("PFunctionDefinitionNode","");
     ASTNode* declarationNode = createASTNode("PDeclarationNode","");
     // 判断式，不消耗Token
@@ -98,13 +295,15 @@ void Parser::externalDeclaration() {
 	}
     else {
 		// 错误处理
-		std::cout << "Expected declaration or function definition." << std::endl;
+		error("P001", "Expected declaration or function definition.");
+		// 跳过当前Token继续分析，否则translationUnit会在原地死循环
+		consumeToken();
 		return;
 	}
-    if (functionDefinitionNode->children.size() != 0) {
+    if (functionDefinitionNode != nullptr && functionDefinitionNode->children.size() != 0) {
         ast->addChild(functionDefinitionNode);
     }
-    if (declarationNode->children.size() != 0) {
+    if (declarationNode != nullptr && declarationNode->children.size() != 0) {
         ast->addChild(declarationNode);
     }
 
@@ -112,6 +311,7 @@ void Parser::externalDeclaration() {
 
 // 产生式规则：function_definition -> type_specifier direct_declarator compound_statement
 ASTNode* Parser::functionDefinition() {
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::functionDefinition, consumed_);
     ASTNode* functionDefinitionNode = createASTNode("FunctionDefinitionNode","");
 
     ASTNode* typeSpecifierNode = typeSpecifier();
@@ -127,6 +327,7 @@ ASTNode* Parser::functionDefinition() {
 
 // 产生式规则：declaration -> type_specifier init_declarator_list ';'
 ASTNode* Parser::declaration() {
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::declaration, consumed_);
     ASTNode* declarationNode = createASTNode("DeclarationNode","");
     ASTNode* typeSpecifierNode = typeSpecifier();
     ASTNode* initDeclaratorListNode = initDeclaratorList();
@@ -136,7 +337,7 @@ ASTNode* Parser::declaration() {
     }
     else {
         // 错误处理
-        std::cout << "Expected ';' at the end of declaration." << std::endl;
+        error("P002", "Expected ';' at the end of declaration.");
         return nullptr;
     }
 
@@ -148,6 +349,7 @@ ASTNode* Parser::declaration() {
 
 // 产生式规则：init_declarator_list -> init_declarator (',' init_declarator)*
 ASTNode* Parser::initDeclaratorList() {
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::initDeclaratorList, consumed_);
     ASTNode* initDeclaratorNode = initDeclarator();
     std::vector<ASTNode*> children = { initDeclaratorNode };
 
@@ -165,6 +367,7 @@ ASTNode* Parser::initDeclaratorList() {
 
 // 产生式规则：init_declarator -> direct_declarator ('=' initializer)?
 ASTNode* Parser::initDeclarator() {
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::initDeclarator, consumed_);
     ASTNode* declaratorNode = directDeclarator();
     ASTNode* initializerNode = nullptr;
 
@@ -186,6 +389,7 @@ ASTNode* Parser::initDeclarator() {
 //                                              | direct_declarator‘, ’identifier_list
 
 ASTNode* Parser::directDeclarator() {
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::directDeclarator, consumed_);
     ASTNode* directDeclaratorNode = createASTNode("DirectDeclarator", "");
 
     if (getCurrentToken().type == TokenType::IDENTIFIER) {
@@ -224,7 +428,7 @@ ASTNode* Parser::directDeclarator() {
     }
     else {
         // 错误处理
-        std::cout << "Expected identifier." << std::endl;
+        error("P003", "Expected identifier.");
         return nullptr;
     }
 
@@ -240,12 +444,14 @@ ASTNode* Parser::directDeclarator() {
 
 // 产生式规则：constant_expression ::= conditional_expression
 ASTNode* Parser::constantExpression() {
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::constantExpression, consumed_);
     return conditionalExpression();
 }
 
 
 // 产生式规则：parameter_list -> '(' parameter_declaration ')'
 ASTNode* Parser::parameterList() {
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::parameterList, consumed_);
     ASTNode* parameterListNode = createASTNode("ParameterList", "");
 
     connectChildren(parameterListNode, { parameterDeclaration() });
@@ -260,6 +466,7 @@ ASTNode* Parser::parameterList() {
 
 // 产生式规则：parameter_declaration -> declaration_specifiers identifier
 ASTNode* Parser::parameterDeclaration() {
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::parameterDeclaration, consumed_);
     // TODO:typeSpecifier() change to declarationSpecifiers()
     ASTNode* declarationSpecifiersNode = typeSpecifier();
 
@@ -275,7 +482,7 @@ ASTNode* Parser::parameterDeclaration() {
     }
     else {
         // 错误处理
-        std::cout << "Expected identifier in parameter declaration." << std::endl;
+        error("P004", "Expected identifier in parameter declaration.");
         // 其他错误处理逻辑，例如抛出异常或采取适当的措施
         return nullptr;
     }
@@ -293,9 +500,8 @@ ASTNode* Parser::parameterDeclaration() {
 
 // 产生式规则：type_specifier -> 'int' | 'float' | 'char'
 ASTNode* Parser::typeSpecifier() {
-    // TODO:Stupid Design, need to be improved
-    if (getCurrentToken().type <= TokenType::NULLPTR && getCurrentToken().type >= TokenType::INTEGER
-        ) {
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::typeSpecifier, consumed_);
+    if (TokenSets::typeSpecifiers.contains(getCurrentToken().type)) {
         std::string typeSpecifierValue = getCurrentToken().lexeme;
         consumeToken();
 
@@ -304,76 +510,69 @@ ASTNode* Parser::typeSpecifier() {
     }
     else {
         // 错误处理
-        std::cout << "Expected type specifier." << std::endl;
+        error("P005", "Expected type specifier.");
         return nullptr;
     }
 }
 
 // 产生式规则：initializer -> assignment_expression
 ASTNode* Parser::initializer() {
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::initializer, consumed_);
     return assignmentExpression();
 }
 
 // 产生式规则：assignment_expression ::= conditional_expression
 //| unary_expression assignment_operator assignment_expression
 ASTNode* Parser::assignmentExpression() {
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::assignmentExpression, consumed_);
+    // 括号、下标、参数和条件表达式中间的表达式都从这里进入，按一层嵌套计算
+    NestingScope nesting(*this);
+    if (!nesting.withinLimit()) {
+        return nullptr;
+    }
+    // 赋值是右结合的，左操作数和运算符压栈，最后一个操作数分析完后再从右向左构造
+    size_t base = pending_.size();
     ASTNode* exprNode = conditionalExpression();
-    auto isAssignmentOperator = [](TokenType type) {
-        // 返回true或false，表示是否是赋值操作符
-        return type == TokenType::ASSIGN || type == TokenType::PLUS_ASSIGN || type == TokenType::MINUS_ASSIGN
-            || type == TokenType::MULTIPLY_ASSIGN || type == TokenType::DIVIDE_ASSIGN || type == TokenType::MODULO_ASSIGN
-            ;
-    };
-    if (isAssignmentOperator(getCurrentToken().type)) {
-        Token operatorToken = getCurrentToken();
+    while (TokenSets::assignmentOperators.contains(getCurrentToken().type)) {
+        pending_.push_back({ PendingKind::Assignment, exprNode, nullptr, getCurrentToken().lexeme });
         consumeToken(); // 消耗赋值操作符
-
-        ASTNode* assignmentExprNode = assignmentExpression();
-
-        ASTNode* binaryExprNode = createASTNode("AssignmentExpression","");
-        binaryExprNode->addChild(exprNode);
-        binaryExprNode->addChild(createASTNode(operatorToken.lexeme));
-        binaryExprNode->addChild(assignmentExprNode);
-
-        exprNode = binaryExprNode;
+        exprNode = conditionalExpression();
     }
-
-    return exprNode;
+    return reducePending(base, exprNode);
 }
 
 //产生式规则:conditional_expression :: = logical_or_expression
 //         | logical_or_expression '?' expression ':' conditional_expression
 ASTNode* Parser::conditionalExpression() {
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::conditionalExpression, consumed_);
+    // 假分支中的条件表达式 a ? b : c ? d : e 用循环代替递归
+    size_t base = pending_.size();
     ASTNode* exprNode = logicalOrExpression();
-
-    if (getCurrentToken().type == TokenType::TERNARY) {
+    while (getCurrentToken().type == TokenType::TERNARY) {
         consumeToken(); // 消耗问号
 
         ASTNode* trueExprNode = expression();
 
         if (getCurrentToken().type != TokenType::COLON) {
-            // 错误处理：缺少冒号
-            std::cout << "Expected ':' in conditional expression." << std::endl;
-            return nullptr;
+            // 错误处理：缺少冒号，这一层的结果为空
+            error("P006", "Expected ':' in conditional expression.");
+            delete exprNode;
+            delete trueExprNode;
+            exprNode = nullptr;
+            break;
         }
         consumeToken(); // 消耗冒号
 
-        ASTNode* falseExprNode = conditionalExpression();
-
-        ASTNode* ternaryExprNode = createASTNode("ConditionalExpression");
-        ternaryExprNode->addChild(exprNode);
-        ternaryExprNode->addChild(trueExprNode);
-        ternaryExprNode->addChild(falseExprNode);
-
-        exprNode = ternaryExprNode;
+        pending_.push_back({ PendingKind::Conditional, exprNode, trueExprNode });
+        exprNode = logicalOrExpression();
     }
-
-    return exprNode;
+    return reducePending(base, exprNode);
 }
 
 // 产生式规则：logical_or_expression :: = logical_and_expression
 //          | logical_or_expression OR_OP logical_and_expression
 ASTNode* Parser::logicalOrExpression() {
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::logicalOrExpression, consumed_);
     ASTNode* exprNode = logicalAndExpression();
 
     while (getCurrentToken().type == TokenType::LOGICAL_OR) {
@@ -396,6 +595,7 @@ ASTNode* Parser::logicalOrExpression() {
 // 产生式规则：logical_and_expression :: = inclusive_or_expression
 //          | logical_and_expression AND_OP inclusive_or_expression
 ASTNode* Parser::logicalAndExpression() {
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::logicalAndExpression, consumed_);
     ASTNode* exprNode = inclusiveOrExpression();
 
     while (getCurrentToken().type == TokenType::LOGICAL_AND) {
@@ -418,6 +618,7 @@ ASTNode* Parser::logicalAndExpression() {
 // 产生式规则：inclusive_or_expression :: = exclusive_or_expression
 //          | inclusive_or_expression '|' exclusive_or_expression
 ASTNode* Parser::inclusiveOrExpression() {
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::inclusiveOrExpression, consumed_);
     ASTNode* exprNode = exclusiveOrExpression();
 
     while (getCurrentToken().type == TokenType::BITWISE_OR) {
@@ -441,6 +642,7 @@ ASTNode* Parser::inclusiveOrExpression() {
 // 产生式规则：exclusive_or_expression :: = and_expression
 //          | exclusive_or_expression '^' and_expression
 ASTNode* Parser::exclusiveOrExpression() {
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::exclusiveOrExpression, consumed_);
     ASTNode* exprNode = andExpression();
 
     while (getCurrentToken().type == TokenType::BITWISE_XOR) {
@@ -463,6 +665,7 @@ ASTNode* Parser::exclusiveOrExpression() {
 // 产生式规则：and_expression :: = equality_expression
 //          | and_expression '&' equality_expression
 ASTNode* Parser::andExpression() {
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::andExpression, consumed_);
     ASTNode* exprNode = equalityExpression();
 
     while (getCurrentToken().type == TokenType::BITWISE_AND) {
@@ -486,12 +689,9 @@ ASTNode* Parser::andExpression() {
 //          | equality_expression EQ_OP relational_expression
 //          | equality_expression NE_OP relational_expression
 ASTNode* Parser::equalityExpression() {
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::equalityExpression, consumed_);
     ASTNode* exprNode = relationalExpression();
-    auto isEqualityOperator = [](TokenType type) {
-        // 返回true或false，表示是否是相等性操作符
-        return type == TokenType::EQUAL || type == TokenType::NOT_EQUAL;
-    };
-    while (isEqualityOperator(getCurrentToken().type)) {
+    while (TokenSets::equalityOperators.contains(getCurrentToken().type)) {
         Token operatorToken = getCurrentToken();
         consumeToken(); // 消耗相等性操作符
 
@@ -514,13 +714,9 @@ ASTNode* Parser::equalityExpression() {
 //          | relational_expression LE_OP shift_expression
 //          | relational_expression GE_OP shift_expression
 ASTNode* Parser::relationalExpression() {
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::relationalExpression, consumed_);
 	ASTNode* exprNode = shiftExpression();
-    auto isRelationalOperator = [](TokenType type) {
-        // 返回true或false，表示是否是关系操作符
-        return type == TokenType::LESS_THAN || type == TokenType::GREATER_THAN ||
-            type == TokenType::LESS_THAN_OR_EQUAL_TO || type == TokenType::GREATER_THAN_OR_EQUAL_TO;
-    };
-    while (isRelationalOperator(getCurrentToken().type)) {
+    while (TokenSets::relationalOperators.contains(getCurrentToken().type)) {
 		Token operatorToken = getCurrentToken();
 		consumeToken(); // 消耗关系操作符
 
@@ -541,12 +737,9 @@ ASTNode* Parser::relationalExpression() {
 //          | shift_expression SHIFT_LEFT additive_expression
 //          | shift_expression SHIFT_RIGHT additive_expression
 ASTNode* Parser::shiftExpression() {
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::shiftExpression, consumed_);
 	ASTNode* exprNode = additiveExpression();
-    auto isShiftOperator = [](TokenType type) {
-        // 返回true或false，表示是否是移位操作符
-        return type == TokenType::SHIFT_LEFT || type == TokenType::SHIFT_RIGHT || type == TokenType::SHIFT_RIGHT_UNSIGNED;
-    };
-    while (isShiftOperator(getCurrentToken().type)) {
+    while (TokenSets::shiftOperators.contains(getCurrentToken().type)) {
 		Token operatorToken = getCurrentToken();
 		consumeToken(); // 消耗移位操作符
 
@@ -566,10 +759,11 @@ ASTNode* Parser::shiftExpression() {
 
 // 产生式规则：additive_expression -> multiplicative_expression (('+' | '-') multiplicative_expression)*
 ASTNode* Parser::additiveExpression() {
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::additiveExpression, consumed_);
     ASTNode* multiplicativeExpressionNode = multiplicativeExpression();
     std::vector<ASTNode*> children = { multiplicativeExpressionNode };
 
-    while (getCurrentToken().type == TokenType::PLUS || getCurrentToken().type == TokenType::MINUS) {
+    while (TokenSets::additiveOperators.contains(getCurrentToken().type)) {
         std::string operatorValue = getCurrentToken().lexeme;
         consumeToken();
 
@@ -582,54 +776,30 @@ ASTNode* Parser::additiveExpression() {
     return children.back();
 }
 
-// 产生式规则：multiplicative_expression -> primary_expression (('*' | '/') primary_expression)*
+// 产生式规则：multiplicative_expression -> cast_expression (('*' | '/' | '%') cast_expression)*
 ASTNode* Parser::multiplicativeExpression() {
-    ASTNode* primaryExpressionNode = primaryExpression();
-    std::vector<ASTNode*> children = { primaryExpressionNode };
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::multiplicativeExpression, consumed_);
+    ASTNode* castExpressionNode = castExpression();
+    std::vector<ASTNode*> children = { castExpressionNode };
 
-    while (getCurrentToken().type == TokenType::MULTIPLY || getCurrentToken().type == TokenType::DIVIDE) {
+    while (TokenSets::multiplicativeOperators.contains(getCurrentToken().type)) {
         std::string operatorValue = getCurrentToken().lexeme;
         consumeToken();
 
-        ASTNode* primaryExpressionNode = primaryExpression();
+        ASTNode* castExpressionNode = castExpression();
         ASTNode* multiplicativeExpressionNode = createASTNode("MultiplicativeExpression", operatorValue);
-        connectChildren(multiplicativeExpressionNode, { children.back(), primaryExpressionNode });
+        connectChildren(multiplicativeExpressionNode, { children.back(), castExpressionNode });
         children.back() = multiplicativeExpressionNode;
     }
 
     return children.back();
 }
 
-// TODO: castExpression
 // 产生式规则：cast_expression -> unary_expression | '(' type_name ')' cast_expression
+// '(' 后面是类型说明符时才是类型转换，否则是带括号的表达式，交给primary_expression
 ASTNode* Parser::castExpression() {
-    if (getCurrentToken().type == TokenType::LEFT_PAREN) {
-        consumeToken(); // 消耗左括号
-
-        ASTNode* typeNameNode = createASTNode("typenameTemp");//typeName();
-
-        if (getCurrentToken().type == TokenType::RIGHT_PAREN) {
-            consumeToken(); // 消耗右括号
-
-            ASTNode* castExprNode = castExpression();
-
-            ASTNode* castExpressionNode = createASTNode("CastExpression");
-            castExpressionNode->addChild(createASTNode("("));
-            castExpressionNode->addChild(typeNameNode);
-            castExpressionNode->addChild(createASTNode(")"));
-            castExpressionNode->addChild(castExprNode);
-
-            return castExpressionNode;
-        }
-        else {
-            // 错误处理：缺少右括号
-            std::cout << "Expected ')' after type name in cast expression." << std::endl;
-            return nullptr;
-        }
-    }
-    else {
-        return unaryExpression();
-    }
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::castExpression, consumed_);
+    return prefixExpression(true);
 }
 
 // 产生式规则：unary_expression -> postfix_expression
@@ -639,64 +809,90 @@ ASTNode* Parser::castExpression() {
 //          | SIZEOF unary_expression
 //          | SIZEOF '(' type_name ')'
 ASTNode* Parser::unaryExpression() {
-    auto isUnaryOperator = [](TokenType type) {
-        // 返回true或false，表示是否是一元操作符
-        return type == TokenType::PLUS || type == TokenType::MINUS || type == TokenType::NOT;
-    };
-    if (isUnaryOperator(getCurrentToken().type)) {
-        Token operatorToken = getCurrentToken();
-        consumeToken(); // 消耗一元操作符
-
-        ASTNode* castExprNode = castExpression();
-
-        ASTNode* unaryExprNode = createASTNode("UnaryExpression");
-        unaryExprNode->addChild(createASTNode(operatorToken.lexeme));
-        unaryExprNode->addChild(castExprNode);
-
-        return unaryExprNode;
-    }
-    // TODO:SIZEOF
-    else if (getCurrentToken().type == TokenType::SIZEOF) {
-        Token sizeofToken = getCurrentToken();
-        consumeToken(); // 消耗 sizeof 关键字
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::unaryExpression, consumed_);
+    return prefixExpression(false);
+}
 
-        if (getCurrentToken().type == TokenType::LEFT_PAREN) {
+// 连续的类型转换和前缀运算符，如 - (int) ++x：运算符依次压栈，分析完最内层的操作数后再从内向外构造。
+// allowCast为true时从cast_expression开始，'(' 后面是类型名时是类型转换；
+// 自增自减和sizeof的操作数是unary_expression，不能是类型转换
+ASTNode* Parser::prefixExpression(bool allowCast) {
+    size_t base = pending_.size();
+    ASTNode* operandNode = nullptr;
+    while (true) {
+        TokenType type = getCurrentToken().type;
+        if (allowCast && type == TokenType::LEFT_PAREN) {
             consumeToken(); // 消耗左括号
+            if (!TokenSets::typeSpecifiers.contains(getCurrentToken().type)) {
+                // 括号属于基本表达式
+                putBackToken();
+                allowCast = false;
+                continue;
+            }
 
-            ASTNode* typeNameNode = createASTNode("typenameTemp");//typeName();
-
-            if (getCurrentToken().type == TokenType::RIGHT_PAREN) {
-                consumeToken(); // 消耗右括号
-
-                ASTNode* sizeofExprNode = createASTNode("SizeofExpression");
-                sizeofExprNode->addChild(createASTNode(sizeofToken.lexeme));
-                sizeofExprNode->addChild(createASTNode("("));
-                sizeofExprNode->addChild(typeNameNode);
-                sizeofExprNode->addChild(createASTNode(")"));
+            ASTNode* typeNameNode = typeSpecifier();
 
-                return sizeofExprNode;
-            } else {
+            if (getCurrentToken().type != TokenType::RIGHT_PAREN) {
                 // 错误处理：缺少右括号
-                std::cout << "Expected ')' after type name in sizeof expression." << std::endl;
-                return nullptr;
+                delete typeNameNode;
+                error("P007", "Expected ')' after type name in cast expression.");
+                break;
             }
+            consumeToken(); // 消耗右括号
+            pending_.push_back({ PendingKind::Cast, typeNameNode });
         }
-        else {
-            ASTNode* unaryExprNode = createASTNode("SizeofExpression");
-            unaryExprNode->addChild(createASTNode(sizeofToken.lexeme));
-            unaryExprNode->addChild(castExpression());
+        else if (TokenSets::unaryOperators.contains(type)) {
+            pending_.push_back({ PendingKind::Unary, nullptr, nullptr, getCurrentToken().lexeme });
+            consumeToken(); // 消耗一元操作符
+            allowCast = true;
+        }
+        else if (TokenSets::incrementOperators.contains(type)) {
+            pending_.push_back({ PendingKind::Unary, nullptr, nullptr, getCurrentToken().lexeme });
+            consumeToken(); // 消耗自增或自减操作符
+            allowCast = false;
+        }
+        else if (type == TokenType::SIZEOF) {
+            std::string sizeofLexeme = getCurrentToken().lexeme;
+            consumeToken(); // 消耗 sizeof 关键字
+
+            if (getCurrentToken().type == TokenType::LEFT_PAREN) {
+                consumeToken(); // 消耗左括号
+                if (TokenSets::typeSpecifiers.contains(getCurrentToken().type)) {
+                    ASTNode* typeNameNode = typeSpecifier();
+
+                    if (getCurrentToken().type != TokenType::RIGHT_PAREN) {
+                        // 错误处理：缺少右括号
+                        delete typeNameNode;
+                        error("P008", "Expected ')' after type name in sizeof expression.");
+                        break;
+                    }
+                    consumeToken(); // 消耗右括号
 
-            return unaryExprNode;
+                    operandNode = createASTNode("SizeofExpression");
+                    operandNode->addChild(createASTNode(sizeofLexeme));
+                    operandNode->addChild(createASTNode("("));
+                    operandNode->addChild(typeNameNode);
+                    operandNode->addChild(createASTNode(")"));
+                    break;
+                }
+                // sizeof (expression)，括号属于操作数
+                putBackToken();
+            }
+            pending_.push_back({ PendingKind::Sizeof, nullptr, nullptr, sizeofLexeme });
+            allowCast = false;
+        }
+        else {
+            operandNode = postfixExpression();
+            break;
         }
     }
-    else {
-        return postfixExpression();
-    }
+    return reducePending(base, operandNode);
 }
 
 
 // 产生式规则：postfix_expression -> primary_expression (('[' expression ']') | ('(' ')') | ('(' argument_expression_list ')') | ('.' identifier) | ('->' identifier) | ('++') | ('--'))*
 ASTNode* Parser::postfixExpression() {
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::postfixExpression, consumed_);
     ASTNode* exprNode = primaryExpression();
 
     while (true) {
@@ -718,7 +914,7 @@ ASTNode* Parser::postfixExpression() {
             }
             else {
                 // 错误处理：缺少右方括号
-                std::cout << "Expected ']' after array index." << std::endl;
+                error("P009", "Expected ']' after array index.");
                 return nullptr;
             }
         }
@@ -738,7 +934,7 @@ ASTNode* Parser::postfixExpression() {
             else {
                 ASTNode* argExprListNode = argumentExpressionList();
 
-                if (getCurrentToken().type == TokenType::LEFT_PAREN) {
+                if (getCurrentToken().type == TokenType::RIGHT_PAREN) {
                     consumeToken(); // 消耗右括号
 
                     ASTNode* functionCallNode = createASTNode("FunctionCall");
@@ -751,12 +947,12 @@ ASTNode* Parser::postfixExpression() {
                 }
                 else {
                     // 错误处理：缺少右括号
-                    std::cout << "Expected ')' after function arguments." << std::endl;
+                    error("P010", "Expected ')' after function arguments.");
                     return nullptr;
                 }
             }
         }
-        else if (getCurrentToken().type == TokenType::DOT || getCurrentToken().type == TokenType::ARROW) {
+        else if (TokenSets::memberAccessOperators.contains(getCurrentToken().type)) {
             Token operatorToken = getCurrentToken();
             consumeToken(); // 消耗点号或箭头
 
@@ -773,11 +969,11 @@ ASTNode* Parser::postfixExpression() {
             }
             else {
                 // 错误处理：点号或箭头后缺少标识符
-                std::cout << "Expected identifier after '.' or '->'." << std::endl;
+                error("P011", "Expected identifier after '.' or '->'.");
                 return nullptr;
             }
         }
-        else if (getCurrentToken().type == TokenType::INCREMENT || getCurrentToken().type == TokenType::DECREMENT) {
+        else if (TokenSets::incrementOperators.contains(getCurrentToken().type)) {
             Token operatorToken = getCurrentToken();
             consumeToken(); // 消耗自增或自减操作符
 
@@ -798,6 +994,7 @@ ASTNode* Parser::postfixExpression() {
 
 // 产生式规则：argument_expression_list -> assignment_expression (',' assignment_expression)*
 ASTNode* Parser::argumentExpressionList() {
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::argumentExpressionList, consumed_);
     ASTNode* argExprListNode = createASTNode("ArgumentExpressionList");
 
     ASTNode* exprNode = assignmentExpression();
@@ -815,6 +1012,7 @@ ASTNode* Parser::argumentExpressionList() {
 
 // 产生式规则：primary_expression -> identifier | constant | string | '(' expression ')'
 ASTNode* Parser::primaryExpression() {
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::primaryExpression, consumed_);
     if (getCurrentToken().type == TokenType::IDENTIFIER || 
         getCurrentToken().type == TokenType::CONSTANT
         ) {
@@ -834,24 +1032,25 @@ ASTNode* Parser::primaryExpression() {
         }
         else {
             // 错误处理
-            std::cout << "Expected ')' in primary expression." << std::endl;
+            error("P012", "Expected ')' in primary expression.");
             return nullptr;
         }
     }
     else {
         // 错误处理
-        std::cout << "Expected identifier, constant, or '(' in primary expression." << std::endl;
+        error("P013", "Expected identifier, constant, or '(' in primary expression.");
         return nullptr;
     }
 }
 
 // 产生式规则：compound_statement -> '{' (declaration | statement)* '}'
 ASTNode* Parser::compoundStatement() {
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::compoundStatement, consumed_);
     if (getCurrentToken().type == TokenType::LEFT_BRACE) {
         consumeToken();
         std::vector<ASTNode*> children;
 
-        while (getCurrentToken().type != TokenType::RIGHT_BRACE && index < tokens.size()) {
+        while (getCurrentToken().type != TokenType::RIGHT_BRACE && getCurrentToken().type != TokenType::END_OF_FILE) {
             if (isDeclarationOrFunctionDefinition() == DeclarationType::Declaration) {
                 children.push_back(declaration());
             }
@@ -865,7 +1064,7 @@ ASTNode* Parser::compoundStatement() {
         }
         else {
             // 错误处理
-            std::cout << "Expected '}' at the end of compound statement." << std::endl;
+            error("P014", "Expected '}' at the end of compound statement.");
             return nullptr;
         }
 
@@ -875,24 +1074,30 @@ ASTNode* Parser::compoundStatement() {
     }
     else {
         // 错误处理
-        std::cout << "Expected '{' at the beginning of compound statement." << std::endl;
+        error("P015", "Expected '{' at the beginning of compound statement.");
         return nullptr;
     }
 }
 
 // 产生式规则：statement -> compound_statement | expression_statement
 ASTNode* Parser::statement() {
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::statement, consumed_);
+    // 复合语句和控制语句的语句体都从这里进入，按一层嵌套计算
+    NestingScope nesting(*this);
+    if (!nesting.withinLimit()) {
+        return nullptr;
+    }
     if (getCurrentToken().type == TokenType::LEFT_BRACE) {
         return compoundStatement();
     }
-    else if (getCurrentToken().type <= TokenType::RETURN && getCurrentToken().type >= TokenType::IF) {
+    else if (TokenSets::statementKeywords.contains(getCurrentToken().type)) {
         if (getCurrentToken().lexeme == "if") {
             return selectionStatement();
         }
         //else if (getCurrentToken().lexeme == "else") {
         //    return selectionStatement();
         //}
-        else if (getCurrentToken().lexeme == "while") {
+        else if (getCurrentToken().lexeme == "while" || getCurrentToken().lexeme == "for") {
             return iterationStatement();
         }
         else if (getCurrentToken().lexeme == "return") {
@@ -906,17 +1111,17 @@ ASTNode* Parser::statement() {
 		}
         else {
 			// 错误处理：不支持的语句类型
-			std::cout << "Unsupported statement type." << std::endl;
+			error("P016", "Unsupported statement type.");
 			consumeToken();
 			return nullptr;
 		}
     }
-    else if (getCurrentToken().type == TokenType::IDENTIFIER || getCurrentToken().type == TokenType::CONSTANT) {
+    else if (TokenSets::expressionStatementStarters.contains(getCurrentToken().type)) {
         return expressionStatement();
     }
     else {
         // 错误处理：不支持的语句类型
-        std::cout << "Unsupported statement type." << std::endl;
+        error("P016", "Unsupported statement type.");
         consumeToken();
         return nullptr;
     }
@@ -926,56 +1131,66 @@ ASTNode* Parser::statement() {
 //          | 'if' '(' exp ')' stat 'else' stat
 //          | 'switch' '(' exp ')' stat
 ASTNode* Parser::selectionStatement() {
-    if (getCurrentToken().type <= TokenType::RETURN && getCurrentToken().type >= TokenType::IF && getCurrentToken().lexeme == "if") {
-		consumeToken(); // 消耗关键字 if
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::selectionStatement, consumed_);
+    if (!TokenSets::statementKeywords.contains(getCurrentToken().type) || getCurrentToken().lexeme != "if") {
+        // 错误处理：不支持的语句类型
+        error("P016", "Unsupported statement type.");
+        consumeToken();
+        return nullptr;
+    }
+
+    // else if 链用循环代替递归：等待else分支的if语句压栈，链中最后一个if语句分析完后依次接上
+    size_t base = pending_.size();
+    ASTNode* selectionStmtNode = nullptr;
+    while (true) {
+        consumeToken(); // 消耗关键字 if
 
         if (getCurrentToken().type != TokenType::LEFT_PAREN) {
-			// 错误处理：期望左括号
-			std::cout << "Expected '(' after 'if' in selection statement." << std::endl;
-			return nullptr;
-		}
+            // 错误处理：期望左括号
+            error("P017", "Expected '(' after 'if' in selection statement.");
+            break;
+        }
 
-		consumeToken(); // 消耗左括号
+        consumeToken(); // 消耗左括号
 
-		ASTNode* selectionStmtNode = createASTNode("SelectionStatement", "");
-		connectChildren(selectionStmtNode, { expression() });
+        ASTNode* ifNode = createASTNode("SelectionStatement", "");
+        connectChildren(ifNode, { expression() });
 
         if (getCurrentToken().type != TokenType::RIGHT_PAREN) {
-			// 错误处理：期望右括号
-			std::cout << "Expected ')' after expression in selection statement." << std::endl;
-			return nullptr;
-		}
-
-		consumeToken(); // 消耗右括号
+            // 错误处理：期望右括号
+            error("P018", "Expected ')' after expression in selection statement.");
+            delete ifNode;
+            break;
+        }
 
-		ASTNode* ifStmtNode = statement();
-		selectionStmtNode->addChild(ifStmtNode);
+        consumeToken(); // 消耗右括号
 
-        if (getCurrentToken().type <= TokenType::RETURN && getCurrentToken().type >= TokenType::IF && getCurrentToken().lexeme == "else") {
-			consumeToken(); // 消耗关键字 else
+        ifNode->addChild(statement());
 
-			ASTNode* elseStmtNode = statement();
-			selectionStmtNode->addChild(elseStmtNode);
-		}
+        if (TokenSets::statementKeywords.contains(getCurrentToken().type) && getCurrentToken().lexeme == "else") {
+            consumeToken(); // 消耗关键字 else
 
-		return selectionStmtNode;
-	}
-    else {
-		// 错误处理：不支持的语句类型
-		std::cout << "Unsupported statement type." << std::endl;
-		consumeToken();
-		return nullptr;
-	}
+            if (TokenSets::statementKeywords.contains(getCurrentToken().type) && getCurrentToken().lexeme == "if") {
+                pending_.push_back({ PendingKind::ElseIf, ifNode });
+                continue;
+            }
+            ifNode->addChild(statement());
+        }
+        selectionStmtNode = ifNode;
+        break;
+    }
+    return reducePending(base, selectionStmtNode);
 }
 
 // 产生式规则：iteration_statement -> 'while' '(' expression ')' statement
 ASTNode* Parser::iterationStatement() {
-    if (getCurrentToken().type <= TokenType::RETURN && getCurrentToken().type >= TokenType::IF && getCurrentToken().lexeme == "while") {
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::iterationStatement, consumed_);
+    if (TokenSets::statementKeywords.contains(getCurrentToken().type) && getCurrentToken().lexeme == "while") {
         consumeToken(); // 消耗关键字 while
 
         if (getCurrentToken().type != TokenType::LEFT_PAREN) {
             // 错误处理：期望左括号
-            std::cout << "Expected '(' after 'while' in iteration statement." << std::endl;
+            error("P019", "Expected '(' after 'while' in iteration statement.");
             return nullptr;
         }
 
@@ -986,7 +1201,7 @@ ASTNode* Parser::iterationStatement() {
 
         if (getCurrentToken().type != TokenType::RIGHT_PAREN) {
             // 错误处理：期望右括号
-            std::cout << "Expected ')' after expression in iteration statement." << std::endl;
+            error("P020", "Expected ')' after expression in iteration statement.");
             return nullptr;
         }
 
@@ -994,43 +1209,49 @@ ASTNode* Parser::iterationStatement() {
         connectChildren(iterationStmtNode, { statement() });
         return iterationStmtNode;
     }
-    else if (getCurrentToken().type <= TokenType::RETURN && getCurrentToken().type >= TokenType::IF && getCurrentToken().lexeme == "for") {
+    else if (TokenSets::statementKeywords.contains(getCurrentToken().type) && getCurrentToken().lexeme == "for") {
         consumeToken(); // 消耗关键字 for
 
         if (getCurrentToken().type != TokenType::LEFT_PAREN) {
             // 错误处理：期望左括号
-            std::cout << "Expected '(' after 'for' in iteration statement." << std::endl;
+            error("P021", "Expected '(' after 'for' in iteration statement.");
             return nullptr;
         }
 
         consumeToken(); // 消耗左括号
 
-        ASTNode* iterationStmtNode = createASTNode("IterationStatement","");
-        ASTNode* expressionStmt1 = expressionStatement();
-        ASTNode* expressionStmt2 = expressionStatement();
+        // for语句的子节点依次为初始化、条件、步进和循环体，省略的部分是空的ExpressionNode
+        ASTNode* iterationStmtNode = createASTNode("IterationStatement", "for");
+        if (TokenSets::typeSpecifiers.contains(getCurrentToken().type)) {
+            connectChildren(iterationStmtNode, { declaration() });
+        }
+        else {
+            connectChildren(iterationStmtNode, { expressionStatement() });
+        }
+        connectChildren(iterationStmtNode, { expressionStatement() });
 
         if (getCurrentToken().type == TokenType::RIGHT_PAREN) {
             // for循环没有第三个表达式
-            consumeToken(); // 消耗右括号
+            connectChildren(iterationStmtNode, { createASTNode("ExpressionNode", "") });
         }
         else {
             connectChildren(iterationStmtNode, { expression() });
+        }
 
-            if (getCurrentToken().type != TokenType::RIGHT_PAREN) {
-                // 错误处理：期望右括号
-                std::cout << "Expected ')' after expression in iteration statement." << std::endl;
-                return nullptr;
-            }
-
-            consumeToken(); // 消耗右括号
+        if (getCurrentToken().type != TokenType::RIGHT_PAREN) {
+            // 错误处理：期望右括号
+            error("P020", "Expected ')' after expression in iteration statement.");
+            delete iterationStmtNode;
+            return nullptr;
         }
 
+        consumeToken(); // 消耗右括号
         connectChildren(iterationStmtNode, { statement() });
         return iterationStmtNode;
     }
     else {
         // 错误处理：不支持的迭代语句类型
-        std::cout << "Unsupported iteration statement type." << std::endl;
+        error("P022", "Unsupported iteration statement type.");
         consumeToken();
         return nullptr;
     }
@@ -1038,7 +1259,8 @@ ASTNode* Parser::iterationStatement() {
 
 // 产生式规则：jump_statement -> 'return' expression? ';' | 'break' ';' | 'continue' ';'
 ASTNode* Parser::jumpStatement() {
-    if (getCurrentToken().type <= TokenType::RETURN && getCurrentToken().type >= TokenType::IF && getCurrentToken().lexeme == "continue") {
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::jumpStatement, consumed_);
+    if (TokenSets::statementKeywords.contains(getCurrentToken().type) && getCurrentToken().lexeme == "continue") {
         consumeToken(); // 消耗关键字 continue
 
         if (getCurrentToken().type == TokenType::SEMICOLON) {
@@ -1047,11 +1269,11 @@ ASTNode* Parser::jumpStatement() {
         }
         else {
             // 错误处理：缺少分号
-            std::cout << "Expected ';' after 'continue' in jump statement." << std::endl;
+            error("P023", "Expected ';' after 'continue' in jump statement.");
             return nullptr;
         }
     }
-    else if (getCurrentToken().type <= TokenType::RETURN && getCurrentToken().type >= TokenType::IF && getCurrentToken().lexeme == "break") {
+    else if (TokenSets::statementKeywords.contains(getCurrentToken().type) && getCurrentToken().lexeme == "break") {
         consumeToken(); // 消耗关键字 break
 
         if (getCurrentToken().type == TokenType::SEMICOLON) {
@@ -1060,11 +1282,11 @@ ASTNode* Parser::jumpStatement() {
         }
         else {
             // 错误处理：缺少分号
-            std::cout << "Expected ';' after 'break' in jump statement." << std::endl;
+            error("P024", "Expected ';' after 'break' in jump statement.");
             return nullptr;
         }
     }
-    else if (getCurrentToken().type <= TokenType::RETURN && getCurrentToken().type >= TokenType::IF && getCurrentToken().lexeme == "return") {
+    else if (TokenSets::statementKeywords.contains(getCurrentToken().type) && getCurrentToken().lexeme == "return") {
         consumeToken(); // 消耗关键字 return
 
         if (getCurrentToken().type == TokenType::SEMICOLON) {
@@ -1080,7 +1302,7 @@ ASTNode* Parser::jumpStatement() {
             }
             else {
                 // 错误处理：缺少分号
-                std::cout << "Expected ';' after 'return' in jump statement." << std::endl;
+                error("P025", "Expected ';' after 'return' in jump statement.");
             }
 
             return jumpStmtNode;
@@ -1088,7 +1310,7 @@ ASTNode* Parser::jumpStatement() {
     }
     else {
         // 错误处理：不支持的跳转语句类型
-        std::cout << "Unsupported jump statement type." << std::endl;
+        error("P026", "Unsupported jump statement type.");
         consumeToken();
         return nullptr;
     }
@@ -1096,18 +1318,23 @@ ASTNode* Parser::jumpStatement() {
 
 // 产生式规则：expression_statement -> expression? ';'
 ASTNode* Parser::expressionStatement() {
-    ASTNode* expressionNode = createASTNode("ExpressionNode","");
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::expressionStatement, consumed_);
+    ASTNode* expressionNode = nullptr;
 
     if (getCurrentToken().type != TokenType::SEMICOLON) {
         expressionNode = expression();
     }
+    else {
+        // 空语句
+        expressionNode = createASTNode("ExpressionNode","");
+    }
 
     if (getCurrentToken().type == TokenType::SEMICOLON) {
         consumeToken();
     }
     else {
         // 错误处理
-        std::cout << "Expected ';' at the end of expression statement." << std::endl;
+        error("P027", "Expected ';' at the end of expression statement.");
     }
 
     return expressionNode;
@@ -1115,6 +1342,7 @@ ASTNode* Parser::expressionStatement() {
 
 // 产生式规则：expression ::= assignment_expression | expression ',' assignment_expression
 ASTNode* Parser::expression() {
+    RuleScope<parserProfilingEnabled> rule(profile_, ParserRule::expression, consumed_);
     ASTNode* exprNode = assignmentExpression();
 
     while (getCurrentToken().type == TokenType::COMMA) {
@@ -1,9 +1,13 @@
 #pragma once
 #include <string>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 #include "lexer.hpp"
 #include "newVector.hpp"
 #include "ast.hpp"
+#include "diagnostics.hpp"
+#include "parserProfile.hpp"
 extern struct Token;
 
 enum class DeclarationType
@@ -11,14 +15,48 @@ enum class DeclarationType
     Declaration, FunctionDefinition, ELSE
 };
 
+// 流水线模式下Parser的Token来源，Token用完时按批拉取
+class TokenSource {
+public:
+    virtual ~TokenSource() = default;
+    // 把下一批Token追加到tokens末尾；没有更多Token时返回false
+    virtual bool fetch(newVector<Token>& tokens) = 0;
+    // 分析器回到外部声明之间、即将从参数所指的Token开始分析下一个外部声明时询问；
+    // 返回true时分析到此为止，这个Token及之后的Token不再分析
+    virtual bool stopBefore(const Token&) {
+        return false;
+    }
+};
+
 class Parser {
 public:
-    Parser(const newVector<Token>& tokens)
-        : tokens(tokens), index(0), ast(nullptr) {
+    // 语句和表达式默认允许的嵌套层数，与常见编译器对括号嵌套的默认限制相同
+    static constexpr size_t defaultNestingLimit = 256;
+
+    Parser(const newVector<Token>& tokens, DiagnosticEngine& diagnostics)
+        : tokens(tokens), index(0), ast(nullptr), diagnostics(diagnostics), source(nullptr), consumed_(0),
+          nesting_(0), nestingLimit_(defaultNestingLimit), nestingExceeded_(false), stopped_(false) {
+    }
+    // 接管调用者不再使用的Token序列，省去一次复制
+    Parser(newVector<Token>&& tokens, DiagnosticEngine& diagnostics)
+        : tokens(std::move(tokens)), index(0), ast(nullptr), diagnostics(diagnostics), source(nullptr), consumed_(0),
+          nesting_(0), nestingLimit_(defaultNestingLimit), nestingExceeded_(false), stopped_(false) {
+    }
+    // 边接收Token边分析，已经分析完的外部声明对应的Token会被丢弃
+    Parser(TokenSource& source, DiagnosticEngine& diagnostics)
+        : index(0), ast(nullptr), diagnostics(diagnostics), source(&source), consumed_(0),
+          nesting_(0), nestingLimit_(defaultNestingLimit), nestingExceeded_(false), stopped_(false) {
+    }
+
+    // 语句和表达式最多嵌套的层数，超过时报告一条错误并停止分析，不会耗尽调用栈
+    void setNestingLimit(size_t limit) {
+        nestingLimit_ = limit;
     }
 
-    // 公共接口，启动语法分析
+    // 公共接口，启动语法分析；是否成功由调用者根据诊断信息报告
     void parse();
+    // 构建AST并返回根节点，供并行分析的子任务和流水线使用
+    ASTNode* buildAST();
     // 获取构建的AST
     ASTNode* getAST() const {
         return ast;
@@ -27,12 +65,51 @@ private:
     newVector<Token> tokens;  // 词法分析器产生的标记序列
     size_t index;  // 当前处理的标记索引
     ASTNode* ast;  // 抽象语法树的根节点
+    DiagnosticEngine& diagnostics;  // 诊断信息收集器
+    TokenSource* source;  // 流水线模式下的Token来源，拉取完毕后置空
+    // 逐产生式剖析，只在CPP_PARSER_PROFILE=1时占用空间；consumed_是净前进的Token数，丢弃Token后index会归零所以单独计数
+    [[no_unique_address]] std::conditional_t<parserProfilingEnabled, ParserProfile, DisabledParserProfile> profile_;
+    uint64_t consumed_;
+
+    // 右结合的链（a = b = c、条件表达式的假分支、else if）和连续的前缀运算符不递归分析，
+    // 已经分析的部分压入pending_，链结束后再从内向外构造节点；嵌套的分析共用这个栈，各自只处理base以上的部分。
+    // 链不递归，所以不计入嵌套上限；构造出的AST与链一样深，之后的各个阶段由自己的深度上限保护
+    enum class PendingKind : uint8_t {
+        Assignment,   // first = 左操作数，lexeme = 赋值运算符
+        Conditional,  // first = 条件，second = 真分支
+        Cast,         // first = 类型名
+        Unary,        // lexeme = 一元运算符或自增自减运算符
+        Sizeof,       // lexeme = sizeof
+        ElseIf,       // first = 等待else分支的if语句
+    };
+    struct PendingNode {
+        PendingKind kind;
+        ASTNode* first = nullptr;
+        ASTNode* second = nullptr;
+        std::string lexeme = {};
+    };
+    std::vector<PendingNode> pending_;
+
+    // 真正的嵌套（复合语句、控制语句的语句体、括号和参数中的表达式）仍然递归，由层数上限保护
+    class NestingScope;
+    size_t nesting_;
+    size_t nestingLimit_;
+    bool nestingExceeded_;  // 超过上限后跳到了输入末尾，之后的错误不再报告
+    bool stopped_;  // Token来源要求提前停止，剩下的Token不算分析失败
 
+    void fetchTokens();
+    void discardConsumedTokens();
+    void error(const std::string& code, const std::string& message);
     ASTNode* createASTNode(const std::string& type, const std::string& value);
-    Token getCurrentToken() const;
+    const Token& getCurrentToken();  // 流水线模式下拉取或丢弃Token后失效，需要保留时复制
     void connectChildren(ASTNode* parent, const std::vector<ASTNode*>& children);
     void consumeToken();
     void putBackToken();
+    void rewind(size_t position);
+    bool enterNesting();
+    void skipToEnd();
+    ASTNode* reducePending(size_t base, ASTNode* node);
+    ASTNode* prefixExpression(bool allowCast);
     void translationUnit();
     void externalDeclaration();
     DeclarationType isDeclarationOrFunctionDefinition();
@@ -0,0 +1,161 @@
+#include "astVisitor.hpp"
+
+template <typename Derived>
+AstVisitor<Derived>::AstVisitor() : frames_(&stack_) {
+}
+
+template <typename Derived>
+bool AstVisitor<Derived>::traverse(const ASTNode* root) {
+    stack_.clear();
+    frames_ = &stack_;
+    if (root == nullptr) {
+        return true;
+    }
+    if (!enter(root)) {
+        return false;
+    }
+    while (!stack_.empty()) {
+        Frame& frame = stack_.back();
+        if (frame.next != frame.end) {
+            const ASTNode* child = *frame.next++;
+            if (child != nullptr && !enter(child)) {
+                return false;
+            }
+            continue;
+        }
+        // 先出栈再调用leave，钩子中看到的深度和父节点与enter时相同
+        const ASTNode* node = frame.node;
+        NodeKind kind = frame.kind;
+        stack_.pop_back();
+        if (dispatchLeave(kind, node) == VisitAction::Stop) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename Derived>
+bool AstVisitor<Derived>::enter(const ASTNode* node) {
+    NodeKind kind = nodeKindOf(node);
+    VisitAction action = dispatchEnter(kind, node);
+    if (action == VisitAction::Stop) {
+        return false;
+    }
+    ASTNode* const* end = node->children.data() + node->children.size();
+    stack_.push_back({ node, action == VisitAction::SkipChildren ? end : node->children.data(), end, kind });
+    return true;
+}
+
+template <typename Derived>
+VisitAction AstVisitor<Derived>::dispatchEnter(NodeKind kind, const ASTNode* node) {
+    switch (kind) {
+#define AST_NODE(name) case NodeKind::name: return derived().enter##name(node);
+#include "astKind.def"
+#undef AST_NODE
+    default:
+        return derived().enterToken(node);
+    }
+}
+
+template <typename Derived>
+VisitAction AstVisitor<Derived>::dispatchLeave(NodeKind kind, const ASTNode* node) {
+    switch (kind) {
+#define AST_NODE(name) case NodeKind::name: return derived().leave##name(node);
+#include "astKind.def"
+#undef AST_NODE
+    default:
+        return derived().leaveToken(node);
+    }
+}
+
+template <typename Derived>
+size_t AstVisitor<Derived>::depth() const {
+    return frames_->size();
+}
+
+template <typename Derived>
+const ASTNode* AstVisitor<Derived>::parent() const {
+    return frames_->empty() ? nullptr : frames_->back().node;
+}
+
+template <typename... Passes>
+FusedVisitor<Passes...>::FusedVisitor(Passes&... passes)
+    : passes_(passes...), running_(0), active_(0) {
+}
+
+template <typename... Passes>
+bool FusedVisitor<Passes...>::traverse(const ASTNode* root) {
+    states_.fill(PassState::Running);
+    running_ = sizeof...(Passes);
+    active_ = sizeof...(Passes);
+    // 各Pass的depth()和parent()读融合遍历的栈
+    std::apply([this](auto&... pass) { ((pass.frames_ = &this->stack_), ...); }, passes_);
+    return AstVisitor<FusedVisitor<Passes...>>::traverse(root);
+}
+
+template <typename... Passes>
+VisitAction FusedVisitor<Passes...>::enterNode(NodeKind kind, const ASTNode* node) {
+    enterAll(kind, node, std::index_sequence_for<Passes...>{});
+    if (active_ == 0) {
+        return VisitAction::Stop;
+    }
+    return running_ == 0 ? VisitAction::SkipChildren : VisitAction::Continue;
+}
+
+template <typename... Passes>
+VisitAction FusedVisitor<Passes...>::leaveNode(NodeKind kind, const ASTNode* node) {
+    leaveAll(kind, node, std::index_sequence_for<Passes...>{});
+    return active_ == 0 ? VisitAction::Stop : VisitAction::Continue;
+}
+
+template <typename... Passes>
+template <size_t... I>
+void FusedVisitor<Passes...>::enterAll(NodeKind kind, const ASTNode* node, std::index_sequence<I...>) {
+    (enterPass<I>(kind, node), ...);
+}
+
+template <typename... Passes>
+template <size_t... I>
+void FusedVisitor<Passes...>::leaveAll(NodeKind kind, const ASTNode* node, std::index_sequence<I...>) {
+    (leavePass<I>(kind, node), ...);
+}
+
+template <typename... Passes>
+template <size_t I>
+void FusedVisitor<Passes...>::enterPass(NodeKind kind, const ASTNode* node) {
+    if (states_[I] != PassState::Running) {
+        return;
+    }
+    VisitAction action = std::get<I>(passes_).dispatchEnter(kind, node);
+    if (action == VisitAction::Stop) {
+        states_[I] = PassState::Stopped;
+        running_--;
+        active_--;
+    }
+    else if (action == VisitAction::SkipChildren) {
+        states_[I] = PassState::Skipping;
+        skipDepth_[I] = this->depth();
+        running_--;
+    }
+}
+
+template <typename... Passes>
+template <size_t I>
+void FusedVisitor<Passes...>::leavePass(NodeKind kind, const ASTNode* node) {
+    if (states_[I] == PassState::Stopped) {
+        return;
+    }
+    if (states_[I] == PassState::Skipping) {
+        // 还在被跳过的子树中
+        if (this->depth() != skipDepth_[I]) {
+            return;
+        }
+        states_[I] = PassState::Running;
+        running_++;
+    }
+    if (std::get<I>(passes_).dispatchLeave(kind, node) == VisitAction::Stop) {
+        states_[I] = PassState::Stopped;
+        running_--;
+        active_--;
+    }
+}
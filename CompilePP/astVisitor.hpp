@@ -0,0 +1,116 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "ast.hpp"
+#include "astKind.hpp"
+
+// 钩子的返回值：继续遍历、跳过当前节点的子树（离开钩子照常调用）、结束整个遍历
+enum class VisitAction : uint8_t
+{
+    Continue, SkipChildren, Stop
+};
+
+template <typename... Passes>
+class FusedVisitor;
+
+namespace astVisitorDetail {
+    // 遍历栈中的一项，与Visitor的类型无关，融合遍历时各Pass可以共用同一个栈
+    struct Frame {
+        const ASTNode* node;
+        ASTNode* const* next;   // 下一个要访问的子节点
+        ASTNode* const* end;
+        NodeKind kind;
+    };
+}
+
+// 静态分派的AST遍历（CRTP）：派生类按需定义 enterXxx(const ASTNode*) / leaveXxx(const ASTNode*)，
+// Xxx是astKind.def中的节点类型；没有定义的节点类型转到通用钩子 enterNode / leaveNode，默认什么都不做。
+// 分派在编译时确定，没有虚函数调用，也不再逐个比较type字符串。
+// 遍历用显式栈，深度优先、先序调用enter、后序调用leave，不受AST深度的递归限制
+template <typename Derived>
+class AstVisitor {
+public:
+    AstVisitor();
+
+    // 遍历以root为根的子树，被某个钩子返回Stop提前结束时返回false
+    bool traverse(const ASTNode* root);
+
+    // 按节点类型调用派生类的钩子，FusedVisitor借此把同一次遍历转给各个Pass
+    VisitAction dispatchEnter(NodeKind kind, const ASTNode* node);
+    VisitAction dispatchLeave(NodeKind kind, const ASTNode* node);
+
+    // 默认钩子
+    VisitAction enterNode(NodeKind, const ASTNode*) {
+        return VisitAction::Continue;
+    }
+    VisitAction leaveNode(NodeKind, const ASTNode*) {
+        return VisitAction::Continue;
+    }
+#define AST_NODE(name) \
+    VisitAction enter##name(const ASTNode* node) { return derived().enterNode(NodeKind::name, node); } \
+    VisitAction leave##name(const ASTNode* node) { return derived().leaveNode(NodeKind::name, node); }
+#include "astKind.def"
+#undef AST_NODE
+    VisitAction enterToken(const ASTNode* node) {
+        return derived().enterNode(NodeKind::Token, node);
+    }
+    VisitAction leaveToken(const ASTNode* node) {
+        return derived().leaveNode(NodeKind::Token, node);
+    }
+
+protected:
+    // 在钩子中使用：当前节点的深度（根为0）和父节点（根的父节点为nullptr）
+    size_t depth() const;
+    const ASTNode* parent() const;
+
+private:
+    template <typename... Passes>
+    friend class FusedVisitor;
+
+    using Frame = astVisitorDetail::Frame;
+    std::vector<Frame> stack_;
+    // 正在进行的遍历的栈，融合遍历时指向FusedVisitor的栈
+    const std::vector<Frame>* frames_;
+
+    Derived& derived() {
+        return static_cast<Derived&>(*this);
+    }
+    bool enter(const ASTNode* node);
+};
+
+// 把几个Pass融合到一次遍历中：每个节点只换算一次类型、只入栈一次，再依次调用各个Pass的钩子。
+// 每个Pass的SkipChildren和Stop只影响它自己：跳过子树的Pass在离开该节点之前不再收到钩子，
+// 结束的Pass不再收到任何钩子；所有Pass都跳过时不再进入子树，所有Pass都结束时遍历结束。
+// 各Pass在钩子中看到的depth()和parent()与单独遍历时相同
+template <typename... Passes>
+class FusedVisitor : public AstVisitor<FusedVisitor<Passes...>> {
+public:
+    explicit FusedVisitor(Passes&... passes);
+
+    bool traverse(const ASTNode* root);
+
+    VisitAction enterNode(NodeKind kind, const ASTNode* node);
+    VisitAction leaveNode(NodeKind kind, const ASTNode* node);
+
+private:
+    enum class PassState : uint8_t { Running, Skipping, Stopped };
+
+    std::tuple<Passes&...> passes_;
+    std::array<PassState, sizeof...(Passes)> states_;
+    std::array<size_t, sizeof...(Passes)> skipDepth_;   // 开始跳过的节点的深度
+    size_t running_;
+    size_t active_;     // 没有结束的Pass
+
+    template <size_t... I>
+    void enterAll(NodeKind kind, const ASTNode* node, std::index_sequence<I...>);
+    template <size_t... I>
+    void leaveAll(NodeKind kind, const ASTNode* node, std::index_sequence<I...>);
+    template <size_t I>
+    void enterPass(NodeKind kind, const ASTNode* node);
+    template <size_t I>
+    void leavePass(NodeKind kind, const ASTNode* node);
+};
@@ -0,0 +1,88 @@
+#include <condition_variable>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include "batchCompiler.hpp"
+#include "threadPool.hpp"
+
+namespace {
+    // 一个文件的编译结果，写出之后释放缓冲区
+    struct FileResult {
+        std::ostringstream out;
+        std::ostringstream err;
+        int exitCode = 0;
+        bool done = false;
+    };
+
+    void compileFile(const std::string& path, const CompileOptions& options, FileResult& result) {
+        // 线程池的工作线程不能再等待同一个池，文件内部的逐函数Pass在当前线程上顺序执行
+        ParallelPassManager sequential;
+        try {
+            result.exitCode = ::compileFile(path, options, sequential, result.out, result.err);
+        }
+        catch (const std::exception& exception) {
+            // 不让一个文件的意外错误影响其他文件
+            result.err << "Internal error: " << exception.what() << "\n";
+            result.exitCode = 1;
+        }
+    }
+}
+
+bool readResponseFile(const std::string& path, std::vector<std::string>& paths, std::string& error) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        error = "Failed to open response file: " + path;
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t begin = line.find_first_not_of(" \t\r");
+        if (begin == std::string::npos || line[begin] == '#') {
+            continue;
+        }
+        size_t end = line.find_last_not_of(" \t\r");
+        paths.push_back(line.substr(begin, end - begin + 1));
+    }
+    return true;
+}
+
+int compileBatch(const std::vector<std::string>& paths, const CompileOptions& options, size_t jobs,
+    std::ostream& out, std::ostream& err) {
+    std::vector<FileResult> results(paths.size());
+    std::mutex mutex;
+    std::condition_variable finished;
+
+    ThreadPool pool(jobs);
+    for (size_t i = 0; i < paths.size(); i++) {
+        pool.submit([&, i] {
+            compileFile(paths[i], options, results[i]);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                results[i].done = true;
+            }
+            finished.notify_all();
+        });
+    }
+
+    // 按输入顺序写出，前面的文件还没完成时等待，后面已经完成的文件留在缓冲区里
+    size_t failed = 0;
+    for (size_t i = 0; i < results.size(); i++) {
+        FileResult& result = results[i];
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            finished.wait(lock, [&result] { return result.done; });
+        }
+        out << result.out.str();
+        out.flush();
+        err << result.err.str();
+        err.flush();
+        result.out.str(std::string());
+        result.err.str(std::string());
+        failed += result.exitCode != 0 ? 1 : 0;
+    }
+    pool.wait();
+
+    out << "Batch: " << paths.size() << " files, " << failed << " failed\n";
+    return failed != 0 ? 1 : 0;
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "driver.hpp"
+
+// 读取响应文件：每行一个源文件路径，忽略空行和以#开头的行，路径追加到paths末尾；失败时返回false
+bool readResponseFile(const std::string& path, std::vector<std::string>& paths, std::string& error);
+
+// 批量编译：在同一个进程里用jobs个线程（0表示硬件线程数）同时编译多个源文件，省去逐个启动进程的开销。
+// 每个文件的结果和诊断先写进它自己的缓冲区，排在它前面的文件都写出之后再按输入顺序写到out和err，
+// 输出与线程数和完成顺序无关。每个文件内部的逐函数Pass在编译它的线程上顺序执行。
+// 有文件编译失败时返回1
+int compileBatch(const std::vector<std::string>& paths, const CompileOptions& options, size_t jobs,
+    std::ostream& out, std::ostream& err);
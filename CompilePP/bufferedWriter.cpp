@@ -0,0 +1,96 @@
+#include <charconv>
+#include "bufferedWriter.hpp"
+
+BufferedWriter::BufferedWriter(std::ostream& os, size_t capacity)
+    : os_(os), buffer_(new char[capacity < 64 ? 64 : capacity]), capacity_(capacity < 64 ? 64 : capacity), size_(0), drained_(0) {
+}
+
+BufferedWriter::~BufferedWriter() {
+    drain();
+}
+
+void BufferedWriter::writeUnsigned(uint64_t value) {
+    // 20位足够放下任何uint64_t
+    if (capacity_ - size_ < 20) {
+        drain();
+    }
+    char* end = std::to_chars(buffer_.get() + size_, buffer_.get() + capacity_, value).ptr;
+    size_ = static_cast<size_t>(end - buffer_.get());
+}
+
+void BufferedWriter::writeVarint(uint64_t value) {
+    if (capacity_ - size_ < 10) {
+        drain();
+    }
+    while (value >= 0x80) {
+        buffer_[size_++] = static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    buffer_[size_++] = static_cast<char>(value);
+}
+
+void BufferedWriter::writeJsonString(const std::string& text) {
+    static const char hex[] = "0123456789abcdef";
+    put('"');
+    // 不需要转义的连续字符整段复制
+    size_t run = 0;
+    for (size_t i = 0; i < text.size(); i++) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        write(text.data() + run, i - run);
+        run = i + 1;
+        switch (c) {
+        case '"': write("\\\""); break;
+        case '\\': write("\\\\"); break;
+        case '\n': write("\\n"); break;
+        case '\r': write("\\r"); break;
+        case '\t': write("\\t"); break;
+        default:
+            write("\\u00");
+            put(hex[c >> 4]);
+            put(hex[c & 0xF]);
+            break;
+        }
+    }
+    write(text.data() + run, text.size() - run);
+    put('"');
+}
+
+void BufferedWriter::fill(char c, size_t count) {
+    while (count > 0) {
+        if (size_ == capacity_) {
+            drain();
+        }
+        size_t chunk = capacity_ - size_ < count ? capacity_ - size_ : count;
+        std::memset(buffer_.get() + size_, c, chunk);
+        size_ += chunk;
+        count -= chunk;
+    }
+}
+
+void BufferedWriter::flush() {
+    drain();
+    os_.flush();
+}
+
+void BufferedWriter::drain() {
+    if (size_ != 0) {
+        os_.write(buffer_.get(), static_cast<std::streamsize>(size_));
+        drained_ += size_;
+        size_ = 0;
+    }
+}
+
+void BufferedWriter::writeLarge(const char* data, size_t size) {
+    drain();
+    if (size >= capacity_) {
+        // 比缓冲区还大的数据直接写出，不再复制
+        os_.write(data, static_cast<std::streamsize>(size));
+        drained_ += size;
+        return;
+    }
+    std::memcpy(buffer_.get(), data, size);
+    size_ = size;
+}
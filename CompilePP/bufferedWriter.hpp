@@ -0,0 +1,71 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+
+// 大缓冲区输出：攒满缓冲区才整块写给底层的流，从不按行刷新。
+// 整数直接格式化进缓冲区，JSON字符串边转义边写，输出过程中不分配内存
+class BufferedWriter {
+public:
+    static constexpr size_t defaultCapacity = 1 << 20;
+
+    explicit BufferedWriter(std::ostream& os, size_t capacity = defaultCapacity);
+    // 析构时写出剩余内容
+    ~BufferedWriter();
+
+    BufferedWriter(const BufferedWriter&) = delete;
+    BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+    void put(char c) {
+        if (size_ == capacity_) {
+            drain();
+        }
+        buffer_[size_++] = c;
+    }
+    void write(const char* data, size_t size) {
+        if (size <= capacity_ - size_) {
+            std::memcpy(buffer_.get() + size_, data, size);
+            size_ += size;
+        }
+        else {
+            writeLarge(data, size);
+        }
+    }
+    void write(const std::string& text) {
+        write(text.data(), text.size());
+    }
+    template <size_t N>
+    void write(const char (&literal)[N]) {
+        write(literal, N - 1);
+    }
+
+    // 十进制
+    void writeUnsigned(uint64_t value);
+    // 无符号LEB128，用于二进制格式
+    void writeVarint(uint64_t value);
+    // 带引号的JSON字符串，转义规则与诊断的JSON输出相同
+    void writeJsonString(const std::string& text);
+    // 连续count个字符c，用于缩进
+    void fill(char c, size_t count);
+
+    // 把缓冲区写给底层的流并刷新它；只在一段输出结束时调用
+    void flush();
+    // 已经写入的字节数（含缓冲区中的）
+    size_t written() const {
+        return drained_ + size_;
+    }
+
+private:
+    std::ostream& os_;
+    std::unique_ptr<char[]> buffer_;
+    size_t capacity_;
+    size_t size_;
+    size_t drained_;    // 已经交给底层流的字节数
+
+    // 只把缓冲区交给底层流，不刷新
+    void drain();
+    void writeLarge(const char* data, size_t size);
+};
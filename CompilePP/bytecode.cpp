@@ -0,0 +1,48 @@
+#include <iomanip>
+#include "bytecode.hpp"
+
+namespace {
+    const char* const opcodeNames[] = {
+#define BYTECODE_OP(name, format) #name,
+#include "bytecode.def"
+#undef BYTECODE_OP
+    };
+
+    const char* const opcodeFormats[] = {
+#define BYTECODE_OP(name, format) format,
+#include "bytecode.def"
+#undef BYTECODE_OP
+    };
+
+    void printOperand(std::ostream& os, char kind, uint16_t value, const BytecodeProgram& program) {
+        switch (kind) {
+        case 'r': os << " r" << value; break;
+        case 'i': os << " #" << static_cast<int16_t>(value); break;
+        case 'k': os << " k" << value; break;
+        case 'g': os << " g" << value; break;
+        case 'f': os << " " << program.functions[value].name; break;
+        case 't': os << " @" << value; break;
+        default: break;
+        }
+    }
+}
+
+const char* opcodeName(Opcode op) {
+    return opcodeNames[static_cast<size_t>(op)];
+}
+
+void disassemble(const BytecodeProgram& program, std::ostream& os) {
+    for (const BytecodeFunction& function : program.functions) {
+        os << function.name << ": " << function.parameterCount << " parameter(s), "
+            << function.registerCount << " register(s)\n";
+        for (size_t pc = 0; pc < function.code.size(); pc++) {
+            const Instruction& instruction = function.code[pc];
+            const char* format = opcodeFormats[static_cast<size_t>(instruction.op)];
+            os << std::setw(6) << pc << "  " << opcodeName(instruction.op);
+            printOperand(os, format[0], instruction.a, program);
+            printOperand(os, format[1], instruction.b, program);
+            printOperand(os, format[2], instruction.c, program);
+            os << "\n";
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "runtimeValue.hpp"
+
+enum class Opcode : uint8_t
+{
+#define BYTECODE_OP(name, format) name,
+#include "bytecode.def"
+#undef BYTECODE_OP
+    Count
+};
+
+// 定长8字节的指令，操作数的含义见bytecode.def
+struct Instruction {
+    Opcode op;
+    uint16_t a;
+    uint16_t b;
+    uint16_t c;
+};
+
+// 数组在数组栈上的位置
+struct ArrayRef {
+    uint32_t offset;
+    uint32_t length;
+};
+
+// 寄存器、全局变量和数组元素共用的无标签值，类型由编译器静态确定
+// char和bool以int保存，float以double保存
+union BytecodeValue {
+    int32_t i;
+    double d;
+    ArrayRef array;
+    uint64_t bits;
+};
+
+struct BytecodeFunction {
+    std::string name;
+    uint32_t parameterCount;   // 参数在寄存器0..parameterCount-1
+    uint32_t registerCount;    // 局部变量槽位加临时寄存器
+    std::vector<Instruction> code;
+};
+
+struct BytecodeProgram {
+    std::vector<BytecodeFunction> functions;
+    std::vector<BytecodeValue> constants;
+    uint32_t globalCount = 0;
+    uint32_t initFunction = 0;  // 初始化全局变量的函数
+    uint32_t mainFunction = 0;
+};
+
+const char* opcodeName(Opcode op);
+// 按bytecode.def中的格式输出所有函数的指令
+void disassemble(const BytecodeProgram& program, std::ostream& os);
@@ -0,0 +1,1043 @@
+#include <string>
+#include "bytecodeCompiler.hpp"
+
+namespace {
+    const ASTNode* childAt(const ASTNode* node, size_t index) {
+        return node != nullptr && index < node->children.size() ? node->children[index] : nullptr;
+    }
+
+    const char* const printBuiltin = "print";
+    constexpr uint32_t operandLimit = 0xFFFF;
+
+    bool fitsImmediate(int32_t value) {
+        return value >= INT16_MIN && value <= INT16_MAX;
+    }
+
+    // 能编码成立即数的int常量
+    bool immediateOf(const ASTNode* node, int32_t& value) {
+        RuntimeValue constant;
+        if (node == nullptr || node->type != "PrimaryExpression" || !parseConstant(node->value, constant) ||
+            constant.type != ValueType::Int || !fitsImmediate(constant.intValue)) {
+            return false;
+        }
+        value = constant.intValue;
+        return true;
+    }
+
+    bool declaresArray(const ASTNode* declaration) {
+        const ASTNode* list = childAt(declaration, 1);
+        if (declaration == nullptr || declaration->type != "DeclarationNode" || list == nullptr) {
+            return false;
+        }
+        for (const ASTNode* initDeclarator : list->children) {
+            const ASTNode* marker = childAt(childAt(initDeclarator, 0), 0);
+            if (marker != nullptr && marker->type == "ArrayDeclarator") {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+BytecodeCompiler::BytecodeCompiler()
+    : resolver_(nullptr), checker_(nullptr), function_(nullptr), returnType_(ValueType::Int), nextRegister_(0) {
+}
+
+BytecodeProgram BytecodeCompiler::compile(const ASTNode* root) {
+    program_ = BytecodeProgram();
+    if (root == nullptr) {
+        throw RuntimeError("no program to compile");
+    }
+    NameResolver resolver;
+    resolver.resolve(root);
+    if (!resolver.redeclarations().empty()) {
+        throw RuntimeError("redeclared identifier '" + resolver.redeclarations().front().declarator->value + "'");
+    }
+    resolver_ = &resolver;
+    // 表达式的类型和数组长度都从类型检查的结果中读取
+    TypeChecker checker(resolver);
+    checker.check(root);
+    if (!checker.errors().empty()) {
+        throw RuntimeError(checker.errors().front().message);
+    }
+    checker_ = &checker;
+    if (resolver.globalCount() > operandLimit || resolver.functionCount() >= operandLimit) {
+        throw RuntimeError("program has too many globals or functions for the bytecode encoding");
+    }
+
+    // 函数按符号槽位编号，最后一个是初始化全局变量的函数
+    program_.globalCount = resolver.globalCount();
+    program_.functions.resize(resolver.functionCount() + 1);
+    program_.initFunction = resolver.functionCount();
+    program_.functions[program_.initFunction].name = "<init>";
+    signatures_.assign(resolver.functionCount(), { ValueType::Int, {}, false });
+    bool hasMain = false;
+    for (const Symbol& symbol : resolver.symbols()) {
+        if (symbol.kind != SymbolKind::Function) {
+            continue;
+        }
+        Signature& signature = signatures_[symbol.slot];
+        BytecodeFunction& function = program_.functions[symbol.slot];
+        function.name = resolver.names().name(symbol.name);
+        signature.returnType = typeOf(symbol.type);
+        signature.defined = symbol.definition != nullptr;
+        const ASTNode* parameters = childAt(childAt(symbol.definition, 1), 2);
+        if (parameters != nullptr) {
+            for (const ASTNode* parameter : parameters->children) {
+                signature.parameters.push_back(typeOf(childAt(parameter, 0)));
+            }
+        }
+        function.parameterCount = static_cast<uint32_t>(signature.parameters.size());
+        if (symbol.depth == 0 && function.name == "main" && signature.defined) {
+            if (!signature.parameters.empty()) {
+                throw RuntimeError("main must not take parameters");
+            }
+            program_.mainFunction = symbol.slot;
+            hasMain = true;
+        }
+    }
+    if (!hasMain) {
+        throw RuntimeError("program has no main function");
+    }
+
+    // 文件作用域的声明按出现顺序编进初始化函数
+    BytecodeFunction& init = program_.functions[program_.initFunction];
+    for (const ASTNode* declaration : root->children) {
+        if (declaration == nullptr) {
+            continue;
+        }
+        if (declaration->type == "FunctionDefinitionNode") {
+            compileFunction(declaration);
+        }
+        else if (declaration->type == "DeclarationNode") {
+            function_ = &init;
+            nextRegister_ = 0;
+            loops_.clear();
+            arrayMarks_.clear();
+            compileDeclaration(declaration, true);
+        }
+        else {
+            throw RuntimeError("unsupported external declaration '" + declaration->type + "'");
+        }
+    }
+    function_ = &init;
+    emit(Opcode::ReturnVoid);
+    if (init.code.size() > operandLimit) {
+        throw RuntimeError("global initializers are too large for the bytecode encoding");
+    }
+    resolver_ = nullptr;
+    checker_ = nullptr;
+    function_ = nullptr;
+    return std::move(program_);
+}
+
+// FunctionDefinitionNode: TypeSpecifier DirectDeclarator CompoundStatement
+void BytecodeCompiler::compileFunction(const ASTNode* node) {
+    const ASTNode* declarator = childAt(node, 1);
+    const Symbol* symbol = resolver_->declarationOf(childAt(declarator, 1));
+    if (symbol == nullptr || symbol->definition != node) {
+        throw RuntimeError("malformed function definition");
+    }
+    function_ = &program_.functions[symbol->slot];
+    returnType_ = signatures_[symbol->slot].returnType;
+    loops_.clear();
+    arrayMarks_.clear();
+    nextRegister_ = symbol->frameSize;
+    function_->registerCount = symbol->frameSize;
+
+    // 参数最先声明，占用槽位0..n-1，调用者直接把实参放在被调函数栈帧的这些寄存器里
+    const ASTNode* parameters = childAt(declarator, 2);
+    if (parameters != nullptr) {
+        for (size_t i = 0; i < parameters->children.size(); i++) {
+            const Symbol* parameter = resolver_->declarationOf(childAt(parameters->children[i], 1));
+            if (parameter == nullptr || parameter->slot != i) {
+                throw RuntimeError("malformed parameter list of '" + function_->name + "'");
+            }
+        }
+    }
+    compileStatement(childAt(node, 2), true);
+    emit(Opcode::ReturnVoid);
+    if (function_->code.size() > operandLimit) {
+        throw RuntimeError("function '" + function_->name + "' is too large for the bytecode encoding");
+    }
+}
+
+void BytecodeCompiler::compileStatement(const ASTNode* node, bool functionBody) {
+    if (node == nullptr) {
+        throw RuntimeError("incomplete syntax tree");
+    }
+    uint32_t mark = nextRegister_;
+    const std::string& type = node->type;
+    if (type == "CompoundStatement") {
+        // 块里声明了数组时，离开块要释放数组；函数体不需要，返回时会恢复数组栈
+        bool releases = false;
+        if (!functionBody) {
+            for (const ASTNode* child : node->children) {
+                releases = releases || declaresArray(child);
+            }
+        }
+        uint16_t arrayMark = 0;
+        if (releases) {
+            arrayMark = allocRegister();
+            emit(Opcode::ArrayMark, arrayMark);
+            arrayMarks_.push_back(arrayMark);
+        }
+        for (const ASTNode* child : node->children) {
+            compileStatement(child);
+        }
+        if (releases) {
+            emit(Opcode::ArrayRelease, arrayMark);
+            arrayMarks_.pop_back();
+        }
+    }
+    else if (type == "DeclarationNode") {
+        compileDeclaration(node, false);
+    }
+    else if (type == "ExpressionNode") {
+        // 空语句
+    }
+    else if (type == "SelectionStatement") {
+        // SelectionStatement: expression statement statement?
+        std::vector<size_t> elseJumps;
+        compileBranch(childAt(node, 0), false, elseJumps);
+        compileStatement(childAt(node, 1));
+        if (node->children.size() > 2) {
+            std::vector<size_t> endJumps = { emit(Opcode::Jump) };
+            patch(elseJumps);
+            compileStatement(node->children[2]);
+            patch(endJumps);
+        }
+        else {
+            patch(elseJumps);
+        }
+    }
+    else if (type == "IterationStatement") {
+        bool isFor = node->value == "for";
+        const ASTNode* init = isFor ? childAt(node, 0) : nullptr;
+        const ASTNode* condition = childAt(node, isFor ? 1 : 0);
+        const ASTNode* step = isFor ? childAt(node, 2) : nullptr;
+        const ASTNode* body = childAt(node, isFor ? 3 : 1);
+
+        uint16_t arrayMark = 0;
+        bool releases = declaresArray(init);
+        if (releases) {
+            arrayMark = allocRegister();
+            emit(Opcode::ArrayMark, arrayMark);
+            arrayMarks_.push_back(arrayMark);
+        }
+        if (init != nullptr) {
+            compileStatement(init);
+        }
+        size_t top = function_->code.size();
+        loops_.push_back({ {}, {}, arrayMarks_.size() });
+        std::vector<size_t> exitJumps;
+        if (condition != nullptr && condition->type != "ExpressionNode") {
+            compileBranch(condition, false, exitJumps);
+        }
+        compileStatement(body);
+        Loop loop = std::move(loops_.back());
+        loops_.pop_back();
+        patch(loop.continues);
+        if (step != nullptr && step->type != "ExpressionNode") {
+            compileEffect(step);
+        }
+        patchTo({ emit(Opcode::Jump) }, top);
+        patch(exitJumps);
+        patch(loop.breaks);
+        if (releases) {
+            emit(Opcode::ArrayRelease, arrayMark);
+            arrayMarks_.pop_back();
+        }
+    }
+    else if (type == "JumpStatement") {
+        if (node->value == "return") {
+            if (node->children.empty()) {
+                emit(Opcode::ReturnVoid);
+            }
+            else {
+                uint16_t value = allocRegister();
+                compileInto(node->children[0], value, returnType_);
+                emit(Opcode::Return, value);
+            }
+        }
+        else {
+            compileLoopExit(node->value == "break");
+        }
+    }
+    else {
+        compileEffect(node);
+    }
+    nextRegister_ = mark;
+}
+
+void BytecodeCompiler::compileLoopExit(bool isBreak) {
+    if (loops_.empty()) {
+        throw RuntimeError(std::string("'") + (isBreak ? "break" : "continue") + "' outside of a loop");
+    }
+    Loop& loop = loops_.back();
+    // 跳出循环体内声明了数组的块时，先释放其中最外层块之后分配的数组
+    if (arrayMarks_.size() > loop.arrayBlocks) {
+        emit(Opcode::ArrayRelease, arrayMarks_[loop.arrayBlocks]);
+    }
+    (isBreak ? loop.breaks : loop.continues).push_back(emit(Opcode::Jump));
+}
+
+// DeclarationNode: TypeSpecifier InitDeclaratorList
+// 与Interpreter相同：逗号后面的名字是同一类型的标量，初始化表达式属于最后一个名字
+void BytecodeCompiler::compileDeclaration(const ASTNode* node, bool global) {
+    ValueType type = typeOf(childAt(node, 0));
+    const ASTNode* list = childAt(node, 1);
+    if (list == nullptr) {
+        return;
+    }
+    for (const ASTNode* initDeclarator : list->children) {
+        const ASTNode* declarator = childAt(initDeclarator, 0);
+        const ASTNode* initializer = childAt(initDeclarator, 1);
+        if (declarator == nullptr || declarator->children.empty() || declarator->children[0] == nullptr) {
+            throw RuntimeError("incomplete syntax tree");
+        }
+        const std::string& marker = declarator->children[0]->type;
+        std::vector<const Symbol*> scalars;
+        size_t next = 0;
+        if (marker == "ArrayDeclarator") {
+            const Symbol* symbol = resolver_->declarationOf(childAt(declarator, 1));
+            if (symbol == nullptr) {
+                throw RuntimeError("malformed declaration");
+            }
+            if (initializer != nullptr && declarator->children.size() == 3) {
+                throw RuntimeError("array initializers are not supported");
+            }
+            uint32_t mark = nextRegister_;
+            const ASTNode* lengthNode = childAt(declarator, 2);
+            Operand length = compileExpression(lengthNode, -1);
+            if (global) {
+                uint16_t array = allocRegister();
+                emit(Opcode::NewArray, array, length.reg);
+                emit(Opcode::StoreGlobal, symbol->slot, array);
+            }
+            else {
+                emit(Opcode::NewArray, symbol->slot, length.reg);
+            }
+            nextRegister_ = mark;
+            next = 3;
+        }
+        else if (marker == "FunctionDeclarator") {
+            next = 3;
+        }
+        for (size_t i = next; i < declarator->children.size(); i++) {
+            const Symbol* symbol = resolver_->declarationOf(declarator->children[i]);
+            if (symbol == nullptr) {
+                throw RuntimeError("malformed declaration");
+            }
+            scalars.push_back(symbol);
+        }
+        if (initializer != nullptr && scalars.empty()) {
+            throw RuntimeError("initializer on a function declaration");
+        }
+        for (size_t i = 0; i < scalars.size(); i++) {
+            uint32_t mark = nextRegister_;
+            uint16_t reg = global ? allocRegister() : static_cast<uint16_t>(scalars[i]->slot);
+            if (initializer != nullptr && i + 1 == scalars.size()) {
+                compileInto(initializer, reg, type);
+            }
+            else {
+                // 没有初值的变量置为零，与Interpreter一致
+                emit(Opcode::LoadInt, reg, 0);
+            }
+            if (global) {
+                emit(Opcode::StoreGlobal, scalars[i]->slot, reg);
+            }
+            nextRegister_ = mark;
+        }
+    }
+}
+
+// 值不被使用的表达式：自增自减编译成IncI，不需要保留旧值
+void BytecodeCompiler::compileEffect(const ASTNode* node) {
+    uint32_t mark = nextRegister_;
+    if (node != nullptr && (node->type == "UnaryExpression" || node->type == "PostfixExpression") && node->children.size() == 2) {
+        bool postfix = node->type == "PostfixExpression";
+        const ASTNode* op = node->children[postfix ? 1 : 0];
+        if (op != nullptr && (op->type == "++" || op->type == "--")) {
+            compileIncrement(node->children[postfix ? 0 : 1], op->type == "++" ? 1 : -1, false);
+            nextRegister_ = mark;
+            return;
+        }
+    }
+    compileExpression(node, -1);
+    nextRegister_ = mark;
+}
+
+// 条件为jumpIf时跳转，跳转指令的位置加入jumps，由调用者回填目标
+void BytecodeCompiler::compileBranch(const ASTNode* node, bool jumpIf, std::vector<size_t>& jumps) {
+    if (node == nullptr) {
+        throw RuntimeError("incomplete syntax tree");
+    }
+    uint32_t mark = nextRegister_;
+    const std::string& type = node->type;
+    const ASTNode* op = childAt(node, 1);
+
+    RuntimeValue constant;
+    if (type == "PrimaryExpression" && parseConstant(node->value, constant)) {
+        if (isTruthy(constant) == jumpIf) {
+            jumps.push_back(emit(Opcode::Jump));
+        }
+        return;
+    }
+    if ((type == "LogicalAndExpression" || type == "LogicalOrExpression") && op != nullptr) {
+        // a && b 为假、a || b 为真时都可以只看左边的结果
+        bool shortCircuit = type == "LogicalAndExpression" ? false : true;
+        if (jumpIf == shortCircuit) {
+            compileBranch(childAt(node, 0), jumpIf, jumps);
+            compileBranch(childAt(node, 2), jumpIf, jumps);
+        }
+        else {
+            std::vector<size_t> skip;
+            compileBranch(childAt(node, 0), shortCircuit, skip);
+            compileBranch(childAt(node, 2), jumpIf, jumps);
+            patch(skip);
+        }
+        return;
+    }
+    if (type == "UnaryExpression" && childAt(node, 0) != nullptr && node->children[0]->type == "!") {
+        compileBranch(childAt(node, 1), !jumpIf, jumps);
+        return;
+    }
+    if ((type == "RelationalExpression" || type == "EqualityExpression") && op != nullptr) {
+        BinaryOp comparison;
+        if (!binaryOpFromLexeme(op->type, comparison)) {
+            throw RuntimeError("unsupported operator '" + op->type + "'");
+        }
+        Operand left = compileExpression(childAt(node, 0), -1);
+        Operand right = compileExpression(childAt(node, 2), -1);
+        if (left.type == ValueType::Int && right.type == ValueType::Int) {
+            // 把a > b、a >= b改写成b < a、b <= a；条件为真时跳转等价于相反条件不成立时跳转
+            uint16_t a = left.reg;
+            uint16_t b = right.reg;
+            if (comparison == BinaryOp::Greater || comparison == BinaryOp::GreaterEqual) {
+                std::swap(a, b);
+                comparison = comparison == BinaryOp::Greater ? BinaryOp::Less : BinaryOp::LessEqual;
+            }
+            Opcode opcode;
+            if (!jumpIf) {
+                opcode = comparison == BinaryOp::Less ? Opcode::JumpUnlessLtI
+                    : comparison == BinaryOp::LessEqual ? Opcode::JumpUnlessLeI
+                    : comparison == BinaryOp::Equal ? Opcode::JumpUnlessEqI : Opcode::JumpUnlessNeI;
+            }
+            else {
+                // a < b 成立 <=> !(b <= a)
+                if (comparison == BinaryOp::Less || comparison == BinaryOp::LessEqual) {
+                    std::swap(a, b);
+                }
+                opcode = comparison == BinaryOp::Less ? Opcode::JumpUnlessLeI
+                    : comparison == BinaryOp::LessEqual ? Opcode::JumpUnlessLtI
+                    : comparison == BinaryOp::Equal ? Opcode::JumpUnlessNeI : Opcode::JumpUnlessEqI;
+            }
+            jumps.push_back(emit(opcode, a, b));
+        }
+        else {
+            uint16_t result = allocRegister();
+            emitBinary(comparison, left, right, result);
+            jumps.push_back(emit(jumpIf ? Opcode::JumpIfTrue : Opcode::JumpIfFalse, result));
+        }
+        nextRegister_ = mark;
+        return;
+    }
+
+    Operand value = compileExpression(node, -1);
+    if (value.type != ValueType::Int) {
+        uint16_t truth = allocRegister();
+        emit(Opcode::DoubleToBool, truth, value.reg);
+        value = { truth, ValueType::Int };
+    }
+    jumps.push_back(emit(jumpIf ? Opcode::JumpIfTrue : Opcode::JumpIfFalse, value.reg));
+    nextRegister_ = mark;
+}
+
+// 编译表达式，结果可能直接在hint指定的寄存器里，也可能在局部变量或临时寄存器里
+// 只有最后一条指令写hint，所以hint是表达式中读到的局部变量也没有问题
+BytecodeCompiler::Operand BytecodeCompiler::compileExpression(const ASTNode* node, int32_t hint) {
+    if (node == nullptr) {
+        throw RuntimeError("incomplete syntax tree");
+    }
+    const std::string& type = node->type;
+    if (type == "PrimaryExpression") {
+        RuntimeValue constant;
+        if (parseConstant(node->value, constant)) {
+            uint16_t dest = target(hint);
+            emitConstant(dest, constant);
+            return { dest, constant.type };
+        }
+        const Symbol& symbol = symbolOf(node);
+        if (symbol.kind == SymbolKind::Function || symbol.kind == SymbolKind::Array) {
+            throw RuntimeError(std::string(symbol.kind == SymbolKind::Function ? "function '" : "array '") + node->value + "' used as a value");
+        }
+        Place place = compilePlace(node);
+        return load(place, hint);
+    }
+    if (type == "AdditiveExpression" || type == "MultiplicativeExpression") {
+        return compileBinary(node, node->value, childAt(node, 0), childAt(node, 1), hint);
+    }
+    if (type == "LogicalAndExpression" || type == "LogicalOrExpression") {
+        return compileLogical(node, hint);
+    }
+    if (type == "ShiftExpression" || type == "RelationalExpression" || type == "EqualityExpression" ||
+        type == "AndExpression" || type == "ExclusiveOrExpression" || type == "InclusiveOrExpression") {
+        const ASTNode* op = childAt(node, 1);
+        if (op == nullptr) {
+            throw RuntimeError("incomplete syntax tree");
+        }
+        return compileBinary(node, op->type, childAt(node, 0), childAt(node, 2), hint);
+    }
+    if (type == "AssignmentExpression") {
+        return compileAssignment(node);
+    }
+    if (type == "ConditionalExpression") {
+        return compileConditional(node, hint);
+    }
+    if (type == "CommaExpression") {
+        uint32_t mark = nextRegister_;
+        compileExpression(childAt(node, 0), -1);
+        nextRegister_ = mark;
+        return compileExpression(childAt(node, 1), hint);
+    }
+    if (type == "UnaryExpression" || type == "PostfixExpression") {
+        return compileUnary(node, hint);
+    }
+    if (type == "CastExpression") {
+        // CastExpression: '(' TypeSpecifier ')' operand
+        ValueType castType = typeOf(childAt(node, 1));
+        uint16_t dest = target(hint);
+        uint32_t mark = nextRegister_;
+        Operand operand = compileExpression(childAt(node, 3), dest);
+        emitConvert(dest, operand, castType);
+        nextRegister_ = mark;
+        return { dest, promotedType(castType) };
+    }
+    if (type == "SizeofExpression") {
+        return compileSizeof(node, hint);
+    }
+    if (type == "ArrayAccess") {
+        uint16_t dest = target(hint);
+        uint32_t mark = nextRegister_;
+        Place place = compilePlace(node);
+        Operand value = load(place, dest);
+        nextRegister_ = mark;
+        return value;
+    }
+    if (type == "FunctionCall") {
+        return compileCall(node, hint);
+    }
+    throw RuntimeError("unsupported expression '" + type + "'");
+}
+
+void BytecodeCompiler::compileInto(const ASTNode* node, uint16_t dest, ValueType type) {
+    uint32_t mark = nextRegister_;
+    Operand value = compileExpression(node, dest);
+    emitConvert(dest, value, type);
+    nextRegister_ = mark;
+}
+
+BytecodeCompiler::Operand BytecodeCompiler::compileBinary(const ASTNode* node, const std::string& op, const ASTNode* left, const ASTNode* right, int32_t hint) {
+    BinaryOp binary;
+    if (!binaryOpFromLexeme(op, binary)) {
+        throw RuntimeError("unsupported operator '" + op + "' in " + node->type);
+    }
+    uint16_t dest = target(hint);
+    uint32_t mark = nextRegister_;
+    Operand leftValue = compileExpression(left, -1);
+    int32_t immediate;
+    Operand result;
+    if ((binary == BinaryOp::Add || binary == BinaryOp::Sub) && leftValue.type == ValueType::Int &&
+        immediateOf(right, immediate) && fitsImmediate(-immediate)) {
+        // 加减常量：AddImmI
+        emit(Opcode::AddImmI, dest, leftValue.reg, static_cast<uint16_t>(binary == BinaryOp::Add ? immediate : -immediate));
+        result = { dest, ValueType::Int };
+    }
+    else {
+        Operand rightValue = compileExpression(right, -1);
+        result = emitBinary(binary, leftValue, rightValue, dest);
+    }
+    nextRegister_ = mark;
+    return result;
+}
+
+// &&、||的值：先按条件跳转，再在两个出口分别写入1和0
+BytecodeCompiler::Operand BytecodeCompiler::compileLogical(const ASTNode* node, int32_t hint) {
+    uint16_t dest = target(hint);
+    uint32_t mark = nextRegister_;
+    std::vector<size_t> falseJumps;
+    compileBranch(node, false, falseJumps);
+    emit(Opcode::LoadInt, dest, 1);
+    std::vector<size_t> endJumps = { emit(Opcode::Jump) };
+    patch(falseJumps);
+    emit(Opcode::LoadInt, dest, 0);
+    patch(endJumps);
+    nextRegister_ = mark;
+    return { dest, ValueType::Int };
+}
+
+// ConditionalExpression: condition ? whenTrue : whenFalse，两个分支都转换成常用算术转换之后的类型
+BytecodeCompiler::Operand BytecodeCompiler::compileConditional(const ASTNode* node, int32_t hint) {
+    ValueType type = checker_->valueTypeOf(node);
+    uint16_t dest = target(hint);
+    uint32_t mark = nextRegister_;
+    std::vector<size_t> falseJumps;
+    compileBranch(childAt(node, 0), false, falseJumps);
+    compileInto(childAt(node, 1), dest, type);
+    std::vector<size_t> endJumps = { emit(Opcode::Jump) };
+    patch(falseJumps);
+    compileInto(childAt(node, 2), dest, type);
+    patch(endJumps);
+    nextRegister_ = mark;
+    return { dest, type };
+}
+
+// AssignmentExpression: target operator value
+BytecodeCompiler::Operand BytecodeCompiler::compileAssignment(const ASTNode* node) {
+    const ASTNode* op = childAt(node, 1);
+    if (op == nullptr) {
+        throw RuntimeError("incomplete syntax tree");
+    }
+    // 局部变量直接写自己的寄存器，其余情况先算到新的临时寄存器再存回去。
+    // 所以不接受hint：hint可能是下标里读到的变量，例如 i = a[i] = 5
+    const ASTNode* targetNode = childAt(node, 0);
+    const Symbol* symbol = targetNode != nullptr && targetNode->type == "PrimaryExpression" ? resolver_->bindingOf(targetNode) : nullptr;
+    bool local = symbol != nullptr && symbol->depth != 0 && (symbol->kind == SymbolKind::Variable || symbol->kind == SymbolKind::Parameter);
+    uint16_t dest = local ? static_cast<uint16_t>(symbol->slot) : allocRegister();
+    uint32_t mark = nextRegister_;
+    Place place = compilePlace(targetNode);
+    ValueType valueType = promotedType(place.type);
+
+    if (op->type == "=") {
+        compileInto(childAt(node, 2), dest, place.type);
+    }
+    else {
+        BinaryOp binary;
+        if (!binaryOpFromLexeme(op->type, binary)) {
+            throw RuntimeError("unsupported assignment operator '" + op->type + "'");
+        }
+        int32_t immediate;
+        if (place.kind == Place::Kind::Local && place.type == ValueType::Int &&
+            (binary == BinaryOp::Add || binary == BinaryOp::Sub) && immediateOf(childAt(node, 2), immediate) && fitsImmediate(-immediate)) {
+            emit(Opcode::IncI, dest, static_cast<uint16_t>(binary == BinaryOp::Add ? immediate : -immediate));
+        }
+        else {
+            Operand current = load(place, -1);
+            Operand value = compileExpression(childAt(node, 2), -1);
+            Operand result = emitBinary(binary, current, value, dest);
+            emitConvert(dest, result, place.type);
+        }
+    }
+    if (place.kind != Place::Kind::Local) {
+        store(place, dest);
+    }
+    nextRegister_ = mark;
+    return { dest, valueType };
+}
+
+// ++/--：局部int变量编译成IncI，其余情况读出、加减、转换后存回
+BytecodeCompiler::Operand BytecodeCompiler::compileIncrement(const ASTNode* operand, int32_t delta, bool postfix) {
+    const Symbol* symbol = operand != nullptr && operand->type == "PrimaryExpression" ? resolver_->bindingOf(operand) : nullptr;
+    bool local = symbol != nullptr && symbol->depth != 0 && (symbol->kind == SymbolKind::Variable || symbol->kind == SymbolKind::Parameter);
+    // 后缀形式的旧值和非局部变量的新值放在新分配的寄存器里，理由同compileAssignment
+    uint16_t dest = local && !postfix ? static_cast<uint16_t>(symbol->slot) : allocRegister();
+    uint32_t mark = nextRegister_;
+    RuntimeValue constant;
+    if (operand == nullptr || (operand->type != "PrimaryExpression" && operand->type != "ArrayAccess") ||
+        (operand->type == "PrimaryExpression" && parseConstant(operand->value, constant))) {
+        throw RuntimeError(std::string("operand of '") + (delta > 0 ? "++" : "--") + "' is not assignable");
+    }
+    Place place = compilePlace(operand);
+    ValueType valueType = promotedType(place.type);
+
+    if (place.kind == Place::Kind::Local && place.type == ValueType::Int) {
+        if (postfix) {
+            emit(Opcode::Move, dest, place.reg);
+        }
+        emit(Opcode::IncI, place.reg, static_cast<uint16_t>(delta));
+        nextRegister_ = mark;
+        return { dest, ValueType::Int };
+    }
+
+    Operand current = load(place, -1);
+    if (postfix) {
+        emit(Opcode::Move, dest, current.reg);
+    }
+    uint16_t updated = place.kind == Place::Kind::Local ? place.reg : (postfix ? allocRegister() : dest);
+    Operand result;
+    if (current.type == ValueType::Int) {
+        emit(Opcode::AddImmI, updated, current.reg, static_cast<uint16_t>(delta));
+        result = { updated, ValueType::Int };
+    }
+    else {
+        uint16_t step = allocRegister();
+        emitConstant(step, RuntimeValue::ofDouble(delta));
+        result = emitBinary(BinaryOp::Add, current, { step, ValueType::Double }, updated);
+        if (current.type == ValueType::Float) {
+            emit(Opcode::RoundFloat, updated, updated);
+            result.type = ValueType::Float;
+        }
+    }
+    emitConvert(updated, result, place.type);
+    if (place.kind != Place::Kind::Local) {
+        store(place, updated);
+    }
+    nextRegister_ = mark;
+    return { postfix ? dest : updated, postfix ? current.type : valueType };
+}
+
+// UnaryExpression: op operand；PostfixExpression: operand op
+BytecodeCompiler::Operand BytecodeCompiler::compileUnary(const ASTNode* node, int32_t hint) {
+    bool postfix = node->type == "PostfixExpression";
+    const ASTNode* op = childAt(node, postfix ? 1 : 0);
+    const ASTNode* operandNode = childAt(node, postfix ? 0 : 1);
+    if (op == nullptr) {
+        throw RuntimeError("incomplete syntax tree");
+    }
+    if (op->type == "++" || op->type == "--") {
+        return compileIncrement(operandNode, op->type == "++" ? 1 : -1, postfix);
+    }
+    if (op->type == "+") {
+        return compileExpression(operandNode, hint);
+    }
+
+    uint16_t dest = target(hint);
+    uint32_t mark = nextRegister_;
+    Operand operand = compileExpression(operandNode, -1);
+    Operand result = { dest, ValueType::Int };
+    if (op->type == "-") {
+        emit(operand.type == ValueType::Int ? Opcode::NegI : Opcode::NegD, dest, operand.reg);
+        result.type = operand.type;
+    }
+    else if (op->type == "!") {
+        emit(operand.type == ValueType::Int ? Opcode::NotI : Opcode::NotD, dest, operand.reg);
+    }
+    else if (op->type == "~") {
+        if (operand.type != ValueType::Int) {
+            throw RuntimeError("invalid operand of floating type to '~'");
+        }
+        emit(Opcode::BitNotI, dest, operand.reg);
+    }
+    else {
+        throw RuntimeError("unsupported operator '" + op->type + "'");
+    }
+    nextRegister_ = mark;
+    return result;
+}
+
+// FunctionCall: callee '(' ArgumentExpressionList? ')'
+// 实参依次编译到连续的寄存器中，被调函数的栈帧从第一个实参开始
+BytecodeCompiler::Operand BytecodeCompiler::compileCall(const ASTNode* node, int32_t hint) {
+    const ASTNode* callee = childAt(node, 0);
+    if (callee == nullptr || callee->type != "PrimaryExpression") {
+        throw RuntimeError("unsupported function call");
+    }
+    const ASTNode* list = node->children.size() == 4 ? node->children[2] : nullptr;
+    size_t count = list != nullptr ? list->children.size() : 0;
+    const Symbol* symbol = resolver_->bindingOf(callee);
+
+    uint16_t dest = target(hint);
+    uint32_t mark = nextRegister_;
+    if (symbol == nullptr && callee->value == printBuiltin) {
+        for (size_t i = 0; i < count; i++) {
+            Operand value = compileExpression(list->children[i], -1);
+            if (i != 0) {
+                emit(Opcode::PrintSpace);
+            }
+            emit(value.type == ValueType::Int ? Opcode::PrintInt : Opcode::PrintDouble, value.reg);
+            nextRegister_ = mark;
+        }
+        emit(Opcode::PrintNewline);
+        emit(Opcode::LoadInt, dest, 0);
+        return { dest, ValueType::Int };
+    }
+    if (symbol == nullptr) {
+        throw RuntimeError("undeclared function '" + callee->value + "'");
+    }
+    if (symbol->kind != SymbolKind::Function) {
+        throw RuntimeError("'" + callee->value + "' is not a function");
+    }
+    const Signature& signature = signatures_[symbol->slot];
+    const std::string& name = program_.functions[symbol->slot].name;
+    if (!signature.defined) {
+        throw RuntimeError("function '" + name + "' is declared but never defined");
+    }
+    if (count != signature.parameters.size()) {
+        throw RuntimeError("function '" + name + "' expects " + std::to_string(signature.parameters.size()) +
+            " argument(s), " + std::to_string(count) + " given");
+    }
+
+    uint16_t base = static_cast<uint16_t>(nextRegister_);
+    for (size_t i = 0; i < count; i++) {
+        uint16_t argument = allocRegister();
+        compileInto(list->children[i], argument, signature.parameters[i]);
+    }
+    emit(Opcode::Call, dest, symbol->slot, base);
+    nextRegister_ = mark;
+    return { dest, promotedType(signature.returnType) };
+}
+
+// sizeof不对操作数求值，只需要它的类型
+BytecodeCompiler::Operand BytecodeCompiler::compileSizeof(const ASTNode* node, int32_t hint) {
+    size_t size;
+    const ASTNode* operand = childAt(node, 1);
+    const Symbol* symbol = operand != nullptr && operand->type == "PrimaryExpression" ? resolver_->bindingOf(operand) : nullptr;
+    if (operand != nullptr && operand->type == "(") {
+        // SizeofExpression: sizeof '(' TypeSpecifier ')'
+        size = sizeOfType(typeOf(childAt(node, 2)));
+    }
+    else if (symbol != nullptr && symbol->kind == SymbolKind::Array) {
+        int32_t length = checker_->types().info(checker_->symbolType(*symbol)).length;
+        if (length < 0) {
+            throw RuntimeError("sizeof of array '" + operand->value + "' with a non-constant length");
+        }
+        size = static_cast<size_t>(length) * sizeOfType(typeOf(symbol->type));
+    }
+    else {
+        // 按未提升的类型计算，char变量是1个字节，与Interpreter一致
+        size = sizeOfType(checker_->types().info(checker_->typeOf(operand)).scalar);
+    }
+    uint16_t dest = target(hint);
+    emitConstant(dest, RuntimeValue::ofInt(static_cast<int32_t>(size)));
+    return { dest, ValueType::Int };
+}
+
+BytecodeCompiler::Place BytecodeCompiler::compilePlace(const ASTNode* node) {
+    RuntimeValue constant;
+    if (node != nullptr && node->type == "PrimaryExpression" && !parseConstant(node->value, constant)) {
+        const Symbol& symbol = symbolOf(node);
+        if (symbol.kind == SymbolKind::Variable || symbol.kind == SymbolKind::Parameter) {
+            ValueType type = typeOf(symbol.type);
+            if (symbol.depth == 0) {
+                return { Place::Kind::Global, 0, static_cast<uint16_t>(symbol.slot), type };
+            }
+            return { Place::Kind::Local, static_cast<uint16_t>(symbol.slot), 0, type };
+        }
+    }
+    else if (node != nullptr && node->type == "ArrayAccess") {
+        // ArrayAccess: array '[' index ']'，数组只能通过名字访问
+        const ASTNode* base = childAt(node, 0);
+        if (base == nullptr || base->type != "PrimaryExpression") {
+            throw RuntimeError("unsupported array access");
+        }
+        const Symbol& symbol = symbolOf(base);
+        if (symbol.kind != SymbolKind::Array) {
+            throw RuntimeError("'" + base->value + "' is not an array");
+        }
+        uint16_t array = static_cast<uint16_t>(symbol.slot);
+        if (symbol.depth == 0) {
+            array = allocRegister();
+            emit(Opcode::LoadGlobal, array, symbol.slot);
+        }
+        Operand index = compileExpression(childAt(node, 2), -1);
+        if (index.type != ValueType::Int) {
+            throw RuntimeError("array subscript is not an integer");
+        }
+        return { Place::Kind::Element, array, index.reg, typeOf(symbol.type) };
+    }
+    throw RuntimeError("expression is not assignable");
+}
+
+BytecodeCompiler::Operand BytecodeCompiler::load(const Place& place, int32_t hint) {
+    ValueType type = promotedType(place.type);
+    switch (place.kind) {
+    case Place::Kind::Local:
+        return { place.reg, type };
+    case Place::Kind::Global: {
+        uint16_t dest = target(hint);
+        emit(Opcode::LoadGlobal, dest, place.index);
+        return { dest, type };
+    }
+    default: {
+        uint16_t dest = target(hint);
+        emit(Opcode::LoadElement, dest, place.reg, place.index);
+        return { dest, type };
+    }
+    }
+}
+
+void BytecodeCompiler::store(const Place& place, uint16_t reg) {
+    switch (place.kind) {
+    case Place::Kind::Local:
+        if (reg != place.reg) {
+            emit(Opcode::Move, place.reg, reg);
+        }
+        break;
+    case Place::Kind::Global:
+        emit(Opcode::StoreGlobal, place.index, reg);
+        break;
+    default:
+        emit(Opcode::StoreElement, place.reg, place.index, reg);
+        break;
+    }
+}
+
+// 按常用算术转换计算left op right并写入dest；dest可以与操作数相同
+BytecodeCompiler::Operand BytecodeCompiler::emitBinary(BinaryOp op, Operand left, Operand right, uint16_t dest) {
+    ValueType type = arithmeticType(left.type, right.type);
+    bool comparison = op >= BinaryOp::Less;
+    if (type != ValueType::Int) {
+        if (op > BinaryOp::Div && !comparison) {
+            throw RuntimeError("invalid operands of floating type to an integer operator");
+        }
+        left = toDouble(left);
+        right = toDouble(right);
+    }
+    uint16_t a = left.reg;
+    uint16_t b = right.reg;
+    if (op == BinaryOp::Greater || op == BinaryOp::GreaterEqual) {
+        std::swap(a, b);
+        op = op == BinaryOp::Greater ? BinaryOp::Less : BinaryOp::LessEqual;
+    }
+    static const Opcode intOpcodes[] = {
+        Opcode::AddI, Opcode::SubI, Opcode::MulI, Opcode::DivI, Opcode::ModI, Opcode::ShlI, Opcode::ShrI,
+        Opcode::AndI, Opcode::OrI, Opcode::XorI, Opcode::LtI, Opcode::LtI, Opcode::LeI, Opcode::LeI, Opcode::EqI, Opcode::NeI
+    };
+    static const Opcode doubleOpcodes[] = {
+        Opcode::AddD, Opcode::SubD, Opcode::MulD, Opcode::DivD, Opcode::Count, Opcode::Count, Opcode::Count,
+        Opcode::Count, Opcode::Count, Opcode::Count, Opcode::LtD, Opcode::LtD, Opcode::LeD, Opcode::LeD, Opcode::EqD, Opcode::NeD
+    };
+    size_t index = static_cast<size_t>(op);
+    emit(type == ValueType::Int ? intOpcodes[index] : doubleOpcodes[index], dest, a, b);
+    if (comparison) {
+        return { dest, ValueType::Int };
+    }
+    if (type == ValueType::Float) {
+        emit(Opcode::RoundFloat, dest, dest);
+    }
+    return { dest, type };
+}
+
+// 把source转换成存储类型type写入dest
+void BytecodeCompiler::emitConvert(uint16_t dest, Operand source, ValueType type) {
+    bool floating = source.type != ValueType::Int;
+    switch (type) {
+    case ValueType::Int:
+        if (floating) {
+            emit(Opcode::DoubleToInt, dest, source.reg);
+        }
+        else if (dest != source.reg) {
+            emit(Opcode::Move, dest, source.reg);
+        }
+        break;
+    case ValueType::Char:
+        if (floating) {
+            emit(Opcode::DoubleToInt, dest, source.reg);
+            emit(Opcode::TruncChar, dest, dest);
+        }
+        else {
+            emit(Opcode::TruncChar, dest, source.reg);
+        }
+        break;
+    case ValueType::Bool:
+        emit(floating ? Opcode::DoubleToBool : Opcode::IntToBool, dest, source.reg);
+        break;
+    case ValueType::Float:
+        if (!floating) {
+            emit(Opcode::IntToDouble, dest, source.reg);
+            emit(Opcode::RoundFloat, dest, dest);
+        }
+        else if (source.type == ValueType::Double) {
+            emit(Opcode::RoundFloat, dest, source.reg);
+        }
+        else if (dest != source.reg) {
+            emit(Opcode::Move, dest, source.reg);
+        }
+        break;
+    case ValueType::Double:
+        if (!floating) {
+            emit(Opcode::IntToDouble, dest, source.reg);
+        }
+        else if (dest != source.reg) {
+            emit(Opcode::Move, dest, source.reg);
+        }
+        break;
+    default:
+        throw RuntimeError(std::string("cannot convert to ") + valueTypeName(type));
+    }
+}
+
+BytecodeCompiler::Operand BytecodeCompiler::toDouble(Operand operand) {
+    if (operand.type != ValueType::Int) {
+        return operand;
+    }
+    uint16_t reg = allocRegister();
+    emit(Opcode::IntToDouble, reg, operand.reg);
+    return { reg, ValueType::Double };
+}
+
+void BytecodeCompiler::emitConstant(uint16_t dest, const RuntimeValue& value) {
+    if (value.type == ValueType::Int && fitsImmediate(value.intValue)) {
+        emit(Opcode::LoadInt, dest, static_cast<uint16_t>(value.intValue));
+        return;
+    }
+    BytecodeValue constant;
+    constant.bits = 0;
+    if (value.type == ValueType::Int) {
+        constant.i = value.intValue;
+    }
+    else {
+        constant.d = value.doubleValue;
+    }
+    // 相同的常量只保存一份
+    size_t index = 0;
+    while (index < program_.constants.size() && program_.constants[index].bits != constant.bits) {
+        index++;
+    }
+    if (index == program_.constants.size()) {
+        if (index >= operandLimit) {
+            throw RuntimeError("too many constants for the bytecode encoding");
+        }
+        program_.constants.push_back(constant);
+    }
+    emit(Opcode::LoadConst, dest, static_cast<uint32_t>(index));
+}
+
+const Symbol& BytecodeCompiler::symbolOf(const ASTNode* use) const {
+    const Symbol* symbol = resolver_->bindingOf(use);
+    if (symbol == nullptr) {
+        throw RuntimeError("undeclared identifier '" + use->value + "'");
+    }
+    return *symbol;
+}
+
+ValueType BytecodeCompiler::typeOf(const ASTNode* typeSpecifier) const {
+    ValueType type;
+    if (typeSpecifier == nullptr || !valueTypeFromName(typeSpecifier->value, type)) {
+        throw RuntimeError("unsupported type '" + (typeSpecifier == nullptr ? std::string() : typeSpecifier->value) + "'");
+    }
+    return type;
+}
+
+uint16_t BytecodeCompiler::allocRegister() {
+    if (nextRegister_ >= operandLimit) {
+        throw RuntimeError("function '" + function_->name + "' uses too many registers");
+    }
+    uint16_t reg = static_cast<uint16_t>(nextRegister_++);
+    if (nextRegister_ > function_->registerCount) {
+        function_->registerCount = nextRegister_;
+    }
+    return reg;
+}
+
+// 结果寄存器：调用者指定了hint就用hint，否则分配一个临时寄存器
+uint16_t BytecodeCompiler::target(int32_t hint) {
+    return hint >= 0 ? static_cast<uint16_t>(hint) : allocRegister();
+}
+
+size_t BytecodeCompiler::emit(Opcode op, uint32_t a, uint32_t b, uint32_t c) {
+    function_->code.push_back({ op, static_cast<uint16_t>(a), static_cast<uint16_t>(b), static_cast<uint16_t>(c) });
+    return function_->code.size() - 1;
+}
+
+// 把跳转指令的目标回填为下一条指令
+void BytecodeCompiler::patch(const std::vector<size_t>& jumps) {
+    patchTo(jumps, function_->code.size());
+}
+
+void BytecodeCompiler::patchTo(const std::vector<size_t>& jumps, size_t destination) {
+    for (size_t jump : jumps) {
+        function_->code[jump].c = static_cast<uint16_t>(destination);
+    }
+}
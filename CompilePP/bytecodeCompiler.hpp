@@ -0,0 +1,95 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "ast.hpp"
+#include "bytecode.hpp"
+#include "nameResolver.hpp"
+#include "typeChecker.hpp"
+
+// 把AST编译成寄存器式字节码
+// 局部变量和参数直接使用NameResolver分配的栈帧槽位作为寄存器，表达式的中间结果使用槽位之后的临时寄存器；
+// 表达式的类型取自TypeChecker的检查结果，运算指令按int/double区分，赋值、传参和返回时插入转换指令。
+// 条件中的int比较编译成比较并跳转的超级指令，局部int变量的自增和加常量编译成IncI/AddImmI
+class BytecodeCompiler {
+public:
+    BytecodeCompiler();
+
+    BytecodeCompiler(const BytecodeCompiler&) = delete;
+    BytecodeCompiler& operator=(const BytecodeCompiler&) = delete;
+
+    // 编译整个程序；程序使用了不支持的结构、类型不匹配或超出字节码的编码范围时抛出RuntimeError
+    BytecodeProgram compile(const ASTNode* root);
+
+private:
+    // 表达式的值所在的寄存器，type只会是Int、Float或Double（char和bool已经提升为int）
+    struct Operand {
+        uint16_t reg;
+        ValueType type;
+    };
+
+    // 可以赋值的位置
+    struct Place {
+        enum class Kind : uint8_t { Local, Global, Element } kind;
+        uint16_t reg;      // 局部变量的寄存器，或数组所在的寄存器
+        uint16_t index;    // 全局变量下标，或下标所在的寄存器
+        ValueType type;    // 存储类型
+    };
+
+    struct Loop {
+        std::vector<size_t> breaks;
+        std::vector<size_t> continues;
+        size_t arrayBlocks;  // 进入循环时arrayMarks_的大小
+    };
+
+    struct Signature {
+        ValueType returnType;
+        std::vector<ValueType> parameters;
+        bool defined;
+    };
+
+    const NameResolver* resolver_;
+    const TypeChecker* checker_;
+    BytecodeProgram program_;
+    std::vector<Signature> signatures_;     // 按函数符号的槽位编号
+
+    // 当前函数的编译状态
+    BytecodeFunction* function_;
+    ValueType returnType_;
+    uint32_t nextRegister_;
+    std::vector<Loop> loops_;
+    std::vector<uint16_t> arrayMarks_;      // 声明了数组的块保存数组栈顶的寄存器
+
+    void compileFunction(const ASTNode* node);
+    void compileStatement(const ASTNode* node, bool functionBody = false);
+    void compileDeclaration(const ASTNode* node, bool global);
+    void compileLoopExit(bool isBreak);
+    void compileEffect(const ASTNode* node);
+    void compileBranch(const ASTNode* node, bool jumpIf, std::vector<size_t>& jumps);
+
+    Operand compileExpression(const ASTNode* node, int32_t hint);
+    void compileInto(const ASTNode* node, uint16_t dest, ValueType type);
+    Operand compileBinary(const ASTNode* node, const std::string& op, const ASTNode* left, const ASTNode* right, int32_t hint);
+    Operand compileLogical(const ASTNode* node, int32_t hint);
+    Operand compileConditional(const ASTNode* node, int32_t hint);
+    Operand compileAssignment(const ASTNode* node);
+    Operand compileIncrement(const ASTNode* operand, int32_t delta, bool postfix);
+    Operand compileUnary(const ASTNode* node, int32_t hint);
+    Operand compileCall(const ASTNode* node, int32_t hint);
+    Operand compileSizeof(const ASTNode* node, int32_t hint);
+
+    Place compilePlace(const ASTNode* node);
+    Operand load(const Place& place, int32_t hint);
+    void store(const Place& place, uint16_t reg);
+    Operand emitBinary(BinaryOp op, Operand left, Operand right, uint16_t dest);
+    void emitConvert(uint16_t dest, Operand source, ValueType type);
+    Operand toDouble(Operand operand);
+    void emitConstant(uint16_t dest, const RuntimeValue& value);
+
+    const Symbol& symbolOf(const ASTNode* use) const;
+    ValueType typeOf(const ASTNode* typeSpecifier) const;
+    uint16_t allocRegister();
+    uint16_t target(int32_t hint);
+    size_t emit(Opcode op, uint32_t a = 0, uint32_t b = 0, uint32_t c = 0);
+    void patch(const std::vector<size_t>& jumps);
+    void patchTo(const std::vector<size_t>& jumps, size_t destination);
+};
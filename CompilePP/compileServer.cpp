@@ -0,0 +1,426 @@
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+#include "compileServer.hpp"
+#include "driver.hpp"
+#include "threadPool.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define SERVER_SUPPORTED 1
+#endif
+
+#ifdef SERVER_SUPPORTED
+namespace {
+    // 一个连接只传一次请求和一次响应，整数都是4字节小端序，字符串是长度加字节：
+    //   请求：类型（1字节）、字符串个数、客户端的工作目录、各个参数
+    //   编译的响应：退出码、标准输出、标准错误；停止的响应：0
+    enum class RequestKind : uint8_t {
+        Compile = 'C',
+        Stop = 'S'
+    };
+
+    // 防止损坏的请求让服务器申请过大的内存
+    constexpr uint32_t maxStringCount = 1 << 16;
+    constexpr uint32_t maxStringLength = 1 << 30;
+
+    void appendUint32(std::string& buffer, uint32_t value) {
+        for (int i = 0; i < 4; i++) {
+            buffer.push_back(static_cast<char>((value >> (i * 8)) & 0xFF));
+        }
+    }
+
+    void appendString(std::string& buffer, const std::string& text) {
+        appendUint32(buffer, static_cast<uint32_t>(text.size()));
+        buffer += text;
+    }
+
+    bool sendAll(int fd, const std::string& buffer) {
+        size_t sent = 0;
+        while (sent < buffer.size()) {
+            ssize_t count = ::write(fd, buffer.data() + sent, buffer.size() - sent);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                return false;
+            }
+            sent += static_cast<size_t>(count);
+        }
+        return true;
+    }
+
+    bool receiveAll(int fd, char* data, size_t size) {
+        size_t received = 0;
+        while (received < size) {
+            ssize_t count = ::read(fd, data + received, size - received);
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count <= 0) {
+                return false;
+            }
+            received += static_cast<size_t>(count);
+        }
+        return true;
+    }
+
+    bool receiveUint32(int fd, uint32_t& value) {
+        unsigned char bytes[4];
+        if (!receiveAll(fd, reinterpret_cast<char*>(bytes), 4)) {
+            return false;
+        }
+        value = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+        return true;
+    }
+
+    bool receiveString(int fd, std::string& text) {
+        uint32_t length;
+        if (!receiveUint32(fd, length) || length > maxStringLength) {
+            return false;
+        }
+        text.resize(length);
+        return length == 0 || receiveAll(fd, text.data(), length);
+    }
+
+    bool makeAddress(const std::string& socketPath, sockaddr_un& address, std::ostream& err) {
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path)) {
+            err << "Invalid socket path: " << socketPath << "\n";
+            return false;
+        }
+        std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+        return true;
+    }
+
+    // 连接失败时返回-1，errno保留connect的错误
+    int connectTo(const sockaddr_un& address) {
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            return -1;
+        }
+        if (::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+            int error = errno;
+            ::close(fd);
+            errno = error;
+            return -1;
+        }
+        return fd;
+    }
+
+    // 发送请求并接收整数形式的第一个响应字段
+    bool exchange(int fd, RequestKind kind, const std::vector<std::string>& strings, uint32_t& status) {
+        std::string request;
+        request.push_back(static_cast<char>(kind));
+        appendUint32(request, static_cast<uint32_t>(strings.size()));
+        for (const std::string& text : strings) {
+            appendString(request, text);
+        }
+        return sendAll(fd, request) && receiveUint32(fd, status);
+    }
+
+    struct FileStamp {
+        std::string path;
+        uintmax_t size;
+        std::filesystem::file_time_type time;
+
+        bool operator==(const FileStamp& other) const {
+            return path == other.path && size == other.size && time == other.time;
+        }
+    };
+
+    struct CachedResult {
+        std::vector<FileStamp> inputs;
+        int exitCode;
+        std::string out;
+        std::string err;
+    };
+
+    // 按工作目录和参数缓存编译结果；输入文件的大小和修改时间都没变才算命中，与make判断文件是否过期的方式相同
+    class ResultCache {
+    public:
+        // 缓存满了就整体清空，构建脚本的调用通常集中在一批文件上
+        static constexpr size_t capacity = 4096;
+
+        bool find(const std::string& key, const std::vector<FileStamp>& inputs, CachedResult& result) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = entries_.find(key);
+            if (it == entries_.end() || it->second.inputs != inputs) {
+                return false;
+            }
+            result = it->second;
+            return true;
+        }
+
+        void store(const std::string& key, CachedResult result) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (entries_.size() >= capacity) {
+                entries_.clear();
+            }
+            entries_[key] = std::move(result);
+        }
+
+    private:
+        std::mutex mutex_;
+        std::unordered_map<std::string, CachedResult> entries_;
+    };
+
+    struct ServerState {
+        sockaddr_un address;
+        ResultCache cache;
+        std::atomic<bool> stopping{ false };
+        std::atomic<size_t> requests{ 0 };
+        std::atomic<size_t> cacheHits{ 0 };
+    };
+
+    // 结果只由参数和输入文件决定的请求才能缓存：不写文件、不输出计时和内存统计
+    bool cacheable(const CommandLine& commandLine) {
+        const CompileOptions& options = commandLine.options;
+        return commandLine.interpIterations == 0 && commandLine.aotIterations == 0 && !commandLine.paths.empty()
+            && options.benchIterations == 0 && options.visitorIterations == 0 && !options.timePasses && !options.timeReport && !options.memReport
+            && options.syntaxPath.empty() && options.asmPath.empty() && options.executablePath.empty();
+    }
+
+    // 有文件无法访问时返回false，这样的请求不缓存，错误信息由编译本身给出
+    bool stampInputs(const CommandLine& commandLine, std::vector<FileStamp>& inputs) {
+        std::error_code error;
+        for (const auto* list : { &commandLine.responseFiles, &commandLine.paths }) {
+            for (const std::string& path : *list) {
+                FileStamp stamp{ path, std::filesystem::file_size(path, error), {} };
+                if (error) {
+                    return false;
+                }
+                stamp.time = std::filesystem::last_write_time(path, error);
+                if (error) {
+                    return false;
+                }
+                inputs.push_back(std::move(stamp));
+            }
+        }
+        return true;
+    }
+
+    CachedResult compile(const std::vector<std::string>& strings, ServerState& state) {
+        CachedResult result;
+        std::vector<std::string> args(strings.begin() + 1, strings.end());
+        std::ostringstream out;
+        std::ostringstream err;
+        CommandLine commandLine;
+        commandLine.programName = "cpp";
+        if (!parseCommandLine(args, strings.front(), commandLine, err)) {
+            result.exitCode = 1;
+            result.err = err.str();
+            return result;
+        }
+        // Parser的剖析结果在整个进程里累加，并发的请求会混在一起
+        if (commandLine.options.profileParser) {
+            result.exitCode = 1;
+            result.err = "--profile-parser is not supported by the compile server\n";
+            return result;
+        }
+        // 请求已经在线程池上并发处理，没有指定-j时每个请求内部顺序执行，避免线程数成倍增长
+        if (!commandLine.jobsGiven) {
+            commandLine.jobs = 1;
+            commandLine.jobsGiven = true;
+        }
+
+        std::string key;
+        bool useCache = cacheable(commandLine) && stampInputs(commandLine, result.inputs);
+        if (useCache) {
+            for (const std::string& text : strings) {
+                key += text;
+                key.push_back('\0');
+            }
+            if (state.cache.find(key, result.inputs, result)) {
+                state.cacheHits++;
+                return result;
+            }
+        }
+
+        try {
+            result.exitCode = runCommandLine(commandLine, out, err);
+        }
+        catch (const std::exception& exception) {
+            err << "Internal error: " << exception.what() << "\n";
+            result.exitCode = 1;
+            useCache = false;
+        }
+        result.out = out.str();
+        result.err = err.str();
+        if (useCache) {
+            state.cache.store(key, result);
+        }
+        return result;
+    }
+
+    void serveConnection(int fd, ServerState& state) {
+        char kind;
+        uint32_t count;
+        if (!receiveAll(fd, &kind, 1) || !receiveUint32(fd, count) || count == 0 || count > maxStringCount) {
+            return;
+        }
+        std::vector<std::string> strings(count);
+        for (std::string& text : strings) {
+            if (!receiveString(fd, text)) {
+                return;
+            }
+        }
+
+        std::string response;
+        if (kind == static_cast<char>(RequestKind::Stop)) {
+            appendUint32(response, 0);
+            sendAll(fd, response);
+            // 主线程阻塞在accept上，连接一次把它唤醒
+            state.stopping = true;
+            int wake = connectTo(state.address);
+            if (wake >= 0) {
+                ::close(wake);
+            }
+            return;
+        }
+        if (kind != static_cast<char>(RequestKind::Compile)) {
+            return;
+        }
+        state.requests++;
+        CachedResult result = compile(strings, state);
+        appendUint32(response, static_cast<uint32_t>(result.exitCode));
+        appendString(response, result.out);
+        appendString(response, result.err);
+        sendAll(fd, response);
+    }
+}
+#endif
+
+int runCompileServer(const std::string& socketPath, size_t jobs, std::ostream& log) {
+#ifndef SERVER_SUPPORTED
+    (void)jobs;
+    log << "Compile server needs a Unix-like system: " << socketPath << "\n";
+    return 1;
+#else
+    // 客户端提前断开时写套接字会触发SIGPIPE，改为由write返回错误
+    std::signal(SIGPIPE, SIG_IGN);
+    ServerState state;
+    if (!makeAddress(socketPath, state.address, log)) {
+        return 1;
+    }
+    int existing = connectTo(state.address);
+    if (existing >= 0) {
+        ::close(existing);
+        log << "Compile server already running on " << socketPath << "\n";
+        return 1;
+    }
+    // 上一个服务器异常退出时留下的套接字文件
+    ::unlink(socketPath.c_str());
+
+    int listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0 || ::bind(listenFd, reinterpret_cast<const sockaddr*>(&state.address), sizeof(state.address)) != 0
+        || ::listen(listenFd, SOMAXCONN) != 0) {
+        log << "Failed to listen on " << socketPath << ": " << std::strerror(errno) << "\n";
+        if (listenFd >= 0) {
+            ::close(listenFd);
+        }
+        return 1;
+    }
+
+    int exitCode = 0;
+    {
+        ThreadPool pool(jobs);
+        log << "Compile server listening on " << socketPath << " with " << pool.size() << " workers" << std::endl;
+        while (!state.stopping) {
+            int fd = ::accept(listenFd, nullptr, nullptr);
+            if (fd < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) {
+                    continue;
+                }
+                log << "Failed to accept a connection: " << std::strerror(errno) << "\n";
+                exitCode = 1;
+                break;
+            }
+            pool.submit([fd, &state]() {
+                serveConnection(fd, state);
+                ::close(fd);
+            });
+        }
+        ::close(listenFd);
+        ::unlink(socketPath.c_str());
+        // 已经接受的请求都处理完才退出
+        pool.wait();
+    }
+    log << "Compile server stopped after " << state.requests << " requests, " << state.cacheHits << " served from cache\n";
+    return exitCode;
+#endif
+}
+
+int runCompileClient(const std::string& socketPath, const std::vector<std::string>& args,
+    std::ostream& out, std::ostream& err) {
+#ifndef SERVER_SUPPORTED
+    (void)args;
+    (void)out;
+    err << "Compile server needs a Unix-like system: " << socketPath << "\n";
+    return 1;
+#else
+    std::signal(SIGPIPE, SIG_IGN);
+    sockaddr_un address;
+    if (!makeAddress(socketPath, address, err)) {
+        return 1;
+    }
+    int fd = connectTo(address);
+    if (fd < 0) {
+        err << "Failed to connect to compile server on " << socketPath << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    std::vector<std::string> strings;
+    strings.reserve(args.size() + 1);
+    strings.push_back(std::filesystem::current_path().string());
+    strings.insert(strings.end(), args.begin(), args.end());
+
+    uint32_t exitCode;
+    std::string output;
+    std::string errors;
+    bool ok = exchange(fd, RequestKind::Compile, strings, exitCode) && receiveString(fd, output) && receiveString(fd, errors);
+    ::close(fd);
+    if (!ok) {
+        err << "Compile server on " << socketPath << " closed the connection\n";
+        return 1;
+    }
+    out << output;
+    err << errors;
+    return static_cast<int>(exitCode);
+#endif
+}
+
+int stopCompileServer(const std::string& socketPath, std::ostream& err) {
+#ifndef SERVER_SUPPORTED
+    err << "Compile server needs a Unix-like system: " << socketPath << "\n";
+    return 1;
+#else
+    std::signal(SIGPIPE, SIG_IGN);
+    sockaddr_un address;
+    if (!makeAddress(socketPath, address, err)) {
+        return 1;
+    }
+    int fd = connectTo(address);
+    if (fd < 0) {
+        err << "Failed to connect to compile server on " << socketPath << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    uint32_t status;
+    bool ok = exchange(fd, RequestKind::Stop, { std::filesystem::current_path().string() }, status);
+    ::close(fd);
+    if (!ok) {
+        err << "Compile server on " << socketPath << " closed the connection\n";
+        return 1;
+    }
+    return 0;
+#endif
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// 编译服务器：常驻进程在Unix域套接字上接受请求，省去构建脚本每次调用都启动进程的开销。
+// 请求是客户端的工作目录和完整的命令行参数，服务器按与直接运行相同的规则解析参数、
+// 用工作线程池并发编译，把标准输出、标准错误和退出码原样返回给客户端。
+// 线程池、输出缓冲区和结果缓存在请求之间复用；没有写文件和计时输出的请求按
+// 参数和输入文件的大小、修改时间缓存结果，输入未变时直接返回上一次的结果。
+// 只支持类Unix系统，其他平台上这些函数输出错误并返回1
+
+// 在socketPath上运行服务器，jobs个线程（0表示硬件线程数）同时处理请求，
+// 直到收到停止请求才返回。socketPath已被正在运行的服务器占用时返回1，残留的套接字文件会被替换
+int runCompileServer(const std::string& socketPath, size_t jobs, std::ostream& log);
+
+// 瘦客户端：把当前工作目录和args发给服务器，服务器的输出写到out和err，返回服务器给出的退出码
+int runCompileClient(const std::string& socketPath, const std::vector<std::string>& args,
+    std::ostream& out, std::ostream& err);
+
+// 请求服务器处理完已接受的请求后退出
+int stopCompileServer(const std::string& socketPath, std::ostream& err);
@@ -0,0 +1,381 @@
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+#include "constantFolder.hpp"
+
+ASTNode* ConstantFolder::fold(ASTNode* root) {
+    return foldNode(root);
+}
+
+ASTNode* ConstantFolder::fold(ASTNode* root, ParallelPassManager& passes) {
+    if (root == nullptr) {
+        return nullptr;
+    }
+    std::vector<ConstantFolder> workers(passes.jobs());
+    passes.run(root->children.size(), [&](size_t index, size_t worker) {
+        ASTNode*& declaration = root->children[index];
+        declaration = workers[worker].foldNode(declaration);
+    });
+    for (const ConstantFolder& worker : workers) {
+        stats_.removedNodes += worker.stats_.removedNodes;
+        stats_.folded += worker.stats_.folded;
+        stats_.simplified += worker.stats_.simplified;
+    }
+    return root;
+}
+
+const FoldStats& ConstantFolder::stats() const {
+    return stats_;
+}
+
+double ConstantFolder::Constant::asDouble() const {
+    return isDouble ? doubleValue : static_cast<double>(intValue);
+}
+
+bool ConstantFolder::Constant::isZero() const {
+    return isDouble ? doubleValue == 0.0 : intValue == 0;
+}
+
+ASTNode* ConstantFolder::foldNode(ASTNode* node) {
+    if (node == nullptr) {
+        return nullptr;
+    }
+    // 超过深度上限的子树保持原样，名字解析之后的阶段会拒绝这样的程序
+    if (depth_ >= astDepthLimit) {
+        return node;
+    }
+    // 先折叠子树，父节点看到的操作数已经是最简形式
+    depth_++;
+    for (ASTNode*& child : node->children) {
+        child = foldNode(child);
+    }
+    depth_--;
+
+    const std::string& type = node->type;
+    if (type == "AdditiveExpression" || type == "MultiplicativeExpression") {
+        // 运算符保存在节点的值里：left right
+        if (node->children.size() == 2) {
+            return foldBinary(node, node->children[0], node->value, node->children[1]);
+        }
+    }
+    else if (type == "ShiftExpression" || type == "RelationalExpression" || type == "EqualityExpression"
+        || type == "AndExpression" || type == "ExclusiveOrExpression" || type == "InclusiveOrExpression"
+        || type == "LogicalAndExpression" || type == "LogicalOrExpression") {
+        // 运算符是中间的子节点：left op right
+        if (node->children.size() == 3 && node->children[1] != nullptr) {
+            return foldBinary(node, node->children[0], node->children[1]->type, node->children[2]);
+        }
+    }
+    else if (type == "UnaryExpression") {
+        return foldUnary(node);
+    }
+    else if (type == "ConditionalExpression") {
+        return foldConditional(node);
+    }
+    else if (type == "SizeofExpression") {
+        return foldSizeof(node);
+    }
+    return node;
+}
+
+ASTNode* ConstantFolder::foldBinary(ASTNode* node, ASTNode* left, const std::string& op, ASTNode* right) {
+    Constant leftValue;
+    Constant rightValue;
+    bool leftConstant = constantOf(left, leftValue);
+    bool rightConstant = constantOf(right, rightValue);
+
+    if (leftConstant && rightConstant) {
+        Constant result;
+        if (evaluate(op, leftValue, rightValue, result)) {
+            return replaceWithConstant(node, result);
+        }
+        return node;
+    }
+
+    // 短路求值：右操作数不会被求值，无论它有没有副作用都可以丢弃
+    if (leftConstant && op == "&&" && leftValue.isZero()) {
+        return replaceWithConstant(node, { false, 0, 0.0 });
+    }
+    if (leftConstant && op == "||" && !leftValue.isZero()) {
+        return replaceWithConstant(node, { false, 1, 0.0 });
+    }
+
+    // 恒等式只对int常量0和1生效：另一侧是int时结果类型不变，是double时本来就会转换成double
+    auto isInt = [](bool constant, const Constant& value, int32_t expected) {
+        return constant && !value.isDouble && value.intValue == expected;
+    };
+    ASTNode* kept = nullptr;
+    if (op == "+") {
+        kept = isInt(rightConstant, rightValue, 0) ? left : isInt(leftConstant, leftValue, 0) ? right : nullptr;
+    }
+    else if (op == "-" || op == "/") {
+        kept = isInt(rightConstant, rightValue, op == "-" ? 0 : 1) ? left : nullptr;
+    }
+    else if (op == "*") {
+        kept = isInt(rightConstant, rightValue, 1) ? left : isInt(leftConstant, leftValue, 1) ? right : nullptr;
+    }
+    if (kept != nullptr) {
+        stats_.simplified++;
+        return replaceWithChild(node, kept);
+    }
+    return node;
+}
+
+// UnaryExpression: op operand
+ASTNode* ConstantFolder::foldUnary(ASTNode* node) {
+    Constant value;
+    if (node->children.size() != 2 || node->children[0] == nullptr || !constantOf(node->children[1], value)) {
+        return node;
+    }
+    const std::string& op = node->children[0]->type;
+    if (op == "-") {
+        if (value.isDouble) {
+            value.doubleValue = -value.doubleValue;
+        }
+        else {
+            value.intValue = static_cast<int32_t>(0u - static_cast<uint32_t>(value.intValue));
+        }
+    }
+    else if (op == "!") {
+        value = { false, value.isZero() ? 1 : 0, 0.0 };
+    }
+    else if (op == "~" && !value.isDouble) {
+        value.intValue = ~value.intValue;
+    }
+    else if (op != "+") {
+        return node;
+    }
+    return replaceWithConstant(node, value);
+}
+
+// ConditionalExpression: condition trueExpr falseExpr
+ASTNode* ConstantFolder::foldConditional(ASTNode* node) {
+    if (node->children.size() != 3) {
+        return node;
+    }
+    ASTNode* trueExpr = node->children[1];
+    ASTNode* falseExpr = node->children[2];
+
+    Constant condition;
+    if (constantOf(node->children[0], condition)) {
+        ASTNode* chosen = condition.isZero() ? falseExpr : trueExpr;
+        // 两个分支都是常量时，结果类型按常用算术转换取两者中较宽的一个
+        Constant trueValue;
+        Constant falseValue;
+        if (constantOf(trueExpr, trueValue) && constantOf(falseExpr, falseValue) && trueValue.isDouble != falseValue.isDouble) {
+            Constant chosenValue = condition.isZero() ? falseValue : trueValue;
+            return replaceWithConstant(node, { true, 0, chosenValue.asDouble() });
+        }
+        stats_.folded++;
+        return replaceWithChild(node, chosen);
+    }
+    // cond ? a : a，条件没有副作用时可以不求值
+    if (sameTree(trueExpr, falseExpr) && !hasSideEffects(node->children[0])) {
+        stats_.simplified++;
+        return replaceWithChild(node, trueExpr);
+    }
+    return node;
+}
+
+// SizeofExpression: sizeof unary_expression | sizeof ( type_name )
+// 类型名目前只是占位节点，只能折叠操作数是常量的形式；sizeof不求值操作数，int为4字节，double为8字节
+ASTNode* ConstantFolder::foldSizeof(ASTNode* node) {
+    Constant value;
+    if (node->children.size() != 2 || !constantOf(node->children[1], value)) {
+        return node;
+    }
+    return replaceWithConstant(node, { false, value.isDouble ? 8 : 4, 0.0 });
+}
+
+ASTNode* ConstantFolder::replaceWithConstant(ASTNode* node, const Constant& value) {
+    std::string text;
+    if (value.isDouble) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.17g", value.doubleValue);
+        text = buffer;
+        // 保证写回的常量仍然是浮点数
+        if (text.find_first_of(".e") == std::string::npos) {
+            text += ".0";
+        }
+    }
+    else {
+        text = std::to_string(value.intValue);
+    }
+
+    stats_.folded++;
+    stats_.removedNodes += countNodes(node) - 1;
+    delete node;
+    return new ASTNode("PrimaryExpression", text);
+}
+
+ASTNode* ConstantFolder::replaceWithChild(ASTNode* node, ASTNode* child) {
+    stats_.removedNodes += countNodes(node) - countNodes(child);
+    for (ASTNode*& slot : node->children) {
+        if (slot == child) {
+            slot = nullptr;
+        }
+    }
+    delete node;
+    return child;
+}
+
+bool ConstantFolder::constantOf(const ASTNode* node, Constant& value) {
+    if (node == nullptr || node->type != "PrimaryExpression" || node->value.empty()) {
+        return false;
+    }
+    const std::string& text = node->value;
+    size_t digit = text[0] == '-' ? 1 : 0;
+    if (digit >= text.size() || !std::isdigit(static_cast<unsigned char>(text[digit]))) {
+        return false;
+    }
+    errno = 0;
+    if (text.find_first_of(".e") != std::string::npos) {
+        value = { true, 0, std::strtod(text.c_str(), nullptr) };
+        return errno == 0;
+    }
+    // 超出int范围的整数常量在C中是long类型，不参与折叠
+    long long parsed = std::strtoll(text.c_str(), nullptr, 10);
+    if (errno != 0 || parsed < INT32_MIN || parsed > INT32_MAX) {
+        return false;
+    }
+    value = { false, static_cast<int32_t>(parsed), 0.0 };
+    return true;
+}
+
+// 按C语义计算left op right，无法在编译期确定结果时返回false
+bool ConstantFolder::evaluate(const std::string& op, const Constant& left, const Constant& right, Constant& result) {
+    if (op == "&&" || op == "||") {
+        bool value = op == "&&" ? !left.isZero() && !right.isZero() : !left.isZero() || !right.isZero();
+        result = { false, value ? 1 : 0, 0.0 };
+        return true;
+    }
+
+    // 常用算术转换：有一个操作数是double时按double计算
+    if (left.isDouble || right.isDouble) {
+        double a = left.asDouble();
+        double b = right.asDouble();
+        double value;
+        if (op == "+") value = a + b;
+        else if (op == "-") value = a - b;
+        else if (op == "*") value = a * b;
+        else if (op == "/") {
+            if (b == 0.0) {
+                return false;
+            }
+            value = a / b;
+        }
+        else if (op == "<") { result = { false, a < b, 0.0 }; return true; }
+        else if (op == ">") { result = { false, a > b, 0.0 }; return true; }
+        else if (op == "<=") { result = { false, a <= b, 0.0 }; return true; }
+        else if (op == ">=") { result = { false, a >= b, 0.0 }; return true; }
+        else if (op == "==") { result = { false, a == b, 0.0 }; return true; }
+        else if (op == "!=") { result = { false, a != b, 0.0 }; return true; }
+        else {
+            // 位运算、取模和移位不接受浮点操作数
+            return false;
+        }
+        if (!std::isfinite(value)) {
+            return false;
+        }
+        result = { true, 0, value };
+        return true;
+    }
+
+    int32_t a = left.intValue;
+    int32_t b = right.intValue;
+    // 加减乘在无符号域内计算，结果按补码回绕
+    uint32_t ua = static_cast<uint32_t>(a);
+    uint32_t ub = static_cast<uint32_t>(b);
+    int32_t value;
+    if (op == "+") value = static_cast<int32_t>(ua + ub);
+    else if (op == "-") value = static_cast<int32_t>(ua - ub);
+    else if (op == "*") value = static_cast<int32_t>(ua * ub);
+    else if (op == "/" || op == "%") {
+        if (b == 0 || (a == INT32_MIN && b == -1)) {
+            return false;
+        }
+        value = op == "/" ? a / b : a % b;
+    }
+    else if (op == "<<" || op == ">>") {
+        if (b < 0 || b >= 32 || (op == "<<" && a < 0)) {
+            return false;
+        }
+        value = op == "<<" ? static_cast<int32_t>(ua << b) : a >> b;
+    }
+    else if (op == "&") value = a & b;
+    else if (op == "|") value = a | b;
+    else if (op == "^") value = a ^ b;
+    else if (op == "<") value = a < b;
+    else if (op == ">") value = a > b;
+    else if (op == "<=") value = a <= b;
+    else if (op == ">=") value = a >= b;
+    else if (op == "==") value = a == b;
+    else if (op == "!=") value = a != b;
+    else {
+        return false;
+    }
+    result = { false, value, 0.0 };
+    return true;
+}
+
+bool ConstantFolder::hasSideEffects(const ASTNode* node) {
+    std::vector<const ASTNode*> pending = { node };
+    while (!pending.empty()) {
+        const ASTNode* current = pending.back();
+        pending.pop_back();
+        if (current == nullptr) {
+            continue;
+        }
+        if (current->type == "AssignmentExpression" || current->type == "FunctionCall" || current->type == "PostfixExpression") {
+            return true;
+        }
+        // 前缀自增自减
+        if (current->type == "UnaryExpression" && !current->children.empty() && current->children[0] != nullptr
+            && (current->children[0]->type == "++" || current->children[0]->type == "--")) {
+            return true;
+        }
+        pending.insert(pending.end(), current->children.begin(), current->children.end());
+    }
+    return false;
+}
+
+bool ConstantFolder::sameTree(const ASTNode* left, const ASTNode* right) {
+    std::vector<std::pair<const ASTNode*, const ASTNode*>> pending = { { left, right } };
+    while (!pending.empty()) {
+        auto [a, b] = pending.back();
+        pending.pop_back();
+        if (a == nullptr || b == nullptr) {
+            if (a != b) {
+                return false;
+            }
+            continue;
+        }
+        if (a->type != b->type || a->value != b->value || a->children.size() != b->children.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < a->children.size(); i++) {
+            pending.emplace_back(a->children[i], b->children[i]);
+        }
+    }
+    return true;
+}
+
+size_t ConstantFolder::countNodes(const ASTNode* node) {
+    size_t count = 0;
+    std::vector<const ASTNode*> pending = { node };
+    while (!pending.empty()) {
+        const ASTNode* current = pending.back();
+        pending.pop_back();
+        if (current == nullptr) {
+            continue;
+        }
+        count++;
+        pending.insert(pending.end(), current->children.begin(), current->children.end());
+    }
+    return count;
+}
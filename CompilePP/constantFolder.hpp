@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "ast.hpp"
+#include "parallelPasses.hpp"
+
+// 常量折叠的统计
+struct FoldStats {
+    size_t removedNodes = 0;   // 从AST中删除的节点数（折叠前节点数减去折叠后节点数）
+    size_t folded = 0;         // 折叠成常量的表达式个数
+    size_t simplified = 0;     // 按代数恒等式化简的表达式个数
+};
+
+// 常量折叠与代数化简，自底向上原地改写AST
+// 整数按32位int计算，溢出按二进制补码回绕；除数为0、INT_MIN / -1、移位位数越界等
+// 在运行时才有确定行为（或没有定义行为）的表达式保持原样，不提前折叠
+// 结果写回PrimaryExpression的值，负数常量以'-'开头，浮点常量总是带小数点或指数
+class ConstantFolder {
+public:
+    // 折叠root下的所有表达式，返回替换后的根节点；被替换的节点会被释放
+    ASTNode* fold(ASTNode* root);
+    // 每个外部声明作为一个任务折叠，外部声明本身不会被替换；各线程的统计最后累加到stats()
+    ASTNode* fold(ASTNode* root, ParallelPassManager& passes);
+    const FoldStats& stats() const;
+
+private:
+    // 常量值，按C的类型分为int和double两种
+    struct Constant {
+        bool isDouble;
+        int32_t intValue;
+        double doubleValue;
+
+        double asDouble() const;
+        bool isZero() const;
+    };
+
+    FoldStats stats_;
+    size_t depth_ = 0;  // foldNode的递归层数
+
+    ASTNode* foldNode(ASTNode* node);
+    ASTNode* foldBinary(ASTNode* node, ASTNode* left, const std::string& op, ASTNode* right);
+    ASTNode* foldUnary(ASTNode* node);
+    ASTNode* foldConditional(ASTNode* node);
+    ASTNode* foldSizeof(ASTNode* node);
+
+    // 用常量节点替换node
+    ASTNode* replaceWithConstant(ASTNode* node, const Constant& value);
+    // 用node的一个子树替换node，其余部分被释放
+    ASTNode* replaceWithChild(ASTNode* node, ASTNode* child);
+
+    static bool constantOf(const ASTNode* node, Constant& value);
+    static bool evaluate(const std::string& op, const Constant& left, const Constant& right, Constant& result);
+    // 以下三个函数用显式栈遍历，没有折叠的过深子树也可能传进来
+    static bool hasSideEffects(const ASTNode* node);
+    static bool sameTree(const ASTNode* left, const ASTNode* right);
+    static size_t countNodes(const ASTNode* node);
+};
@@ -0,0 +1,171 @@
+#include "diagnostics.hpp"
+
+DiagnosticEngine::DiagnosticEngine(size_t errorLimit)
+    : errorLimit_(errorLimit), errorCount_(0), suppressed_(0), lastErrorLine_(0), lastErrorColumn_(0) {
+}
+
+void DiagnosticEngine::setFileName(const std::string& fileName) {
+    fileName_ = fileName;
+}
+
+const std::string& DiagnosticEngine::fileName() const {
+    return fileName_;
+}
+
+void DiagnosticEngine::report(Severity severity, const std::string& code, const SourceRange& range, const std::string& message) {
+    bool isError = severity == Severity::Error || severity == Severity::Fatal;
+    if (isError) {
+        // 超过上限后不再记录
+        if (errorLimit_ != 0 && errorCount_ >= errorLimit_) {
+            suppressed_++;
+            return;
+        }
+        // 递归下降分析失败后，上层规则往往在同一个Token处再次报错，只保留第一条
+        if (errorCount_ != 0 && range.line == lastErrorLine_ && range.column == lastErrorColumn_) {
+            suppressed_++;
+            return;
+        }
+        lastErrorLine_ = range.line;
+        lastErrorColumn_ = range.column;
+        errorCount_++;
+    }
+    diagnostics_.push_back({ severity, code, range, message });
+}
+
+void DiagnosticEngine::merge(const DiagnosticEngine& other) {
+    for (const Diagnostic& diagnostic : other.diagnostics_) {
+        report(diagnostic.severity, diagnostic.code, diagnostic.range, diagnostic.message);
+    }
+    suppressed_ += other.suppressed_;
+}
+
+void DiagnosticEngine::addSuppressed(size_t count) {
+    suppressed_ += count;
+}
+
+bool DiagnosticEngine::hasErrors() const {
+    return errorCount_ != 0;
+}
+
+bool DiagnosticEngine::limitReached() const {
+    return errorLimit_ != 0 && errorCount_ >= errorLimit_;
+}
+
+size_t DiagnosticEngine::errorCount() const {
+    return errorCount_;
+}
+
+size_t DiagnosticEngine::errorLimit() const {
+    return errorLimit_;
+}
+
+size_t DiagnosticEngine::suppressedCount() const {
+    return suppressed_;
+}
+
+const std::vector<Diagnostic>& DiagnosticEngine::diagnostics() const {
+    return diagnostics_;
+}
+
+void DiagnosticEngine::render(std::ostream& os, DiagnosticFormat format) const {
+    if (format == DiagnosticFormat::Json) {
+        renderJson(os);
+    }
+    else {
+        renderText(os);
+    }
+}
+
+static const char* severityName(Severity severity) {
+    switch (severity) {
+    case Severity::Note: return "note";
+    case Severity::Warning: return "warning";
+    case Severity::Error: return "error";
+    case Severity::Fatal: return "fatal error";
+    }
+    return "error";
+}
+
+// 先拼接到一个字符串中，最后只写一次输出流
+void DiagnosticEngine::renderText(std::ostream& os) const {
+    std::string out;
+    out.reserve(diagnostics_.size() * 96);
+    for (const Diagnostic& diagnostic : diagnostics_) {
+        out += fileName_.empty() ? "<input>" : fileName_;
+        out += ':';
+        out += std::to_string(diagnostic.range.line);
+        out += ':';
+        out += std::to_string(diagnostic.range.column);
+        out += ": ";
+        out += severityName(diagnostic.severity);
+        out += '[';
+        out += diagnostic.code;
+        out += "]: ";
+        out += diagnostic.message;
+        out += '\n';
+    }
+    if (suppressed_ != 0) {
+        out += std::to_string(suppressed_);
+        out += " further error(s) suppressed.\n";
+    }
+    if (errorCount_ != 0) {
+        out += std::to_string(errorCount_);
+        out += " error(s) generated.\n";
+    }
+    os.write(out.data(), out.size());
+}
+
+static void appendJsonString(std::string& out, const std::string& value) {
+    static const char hex[] = "0123456789abcdef";
+    out += '"';
+    for (unsigned char c : value) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (c < 0x20) {
+                out += "\\u00";
+                out += hex[c >> 4];
+                out += hex[c & 0xF];
+            }
+            else {
+                out += static_cast<char>(c);
+            }
+            break;
+        }
+    }
+    out += '"';
+}
+
+// 机器可读格式：{"file":..., "diagnostics":[...], "errors":N, "suppressed":N}
+void DiagnosticEngine::renderJson(std::ostream& os) const {
+    std::string out;
+    out.reserve(64 + diagnostics_.size() * 160);
+    out += "{\"file\":";
+    appendJsonString(out, fileName_);
+    out += ",\"diagnostics\":[";
+    for (size_t i = 0; i < diagnostics_.size(); i++) {
+        const Diagnostic& diagnostic = diagnostics_[i];
+        if (i != 0) {
+            out += ',';
+        }
+        out += "{\"severity\":";
+        appendJsonString(out, severityName(diagnostic.severity));
+        out += ",\"code\":";
+        appendJsonString(out, diagnostic.code);
+        out += ",\"line\":" + std::to_string(diagnostic.range.line);
+        out += ",\"column\":" + std::to_string(diagnostic.range.column);
+        out += ",\"endLine\":" + std::to_string(diagnostic.range.endLine);
+        out += ",\"endColumn\":" + std::to_string(diagnostic.range.endColumn);
+        out += ",\"message\":";
+        appendJsonString(out, diagnostic.message);
+        out += '}';
+    }
+    out += "],\"errors\":" + std::to_string(errorCount_);
+    out += ",\"suppressed\":" + std::to_string(suppressed_);
+    out += "}\n";
+    os.write(out.data(), out.size());
+}
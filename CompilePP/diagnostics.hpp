@@ -0,0 +1,72 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <vector>
+
+// 诊断信息的严重程度
+enum class Severity
+{
+    Note, Warning, Error, Fatal
+};
+
+// 诊断信息的输出格式
+enum class DiagnosticFormat
+{
+    Text, Json
+};
+
+// 源码范围，行号列号与Token保持一致
+struct SourceRange {
+    size_t line;
+    size_t column;
+    size_t endLine;
+    size_t endColumn;
+};
+
+// 一条结构化的诊断信息
+struct Diagnostic {
+    Severity severity;
+    std::string code;     // 诊断编号，例如 L001 / P002
+    SourceRange range;
+    std::string message;
+};
+
+// 诊断收集器：词法/语法分析期间只在内存中记录，结束后统一输出一次
+class DiagnosticEngine {
+public:
+    explicit DiagnosticEngine(size_t errorLimit = 20);
+
+    void setFileName(const std::string& fileName);
+    const std::string& fileName() const;
+
+    // 记录一条诊断；同一位置的级联错误以及超过上限的错误会被丢弃
+    void report(Severity severity, const std::string& code, const SourceRange& range, const std::string& message);
+    // 按顺序并入另一个收集器的诊断，去重和上限规则照常生效
+    void merge(const DiagnosticEngine& other);
+    // 计入在别处已经丢弃的错误，例如增量分析时尾块去重和超过上限丢弃的错误
+    void addSuppressed(size_t count);
+
+    bool hasErrors() const;
+    // 错误数量达到上限后，分析器应尽快停止
+    bool limitReached() const;
+    size_t errorCount() const;
+    size_t errorLimit() const;
+    size_t suppressedCount() const;
+    const std::vector<Diagnostic>& diagnostics() const;
+
+    // 一次性输出全部诊断
+    void render(std::ostream& os, DiagnosticFormat format) const;
+
+private:
+    std::string fileName_;
+    std::vector<Diagnostic> diagnostics_;
+    size_t errorLimit_;
+    size_t errorCount_;
+    size_t suppressed_;
+    // 上一条错误的位置，用于去除级联错误
+    size_t lastErrorLine_;
+    size_t lastErrorColumn_;
+
+    void renderText(std::ostream& os) const;
+    void renderJson(std::ostream& os) const;
+};
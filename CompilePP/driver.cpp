@@ -0,0 +1,655 @@
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <optional>
+#include <sstream>
+#include "driver.hpp"
+#include "batchCompiler.hpp"
+#include "interpreterBench.hpp"
+#include "aotBench.hpp"
+#include "workloadBench.hpp"
+#include "scalingBench.hpp"
+#include "incrementalBench.hpp"
+#include "lexer.hpp"
+#include "parallelParser.hpp"
+#include "parserProfile.hpp"
+#include "pipelineParser.hpp"
+#include "lalrParser.hpp"
+#include "parserBench.hpp"
+#include "visitorBench.hpp"
+#include "nameResolver.hpp"
+#include "typeChecker.hpp"
+#include "constantFolder.hpp"
+#include "interpreter.hpp"
+#include "bytecodeCompiler.hpp"
+#include "vm.hpp"
+#include "irBuilder.hpp"
+#include "irPasses.hpp"
+#include "newVector.hpp"
+#include "newVector.cpp"
+
+bool readSourceFile(const std::string& path, std::string& absolutePath, std::string& contents, std::string& error) {
+    std::filesystem::path file_path(path);
+    std::ostringstream message;
+    if (!std::filesystem::exists(file_path)) {
+        message << "File not found: " << file_path;
+        error = message.str();
+        return false;
+    }
+
+    file_path = std::filesystem::absolute(file_path);
+    absolutePath = file_path.string();
+
+    //Read file contents
+    std::ifstream file_stream(file_path);
+    if (!file_stream.is_open()) {
+        message << "Failed to open file: " << file_path;
+        error = message.str();
+        return false;
+    }
+
+    AllocationScope site(AllocationSite::SourceText);
+    std::stringstream buffer;
+    buffer << file_stream.rdbuf();
+    contents = buffer.str();
+    return true;
+}
+
+int compileSource(const std::string& fileName, const std::string& source, const CompileOptions& options,
+    ParallelPassManager& passes, std::ostream& out, std::ostream& err, PhaseReport* report) {
+    std::ofstream syntaxFile;
+    if (!options.syntaxPath.empty()) {
+        syntaxFile.open(options.syntaxPath, std::ios::binary);
+        if (!syntaxFile.is_open()) {
+            err << "Failed to open output file: " << options.syntaxPath << "\n";
+            return 1;
+        }
+    }
+    std::ostream& syntax = options.syntaxPath.empty() ? out : syntaxFile;
+
+    // 词法和语法分析的错误都先收集起来，最后统一输出
+    DiagnosticEngine diagnostics(options.errorLimit);
+    diagnostics.setFileName(fileName);
+
+    if (options.benchIterations != 0) {
+        Lexer lexer(source, diagnostics);
+        newVector<Token> tokens = lexer.lex();
+        runParserBenchmark(tokens, options.benchIterations, out);
+        diagnostics.render(err, options.diagnosticFormat);
+        return diagnostics.hasErrors() ? 1 : 0;
+    }
+
+    ASTNode* ast = nullptr;
+    if (options.pipeline) {
+        // Token边产生边被消费，不再保留完整的Token序列，因此不打印Token
+        PhaseTimer phase(report, "Lexing and parsing");
+        PipelineOptions pipelineOptions;
+        pipelineOptions.nestingLimit = options.maxNesting;
+        ast = parsePipelined(source, diagnostics, pipelineOptions);
+    }
+    else {
+        Lexer lexer(source, diagnostics);
+        newVector<Token> tokens;
+        {
+            PhaseTimer phase(report, "Lexing");
+            tokens = lexer.lex();
+        }
+
+        if (outputsTokens(options.output)) {
+            PhaseTimer phase(report, "Token output");
+            BufferedWriter writer(syntax);
+            writeTokens(tokens, writer);
+        }
+        PhaseTimer phase(report, "Parsing");
+        if (options.useLalr) {
+            LalrParser parser(tokens, diagnostics);
+            parser.setNestingLimit(options.maxNesting);
+            parser.parse();
+            ast = parser.getAST();
+        }
+        else if (options.parseThreads == 0) {
+            // 创建Parser对象并启动语法分析
+            Parser parser(tokens, diagnostics);
+            parser.setNestingLimit(options.maxNesting);
+            parser.parse();
+
+            // 获取构建的AST
+            ast = parser.getAST();
+        }
+        else {
+            // 按外部声明切分后并行分析
+            ThreadPool pool(options.parseThreads);
+            ast = parseParallel(tokens, diagnostics, pool, options.maxNesting);
+        }
+    }
+    if (!diagnostics.hasErrors()) {
+        out << "Parsing successful!\n";
+    }
+    if (options.fold && ast != nullptr && !diagnostics.hasErrors()) {
+        PhaseTimer phase(report, "Constant folding");
+        ConstantFolder folder;
+        ast = folder.fold(ast, passes);
+        const FoldStats& stats = folder.stats();
+        out << "Constant folding: removed " << stats.removedNodes << " nodes ("
+            << stats.folded << " folded, " << stats.simplified << " simplified)\n";
+    }
+    if (options.visitorIterations != 0) {
+        runVisitorBenchmark(diagnostics.hasErrors() ? nullptr : ast, options.visitorIterations, out);
+        delete ast;
+        diagnostics.render(err, options.diagnosticFormat);
+        return diagnostics.hasErrors() ? 1 : 0;
+    }
+    if (ast != nullptr && options.output != OutputMode::None && options.output != OutputMode::Tokens) {
+        PhaseTimer phase(report, "AST output");
+        BufferedWriter writer(syntax);
+        if (options.output == OutputMode::Json) {
+            writeAstJson(ast, writer);
+        }
+        else if (options.output == OutputMode::Binary) {
+            writeAstBinary(ast, writer);
+        }
+        else {
+            writer.write("AST constructed.\n");
+            writeAstText(ast, writer);
+        }
+    }
+    bool semanticErrors = false;
+    if ((options.resolve || options.typeCheck) && ast != nullptr && !diagnostics.hasErrors()) {
+        NameResolver resolver;
+        {
+            PhaseTimer phase(report, "Name resolution");
+            resolver.resolve(ast);
+        }
+        semanticErrors = resolver.tooDeep() != nullptr;
+        if (options.resolve) {
+            out << "Name resolution: " << resolver.symbols().size() << " symbols, "
+                << resolver.bindingCount() << " uses bound, " << resolver.unresolved().size() << " unresolved\n";
+            for (const ASTNode* use : resolver.unresolved()) {
+                out << "Unresolved identifier: " << use->value << "\n";
+            }
+            for (const Redeclaration& redeclaration : resolver.redeclarations()) {
+                out << "Redeclared identifier: " << redeclaration.declarator->value << "\n";
+            }
+            if (resolver.tooDeep() != nullptr) {
+                out << "Nesting too deep: subtrees below " << astDepthLimit << " levels were not resolved\n";
+            }
+        }
+        if (options.typeCheck) {
+            PhaseTimer phase(report, "Type checking");
+            TypeChecker checker(resolver);
+            checker.check(ast);
+            out << "Type checking: " << checker.typedCount() << " expressions typed, "
+                << checker.types().size() << " distinct types, " << checker.errors().size() << " errors\n";
+            for (const TypeError& error : checker.errors()) {
+                out << "Type error: " << error.message << "\n";
+            }
+            semanticErrors = !checker.errors().empty();
+        }
+    }
+
+    int exitCode = diagnostics.hasErrors() || semanticErrors ? 1 : 0;
+    bool compileNative = options.emitAsm || !options.executablePath.empty();
+    if ((options.emitIr || options.optimize || options.verifyIrForm || compileNative) && ast != nullptr && !diagnostics.hasErrors()) {
+        PhaseTimer phase(report, "IR");
+        try {
+            IrModule module;
+            {
+                PhaseTimer buildPhase(report, "IR construction");
+                IrBuilder builder;
+                module = builder.build(ast, passes);
+                std::string error;
+                for (const IrFunction& function : module.functions) {
+                    if (options.verifyIrForm && !verifyIr(function, error)) {
+                        throw RuntimeError("IR verification failed: " + error);
+                    }
+                }
+            }
+            if (options.optimize) {
+                PhaseTimer optimizePhase(report, "IR optimization");
+                IrPassManager irPasses;
+                irPasses.addDefaultPipeline();
+                irPasses.setVerifyEach(options.verifyIrForm);
+                irPasses.run(module, passes);
+                if (options.timePasses) {
+                    irPasses.printTimes(out);
+                }
+            }
+            if (options.emitIr) {
+                PhaseTimer printPhase(report, "IR output");
+                printIr(module, out);
+            }
+            if (compileNative) {
+                PhaseTimer nativePhase(report, "Native code generation");
+                // 只链接时汇编写在可执行文件旁边
+                std::string assemblyPath = !options.asmPath.empty() ? options.asmPath : options.executablePath + ".s";
+                std::ostringstream assembly;
+                AotCompiler compiler(options.codegen);
+                compiler.compile(module, assembly, passes);
+                if (options.emitAsm && options.asmPath.empty()) {
+                    out << assembly.str();
+                }
+                if (!options.asmPath.empty() || !options.executablePath.empty()) {
+                    std::ofstream file(assemblyPath);
+                    file << assembly.str();
+                    if (!file) {
+                        throw RuntimeError("cannot write " + assemblyPath);
+                    }
+                }
+                if (!options.executablePath.empty()) {
+                    PhaseTimer linkPhase(report, "Linking");
+                    linkExecutable(assemblyPath, options.executablePath);
+                }
+                const AotStatistics& stats = compiler.statistics();
+                out << "Native code: " << stats.functions << " functions, " << stats.instructions << " instructions, "
+                    << stats.spilled << " of " << stats.values << " values spilled\n";
+            }
+        }
+        catch (const RuntimeError& error) {
+            err << "IR error: " << error.what() << "\n";
+            exitCode = 1;
+        }
+    }
+    if ((options.dumpBytecode || (options.run && options.useVm)) && ast != nullptr && !diagnostics.hasErrors()) {
+        try {
+            BytecodeProgram program;
+            {
+                PhaseTimer compilePhase(report, "Bytecode compilation");
+                BytecodeCompiler compiler;
+                program = compiler.compile(ast);
+            }
+            if (options.dumpBytecode) {
+                disassemble(program, out);
+            }
+            if (options.run) {
+                PhaseTimer runPhase(report, "Execution");
+                VirtualMachine vm(program, out, 100000, options.jitThreshold);
+                int32_t result = vm.run();
+                out << "Program exited with " << result << "\n";
+            }
+        }
+        catch (const RuntimeError& error) {
+            err << "Runtime error: " << error.what() << "\n";
+            exitCode = 1;
+        }
+    }
+    else if (options.run && ast != nullptr && !diagnostics.hasErrors()) {
+        PhaseTimer phase(report, "Execution");
+        Interpreter interpreter(out);
+        try {
+            interpreter.load(ast);
+            int32_t result = interpreter.run();
+            out << "Program exited with " << result << "\n";
+        }
+        catch (const RuntimeError& error) {
+            err << "Runtime error: " << error.what() << "\n";
+            exitCode = 1;
+        }
+    }
+
+    // 释放AST内存
+    {
+        PhaseTimer phase(report, "AST teardown");
+        delete ast;
+    }
+
+    PhaseTimer phase(report, "Diagnostics");
+    diagnostics.render(err, options.diagnosticFormat);
+    return exitCode;
+}
+
+int compileFile(const std::string& path, const CompileOptions& options, ParallelPassManager& passes,
+    std::ostream& out, std::ostream& err) {
+    // 基准自己计时，不需要阶段报告
+    bool benchmark = options.benchIterations != 0 || options.visitorIterations != 0;
+    std::optional<PhaseReport> report;
+    if ((options.timeReport || options.memReport) && !benchmark) {
+        report.emplace(options.timeReport, options.memReport);
+    }
+    PhaseReport* timing = report ? &*report : nullptr;
+    std::string absolutePath;
+    std::string source;
+    std::string error;
+    bool read;
+    {
+        PhaseTimer phase(timing, "Reading file");
+        read = readSourceFile(path, absolutePath, source, error);
+    }
+    int exitCode = 1;
+    if (!read) {
+        err << error << "\n";
+    }
+    else {
+        out << "Reading file: " << std::quoted(absolutePath) << "\n";
+        exitCode = compileSource(absolutePath, source, options, passes, out, err, timing);
+    }
+    if (report) {
+        report->print(err);
+    }
+    return exitCode;
+}
+
+bool parseCommandLine(const std::vector<std::string>& args, const std::string& workingDirectory,
+    CommandLine& commandLine, std::ostream& err) {
+    CompileOptions& options = commandLine.options;
+    auto resolve = [&](const std::string& path) {
+        if (workingDirectory.empty() || path.empty() || std::filesystem::path(path).is_absolute()) {
+            return path;
+        }
+        return (std::filesystem::path(workingDirectory) / path).string();
+    };
+    for (size_t i = 0; i < args.size(); i++) {
+        const std::string& arg = args[i];
+        if (arg == "--diagnostics-format=json") {
+            options.diagnosticFormat = DiagnosticFormat::Json;
+        }
+        else if (arg == "--diagnostics-format=text") {
+            options.diagnosticFormat = DiagnosticFormat::Text;
+        }
+        else if (arg.rfind("--error-limit=", 0) == 0) {
+            if (!parseFlagValue("--error-limit", arg.substr(14), options.errorLimit, err)) {
+                return false;
+            }
+        }
+        else if (arg.rfind("--parse-threads=", 0) == 0) {
+            if (!parseFlagValue("--parse-threads", arg.substr(16), options.parseThreads, err)) {
+                return false;
+            }
+        }
+        else if (arg.rfind("--max-nesting=", 0) == 0) {
+            if (!parseFlagValue("--max-nesting", arg.substr(14), options.maxNesting, err)) {
+                return false;
+            }
+        }
+        else if (arg == "-j" && i + 1 < args.size()) {
+            if (!parseFlagValue("-j", args[++i], commandLine.jobs, err)) {
+                return false;
+            }
+            commandLine.jobsGiven = true;
+        }
+        else if (arg.rfind("-j", 0) == 0 && arg.size() > 2 && arg[2] != '-') {
+            if (!parseFlagValue("-j", arg.substr(2), commandLine.jobs, err)) {
+                return false;
+            }
+            commandLine.jobsGiven = true;
+        }
+        else if (arg.rfind("--output=", 0) == 0) {
+            if (!parseOutputMode(arg.substr(9), options.output)) {
+                err << "Unknown output mode: " << arg.substr(9) << "\n";
+                return false;
+            }
+            commandLine.outputGiven = true;
+        }
+        else if (arg.rfind("--output-file=", 0) == 0) {
+            options.syntaxPath = resolve(arg.substr(14));
+        }
+        else if (arg == "--pipeline") {
+            options.pipeline = true;
+        }
+        else if (arg == "--parser=lalr") {
+            options.useLalr = true;
+        }
+        else if (arg == "--parser=rd") {
+            options.useLalr = false;
+        }
+        else if (arg == "--bench-parsers") {
+            options.benchIterations = 20;
+        }
+        else if (arg.rfind("--bench-parsers=", 0) == 0) {
+            if (!parseFlagValue("--bench-parsers", arg.substr(16), options.benchIterations, err)) {
+                return false;
+            }
+        }
+        else if (arg == "--bench-visitors") {
+            options.visitorIterations = 20;
+        }
+        else if (arg.rfind("--bench-visitors=", 0) == 0) {
+            if (!parseFlagValue("--bench-visitors", arg.substr(17), options.visitorIterations, err)) {
+                return false;
+            }
+        }
+        else if (arg == "--fold") {
+            options.fold = true;
+        }
+        else if (arg == "--resolve") {
+            options.resolve = true;
+        }
+        else if (arg == "--typecheck") {
+            options.typeCheck = true;
+        }
+        else if (arg == "--run" || arg == "--run=ast") {
+            options.run = true;
+            options.useVm = false;
+        }
+        else if (arg == "--run=vm") {
+            options.run = true;
+            options.useVm = true;
+        }
+        else if (arg == "--run=jit") {
+            options.run = true;
+            options.useVm = true;
+            if (options.jitThreshold == 0) {
+                options.jitThreshold = 100;
+            }
+        }
+        else if (arg.rfind("--jit-threshold=", 0) == 0) {
+            if (!parseFlagValue("--jit-threshold", arg.substr(16), options.jitThreshold, err)) {
+                return false;
+            }
+        }
+        else if (arg == "--dump-bytecode") {
+            options.dumpBytecode = true;
+        }
+        else if (arg == "--emit-ir") {
+            options.emitIr = true;
+        }
+        else if (arg == "--optimize") {
+            options.optimize = true;
+        }
+        else if (arg == "--time-passes") {
+            // 只有运行了优化才有时间可以输出
+            options.optimize = true;
+            options.timePasses = true;
+        }
+        else if (arg == "--time-report") {
+            options.timeReport = true;
+        }
+        else if (arg == "--mem-report") {
+            options.memReport = true;
+        }
+        else if (arg == "--profile-parser") {
+            options.profileParser = true;
+        }
+        else if (arg == "--verify-ir") {
+            options.verifyIrForm = true;
+        }
+        else if (arg == "--emit-asm") {
+            options.emitAsm = true;
+        }
+        else if (arg.rfind("--emit-asm=", 0) == 0) {
+            options.emitAsm = true;
+            options.asmPath = resolve(arg.substr(11));
+        }
+        else if (arg.rfind("--compile=", 0) == 0) {
+            options.executablePath = resolve(arg.substr(10));
+        }
+        else if (arg == "--codegen=linear") {
+            options.codegen = RegisterStrategy::LinearScan;
+        }
+        else if (arg == "--codegen=stack") {
+            options.codegen = RegisterStrategy::Stack;
+        }
+        else if (arg == "--bench-aot") {
+            commandLine.aotIterations = 3;
+        }
+        else if (arg.rfind("--bench-aot=", 0) == 0) {
+            if (!parseFlagValue("--bench-aot", arg.substr(12), commandLine.aotIterations, err)) {
+                return false;
+            }
+        }
+        else if (arg == "--bench-interp") {
+            commandLine.interpIterations = 10;
+        }
+        else if (arg.rfind("--bench-interp=", 0) == 0) {
+            if (!parseFlagValue("--bench-interp", arg.substr(15), commandLine.interpIterations, err)) {
+                return false;
+            }
+        }
+        else if (arg == "--bench-workload") {
+            commandLine.workloadIterations = 5;
+        }
+        else if (arg.rfind("--bench-workload=", 0) == 0) {
+            if (!parseFlagValue("--bench-workload", arg.substr(17), commandLine.workloadIterations, err)) {
+                return false;
+            }
+        }
+        else if (arg == "--bench-scaling") {
+            commandLine.scalingIterations = 3;
+        }
+        else if (arg.rfind("--bench-scaling=", 0) == 0) {
+            if (!parseFlagValue("--bench-scaling", arg.substr(16), commandLine.scalingIterations, err)) {
+                return false;
+            }
+        }
+        else if (arg.rfind("--scaling-margin=", 0) == 0) {
+            if (!parseFlagValue("--scaling-margin", arg.substr(17), commandLine.scalingMargin, err)) {
+                return false;
+            }
+        }
+        else if (arg == "--generate-workload") {
+            commandLine.generateWorkload = true;
+        }
+        else if (arg.rfind("--workload-seed=", 0) == 0) {
+            if (!parseFlagValue("--workload-seed", arg.substr(16), commandLine.workload.seed, err)) {
+                return false;
+            }
+        }
+        else if (arg.rfind("--workload-size=", 0) == 0) {
+            if (!parseFlagValue("--workload-size", arg.substr(16), commandLine.workload.targetBytes, err)) {
+                return false;
+            }
+            commandLine.workloadSizeGiven = true;
+        }
+        else if (arg.rfind("--workload-depth=", 0) == 0) {
+            if (!parseFlagValue("--workload-depth", arg.substr(17), commandLine.workload.maxDepth, err)) {
+                return false;
+            }
+        }
+        else if (arg.rfind("--workload-expr=", 0) == 0) {
+            if (!parseFlagValue("--workload-expr", arg.substr(16), commandLine.workload.expressionLength, err)) {
+                return false;
+            }
+        }
+        else if (arg.rfind("--workload-comments=", 0) == 0) {
+            if (!parseFlagValue("--workload-comments", arg.substr(20), commandLine.workload.commentDensity, err)) {
+                return false;
+            }
+        }
+        else if (arg.rfind("--workload-idents=", 0) == 0) {
+            if (!parseFlagValue("--workload-idents", arg.substr(18), commandLine.workload.identifiers, err)) {
+                return false;
+            }
+        }
+        else if (arg == "--bench-incremental") {
+            commandLine.incrementalEdits = 200;
+        }
+        else if (arg.rfind("--bench-incremental=", 0) == 0) {
+            if (!parseFlagValue("--bench-incremental", arg.substr(20), commandLine.incrementalEdits, err)) {
+                return false;
+            }
+        }
+        else if (arg.size() > 1 && arg[0] == '@') {
+            std::string responsePath = resolve(arg.substr(1));
+            size_t first = commandLine.paths.size();
+            std::string error;
+            if (!readResponseFile(responsePath, commandLine.paths, error)) {
+                err << error << "\n";
+                return false;
+            }
+            for (size_t j = first; j < commandLine.paths.size(); j++) {
+                commandLine.paths[j] = resolve(commandLine.paths[j]);
+            }
+            commandLine.responseFiles.push_back(responsePath);
+        }
+        else if (arg.empty() || arg[0] != '-') {
+            commandLine.paths.push_back(resolve(arg));
+        }
+        else {
+            err << "Unknown argument: " << arg << "\n";
+            return false;
+        }
+    }
+    if (options.pipeline && options.parseThreads != 0) {
+        err << "--pipeline cannot be combined with --parse-threads\n";
+        return false;
+    }
+    if (options.useLalr && (options.pipeline || options.parseThreads != 0)) {
+        err << "--parser=lalr cannot be combined with --pipeline or --parse-threads\n";
+        return false;
+    }
+    return true;
+}
+
+int runCommandLine(const CommandLine& commandLine, std::ostream& out, std::ostream& err) {
+    if (commandLine.interpIterations != 0) {
+        // 基准程序是内置的，不需要输入文件
+        runInterpreterBenchmark(commandLine.interpIterations, out);
+        return 0;
+    }
+    if (commandLine.aotIterations != 0) {
+        runAotBenchmark(commandLine.aotIterations, out);
+        return 0;
+    }
+    if (commandLine.generateWorkload) {
+        out << generateWorkload(commandLine.workload);
+        return 0;
+    }
+    if (commandLine.workloadIterations != 0) {
+        runWorkloadBenchmark(commandLine.workload, commandLine.workloadIterations, commandLine.options.useLalr, out);
+        return 0;
+    }
+    if (commandLine.incrementalEdits != 0) {
+        // 每次编辑后都要全量分析一遍作比较，默认用较小的程序
+        WorkloadOptions workload = commandLine.workload;
+        if (!commandLine.workloadSizeGiven) {
+            workload.targetBytes = 64 << 10;
+        }
+        return runIncrementalBenchmark(workload, commandLine.incrementalEdits, commandLine.options.maxNesting, out);
+    }
+    if (commandLine.scalingIterations != 0) {
+        return runScalingBenchmark(commandLine.scalingIterations, commandLine.scalingMargin, commandLine.options.useLalr, out);
+    }
+    if (commandLine.paths.empty()) {
+        err << "Usage: " << commandLine.programName << " <file_path>... | @FILE [--diagnostics-format=text|json] [--error-limit=N] [--parse-threads=N] [--max-nesting=N] [--pipeline] [--parser=rd|lalr] [--output=none|tokens|ast|text|json|binary] [--output-file=FILE] [--bench-parsers[=N]] [--bench-visitors[=N]] [--fold] [--resolve] [--typecheck] [--run[=ast|vm|jit]] [--jit-threshold=N] [--dump-bytecode] [--emit-ir] [--optimize] [--time-passes] [--time-report] [--mem-report] [--profile-parser] [--verify-ir] [--emit-asm[=FILE]] [--compile=EXE] [--codegen=linear|stack] [-j N] [--bench-interp[=N]] [--bench-aot[=N]] [--bench-workload[=N]] [--generate-workload] [--workload-seed=N] [--workload-size=BYTES] [--workload-depth=N] [--workload-expr=N] [--workload-comments=P] [--workload-idents=N] [--bench-scaling[=N]] [--scaling-margin=X] [--bench-incremental[=N]] | --serve=SOCKET [-j N] | --stop-server=SOCKET | --client=SOCKET ARGS...\n";
+        return 1;
+    }
+    if (commandLine.options.profileParser) {
+        if (!parserProfilingEnabled) {
+            err << "--profile-parser: parser profiling is not compiled in, rebuild with CPP_PARSER_PROFILE=1\n";
+            return 1;
+        }
+        // 编译服务拒绝这个选项，进程里只有这一条命令的Parser
+        CommandLine inner = commandLine;
+        inner.options.profileParser = false;
+        int result = runCommandLine(inner, out, err);
+        takeParserProfile().print(err);
+        return result;
+    }
+
+    if (commandLine.paths.size() > 1 || !commandLine.responseFiles.empty()) {
+        CompileOptions options = commandLine.options;
+        if (options.benchIterations != 0 || options.visitorIterations != 0 || !options.asmPath.empty() || !options.executablePath.empty()
+            || !options.syntaxPath.empty()) {
+            err << "--bench-parsers, --bench-visitors, --emit-asm=FILE, --compile and --output-file cannot be used with several input files\n";
+            return 1;
+        }
+        // 批量模式下Token序列和AST的输出量远大于编译本身，默认不输出
+        if (!commandLine.outputGiven) {
+            options.output = OutputMode::None;
+        }
+        return compileBatch(commandLine.paths, options, commandLine.jobsGiven ? commandLine.jobs : 0, out, err);
+    }
+
+    // 语法分析之后的逐函数Pass共用一个线程池，输出与线程数无关
+    ParallelPassManager passes(commandLine.jobs);
+    return compileFile(commandLine.paths.front(), commandLine.options, passes, out, err);
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "aotCompiler.hpp"
+#include "astParser.hpp"
+#include "diagnostics.hpp"
+#include "parallelPasses.hpp"
+#include "syntaxOutput.hpp"
+#include "phaseReport.hpp"
+#include "workloadGenerator.hpp"
+
+// 一次编译的选项，对应命令行参数
+struct CompileOptions {
+    DiagnosticFormat diagnosticFormat = DiagnosticFormat::Text;
+    size_t errorLimit = 20;
+    size_t parseThreads = 0;  // 0表示顺序分析
+    size_t maxNesting = Parser::defaultNestingLimit;  // 递归下降Parser允许的语句和表达式嵌套层数
+    bool pipeline = false;    // 词法分析与语法分析在两个线程上流水线执行
+    bool useLalr = false;     // 使用表驱动的LALR(1)后端代替递归下降
+    size_t benchIterations = 0;  // 非0时只比较两个语法分析后端的性能
+    size_t visitorIterations = 0;  // 非0时分析之后只比较AST遍历的几种写法
+    OutputMode output = OutputMode::Text;  // Token序列和AST的输出方式
+    std::string syntaxPath;   // Token序列和AST写入的文件，为空时与其他结果一起写到out
+    bool fold = false;        // 语法分析之后折叠常量表达式
+    bool resolve = false;     // 语法分析之后做名字解析
+    bool typeCheck = false;   // 名字解析之后做类型检查
+    bool run = false;         // 执行程序
+    bool useVm = false;       // 用字节码虚拟机代替树遍历解释器执行
+    bool dumpBytecode = false;  // 输出编译得到的字节码
+    bool emitIr = false;      // 输出SSA形式的IR
+    bool optimize = false;    // 在IR上运行优化Pass
+    bool timePasses = false;  // 输出每个优化Pass的时间
+    bool timeReport = false;  // 编译结束后输出各阶段的挂钟时间和CPU时间
+    bool memReport = false;   // 编译结束后输出各阶段的分配次数、字节数、峰值和主要的分配点
+    bool profileParser = false;  // 编译结束后输出递归下降Parser每个产生式的剖析结果，需要CPP_PARSER_PROFILE=1
+    bool verifyIrForm = false;  // 构造IR和每个Pass之后检查SSA形式
+    uint32_t jitThreshold = 0;  // 非0时虚拟机中的函数被调用这么多次后编译成本机代码
+    bool emitAsm = false;     // 输出x86-64汇编
+    std::string asmPath;      // 汇编写入的文件，为空时输出到标准输出
+    std::string executablePath;  // 非空时把汇编链接成这个可执行文件
+    RegisterStrategy codegen = RegisterStrategy::LinearScan;
+};
+
+// 读入源文件，absolutePath是用于诊断的绝对路径；失败时返回false，原因写到error
+bool readSourceFile(const std::string& path, std::string& absolutePath, std::string& contents, std::string& error);
+
+// 按options编译一个源文件：分析结果和程序输出写到out，运行时错误和诊断写到err，返回进程的退出码。
+// 只使用参数中的流，不访问全局状态，可以在多个线程上同时编译不同的文件；逐函数Pass交给passes调度。
+// report非空时各阶段的耗时记入report
+int compileSource(const std::string& fileName, const std::string& source, const CompileOptions& options,
+    ParallelPassManager& passes, std::ostream& out, std::ostream& err, PhaseReport* report = nullptr);
+
+// 读入并编译path：先输出"Reading file:"和绝对路径，再调用compileSource。
+// 打开了--time-report或--mem-report时读文件也计入各阶段的统计，报告在最后写到err
+int compileFile(const std::string& path, const CompileOptions& options, ParallelPassManager& passes,
+    std::ostream& out, std::ostream& err);
+
+// 完整的命令行：源文件列表、编译选项和只在命令行层面处理的参数
+struct CommandLine {
+    std::string programName;   // 用于用法说明
+    std::vector<std::string> paths;
+    std::vector<std::string> responseFiles;  // 读入了源文件列表的@FILE，非空时按批量模式编译
+    CompileOptions options;
+    size_t interpIterations = 0;  // 非0时只运行解释器的执行基准
+    size_t aotIterations = 0;     // 非0时只运行提前编译的执行基准
+    size_t workloadIterations = 0;  // 非0时只对合成负载运行词法和语法分析的吞吐量基准
+    size_t incrementalEdits = 0;    // 非0时只对合成负载做这么多次随机编辑，检查增量语法分析与全量分析一致
+    size_t scalingIterations = 0;   // 非0时只运行病态输入的规模测试，有输入增长超过线性时退出码为1
+    double scalingMargin = 0.5;     // 规模测试允许的指数为1加上这个值，缓存和计时的噪声可以让线性的工作测出1.3左右
+    bool generateWorkload = false;  // 只输出按workload生成的程序
+    WorkloadOptions workload;
+    bool workloadSizeGiven = false;
+    size_t jobs = 1;          // 逐函数Pass的并行线程数，批量模式下是同时编译的文件数；0表示硬件线程数
+    bool jobsGiven = false;
+    bool outputGiven = false;
+};
+
+// 把数值参数text完整解析为value（非负整数或小数），不能解析或有多余字符时向err报告并返回false
+template <typename T>
+bool parseFlagValue(const std::string& flag, const std::string& text, T& value, std::ostream& err) {
+    const char* end = text.data() + text.size();
+    auto [last, error] = std::from_chars(text.data(), end, value);
+    if (text.empty() || error != std::errc() || last != end) {
+        err << "invalid value for " << flag << ": " << text << "\n";
+        return false;
+    }
+    return true;
+}
+
+// 解析命令行参数（不含程序名）。workingDirectory非空时，参数和响应文件中的相对路径都相对于它，
+// 供编译服务器按客户端的工作目录解析路径。失败时把原因写到err并返回false
+bool parseCommandLine(const std::vector<std::string>& args, const std::string& workingDirectory,
+    CommandLine& commandLine, std::ostream& err);
+
+// 按命令行执行：单个文件、批量编译或内置基准，返回进程的退出码。与compileSource一样只使用参数中的流
+int runCommandLine(const CommandLine& commandLine, std::ostream& out, std::ostream& err);
@@ -0,0 +1,215 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "incrementalBench.hpp"
+#include "incrementalParser.hpp"
+#include "lexer.hpp"
+#include "astParser.hpp"
+#include "diagnostics.hpp"
+#include "newVector.cpp"
+
+namespace {
+    // 编辑插入的片段：标识符、常量和空白，也有会改变块边界的括号、分号、注释和字符串
+    const char* const snippets[] = {
+        " ", "\n", "x", "1", " + 1", ";", "{", "}", "(", ")", "=", "/", "if (x) ", "int t = 0;\n", "// note\n", "\"s\"",
+    };
+
+    // splitmix64，与合成负载使用同一种生成器，编辑序列只由种子决定
+    class EditRandom {
+    public:
+        explicit EditRandom(uint64_t seed) : state_(seed) {}
+
+        size_t below(size_t bound) {
+            uint64_t z = (state_ += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            z ^= z >> 31;
+            return bound == 0 ? 0 : static_cast<size_t>(z % bound);
+        }
+
+    private:
+        uint64_t state_;
+    };
+
+    TextEdit randomEdit(EditRandom& random, const std::string& source) {
+        TextEdit edit{ random.below(source.size() + 1), 0, "" };
+        size_t kind = random.below(3);  // 0 插入，1 删除，2 替换
+        if (kind != 0) {
+            edit.removedLength = std::min<size_t>(1 + random.below(8), source.size() - edit.offset);
+        }
+        if (kind != 1) {
+            edit.insertedText = snippets[random.below(std::size(snippets))];
+        }
+        return edit;
+    }
+
+    bool sameTokens(const newVector<Token>& a, const newVector<Token>& b) {
+        if (a.size() != b.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < a.size(); i++) {
+            if (a[i].type != b[i].type || a[i].lexeme != b[i].lexeme || a[i].line != b[i].line
+                || a[i].column != b[i].column || a[i].offset != b[i].offset) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // 用显式栈比较，与AST的析构一样不受树深度限制
+    bool sameTree(const ASTNode* a, const ASTNode* b) {
+        std::vector<std::pair<const ASTNode*, const ASTNode*>> pending = { { a, b } };
+        while (!pending.empty()) {
+            auto [left, right] = pending.back();
+            pending.pop_back();
+            if (left == nullptr || right == nullptr) {
+                if (left != right) {
+                    return false;
+                }
+                continue;
+            }
+            if (left->type != right->type || left->value != right->value || left->children.size() != right->children.size()) {
+                return false;
+            }
+            for (size_t i = 0; i < left->children.size(); i++) {
+                pending.emplace_back(left->children[i], right->children[i]);
+            }
+        }
+        return true;
+    }
+
+    std::string renderDiagnostics(const DiagnosticEngine& diagnostics) {
+        std::ostringstream os;
+        diagnostics.render(os, DiagnosticFormat::Text);
+        return os.str();
+    }
+
+    // 与驱动程序相同的全量分析：词法分析和语法分析共用一个收集器
+    struct FullParse {
+        newVector<Token> tokens;
+        ASTNode* ast = nullptr;
+        std::string diagnostics;
+    };
+
+    FullParse parseFull(const std::string& source, size_t nestingLimit) {
+        FullParse result;
+        DiagnosticEngine diagnostics;
+        Lexer lexer(source, diagnostics);
+        result.tokens = lexer.lex();
+        Parser parser(result.tokens, diagnostics);
+        parser.setNestingLimit(nestingLimit);
+        parser.parse();
+        result.ast = parser.getAST();
+        result.diagnostics = renderDiagnostics(diagnostics);
+        return result;
+    }
+
+    std::string quote(const std::string& text) {
+        std::ostringstream os;
+        os << std::quoted(text);
+        return os.str();
+    }
+}
+
+int runIncrementalBenchmark(const WorkloadOptions& options, size_t edits, size_t nestingLimit, std::ostream& os) {
+    std::string source = generateWorkload(options);
+    EditRandom random(options.seed);
+    // 错误上限与全量分析的DiagnosticEngine相同
+    IncrementalParser incremental(source, DiagnosticEngine().errorLimit(), nestingLimit);
+
+    double incrementalSeconds = 0.0;
+    double fullSeconds = 0.0;
+    // 编辑后没有诊断信息的那部分编辑单独计时，有错误时取AST还要把出错的块与后面的块一起重新分析
+    double cleanIncrementalSeconds = 0.0;
+    double cleanFullSeconds = 0.0;
+    size_t cleanEdits = 0;
+    size_t reparsedChunks = 0;
+    size_t reparsedTokens = 0;
+    size_t tailReparses = 0;
+    size_t fullTokens = 0;
+    size_t mismatches = 0;
+    std::string firstMismatch;
+
+    TextEdit undo{ 0, 0, "" };
+    bool pendingUndo = false;
+    for (size_t i = 0; i < edits; i++) {
+        TextEdit edit{ 0, 0, "" };
+        bool undoing = pendingUndo;
+        if (pendingUndo) {
+            edit = undo;
+            pendingUndo = false;
+        }
+        else {
+            edit = randomEdit(random, source);
+            undo = { edit.offset, edit.insertedText.size(), source.substr(edit.offset, edit.removedLength) };
+        }
+        source.replace(edit.offset, edit.removedLength, edit.insertedText);
+
+        auto start = std::chrono::steady_clock::now();
+        bool localEdit = incremental.applyEdit(edit);
+        ASTNode* ast = incremental.getAST();
+        auto middle = std::chrono::steady_clock::now();
+        FullParse full = parseFull(source, nestingLimit);
+        auto end = std::chrono::steady_clock::now();
+        double incrementalTime = std::chrono::duration<double>(middle - start).count();
+        double fullTime = std::chrono::duration<double>(end - middle).count();
+        incrementalSeconds += incrementalTime;
+        fullSeconds += fullTime;
+        if (full.diagnostics.empty()) {
+            cleanIncrementalSeconds += incrementalTime;
+            cleanFullSeconds += fullTime;
+            cleanEdits++;
+        }
+        reparsedChunks += incremental.lastReparsedChunks();
+        reparsedTokens += incremental.lastReparsedTokens();
+        tailReparses += localEdit ? 0 : 1;
+        fullTokens = full.tokens.size();
+        // 引入错误的编辑在下一次被撤销，就像编辑器里改到一半的代码随后被补全，程序不会越改越乱
+        pendingUndo = !undoing && !full.diagnostics.empty();
+
+        DiagnosticEngine collected;
+        incremental.collectDiagnostics(collected);
+        const char* mismatch = incremental.source() != source ? "source"
+            : !sameTokens(incremental.tokens(), full.tokens) ? "tokens"
+            : !sameTree(ast, full.ast) ? "AST"
+            : renderDiagnostics(collected) != full.diagnostics ? "diagnostics"
+            : nullptr;
+        delete full.ast;
+        if (mismatch != nullptr) {
+            if (mismatches == 0) {
+                firstMismatch = std::string(mismatch) + " differ after edit " + std::to_string(i + 1) + " (offset "
+                    + std::to_string(edit.offset) + ", removed " + std::to_string(edit.removedLength)
+                    + ", inserted " + quote(edit.insertedText) + ")";
+            }
+            mismatches++;
+        }
+    }
+
+    double count = edits == 0 ? 1.0 : static_cast<double>(edits);
+    os << "Incremental parsing: " << edits << " edit(s) on a " << source.size() << "-byte program, seed " << options.seed << "\n";
+    os << std::fixed << std::setprecision(3);
+    os << "  incremental  " << std::setw(10) << incrementalSeconds * 1000.0 / count << " ms/edit  ("
+        << std::setprecision(1) << static_cast<double>(reparsedChunks) / count << " chunks, "
+        << static_cast<double>(reparsedTokens) / count << " tokens reparsed on average, "
+        << tailReparses << " reparse(s) to end of file)\n";
+    os << std::setprecision(3) << "  full reparse " << std::setw(10) << fullSeconds * 1000.0 / count << " ms/edit  ("
+        << fullTokens << " tokens)\n";
+    if (incrementalSeconds > 0.0) {
+        os << std::setprecision(1) << "  speedup      " << std::setw(10) << fullSeconds / incrementalSeconds << "x\n";
+    }
+    if (cleanEdits != 0 && cleanIncrementalSeconds > 0.0) {
+        os << std::setprecision(3) << "  error-free   " << std::setw(10) << cleanIncrementalSeconds * 1000.0 / static_cast<double>(cleanEdits)
+            << " ms/edit  (" << cleanEdits << " edit(s), " << std::setprecision(1) << cleanFullSeconds / cleanIncrementalSeconds
+            << "x faster than a full reparse)\n";
+    }
+    if (mismatches == 0) {
+        os << "Source, tokens, AST and diagnostics matched a full reparse after every edit\n";
+        return 0;
+    }
+    os << mismatches << " edit(s) did not match a full reparse; first: " << firstMismatch << "\n";
+    return 1;
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include <cstddef>
+#include <iostream>
+#include "workloadGenerator.hpp"
+
+// 增量语法分析的正确性和速度检查：按options生成程序，对它做edits次随机编辑（插入、删除、替换，
+// 包括破坏块边界的括号和注释，引入错误的编辑随后被撤销），每次编辑后把IncrementalParser的源码、
+// Token序列、AST和诊断信息与全量的词法分析和语法分析比较，并比较两者的耗时。
+// 两者都使用nestingLimit作为嵌套上限。有任何不一致时输出第一处不一致并返回非0
+int runIncrementalBenchmark(const WorkloadOptions& options, size_t edits, size_t nestingLimit, std::ostream& os);
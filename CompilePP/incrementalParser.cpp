@@ -0,0 +1,525 @@
+#include <algorithm>
+#include <utility>
+#include "incrementalParser.hpp"
+#include "parallelParser.hpp"
+#include "newVector.cpp"
+
+namespace {
+    // 区域内的Token是否恰好由若干个完整的外部声明组成
+    bool isBalanced(const newVector<Token>& tokens, size_t count) {
+        size_t depth = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (tokens[i].type == TokenType::LEFT_BRACE) {
+                depth++;
+            }
+            else if (tokens[i].type == TokenType::RIGHT_BRACE && depth > 0) {
+                depth--;
+            }
+        }
+        if (depth != 0) {
+            return false;
+        }
+        return count == 0 || tokens[count - 1].type == TokenType::SEMICOLON || tokens[count - 1].type == TokenType::RIGHT_BRACE;
+    }
+
+    size_t countNewlines(const std::string& text) {
+        size_t count = 0;
+        for (char c : text) {
+            if (c == '\n') {
+                count++;
+            }
+        }
+        return count;
+    }
+
+    // range是否在line行column列之前
+    bool startsBefore(const SourceRange& range, size_t line, size_t column) {
+        return range.line < line || (range.line == line && range.column < column);
+    }
+}
+
+// 依次提供first及之后各块的Token，位置换算成整个文件中的位置，最后是EOF
+class IncrementalParser::ChunkSource : public TokenSource {
+public:
+    ChunkSource(const IncrementalParser& owner, size_t first)
+        : owner_(owner), first_(first), next_(first), position_(0), candidate_(first + 1), stoppedAt_(owner.chunks_.size()),
+          start_(owner.chunkStart(first)), line_(owner.chunkLine(first)), tokenCount_(0) {
+    }
+
+    // 与流水线一样按批提供：分析器每分析完4096个Token丢弃一次，复制的是还没分析的部分，批太大会反复复制
+    bool fetch(newVector<Token>& tokens) override {
+        const std::vector<Chunk>& chunks = owner_.chunks_;
+        if (next_ > chunks.size()) {
+            return false;
+        }
+        if (next_ == chunks.size()) {
+            tokens.push_back({ TokenType::END_OF_FILE, "EOF", line_, owner_.eofColumn_, start_ });
+            next_++;
+            return true;
+        }
+        const Chunk& chunk = chunks[next_];
+        size_t end = std::min(chunk.tokens.size(), position_ + batchSize);
+        for (; position_ < end; position_++) {
+            Token shifted = chunk.tokens[position_];
+            shifted.offset += start_;
+            shifted.line += line_;
+            tokens.push_back(shifted);
+            tokenCount_++;
+        }
+        if (position_ == chunk.tokens.size()) {
+            start_ += chunk.text.size();
+            line_ += chunk.newlines;
+            next_++;
+            position_ = 0;
+        }
+        return true;
+    }
+
+    // 分析器在外部声明之间，下一个Token恰好是某个已经提供的块的第一个Token，
+    // 而且这个块单独分析时没有诊断：从这里开始与单独分析各块的结果相同
+    bool stopBefore(const Token& next) override {
+        const std::vector<Chunk>& chunks = owner_.chunks_;
+        for (; candidate_ < chunks.size() && (candidate_ < next_ || (candidate_ == next_ && position_ != 0)); candidate_++) {
+            const Chunk& chunk = chunks[candidate_];
+            if (chunk.tokens.size() == 0) {
+                continue;
+            }
+            size_t offset = owner_.chunkStart(candidate_) + chunk.tokens[0].offset;
+            if (offset > next.offset) {
+                return false;
+            }
+            if (offset == next.offset && !chunk.syntaxDiagnostics) {
+                stoppedAt_ = candidate_;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 分析器停在哪个块的起点；一直分析到文件末尾时是块数
+    size_t stoppedAt() const {
+        return stoppedAt_;
+    }
+
+    // 分析器实际分析了的块数和Token数
+    size_t chunkCount() const {
+        return std::min(stoppedAt_, position_ != 0 ? next_ + 1 : next_) - first_;
+    }
+
+    size_t tokenCount() const {
+        return tokenCount_;
+    }
+
+private:
+    static constexpr size_t batchSize = 1024;
+
+    const IncrementalParser& owner_;
+    size_t first_;
+    size_t next_;       // 下一个要提供的块，等于块数时提供EOF
+    size_t position_;   // next_中已经提供的Token数
+    size_t candidate_;  // 下一个可能停止的块
+    size_t stoppedAt_;
+    size_t start_;
+    size_t line_;
+    size_t tokenCount_;
+};
+
+void IncrementalParser::Fenwick::reset(const std::vector<long long>& values) {
+    tree.assign(values.size() + 1, 0);
+    for (size_t i = 1; i < tree.size(); i++) {
+        tree[i] += values[i - 1];
+        size_t parent = i + (i & (~i + 1));
+        if (parent < tree.size()) {
+            tree[parent] += tree[i];
+        }
+    }
+}
+
+void IncrementalParser::Fenwick::add(size_t index, long long delta) {
+    for (size_t i = index + 1; i < tree.size(); i += i & (~i + 1)) {
+        tree[i] += delta;
+    }
+}
+
+long long IncrementalParser::Fenwick::prefix(size_t count) const {
+    long long sum = 0;
+    for (size_t i = count; i > 0; i -= i & (~i + 1)) {
+        sum += tree[i];
+    }
+    return sum;
+}
+
+size_t IncrementalParser::Fenwick::upperCount(long long value) const {
+    size_t size = tree.size() - 1;
+    size_t step = 1;
+    while (step * 2 <= size) {
+        step *= 2;
+    }
+    size_t position = 0;
+    for (; step != 0; step /= 2) {
+        if (position + step <= size && tree[position + step] <= value) {
+            position += step;
+            value -= tree[position];
+        }
+    }
+    return position;
+}
+
+IncrementalParser::IncrementalParser(const std::string& source, size_t errorLimit, size_t nestingLimit)
+    : eofColumn_(0), errorLimit_(errorLimit), nestingLimit_(nestingLimit), root_(new ASTNode("ExternalDeclaration", "")),
+      reconciled_(false), diagnostics_(errorLimit), lastReparsedChunks_(0), lastReparsedTokens_(0) {
+    // 初始时整个文件是一个块，第一次分析等价于重新分析这个块
+    chunks_.push_back(Chunk());
+    rebuildIndex();
+    std::vector<Chunk> result;
+    bool extend = false;
+    reparseRegion(0, 0, source, result, extend);
+    chunks_ = std::move(result);
+    rebuildIndex();
+}
+
+IncrementalParser::~IncrementalParser() {
+    root_->children.clear();
+    delete root_;
+    for (Chunk& chunk : chunks_) {
+        for (ASTNode* node : chunk.nodes) {
+            delete node;
+        }
+    }
+    for (ASTNode* node : recovered_) {
+        delete node;
+    }
+}
+
+size_t IncrementalParser::lastReparsedChunks() const {
+    return lastReparsedChunks_;
+}
+
+size_t IncrementalParser::lastReparsedTokens() const {
+    return lastReparsedTokens_;
+}
+
+void IncrementalParser::rebuildIndex() {
+    std::vector<long long> lengths(chunks_.size());
+    std::vector<long long> lines(chunks_.size());
+    for (size_t i = 0; i < chunks_.size(); i++) {
+        lengths[i] = static_cast<long long>(chunks_[i].text.size());
+        lines[i] = static_cast<long long>(chunks_[i].newlines);
+    }
+    lengths_.reset(lengths);
+    lines_.reset(lines);
+}
+
+size_t IncrementalParser::chunkStart(size_t chunk) const {
+    return static_cast<size_t>(lengths_.prefix(chunk));
+}
+
+size_t IncrementalParser::chunkLine(size_t chunk) const {
+    return 1 + static_cast<size_t>(lines_.prefix(chunk));
+}
+
+// 起点不超过offset的最后一个块
+size_t IncrementalParser::chunkAt(size_t offset) const {
+    size_t count = lengths_.upperCount(static_cast<long long>(offset));
+    return count >= chunks_.size() ? chunks_.size() - 1 : count;
+}
+
+// 单独分析一个块；有诊断时只记下来，诊断信息在取结果时与后面的块一起重新分析得到
+void IncrementalParser::parseChunk(Chunk& chunk, size_t eofLine, size_t eofColumn) const {
+    // 括号不配对或者没有以 ';' '}' 结尾的块一定有语法错误，取结果时反正要重新分析
+    if (!isBalanced(chunk.tokens, chunk.tokens.size())) {
+        chunk.syntaxDiagnostics = true;
+        return;
+    }
+    newVector<Token> slice(chunk.tokens);
+    slice.push_back({ TokenType::END_OF_FILE, "EOF", eofLine, eofColumn, chunk.text.size() });
+
+    DiagnosticEngine localDiagnostics(0);
+    Parser parser(std::move(slice), localDiagnostics);
+    parser.setNestingLimit(nestingLimit_);
+    ASTNode* root = parser.buildAST();
+    chunk.nodes.swap(root->children);
+    delete root;
+
+    chunk.syntaxDiagnostics = !localDiagnostics.diagnostics().empty() || localDiagnostics.suppressedCount() != 0;
+}
+
+// 重新分析块[first, last]，text是这些块编辑后的源码
+// 返回false表示区域末尾与下一个块对不上：extend为true时只需把下一个块纳入区域，否则块边界已被破坏
+bool IncrementalParser::reparseRegion(size_t first, size_t last, const std::string& text, std::vector<Chunk>& result, bool& extend) {
+    result.clear();
+    extend = false;
+
+    size_t line = chunkLine(first);
+    size_t column = chunks_[first].column;
+
+    // 下一个块的第一个Token用作同步点：区域一直分析到它结束，它必须原样出现
+    bool hasNext = last + 1 < chunks_.size();
+    std::string lexText = text;
+    const Token* sync = nullptr;
+    if (hasNext) {
+        const Chunk& next = chunks_[last + 1];
+        if (next.tokens.size() == 0) {
+            extend = true;
+            return false;
+        }
+        sync = &next.tokens[0];
+        lexText.append(next.text, 0, sync->offset + sync->lexeme.size());
+    }
+
+    DiagnosticEngine localDiagnostics(0);
+    Lexer lexer(lexText, localDiagnostics, 0, lexText.size(), line, column);
+    newVector<Token> tokens = lexer.lex();
+    size_t count = tokens.size() - 1;
+    size_t eofLine = tokens[count].line;
+    size_t eofColumn = tokens[count].column;
+
+    if (hasNext) {
+        if (count == 0) {
+            return false;
+        }
+        const Token& tail = tokens[count - 1];
+        if (tail.type != sync->type || tail.lexeme != sync->lexeme || tail.offset != text.size() + sync->offset) {
+            return false;
+        }
+        if (tail.column != sync->column) {
+            // 下一个块与编辑处在同一行，列号变了
+            extend = true;
+            return false;
+        }
+        // 同步Token属于下一个块，用它的位置充当本区域的EOF
+        eofLine = tail.line;
+        eofColumn = tail.column;
+        count--;
+        if (!isBalanced(tokens, count)) {
+            return false;
+        }
+    }
+    else {
+        eofColumn_ = eofColumn;
+    }
+    lastReparsedTokens_ = count;
+
+    // 区域内的Token按外部声明切分成块
+    newVector<Token> regionTokens;
+    regionTokens.reserve(count + 1);
+    for (size_t i = 0; i < count; i++) {
+        regionTokens.push_back(tokens[i]);
+    }
+    regionTokens.push_back(tokens[tokens.size() - 1]);
+    std::vector<TokenRange> ranges = splitExternalDeclarations(regionTokens);
+
+    // 每个块的起点（相对区域）、起始行号和第一个Token的列号
+    std::vector<size_t> starts(1, 0);
+    std::vector<size_t> baseLines(1, line);
+    std::vector<size_t> headColumns(1, 0);
+    result.push_back(Chunk());
+    result.back().column = column;
+    for (size_t i = 0; i < ranges.size(); i++) {
+        const Token& head = regionTokens[ranges[i].begin];
+        // 只在源码与词素完全一致的Token处开始新块，这样才能从它的行列号恢复词法分析器状态
+        // （字符串字面量等Token的词素与源码不一致，归入前一个块）
+        bool cleanHead = head.type != TokenType::STRING && head.lexeme.find('\n') == std::string::npos
+            && lexText.compare(head.offset, head.lexeme.size(), head.lexeme) == 0;
+        if (i != 0 && cleanHead) {
+            starts.push_back(head.offset);
+            baseLines.push_back(head.line);
+            headColumns.push_back(head.column);
+            result.push_back(Chunk());
+            result.back().column = head.column - 1;
+        }
+        Chunk& chunk = result.back();
+        for (size_t j = ranges[i].begin; j < ranges[i].end; j++) {
+            Token token = regionTokens[j];
+            token.offset -= starts.back();
+            token.line -= baseLines.back();
+            chunk.tokens.push_back(token);
+        }
+    }
+
+    for (size_t i = 0; i < result.size(); i++) {
+        size_t end = i + 1 < result.size() ? starts[i + 1] : text.size();
+        result[i].text.assign(text, starts[i], end - starts[i]);
+        result[i].newlines = countNewlines(result[i].text);
+    }
+
+    // 词法诊断按位置分到各块；同步Token处的诊断属于下一个块，那里已经记录过
+    size_t owner = 0;
+    for (Diagnostic diagnostic : localDiagnostics.diagnostics()) {
+        if (hasNext && !startsBefore(diagnostic.range, eofLine, eofColumn)) {
+            break;
+        }
+        while (owner + 1 < result.size() && !startsBefore(diagnostic.range, baseLines[owner + 1], headColumns[owner + 1])) {
+            owner++;
+        }
+        diagnostic.range.line -= baseLines[owner];
+        diagnostic.range.endLine -= baseLines[owner];
+        result[owner].lexDiagnostics.push_back(diagnostic);
+    }
+    result[0].lexSuppressed = localDiagnostics.suppressedCount();
+
+    for (size_t i = 0; i < result.size(); i++) {
+        parseChunk(result[i], eofLine - baseLines[i], eofColumn);
+    }
+    return true;
+}
+
+bool IncrementalParser::applyEdit(const TextEdit& edit) {
+    size_t total = static_cast<size_t>(lengths_.prefix(chunks_.size()));
+    size_t offset = edit.offset > total ? total : edit.offset;
+    size_t removed = edit.removedLength > total - offset ? total - offset : edit.removedLength;
+
+    // 受影响的块：包含编辑起点的块，到删除范围内最后一个字符所在的块
+    size_t first = chunkAt(offset);
+    size_t last = removed == 0 ? first : chunkAt(offset + removed - 1);
+
+    std::string text;
+    for (size_t i = first; i <= last; i++) {
+        text += chunks_[i].text;
+    }
+    text.replace(offset - chunkStart(first), removed, edit.insertedText);
+
+    bool incremental = true;
+    std::vector<Chunk> result;
+    bool extend = false;
+    while (!reparseRegion(first, last, text, result, extend)) {
+        if (extend) {
+            last++;
+            text += chunks_[last].text;
+        }
+        else {
+            // 块边界被破坏（例如删掉了 '}'），从这里一直分析到文件末尾
+            while (last + 1 < chunks_.size()) {
+                last++;
+                text += chunks_[last].text;
+            }
+            incremental = false;
+        }
+    }
+
+    for (size_t i = first; i <= last; i++) {
+        for (ASTNode* node : chunks_[i].nodes) {
+            delete node;
+        }
+    }
+    lastReparsedChunks_ = result.size();
+
+    size_t replaced = last - first + 1;
+    if (result.size() == replaced) {
+        // 常见情况：块数不变，原地替换并更新前缀和
+        for (size_t i = 0; i < replaced; i++) {
+            Chunk& chunk = chunks_[first + i];
+            lengths_.add(first + i, static_cast<long long>(result[i].text.size()) - static_cast<long long>(chunk.text.size()));
+            lines_.add(first + i, static_cast<long long>(result[i].newlines) - static_cast<long long>(chunk.newlines));
+            chunk = std::move(result[i]);
+        }
+    }
+    else {
+        chunks_.erase(chunks_.begin() + first, chunks_.begin() + last + 1);
+        chunks_.insert(chunks_.begin() + first, std::make_move_iterator(result.begin()), std::make_move_iterator(result.end()));
+        rebuildIndex();
+    }
+    reconciled_ = false;
+    return incremental;
+}
+
+// 按全量分析的顺序整理AST和诊断信息：全量分析先完成词法分析，再逐个分析外部声明，
+// 错误数达到上限后停止。单独分析时没有诊断的块，只要分析器在它的起点处于外部声明之间，结果就与全量分析相同
+void IncrementalParser::reconcile() {
+    for (ASTNode* node : recovered_) {
+        delete node;
+    }
+    recovered_.clear();
+    root_->children.clear();
+    diagnostics_ = DiagnosticEngine(errorLimit_);
+
+    size_t line = 1;
+    for (const Chunk& chunk : chunks_) {
+        for (Diagnostic diagnostic : chunk.lexDiagnostics) {
+            diagnostic.range.line += line;
+            diagnostic.range.endLine += line;
+            diagnostics_.report(diagnostic.severity, diagnostic.code, diagnostic.range, diagnostic.message);
+        }
+        diagnostics_.addSuppressed(chunk.lexSuppressed);
+        line += chunk.newlines;
+    }
+
+    size_t chunk = 0;
+    while (chunk < chunks_.size()) {
+        if (diagnostics_.limitReached()) {
+            // 分析器在这里停止，并在下一个Token处报告没有分析完，这条错误超过上限被丢弃
+            for (size_t i = chunk; i < chunks_.size(); i++) {
+                if (chunks_[i].tokens.size() != 0) {
+                    diagnostics_.addSuppressed(1);
+                    break;
+                }
+            }
+            break;
+        }
+        if (chunks_[chunk].syntaxDiagnostics) {
+            chunk = resync(chunk);
+            continue;
+        }
+        root_->children.insert(root_->children.end(), chunks_[chunk].nodes.begin(), chunks_[chunk].nodes.end());
+        chunk++;
+    }
+    reconciled_ = true;
+}
+
+// 从有诊断的块first开始像全量分析一样继续分析，直到分析器在外部声明之间回到一个没有诊断的块的起点，
+// 返回这个块；一直没有回到块起点时分析到文件末尾，返回块数
+size_t IncrementalParser::resync(size_t first) {
+    ChunkSource source(*this, first);
+    Parser parser(source, diagnostics_);
+    parser.setNestingLimit(nestingLimit_);
+    ASTNode* root = parser.buildAST();
+    recovered_.insert(recovered_.end(), root->children.begin(), root->children.end());
+    root_->children.insert(root_->children.end(), root->children.begin(), root->children.end());
+    root->children.clear();
+    delete root;
+
+    lastReparsedChunks_ += source.chunkCount();
+    lastReparsedTokens_ += source.tokenCount();
+    return source.stoppedAt();
+}
+
+ASTNode* IncrementalParser::getAST() {
+    if (!reconciled_) {
+        reconcile();
+    }
+    return root_;
+}
+
+std::string IncrementalParser::source() const {
+    std::string source;
+    source.reserve(static_cast<size_t>(lengths_.prefix(chunks_.size())));
+    for (const Chunk& chunk : chunks_) {
+        source += chunk.text;
+    }
+    return source;
+}
+
+newVector<Token> IncrementalParser::tokens() const {
+    newVector<Token> tokens;
+    size_t start = 0;
+    size_t line = 1;
+    for (const Chunk& chunk : chunks_) {
+        for (const Token& token : chunk.tokens) {
+            Token shifted = token;
+            shifted.offset += start;
+            shifted.line += line;
+            tokens.push_back(shifted);
+        }
+        start += chunk.text.size();
+        line += chunk.newlines;
+    }
+    tokens.push_back({ TokenType::END_OF_FILE, "EOF", line, eofColumn_, start });
+    return tokens;
+}
+
+void IncrementalParser::collectDiagnostics(DiagnosticEngine& diagnostics) {
+    if (!reconciled_) {
+        reconcile();
+    }
+    diagnostics.merge(diagnostics_);
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "lexer.hpp"
+#include "astParser.hpp"
+#include "diagnostics.hpp"
+
+// 一次文本编辑：从offset开始删除removedLength个字符，再插入insertedText
+struct TextEdit {
+    size_t offset;
+    size_t removedLength;
+    std::string insertedText;
+};
+
+// 增量语法分析器，供编辑器集成使用
+// 源码按外部声明切分成若干块，每块保存自己的源码、Token、AST子树和诊断信息，
+// 块内的位置都相对于块起点。块的起始偏移和行号由树状数组维护，
+// 编辑时只重新分析受影响的块，其余块原样复用，所以开销与被编辑的函数大小相关，而不是整个文件。
+// 有语法错误时错误恢复可能越过块边界，错误上限也要按全量分析的顺序计算，这些都推迟到取AST或诊断信息时处理：
+// 从有错误的块开始像全量分析一样继续分析，分析器回到某个没有错误的块的起点后就复用后面各块的结果。
+// errorLimit与全量分析所用的DiagnosticEngine上限相同，nestingLimit见Parser::setNestingLimit
+class IncrementalParser {
+public:
+    explicit IncrementalParser(const std::string& source, size_t errorLimit = 20,
+        size_t nestingLimit = Parser::defaultNestingLimit);
+    ~IncrementalParser();
+
+    IncrementalParser(const IncrementalParser&) = delete;
+    IncrementalParser& operator=(const IncrementalParser&) = delete;
+
+    // 应用一次编辑；返回false表示编辑破坏了块边界，已从受影响处重新分析到文件末尾
+    bool applyEdit(const TextEdit& edit);
+
+    // 以下接口按需拼接完整结果，开销与文件大小成正比
+    std::string source() const;
+    newVector<Token> tokens() const;
+    // 把诊断信息写入diagnostics，diagnostics的上限与errorLimit相同时结果与全量分析一致
+    void collectDiagnostics(DiagnosticEngine& diagnostics);
+
+    // 与全量分析结构相同的AST，根节点归IncrementalParser所有
+    ASTNode* getAST();
+
+    // 上一次编辑以及随后取结果时重新分析的块数和Token数
+    size_t lastReparsedChunks() const;
+    size_t lastReparsedTokens() const;
+
+private:
+    // 一个外部声明对应的块，从它的第一个Token开始，到下一个块的第一个Token之前
+    struct Chunk {
+        std::string text;
+        size_t newlines = 0;
+        size_t column = 0;  // 块起点处词法分析器的列号状态
+        newVector<Token> tokens;  // offset相对块起点，line从0开始
+        std::vector<ASTNode*> nodes;  // 单独分析这个块得到的子树
+        // 块内的词法诊断，行号从0开始；lexSuppressed是词法分析时去重丢弃的错误数
+        std::vector<Diagnostic> lexDiagnostics;
+        size_t lexSuppressed = 0;
+        // 单独分析时报告了语法诊断，取结果时要与后面的块一起重新分析
+        bool syntaxDiagnostics = false;
+    };
+
+    // 从某个块开始按顺序提供各块的Token，分析器回到没有语法诊断的块的起点时让它停止
+    class ChunkSource;
+
+    // 树状数组，维护块长度和块内换行数的前缀和
+    struct Fenwick {
+        std::vector<long long> tree;
+        void reset(const std::vector<long long>& values);
+        void add(size_t index, long long delta);
+        long long prefix(size_t count) const;
+        // 满足prefix(k) <= value的最大k
+        size_t upperCount(long long value) const;
+    };
+
+    std::vector<Chunk> chunks_;
+    Fenwick lengths_;
+    Fenwick lines_;
+    size_t eofColumn_;
+    size_t errorLimit_;
+    size_t nestingLimit_;
+    ASTNode* root_;
+    // 以下是按全量分析的顺序整理好的结果，编辑后失效，取结果时重新整理
+    bool reconciled_;
+    std::vector<ASTNode*> recovered_;  // 与后面的块一起重新分析得到的子树
+    DiagnosticEngine diagnostics_;
+    size_t lastReparsedChunks_;
+    size_t lastReparsedTokens_;
+
+    size_t chunkStart(size_t chunk) const;
+    size_t chunkLine(size_t chunk) const;
+    size_t chunkAt(size_t offset) const;
+    void rebuildIndex();
+    bool reparseRegion(size_t first, size_t last, const std::string& text, std::vector<Chunk>& result, bool& columnMismatch);
+    void parseChunk(Chunk& chunk, size_t eofLine, size_t eofColumn) const;
+    void reconcile();
+    size_t resync(size_t first);
+};
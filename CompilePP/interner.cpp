@@ -0,0 +1,79 @@
+#include "interner.hpp"
+
+StringInterner::StringInterner(size_t expectedCount) {
+    // 装载因子不超过1/2
+    size_t capacity = 16;
+    while (capacity < expectedCount * 2) {
+        capacity <<= 1;
+    }
+    slots_.assign(capacity, { 0, npos });
+    mask_ = capacity - 1;
+    names_.reserve(expectedCount);
+}
+
+// FNV-1a
+uint32_t StringInterner::hashOf(std::string_view text) {
+    uint32_t hash = 2166136261u;
+    for (char c : text) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// 返回text所在的槽位，不存在时返回探测链末尾的空槽
+size_t StringInterner::probe(std::string_view text, uint32_t hash) const {
+    size_t position = hash & mask_;
+    while (true) {
+        const Slot& slot = slots_[position];
+        if (slot.id == npos || (slot.hash == hash && names_[slot.id] == text)) {
+            return position;
+        }
+        position = (position + 1) & mask_;
+    }
+}
+
+uint32_t StringInterner::intern(std::string_view text) {
+    uint32_t hash = hashOf(text);
+    size_t position = probe(text, hash);
+    if (slots_[position].id != npos) {
+        return slots_[position].id;
+    }
+    if ((names_.size() + 1) * 2 > slots_.size()) {
+        grow();
+        position = probe(text, hash);
+    }
+    uint32_t id = static_cast<uint32_t>(names_.size());
+    names_.emplace_back(text);
+    slots_[position] = { hash, id };
+    return id;
+}
+
+uint32_t StringInterner::find(std::string_view text) const {
+    return slots_[probe(text, hashOf(text))].id;
+}
+
+const std::string& StringInterner::name(uint32_t id) const {
+    return names_[id];
+}
+
+size_t StringInterner::size() const {
+    return names_.size();
+}
+
+void StringInterner::grow() {
+    std::vector<Slot> old;
+    old.swap(slots_);
+    slots_.assign(old.size() * 2, { 0, npos });
+    mask_ = slots_.size() - 1;
+    for (const Slot& slot : old) {
+        if (slot.id == npos) {
+            continue;
+        }
+        size_t position = slot.hash & mask_;
+        while (slots_[position].id != npos) {
+            position = (position + 1) & mask_;
+        }
+        slots_[position] = slot;
+    }
+}
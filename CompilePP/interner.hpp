@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 标识符驻留表：每个不同的字符串对应一个从0开始的连续编号
+// 开放寻址、线性探测，槽位里保存哈希值，探测时先比较哈希再比较字符串
+class StringInterner {
+public:
+    static constexpr uint32_t npos = UINT32_MAX;
+
+    explicit StringInterner(size_t expectedCount = 256);
+
+    // 返回text的编号，第一次出现时分配新编号
+    uint32_t intern(std::string_view text);
+    // 只查找不插入，不存在时返回npos
+    uint32_t find(std::string_view text) const;
+    const std::string& name(uint32_t id) const;
+    size_t size() const;
+
+private:
+    struct Slot {
+        uint32_t hash;
+        uint32_t id;  // npos表示空槽
+    };
+
+    std::vector<Slot> slots_;
+    std::vector<std::string> names_;
+    size_t mask_;
+
+    static uint32_t hashOf(std::string_view text);
+    size_t probe(std::string_view text, uint32_t hash) const;
+    void grow();
+};
@@ -0,0 +1,829 @@
+#include "interpreter.hpp"
+
+namespace {
+    const ASTNode* childAt(const ASTNode* node, size_t index) {
+        return node != nullptr && index < node->children.size() ? node->children[index] : nullptr;
+    }
+
+    // 内置函数
+    const char* const printBuiltin = "print";
+}
+
+Interpreter::Interpreter(std::ostream& out, size_t maxCallDepth)
+    : out_(out), maxCallDepth_(maxCallDepth), main_(nullptr), resolver_(nullptr), loopDepth_(0),
+    frameBase_(0), stackTop_(0), arrayTop_(0), callDepth_(0), returnValue_(RuntimeValue::zero(ValueType::Void)), executed_(0) {
+}
+
+uint64_t Interpreter::executedNodes() const {
+    return executed_;
+}
+
+void Interpreter::load(const ASTNode* root) {
+    exprs_.clear();
+    stmts_.clear();
+    functions_.clear();
+    globalTypes_.clear();
+    globalInit_.clear();
+    main_ = nullptr;
+    if (root == nullptr) {
+        throw RuntimeError("no program to run");
+    }
+
+    NameResolver resolver;
+    resolver.resolve(root);
+    if (!resolver.redeclarations().empty()) {
+        throw RuntimeError("redeclared identifier '" + resolver.redeclarations().front().declarator->value + "'");
+    }
+    // 降级和执行都按AST的深度递归
+    if (resolver.tooDeep() != nullptr) {
+        throw RuntimeError("program is nested more than " + std::to_string(astDepthLimit) + " levels deep");
+    }
+    resolver_ = &resolver;
+    arrayLengths_.assign(resolver.symbols().size(), -1);
+
+    // 先确定所有函数的签名和全局变量的类型，函数体里可以调用后面定义的函数
+    functions_.resize(resolver.functionCount());
+    globalTypes_.assign(resolver.globalCount(), ValueType::Int);
+    for (const Symbol& symbol : resolver.symbols()) {
+        if (symbol.kind == SymbolKind::Function) {
+            declareFunction(symbol);
+        }
+        else if (symbol.depth == 0) {
+            globalTypes_[symbol.slot] = typeOf(symbol.type);
+        }
+    }
+
+    for (const ASTNode* declaration : root->children) {
+        if (declaration == nullptr) {
+            continue;
+        }
+        if (declaration->type == "FunctionDefinitionNode") {
+            const Symbol* symbol = resolver.declarationOf(childAt(childAt(declaration, 1), 1));
+            if (symbol == nullptr || symbol->definition != declaration) {
+                throw RuntimeError("malformed function definition");
+            }
+            loopDepth_ = 0;
+            functions_[symbol->slot].body = lowerStatement(childAt(declaration, 2));
+        }
+        else if (declaration->type == "DeclarationNode") {
+            globalInit_.push_back(lowerDeclaration(declaration, true));
+        }
+        else {
+            throw RuntimeError("unsupported external declaration '" + declaration->type + "'");
+        }
+    }
+    resolver_ = nullptr;
+}
+
+// 函数符号的签名来自它的定义，只有原型的函数不能被调用
+void Interpreter::declareFunction(const Symbol& symbol) {
+    Function& function = functions_[symbol.slot];
+    function.name = resolver_->names().name(symbol.name);
+    function.returnType = typeOf(symbol.type);
+    function.frameSize = symbol.frameSize;
+    function.body = nullptr;
+    if (symbol.depth == 0 && function.name == "main") {
+        main_ = &function;
+    }
+    if (symbol.definition == nullptr) {
+        return;
+    }
+    // DirectDeclarator: FunctionDeclarator Identifier ParameterList
+    const ASTNode* parameters = childAt(childAt(symbol.definition, 1), 2);
+    if (parameters == nullptr) {
+        return;
+    }
+    for (const ASTNode* parameter : parameters->children) {
+        const Symbol* declared = resolver_->declarationOf(childAt(parameter, 1));
+        if (declared == nullptr) {
+            throw RuntimeError("malformed parameter list of '" + function.name + "'");
+        }
+        function.parameters.push_back({ declared->slot, typeOf(childAt(parameter, 0)) });
+    }
+}
+
+ValueType Interpreter::typeOf(const ASTNode* typeSpecifier) const {
+    ValueType type;
+    if (typeSpecifier == nullptr || !valueTypeFromName(typeSpecifier->value, type)) {
+        throw RuntimeError("unsupported type '" + (typeSpecifier == nullptr ? std::string() : typeSpecifier->value) + "'");
+    }
+    return type;
+}
+
+Interpreter::Expr* Interpreter::newExpr(ExprKind kind, ValueType type) {
+    exprs_.emplace_back();
+    Expr& expr = exprs_.back();
+    expr.kind = kind;
+    expr.op = BinaryOp::Add;
+    expr.type = type;
+    expr.delta = 0;
+    expr.slot = 0;
+    expr.constant = RuntimeValue::zero(ValueType::Int);
+    expr.operands[0] = expr.operands[1] = expr.operands[2] = nullptr;
+    expr.function = nullptr;
+    return &expr;
+}
+
+Interpreter::Stmt* Interpreter::newStmt(StmtKind kind) {
+    stmts_.emplace_back();
+    Stmt& stmt = stmts_.back();
+    stmt.kind = kind;
+    stmt.releasesArrays = false;
+    stmt.expr = nullptr;
+    stmt.step = nullptr;
+    stmt.init = nullptr;
+    stmt.body = nullptr;
+    stmt.alternative = nullptr;
+    return &stmt;
+}
+
+const Interpreter::Stmt* Interpreter::lowerStatement(const ASTNode* node) {
+    if (node == nullptr) {
+        throw RuntimeError("incomplete syntax tree");
+    }
+    const std::string& type = node->type;
+    if (type == "CompoundStatement") {
+        Stmt* block = newStmt(StmtKind::Block);
+        for (const ASTNode* child : node->children) {
+            const Stmt* statement = lowerStatement(child);
+            if (statement->kind == StmtKind::Declare) {
+                for (const Variable& variable : statement->variables) {
+                    block->releasesArrays = block->releasesArrays || variable.length != nullptr;
+                }
+            }
+            if (statement->kind != StmtKind::Empty) {
+                block->statements.push_back(statement);
+            }
+        }
+        return block;
+    }
+    if (type == "DeclarationNode") {
+        return lowerDeclaration(node, false);
+    }
+    if (type == "ExpressionNode") {
+        return newStmt(StmtKind::Empty);
+    }
+    if (type == "SelectionStatement") {
+        // SelectionStatement: expression statement statement?
+        Stmt* selection = newStmt(StmtKind::If);
+        selection->expr = lowerExpression(childAt(node, 0));
+        selection->body = lowerStatement(childAt(node, 1));
+        if (node->children.size() > 2) {
+            selection->alternative = lowerStatement(node->children[2]);
+        }
+        return selection;
+    }
+    if (type == "IterationStatement") {
+        loopDepth_++;
+        Stmt* loop;
+        if (node->value == "for") {
+            // for语句：初始化、条件、步进、循环体，省略的部分是空的ExpressionNode
+            loop = newStmt(StmtKind::For);
+            const ASTNode* init = childAt(node, 0);
+            const ASTNode* condition = childAt(node, 1);
+            const ASTNode* step = childAt(node, 2);
+            if (init != nullptr && init->type != "ExpressionNode") {
+                if (init->type == "DeclarationNode") {
+                    loop->init = lowerDeclaration(init, false);
+                    for (const Variable& variable : loop->init->variables) {
+                        loop->releasesArrays = loop->releasesArrays || variable.length != nullptr;
+                    }
+                }
+                else {
+                    Stmt* expression = newStmt(StmtKind::Expression);
+                    expression->expr = lowerExpression(init);
+                    loop->init = expression;
+                }
+            }
+            if (condition != nullptr && condition->type != "ExpressionNode") {
+                loop->expr = lowerExpression(condition);
+            }
+            if (step != nullptr && step->type != "ExpressionNode") {
+                loop->step = lowerExpression(step);
+            }
+            loop->body = lowerStatement(childAt(node, 3));
+        }
+        else {
+            // while语句：条件、循环体
+            loop = newStmt(StmtKind::While);
+            loop->expr = lowerExpression(childAt(node, 0));
+            loop->body = lowerStatement(childAt(node, 1));
+        }
+        loopDepth_--;
+        return loop;
+    }
+    if (type == "JumpStatement") {
+        if (node->value == "return") {
+            Stmt* jump = newStmt(StmtKind::Return);
+            if (!node->children.empty()) {
+                jump->expr = lowerExpression(node->children[0]);
+            }
+            return jump;
+        }
+        if (loopDepth_ == 0) {
+            throw RuntimeError("'" + node->value + "' outside of a loop");
+        }
+        return newStmt(node->value == "break" ? StmtKind::Break : StmtKind::Continue);
+    }
+    Stmt* expression = newStmt(StmtKind::Expression);
+    expression->expr = lowerExpression(node);
+    return expression;
+}
+
+// DeclarationNode: TypeSpecifier InitDeclaratorList
+// 函数原型不产生任何执行动作；DirectDeclarator后面逗号分隔的名字是同一类型的标量，
+// 初始化表达式属于最后一个名字，与源码中 int a, b = 1; 的含义一致
+const Interpreter::Stmt* Interpreter::lowerDeclaration(const ASTNode* node, bool global) {
+    Stmt* declaration = newStmt(StmtKind::Declare);
+    ValueType type = typeOf(childAt(node, 0));
+    const ASTNode* list = childAt(node, 1);
+    if (list == nullptr) {
+        return declaration;
+    }
+    for (const ASTNode* initDeclarator : list->children) {
+        const ASTNode* declarator = childAt(initDeclarator, 0);
+        const ASTNode* initializer = childAt(initDeclarator, 1);
+        if (declarator == nullptr || declarator->children.empty() || declarator->children[0] == nullptr) {
+            throw RuntimeError("incomplete syntax tree");
+        }
+        // DirectDeclarator: Identifier
+        //                 | ArrayDeclarator Identifier constant_expression
+        //                 | FunctionDeclarator Identifier ParameterList
+        // 后面可能还跟着逗号分隔的若干Identifier
+        const std::string& marker = declarator->children[0]->type;
+        size_t firstVariable = declaration->variables.size();
+        size_t next = 0;
+        if (marker == "ArrayDeclarator") {
+            const Symbol* symbol = resolver_->declarationOf(childAt(declarator, 1));
+            if (symbol == nullptr) {
+                throw RuntimeError("malformed declaration");
+            }
+            Variable variable{ global, symbol->slot, type, lowerExpression(childAt(declarator, 2)), nullptr };
+            if (variable.length->kind == ExprKind::Constant && variable.length->type == ValueType::Int) {
+                arrayLengths_[symbol - resolver_->symbols().data()] = variable.length->constant.intValue;
+            }
+            declaration->variables.push_back(variable);
+            next = 3;
+        }
+        else if (marker == "FunctionDeclarator") {
+            next = 3;
+        }
+        for (size_t i = next; i < declarator->children.size(); i++) {
+            const Symbol* symbol = resolver_->declarationOf(declarator->children[i]);
+            if (symbol == nullptr) {
+                throw RuntimeError("malformed declaration");
+            }
+            declaration->variables.push_back({ global, symbol->slot, type, nullptr, nullptr });
+        }
+        if (initializer != nullptr) {
+            if (declaration->variables.size() == firstVariable) {
+                throw RuntimeError("initializer on a function declaration");
+            }
+            Variable& variable = declaration->variables.back();
+            if (variable.length != nullptr) {
+                throw RuntimeError("array initializers are not supported");
+            }
+            variable.initializer = lowerExpression(initializer);
+        }
+    }
+    return declaration;
+}
+
+const Symbol& Interpreter::symbolOf(const ASTNode* use) const {
+    const Symbol* symbol = resolver_->bindingOf(use);
+    if (symbol == nullptr) {
+        throw RuntimeError("undeclared identifier '" + use->value + "'");
+    }
+    return *symbol;
+}
+
+const Interpreter::Expr* Interpreter::lowerExpression(const ASTNode* node) {
+    if (node == nullptr) {
+        throw RuntimeError("incomplete syntax tree");
+    }
+    const std::string& type = node->type;
+    if (type == "PrimaryExpression") {
+        return lowerPrimary(node);
+    }
+    if (type == "AdditiveExpression" || type == "MultiplicativeExpression") {
+        // 运算符保存在节点的值中
+        return lowerBinary(node, node->value, childAt(node, 0), childAt(node, 1));
+    }
+    if (type == "ShiftExpression" || type == "RelationalExpression" || type == "EqualityExpression" ||
+        type == "AndExpression" || type == "ExclusiveOrExpression" || type == "InclusiveOrExpression" ||
+        type == "LogicalAndExpression" || type == "LogicalOrExpression") {
+        const ASTNode* op = childAt(node, 1);
+        if (op == nullptr) {
+            throw RuntimeError("incomplete syntax tree");
+        }
+        return lowerBinary(node, op->type, childAt(node, 0), childAt(node, 2));
+    }
+    if (type == "AssignmentExpression") {
+        // AssignmentExpression: unary_expression operator assignment_expression
+        const Expr* target = lowerExpression(childAt(node, 0));
+        const ASTNode* op = childAt(node, 1);
+        if (target->kind != ExprKind::Local && target->kind != ExprKind::Global &&
+            target->kind != ExprKind::LocalElement && target->kind != ExprKind::GlobalElement) {
+            throw RuntimeError("expression is not assignable");
+        }
+        if (op == nullptr) {
+            throw RuntimeError("incomplete syntax tree");
+        }
+        Expr* assignment = newExpr(op->type == "=" ? ExprKind::Assign : ExprKind::CompoundAssign, target->type);
+        if (assignment->kind == ExprKind::CompoundAssign && !binaryOpFromLexeme(op->type, assignment->op)) {
+            throw RuntimeError("unsupported assignment operator '" + op->type + "'");
+        }
+        assignment->operands[0] = target;
+        assignment->operands[1] = lowerExpression(childAt(node, 2));
+        return assignment;
+    }
+    if (type == "ConditionalExpression") {
+        const Expr* condition = lowerExpression(childAt(node, 0));
+        const Expr* whenTrue = lowerExpression(childAt(node, 1));
+        const Expr* whenFalse = lowerExpression(childAt(node, 2));
+        Expr* conditional = newExpr(ExprKind::Conditional, arithmeticType(whenTrue->type, whenFalse->type));
+        conditional->operands[0] = condition;
+        conditional->operands[1] = whenTrue;
+        conditional->operands[2] = whenFalse;
+        return conditional;
+    }
+    if (type == "CommaExpression") {
+        const Expr* left = lowerExpression(childAt(node, 0));
+        const Expr* right = lowerExpression(childAt(node, 1));
+        Expr* comma = newExpr(ExprKind::Comma, right->type);
+        comma->operands[0] = left;
+        comma->operands[1] = right;
+        return comma;
+    }
+    if (type == "UnaryExpression" || type == "PostfixExpression") {
+        // UnaryExpression: op operand；PostfixExpression: operand op
+        bool postfix = type == "PostfixExpression";
+        const ASTNode* op = childAt(node, postfix ? 1 : 0);
+        const Expr* operand = lowerExpression(childAt(node, postfix ? 0 : 1));
+        if (op == nullptr) {
+            throw RuntimeError("incomplete syntax tree");
+        }
+        Expr* unary;
+        if (op->type == "++" || op->type == "--") {
+            if (operand->kind != ExprKind::Local && operand->kind != ExprKind::Global &&
+                operand->kind != ExprKind::LocalElement && operand->kind != ExprKind::GlobalElement) {
+                throw RuntimeError("operand of '" + op->type + "' is not assignable");
+            }
+            unary = newExpr(postfix ? ExprKind::PostIncrement : ExprKind::Increment, operand->type);
+            unary->delta = op->type == "++" ? 1 : -1;
+        }
+        else if (op->type == "-") {
+            unary = newExpr(ExprKind::Negate, promotedType(operand->type));
+        }
+        else if (op->type == "+") {
+            // +x 只做整数提升，按 0 + x 计算
+            unary = newExpr(ExprKind::Binary, promotedType(operand->type));
+            unary->op = BinaryOp::Add;
+            Expr* zero = newExpr(ExprKind::Constant, ValueType::Int);
+            zero->constant = RuntimeValue::ofInt(0);
+            unary->operands[0] = zero;
+            unary->operands[1] = operand;
+            return unary;
+        }
+        else if (op->type == "!") {
+            unary = newExpr(ExprKind::Not, ValueType::Int);
+        }
+        else if (op->type == "~") {
+            unary = newExpr(ExprKind::BitNot, ValueType::Int);
+        }
+        else {
+            throw RuntimeError("unsupported operator '" + op->type + "'");
+        }
+        unary->operands[0] = operand;
+        return unary;
+    }
+    if (type == "CastExpression") {
+        // CastExpression: '(' TypeSpecifier ')' operand
+        Expr* cast = newExpr(ExprKind::Cast, typeOf(childAt(node, 1)));
+        cast->operands[0] = lowerExpression(childAt(node, 3));
+        return cast;
+    }
+    if (type == "SizeofExpression") {
+        return lowerSizeof(node);
+    }
+    if (type == "ArrayAccess") {
+        return lowerElement(node);
+    }
+    if (type == "FunctionCall") {
+        return lowerCall(node);
+    }
+    throw RuntimeError("unsupported expression '" + type + "'");
+}
+
+const Interpreter::Expr* Interpreter::lowerBinary(const ASTNode* node, const std::string& op, const ASTNode* left, const ASTNode* right) {
+    const Expr* leftExpr = lowerExpression(left);
+    const Expr* rightExpr = lowerExpression(right);
+    Expr* binary;
+    if (op == "&&" || op == "||") {
+        binary = newExpr(op == "&&" ? ExprKind::LogicalAnd : ExprKind::LogicalOr, ValueType::Int);
+    }
+    else {
+        binary = newExpr(ExprKind::Binary, ValueType::Int);
+        if (!binaryOpFromLexeme(op, binary->op)) {
+            throw RuntimeError("unsupported operator '" + op + "' in " + node->type);
+        }
+        if (binary->op <= BinaryOp::Div) {
+            binary->type = arithmeticType(leftExpr->type, rightExpr->type);
+        }
+    }
+    binary->operands[0] = leftExpr;
+    binary->operands[1] = rightExpr;
+    return binary;
+}
+
+const Interpreter::Expr* Interpreter::lowerPrimary(const ASTNode* node) {
+    RuntimeValue value;
+    if (parseConstant(node->value, value)) {
+        Expr* constant = newExpr(ExprKind::Constant, value.type);
+        constant->constant = value;
+        return constant;
+    }
+    const Symbol& symbol = symbolOf(node);
+    if (symbol.kind == SymbolKind::Function) {
+        throw RuntimeError("function '" + node->value + "' used as a value");
+    }
+    if (symbol.kind == SymbolKind::Array) {
+        throw RuntimeError("array '" + node->value + "' used as a value");
+    }
+    Expr* variable = newExpr(symbol.depth == 0 ? ExprKind::Global : ExprKind::Local, typeOf(symbol.type));
+    variable->slot = symbol.slot;
+    return variable;
+}
+
+// ArrayAccess: array '[' index ']'，数组只能通过名字访问
+const Interpreter::Expr* Interpreter::lowerElement(const ASTNode* node) {
+    const ASTNode* base = childAt(node, 0);
+    if (base == nullptr || base->type != "PrimaryExpression") {
+        throw RuntimeError("unsupported array access");
+    }
+    const Symbol& symbol = symbolOf(base);
+    if (symbol.kind != SymbolKind::Array) {
+        throw RuntimeError("'" + base->value + "' is not an array");
+    }
+    Expr* element = newExpr(symbol.depth == 0 ? ExprKind::GlobalElement : ExprKind::LocalElement, typeOf(symbol.type));
+    element->slot = symbol.slot;
+    element->operands[0] = lowerExpression(childAt(node, 2));
+    return element;
+}
+
+// FunctionCall: callee '(' ArgumentExpressionList? ')'
+const Interpreter::Expr* Interpreter::lowerCall(const ASTNode* node) {
+    const ASTNode* callee = childAt(node, 0);
+    if (callee == nullptr || callee->type != "PrimaryExpression") {
+        throw RuntimeError("unsupported function call");
+    }
+    const ASTNode* list = node->children.size() == 4 ? node->children[2] : nullptr;
+    std::vector<const Expr*> arguments;
+    if (list != nullptr) {
+        for (const ASTNode* argument : list->children) {
+            arguments.push_back(lowerExpression(argument));
+        }
+    }
+
+    const Symbol* symbol = resolver_->bindingOf(callee);
+    if (symbol == nullptr && callee->value == printBuiltin) {
+        Expr* print = newExpr(ExprKind::Print, ValueType::Int);
+        print->arguments = std::move(arguments);
+        return print;
+    }
+    if (symbol == nullptr) {
+        throw RuntimeError("undeclared function '" + callee->value + "'");
+    }
+    if (symbol->kind != SymbolKind::Function) {
+        throw RuntimeError("'" + callee->value + "' is not a function");
+    }
+    const Function& function = functions_[symbol->slot];
+    if (symbol->definition == nullptr) {
+        throw RuntimeError("function '" + function.name + "' is declared but never defined");
+    }
+    if (arguments.size() != function.parameters.size()) {
+        throw RuntimeError("function '" + function.name + "' expects " + std::to_string(function.parameters.size()) +
+            " argument(s), " + std::to_string(arguments.size()) + " given");
+    }
+    Expr* call = newExpr(ExprKind::Call, function.returnType);
+    call->function = &function;
+    call->arguments = std::move(arguments);
+    return call;
+}
+
+// sizeof不对操作数求值，结果在翻译时就能确定
+const Interpreter::Expr* Interpreter::lowerSizeof(const ASTNode* node) {
+    size_t size;
+    const ASTNode* operand = childAt(node, 1);
+    if (operand != nullptr && operand->type == "(") {
+        // SizeofExpression: sizeof '(' TypeSpecifier ')'
+        size = sizeOfType(typeOf(childAt(node, 2)));
+    }
+    else if (operand != nullptr && operand->type == "PrimaryExpression" && resolver_->bindingOf(operand) != nullptr &&
+        resolver_->bindingOf(operand)->kind == SymbolKind::Array) {
+        // 数组的大小要求长度是常量，声明总是先于使用被翻译
+        const Symbol* symbol = resolver_->bindingOf(operand);
+        int32_t length = arrayLengths_[symbol - resolver_->symbols().data()];
+        if (length < 0) {
+            throw RuntimeError("sizeof of array '" + operand->value + "' with a non-constant length");
+        }
+        size = static_cast<size_t>(length) * sizeOfType(typeOf(symbol->type));
+    }
+    else {
+        size = sizeOfType(lowerExpression(operand)->type);
+    }
+    Expr* constant = newExpr(ExprKind::Constant, ValueType::Int);
+    constant->constant = RuntimeValue::ofInt(static_cast<int32_t>(size));
+    return constant;
+}
+
+int32_t Interpreter::run() {
+    if (main_ == nullptr || main_->body == nullptr) {
+        throw RuntimeError("program has no main function");
+    }
+    if (!main_->parameters.empty()) {
+        throw RuntimeError("main must not take parameters");
+    }
+    globals_.resize(globalTypes_.size());
+    for (size_t i = 0; i < globalTypes_.size(); i++) {
+        globals_[i] = RuntimeValue::zero(globalTypes_[i]);
+    }
+    if (stack_.size() < 1024) {
+        stack_.resize(1024);
+    }
+    frameBase_ = 0;
+    stackTop_ = 0;
+    arrayTop_ = 0;
+    callDepth_ = 0;
+    executed_ = 0;
+
+    for (const Stmt* declaration : globalInit_) {
+        execute(declaration);
+    }
+    return invoke(*main_, nullptr).intValue;
+}
+
+Interpreter::Flow Interpreter::execute(const Stmt* stmt) {
+    executed_++;
+    switch (stmt->kind) {
+    case StmtKind::Block: {
+        size_t arrayMark = arrayTop_;
+        Flow flow = Flow::Normal;
+        for (const Stmt* statement : stmt->statements) {
+            flow = execute(statement);
+            if (flow != Flow::Normal) {
+                break;
+            }
+        }
+        if (stmt->releasesArrays) {
+            arrayTop_ = arrayMark;
+        }
+        return flow;
+    }
+    case StmtKind::Expression:
+        evaluate(stmt->expr);
+        return Flow::Normal;
+    case StmtKind::Declare:
+        for (const Variable& variable : stmt->variables) {
+            declare(variable);
+        }
+        return Flow::Normal;
+    case StmtKind::If:
+        if (isTruthy(evaluate(stmt->expr))) {
+            return execute(stmt->body);
+        }
+        return stmt->alternative != nullptr ? execute(stmt->alternative) : Flow::Normal;
+    case StmtKind::While:
+        while (isTruthy(evaluate(stmt->expr))) {
+            Flow flow = execute(stmt->body);
+            if (flow == Flow::Break) {
+                break;
+            }
+            if (flow == Flow::Return) {
+                return flow;
+            }
+        }
+        return Flow::Normal;
+    case StmtKind::For: {
+        size_t arrayMark = arrayTop_;
+        Flow result = Flow::Normal;
+        if (stmt->init != nullptr) {
+            execute(stmt->init);
+        }
+        while (stmt->expr == nullptr || isTruthy(evaluate(stmt->expr))) {
+            Flow flow = execute(stmt->body);
+            if (flow == Flow::Break) {
+                break;
+            }
+            if (flow == Flow::Return) {
+                result = flow;
+                break;
+            }
+            if (stmt->step != nullptr) {
+                evaluate(stmt->step);
+            }
+        }
+        if (stmt->releasesArrays) {
+            arrayTop_ = arrayMark;
+        }
+        return result;
+    }
+    case StmtKind::Return:
+        returnValue_ = stmt->expr != nullptr ? evaluate(stmt->expr) : RuntimeValue::zero(ValueType::Void);
+        return Flow::Return;
+    case StmtKind::Break:
+        return Flow::Break;
+    case StmtKind::Continue:
+        return Flow::Continue;
+    case StmtKind::Empty:
+        return Flow::Normal;
+    }
+    return Flow::Normal;
+}
+
+// 执行一个变量的声明；没有初值的变量置为零，使每次进入作用域时的状态确定
+void Interpreter::declare(const Variable& variable) {
+    RuntimeValue value;
+    if (variable.length != nullptr) {
+        RuntimeValue length = evaluate(variable.length);
+        if (isFloatingType(length.type) || length.intValue <= 0) {
+            throw RuntimeError("array length must be a positive integer");
+        }
+        value.type = ValueType::Array;
+        value.elementType = variable.type;
+        value.length = static_cast<uint32_t>(length.intValue);
+        value.offset = static_cast<uint32_t>(arrayTop_);
+        arrayTop_ += value.length;
+        if (arrayTop_ > arrays_.size()) {
+            arrays_.resize(arrayTop_ > arrays_.size() * 2 ? arrayTop_ : arrays_.size() * 2);
+        }
+        RuntimeValue zero = RuntimeValue::zero(variable.type);
+        for (size_t i = value.offset; i < arrayTop_; i++) {
+            arrays_[i] = zero;
+        }
+    }
+    else if (variable.initializer != nullptr) {
+        value = convertValue(evaluate(variable.initializer), variable.type);
+    }
+    else {
+        value = RuntimeValue::zero(variable.type);
+    }
+    if (variable.global) {
+        globals_[variable.slot] = value;
+    }
+    else {
+        stack_[frameBase_ + variable.slot] = value;
+    }
+}
+
+RuntimeValue Interpreter::evaluate(const Expr* expr) {
+    executed_++;
+    switch (expr->kind) {
+    case ExprKind::Constant:
+        return expr->constant;
+    case ExprKind::Local:
+        return stack_[frameBase_ + expr->slot];
+    case ExprKind::Global:
+        return globals_[expr->slot];
+    case ExprKind::LocalElement:
+    case ExprKind::GlobalElement: {
+        Lvalue location = locate(expr);
+        return (*location.storage)[location.index];
+    }
+    case ExprKind::Binary: {
+        RuntimeValue left = evaluate(expr->operands[0]);
+        return applyBinary(expr->op, left, evaluate(expr->operands[1]));
+    }
+    case ExprKind::LogicalAnd:
+        return RuntimeValue::ofInt(isTruthy(evaluate(expr->operands[0])) && isTruthy(evaluate(expr->operands[1])) ? 1 : 0);
+    case ExprKind::LogicalOr:
+        return RuntimeValue::ofInt(isTruthy(evaluate(expr->operands[0])) || isTruthy(evaluate(expr->operands[1])) ? 1 : 0);
+    case ExprKind::Conditional:
+        return evaluate(isTruthy(evaluate(expr->operands[0])) ? expr->operands[1] : expr->operands[2]);
+    case ExprKind::Comma:
+        evaluate(expr->operands[0]);
+        return evaluate(expr->operands[1]);
+    case ExprKind::Negate: {
+        RuntimeValue value = evaluate(expr->operands[0]);
+        if (isFloatingType(value.type)) {
+            value.doubleValue = -value.doubleValue;
+            return value;
+        }
+        return applyBinary(BinaryOp::Sub, RuntimeValue::ofInt(0), value);
+    }
+    case ExprKind::Not:
+        return RuntimeValue::ofInt(isTruthy(evaluate(expr->operands[0])) ? 0 : 1);
+    case ExprKind::BitNot: {
+        RuntimeValue value = evaluate(expr->operands[0]);
+        if (isFloatingType(value.type)) {
+            throw RuntimeError("invalid operand of floating type to '~'");
+        }
+        return RuntimeValue::ofInt(~convertValue(value, ValueType::Int).intValue);
+    }
+    case ExprKind::Assign: {
+        RuntimeValue value = evaluate(expr->operands[1]);
+        Lvalue location = locate(expr->operands[0]);
+        RuntimeValue& target = (*location.storage)[location.index];
+        target = convertValue(value, location.type);
+        return target;
+    }
+    case ExprKind::CompoundAssign: {
+        Lvalue location = locate(expr->operands[0]);
+        RuntimeValue value = evaluate(expr->operands[1]);
+        RuntimeValue& target = (*location.storage)[location.index];
+        target = convertValue(applyBinary(expr->op, target, value), location.type);
+        return target;
+    }
+    case ExprKind::Increment:
+    case ExprKind::PostIncrement: {
+        Lvalue location = locate(expr->operands[0]);
+        RuntimeValue& target = (*location.storage)[location.index];
+        RuntimeValue previous = target;
+        target = convertValue(applyBinary(BinaryOp::Add, previous, RuntimeValue::ofInt(expr->delta)), location.type);
+        return expr->kind == ExprKind::Increment ? target : previous;
+    }
+    case ExprKind::Cast:
+        return convertValue(evaluate(expr->operands[0]), expr->type);
+    case ExprKind::Call:
+        return call(expr);
+    case ExprKind::Print:
+        for (size_t i = 0; i < expr->arguments.size(); i++) {
+            RuntimeValue value = evaluate(expr->arguments[i]);
+            if (i != 0) {
+                out_ << ' ';
+            }
+            printValue(out_, value);
+        }
+        out_ << '\n';
+        return RuntimeValue::ofInt(0);
+    }
+    return RuntimeValue::ofInt(0);
+}
+
+// 变量或数组元素的位置；下标先求值，再读取数组本身
+Interpreter::Lvalue Interpreter::locate(const Expr* expr) {
+    switch (expr->kind) {
+    case ExprKind::Local:
+        return { &stack_, frameBase_ + expr->slot, expr->type };
+    case ExprKind::Global:
+        return { &globals_, expr->slot, expr->type };
+    default: {
+        RuntimeValue index = evaluate(expr->operands[0]);
+        if (isFloatingType(index.type)) {
+            throw RuntimeError("array subscript is not an integer");
+        }
+        const RuntimeValue& array = expr->kind == ExprKind::GlobalElement ? globals_[expr->slot] : stack_[frameBase_ + expr->slot];
+        if (index.intValue < 0 || static_cast<uint32_t>(index.intValue) >= array.length) {
+            throw RuntimeError("array index " + std::to_string(index.intValue) + " out of bounds [0, " + std::to_string(array.length) + ")");
+        }
+        return { &arrays_, array.offset + static_cast<size_t>(index.intValue), expr->type };
+    }
+    }
+}
+
+RuntimeValue Interpreter::call(const Expr* expr) {
+    // 参数个数通常很少，先放在固定大小的缓冲区里
+    RuntimeValue buffer[8];
+    std::vector<RuntimeValue> spill;
+    RuntimeValue* arguments = buffer;
+    size_t count = expr->arguments.size();
+    if (count > 8) {
+        spill.resize(count);
+        arguments = spill.data();
+    }
+    for (size_t i = 0; i < count; i++) {
+        arguments[i] = evaluate(expr->arguments[i]);
+    }
+    return invoke(*expr->function, arguments);
+}
+
+// 在值栈上分配函数的栈帧并执行函数体
+RuntimeValue Interpreter::invoke(const Function& function, const RuntimeValue* arguments) {
+    if (callDepth_ >= maxCallDepth_) {
+        throw RuntimeError("call depth limit (" + std::to_string(maxCallDepth_) + ") exceeded in '" + function.name + "'");
+    }
+    size_t base = stackTop_;
+    size_t top = base + function.frameSize;
+    if (top > stack_.size()) {
+        stack_.resize(top > stack_.size() * 2 ? top : stack_.size() * 2);
+    }
+    for (size_t i = 0; i < function.parameters.size(); i++) {
+        const Parameter& parameter = function.parameters[i];
+        stack_[base + parameter.slot] = convertValue(arguments[i], parameter.type);
+    }
+
+    size_t savedBase = frameBase_;
+    frameBase_ = base;
+    stackTop_ = top;
+    callDepth_++;
+    Flow flow = execute(function.body);
+    callDepth_--;
+    frameBase_ = savedBase;
+    stackTop_ = base;
+
+    // 没有return语句或return没有值时返回零值
+    if (flow == Flow::Return && returnValue_.type != ValueType::Void) {
+        return convertValue(returnValue_, function.returnType);
+    }
+    return RuntimeValue::zero(function.returnType);
+}
@@ -0,0 +1,155 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "ast.hpp"
+#include "nameResolver.hpp"
+#include "runtimeValue.hpp"
+
+// 树遍历解释器
+// load把AST翻译成执行树：标识符在执行前解析成栈帧或全局变量的槽位，运算符解析成枚举，
+// 常量预先转换好，执行时不再比较节点类型字符串，也不按名字查找变量。
+// 函数的栈帧大小由NameResolver算出，调用时在值栈上一次分配；
+// 数组元素分配在单独的数组栈上，离开声明所在的块时整体释放
+// 内置函数print(...)输出参数值，以空格分隔并换行
+class Interpreter {
+public:
+    // maxCallDepth限制递归深度，避免解释器自身的栈溢出
+    explicit Interpreter(std::ostream& out, size_t maxCallDepth = 2048);
+
+    Interpreter(const Interpreter&) = delete;
+    Interpreter& operator=(const Interpreter&) = delete;
+
+    // 翻译AST，程序使用了解释器不支持的结构或有未声明的名字时抛出RuntimeError
+    // 翻译结果不引用AST，之后可以释放AST
+    void load(const ASTNode* root);
+    // 初始化全局变量并执行main，返回main的返回值；执行出错时抛出RuntimeError
+    int32_t run();
+
+    // 上一次run执行的语句和表达式节点数
+    uint64_t executedNodes() const;
+
+private:
+    enum class ExprKind : uint8_t
+    {
+        Constant, Local, Global, LocalElement, GlobalElement,
+        Binary, LogicalAnd, LogicalOr, Conditional, Comma,
+        Negate, Not, BitNot, Assign, CompoundAssign, Increment, PostIncrement,
+        Cast, Call, Print
+    };
+
+    struct Function;
+
+    struct Expr {
+        ExprKind kind;
+        BinaryOp op;
+        ValueType type;          // 表达式的静态类型，对变量和数组元素也是赋值时转换的目标类型
+        int32_t delta;           // 自增为1，自减为-1
+        uint32_t slot;           // 变量或数组所在的槽位
+        RuntimeValue constant;
+        const Expr* operands[3];
+        std::vector<const Expr*> arguments;
+        const Function* function;
+    };
+
+    enum class StmtKind : uint8_t
+    {
+        Block, Expression, Declare, If, While, For, Return, Break, Continue, Empty
+    };
+
+    // 声明语句中的一个变量
+    struct Variable {
+        bool global;
+        uint32_t slot;
+        ValueType type;          // 数组为元素类型
+        const Expr* length;      // 数组长度，标量为nullptr
+        const Expr* initializer;
+    };
+
+    struct Stmt {
+        StmtKind kind;
+        bool releasesArrays;     // 其中直接声明了数组，离开时释放
+        const Expr* expr;        // 表达式语句、条件或返回值
+        const Expr* step;        // for语句的步进表达式
+        const Stmt* init;        // for语句的初始化部分
+        const Stmt* body;        // 循环体或then分支
+        const Stmt* alternative; // else分支
+        std::vector<const Stmt*> statements;
+        std::vector<Variable> variables;
+    };
+
+    struct Parameter {
+        uint32_t slot;
+        ValueType type;
+    };
+
+    struct Function {
+        std::string name;
+        ValueType returnType;
+        uint32_t frameSize;
+        std::vector<Parameter> parameters;
+        const Stmt* body;        // 只有声明没有定义时为nullptr
+    };
+
+    enum class Flow : uint8_t
+    {
+        Normal, Break, Continue, Return
+    };
+
+    // 可赋值的位置；保存容器和下标而不是指针，求值过程中值栈扩容也不会失效
+    struct Lvalue {
+        std::vector<RuntimeValue>* storage;
+        size_t index;
+        ValueType type;
+    };
+
+    std::ostream& out_;
+    size_t maxCallDepth_;
+
+    // 翻译结果
+    std::deque<Expr> exprs_;
+    std::deque<Stmt> stmts_;
+    std::vector<Function> functions_;       // 按函数符号的槽位编号
+    std::vector<ValueType> globalTypes_;
+    std::vector<const Stmt*> globalInit_;   // 文件作用域的声明，按出现顺序执行
+    const Function* main_;
+
+    // 翻译时的状态
+    const NameResolver* resolver_;
+    std::vector<int32_t> arrayLengths_;     // 按符号编号，数组长度是常量时供sizeof使用，否则为-1
+    size_t loopDepth_;
+
+    // 执行时的状态
+    std::vector<RuntimeValue> globals_;
+    std::vector<RuntimeValue> stack_;
+    std::vector<RuntimeValue> arrays_;
+    size_t frameBase_;
+    size_t stackTop_;
+    size_t arrayTop_;
+    size_t callDepth_;
+    RuntimeValue returnValue_;
+    uint64_t executed_;
+
+    void declareFunction(const Symbol& symbol);
+    const Stmt* lowerStatement(const ASTNode* node);
+    const Stmt* lowerDeclaration(const ASTNode* node, bool global);
+    const Expr* lowerExpression(const ASTNode* node);
+    const Expr* lowerPrimary(const ASTNode* node);
+    const Expr* lowerElement(const ASTNode* node);
+    const Expr* lowerCall(const ASTNode* node);
+    const Expr* lowerSizeof(const ASTNode* node);
+    const Expr* lowerBinary(const ASTNode* node, const std::string& op, const ASTNode* left, const ASTNode* right);
+    const Symbol& symbolOf(const ASTNode* use) const;
+    ValueType typeOf(const ASTNode* typeSpecifier) const;
+    Expr* newExpr(ExprKind kind, ValueType type);
+    Stmt* newStmt(StmtKind kind);
+
+    Flow execute(const Stmt* stmt);
+    void declare(const Variable& variable);
+    RuntimeValue evaluate(const Expr* expr);
+    Lvalue locate(const Expr* expr);
+    RuntimeValue call(const Expr* expr);
+    RuntimeValue invoke(const Function& function, const RuntimeValue* arguments);
+};
@@ -0,0 +1,180 @@
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include "interpreterBench.hpp"
+#include "interpreter.hpp"
+#include "bytecodeCompiler.hpp"
+#include "vm.hpp"
+#include "lexer.hpp"
+#include "astParser.hpp"
+#include "diagnostics.hpp"
+#include "newVector.cpp"
+
+namespace {
+    struct Workload {
+        const char* name;
+        const char* source;
+    };
+
+    const Workload workloads[] = {
+        { "fib",
+            "int fib(int n) {\n"
+            "    if (n < 2) return n;\n"
+            "    return fib(n - 1) + fib(n - 2);\n"
+            "}\n"
+            "int main() {\n"
+            "    return fib(22);\n"
+            "}\n" },
+        { "loops",
+            "int main() {\n"
+            "    int sum = 0;\n"
+            "    for (int i = 0; i < 300; i++) {\n"
+            "        int j = 0;\n"
+            "        while (j < 1000) {\n"
+            "            sum = sum + (i ^ j) % 7;\n"
+            "            j++;\n"
+            "        }\n"
+            "    }\n"
+            "    return sum;\n"
+            "}\n" },
+        { "array-sum",
+            "int data[1000];\n"
+            "int main() {\n"
+            "    int total = 0;\n"
+            "    for (int round = 0; round < 100; round++) {\n"
+            "        for (int i = 0; i < 1000; i++) {\n"
+            "            data[i] = i * round;\n"
+            "        }\n"
+            "        for (int i = 0; i < 1000; i++) {\n"
+            "            total += data[i];\n"
+            "        }\n"
+            "    }\n"
+            "    return total;\n"
+            "}\n" },
+        { "float-math",
+            "double integrate(int steps) {\n"
+            "    double sum = 0.0;\n"
+            "    double dx = 1.0 / steps;\n"
+            "    for (int i = 0; i < steps; i++) {\n"
+            "        double x = (i + 0.5) * dx;\n"
+            "        sum += 4.0 / (1.0 + x * x);\n"
+            "    }\n"
+            "    return sum * dx;\n"
+            "}\n"
+            "int main() {\n"
+            "    return (int)(integrate(200000) * 1000);\n"
+            "}\n" },
+        { "sieve",
+            "int main() {\n"
+            "    int count = 0;\n"
+            "    for (int round = 0; round < 20; round++) {\n"
+            "        int composite[10000];\n"
+            "        count = 0;\n"
+            "        for (int i = 2; i < 10000; i++) {\n"
+            "            if (composite[i] == 0) {\n"
+            "                count++;\n"
+            "                for (int j = i + i; j < 10000; j += i) {\n"
+            "                    composite[j] = 1;\n"
+            "                }\n"
+            "            }\n"
+            "        }\n"
+            "    }\n"
+            "    return count;\n"
+            "}\n" },
+    };
+}
+
+void runInterpreterBenchmark(size_t iterations, std::ostream& os) {
+    if (iterations == 0) {
+        iterations = 1;
+    }
+    os << "Interpreter benchmark: " << iterations << " iteration(s)\n";
+    os << std::left << std::setw(14) << "workload" << std::right
+        << std::setw(14) << "result" << std::setw(14) << "ms/run"
+        << std::setw(16) << "ops/run" << std::setw(16) << "ops/sec"
+        << std::setw(14) << "vm ms/run" << std::setw(10) << "speedup"
+        << std::setw(14) << "jit ms/run" << std::setw(10) << "speedup" << "\n";
+    for (const Workload& workload : workloads) {
+        DiagnosticEngine diagnostics;
+        std::string source = workload.source;
+        Lexer lexer(source, diagnostics);
+        newVector<Token> tokens = lexer.lex();
+        Parser parser(tokens, diagnostics);
+        ASTNode* ast = parser.buildAST();
+        if (diagnostics.hasErrors() || ast == nullptr) {
+            os << std::left << std::setw(14) << workload.name << " failed to parse\n";
+            diagnostics.render(os, DiagnosticFormat::Text);
+            delete ast;
+            continue;
+        }
+
+        std::ostringstream output;
+        Interpreter interpreter(output);
+        try {
+            interpreter.load(ast);
+            int32_t result = interpreter.run();
+            uint64_t ops = interpreter.executedNodes();
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < iterations; i++) {
+                interpreter.run();
+            }
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            double secondsPerRun = elapsed.count() / static_cast<double>(iterations);
+            double opsPerSecond = secondsPerRun > 0 ? static_cast<double>(ops) / secondsPerRun : 0.0;
+
+            // 同一个程序编译成字节码后在虚拟机上执行，结果必须与解释器一致
+            BytecodeCompiler compiler;
+            BytecodeProgram program = compiler.compile(ast);
+            VirtualMachine vm(program, output);
+            int32_t vmResult = vm.run();
+            start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < iterations; i++) {
+                vm.run();
+            }
+            elapsed = std::chrono::steady_clock::now() - start;
+            double vmSecondsPerRun = elapsed.count() / static_cast<double>(iterations);
+
+            // 阈值为1时第一次执行就把main及其调用的函数编译成本机代码，计时的是升级之后的稳定状态
+            int32_t jitResult = 0;
+            double jitSecondsPerRun = 0.0;
+            bool jitAvailable = JitCompiler::supported();
+            if (jitAvailable) {
+                VirtualMachine jit(program, output, 100000, 1);
+                jitResult = jit.run();
+                start = std::chrono::steady_clock::now();
+                for (size_t i = 0; i < iterations; i++) {
+                    jit.run();
+                }
+                elapsed = std::chrono::steady_clock::now() - start;
+                jitSecondsPerRun = elapsed.count() / static_cast<double>(iterations);
+            }
+
+            os << std::left << std::setw(14) << workload.name << std::right << std::fixed
+                << std::setw(14) << result
+                << std::setw(14) << std::setprecision(3) << secondsPerRun * 1000.0
+                << std::setw(16) << ops
+                << std::setw(16) << std::setprecision(0) << opsPerSecond
+                << std::setw(14) << std::setprecision(3) << vmSecondsPerRun * 1000.0
+                << std::setw(9) << std::setprecision(1) << (vmSecondsPerRun > 0 ? secondsPerRun / vmSecondsPerRun : 0.0) << "x";
+            if (jitAvailable) {
+                os << std::setw(14) << std::setprecision(3) << jitSecondsPerRun * 1000.0
+                    << std::setw(9) << std::setprecision(1) << (jitSecondsPerRun > 0 ? secondsPerRun / jitSecondsPerRun : 0.0) << "x";
+            }
+            else {
+                os << std::setw(14) << "-" << std::setw(10) << "-";
+            }
+            if (vmResult != result) {
+                os << "  (vm result " << vmResult << " differs)";
+            }
+            if (jitAvailable && jitResult != result) {
+                os << "  (jit result " << jitResult << " differs)";
+            }
+            os << "\n";
+        }
+        catch (const RuntimeError& error) {
+            os << std::left << std::setw(14) << workload.name << " runtime error: " << error.what() << "\n";
+        }
+        delete ast;
+    }
+}
@@ -0,0 +1,7 @@
+#pragma once
+#include <iostream>
+
+// 解释器的执行基准：内置的递归fib、循环、数组和浮点程序各执行iterations次，
+// 报告每次执行的耗时和每秒执行的语句与表达式节点数（ops/sec），
+// 再把同一个程序编译成字节码，分别在虚拟机上和升级到本机代码后执行，报告耗时和相对树遍历解释器的加速比
+void runInterpreterBenchmark(size_t iterations, std::ostream& os);
@@ -0,0 +1,441 @@
+#include <algorithm>
+#include "ir.hpp"
+
+namespace {
+    const uint8_t opFlags[] = {
+#define IR_OP(name, mnemonic, flags) static_cast<uint8_t>(flags),
+#include "ir.def"
+#undef IR_OP
+    };
+
+    const char* const opNames[] = {
+#define IR_OP(name, mnemonic, flags) mnemonic,
+#include "ir.def"
+#undef IR_OP
+    };
+
+    constexpr uint32_t none = UINT32_MAX;
+
+    uint32_t findReplacement(std::vector<uint32_t>& replacement, uint32_t value) {
+        uint32_t root = value;
+        while (replacement[root] != root) {
+            root = replacement[root];
+        }
+        // 路径压缩
+        while (replacement[value] != root) {
+            uint32_t next = replacement[value];
+            replacement[value] = root;
+            value = next;
+        }
+        return root;
+    }
+
+    void printValue(std::ostream& os, uint32_t value) {
+        os << "%" << value;
+    }
+}
+
+uint8_t irOpFlags(IrOp op) {
+    return opFlags[static_cast<size_t>(op)];
+}
+
+const char* irOpName(IrOp op) {
+    return opNames[static_cast<size_t>(op)];
+}
+
+const char* irTypeName(IrType type) {
+    switch (type) {
+    case IrType::Void: return "void";
+    case IrType::Int: return "int";
+    case IrType::Double: return "double";
+    case IrType::Array: return "array";
+    case IrType::Mark: return "mark";
+    }
+    return "?";
+}
+
+uint32_t IrFunction::addBlock() {
+    blocks.emplace_back();
+    return static_cast<uint32_t>(blocks.size() - 1);
+}
+
+uint32_t IrFunction::append(uint32_t block, IrOp op, IrType type, std::vector<uint32_t> operands, uint32_t immediate) {
+    IrInstruction instruction;
+    instruction.op = op;
+    instruction.type = type;
+    instruction.block = block;
+    instruction.immediate = immediate;
+    instruction.operands = std::move(operands);
+    values.push_back(std::move(instruction));
+    uint32_t value = static_cast<uint32_t>(values.size() - 1);
+    blocks[block].instructions.push_back(value);
+    return value;
+}
+
+void IrFunction::addEdge(uint32_t from, uint32_t to) {
+    blocks[from].successors.push_back(to);
+    blocks[to].predecessors.push_back(from);
+}
+
+void IrFunction::removeEdge(uint32_t from, uint32_t to) {
+    std::vector<uint32_t>& successors = blocks[from].successors;
+    auto successor = std::find(successors.begin(), successors.end(), to);
+    if (successor != successors.end()) {
+        successors.erase(successor);
+    }
+    std::vector<uint32_t>& predecessors = blocks[to].predecessors;
+    auto predecessor = std::find(predecessors.begin(), predecessors.end(), from);
+    if (predecessor == predecessors.end()) {
+        return;
+    }
+    size_t index = static_cast<size_t>(predecessor - predecessors.begin());
+    predecessors.erase(predecessor);
+    for (uint32_t value : blocks[to].instructions) {
+        IrInstruction& phi = values[value];
+        if (phi.op != IrOp::Phi) {
+            break;
+        }
+        if (phi.removed) {
+            continue;
+        }
+        phi.operands.erase(phi.operands.begin() + static_cast<std::ptrdiff_t>(index));
+    }
+}
+
+uint32_t IrFunction::terminator(uint32_t block) const {
+    const std::vector<uint32_t>& instructions = blocks[block].instructions;
+    return instructions.empty() ? none : instructions.back();
+}
+
+void IrFunction::replaceUses(std::vector<uint32_t>& replacement) {
+    for (IrInstruction& instruction : values) {
+        if (instruction.removed) {
+            continue;
+        }
+        for (uint32_t& operand : instruction.operands) {
+            operand = findReplacement(replacement, operand);
+        }
+    }
+}
+
+void IrFunction::compact() {
+    std::vector<uint32_t> blockIndex(blocks.size(), none);
+    std::vector<IrBlock> liveBlocks;
+    for (uint32_t b = 0; b < blocks.size(); b++) {
+        if (!blocks[b].removed) {
+            blockIndex[b] = static_cast<uint32_t>(liveBlocks.size());
+            liveBlocks.push_back(std::move(blocks[b]));
+        }
+    }
+    // 值按原来的顺序重新编号，保持输出稳定
+    std::vector<uint32_t> valueIndex(values.size(), none);
+    std::vector<bool> placed(values.size(), false);
+    for (const IrBlock& block : liveBlocks) {
+        for (uint32_t value : block.instructions) {
+            placed[value] = !values[value].removed;
+        }
+    }
+    std::vector<IrInstruction> liveValues;
+    for (uint32_t v = 0; v < values.size(); v++) {
+        if (placed[v]) {
+            valueIndex[v] = static_cast<uint32_t>(liveValues.size());
+            liveValues.push_back(std::move(values[v]));
+        }
+    }
+    for (IrInstruction& instruction : liveValues) {
+        instruction.block = blockIndex[instruction.block];
+        for (uint32_t& operand : instruction.operands) {
+            operand = valueIndex[operand];
+        }
+    }
+    for (IrBlock& block : liveBlocks) {
+        std::vector<uint32_t> instructions;
+        for (uint32_t value : block.instructions) {
+            if (valueIndex[value] != none) {
+                instructions.push_back(valueIndex[value]);
+            }
+        }
+        block.instructions = std::move(instructions);
+        for (uint32_t& predecessor : block.predecessors) {
+            predecessor = blockIndex[predecessor];
+        }
+        for (uint32_t& successor : block.successors) {
+            successor = blockIndex[successor];
+        }
+    }
+    blocks = std::move(liveBlocks);
+    values = std::move(liveValues);
+}
+
+std::vector<uint32_t> IrFunction::reversePostorder() const {
+    std::vector<uint32_t> order;
+    if (blocks.empty()) {
+        return order;
+    }
+    std::vector<bool> visited(blocks.size(), false);
+    // 显式栈：块和下一个要访问的后继下标
+    std::vector<std::pair<uint32_t, size_t>> stack{ { 0, 0 } };
+    visited[0] = true;
+    while (!stack.empty()) {
+        auto& [block, next] = stack.back();
+        if (next < blocks[block].successors.size()) {
+            uint32_t successor = blocks[block].successors[next++];
+            if (!visited[successor]) {
+                visited[successor] = true;
+                stack.push_back({ successor, 0 });
+            }
+        }
+        else {
+            order.push_back(block);
+            stack.pop_back();
+        }
+    }
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+// Cooper、Harvey、Kennedy的迭代算法
+std::vector<uint32_t> IrFunction::dominators(const std::vector<uint32_t>& order) const {
+    std::vector<uint32_t> idom(blocks.size(), none);
+    std::vector<uint32_t> position(blocks.size(), none);
+    for (uint32_t i = 0; i < order.size(); i++) {
+        position[order[i]] = i;
+    }
+    if (order.empty()) {
+        return idom;
+    }
+    idom[order[0]] = order[0];
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 1; i < order.size(); i++) {
+            uint32_t block = order[i];
+            uint32_t newIdom = none;
+            for (uint32_t predecessor : blocks[block].predecessors) {
+                if (idom[predecessor] == none) {
+                    continue;
+                }
+                if (newIdom == none) {
+                    newIdom = predecessor;
+                    continue;
+                }
+                uint32_t a = predecessor;
+                uint32_t b = newIdom;
+                while (a != b) {
+                    while (position[a] > position[b]) {
+                        a = idom[a];
+                    }
+                    while (position[b] > position[a]) {
+                        b = idom[b];
+                    }
+                }
+                newIdom = a;
+            }
+            if (newIdom != idom[block]) {
+                idom[block] = newIdom;
+                changed = true;
+            }
+        }
+    }
+    for (uint32_t b = 0; b < blocks.size(); b++) {
+        if (idom[b] == none) {
+            idom[b] = b;
+        }
+    }
+    return idom;
+}
+
+size_t IrFunction::instructionCount() const {
+    size_t count = 0;
+    for (const IrBlock& block : blocks) {
+        if (!block.removed) {
+            count += block.instructions.size();
+        }
+    }
+    return count;
+}
+
+bool verifyIr(const IrFunction& function, std::string& error) {
+    auto fail = [&](uint32_t block, const std::string& message) {
+        error = function.name + ": bb" + std::to_string(block) + ": " + message;
+        return false;
+    };
+    std::vector<uint32_t> order = function.reversePostorder();
+    std::vector<uint32_t> idom = function.dominators(order);
+    std::vector<bool> reachable(function.blocks.size(), false);
+    for (uint32_t block : order) {
+        reachable[block] = true;
+    }
+    auto dominates = [&](uint32_t a, uint32_t b) {
+        while (true) {
+            if (a == b) {
+                return true;
+            }
+            if (idom[b] == b) {
+                return false;
+            }
+            b = idom[b];
+        }
+    };
+
+    std::vector<uint32_t> position(function.values.size(), none);
+    for (uint32_t b = 0; b < function.blocks.size(); b++) {
+        const IrBlock& block = function.blocks[b];
+        if (block.removed) {
+            continue;
+        }
+        for (uint32_t i = 0; i < block.instructions.size(); i++) {
+            uint32_t value = block.instructions[i];
+            if (value >= function.values.size() || function.values[value].removed || function.values[value].block != b) {
+                return fail(b, "instruction %" + std::to_string(value) + " is not owned by the block");
+            }
+            position[value] = i;
+        }
+    }
+
+    for (uint32_t b = 0; b < function.blocks.size(); b++) {
+        const IrBlock& block = function.blocks[b];
+        if (block.removed) {
+            continue;
+        }
+        if (block.instructions.empty()) {
+            return fail(b, "empty block");
+        }
+        for (uint32_t successor : block.successors) {
+            const IrBlock& target = function.blocks[successor];
+            if (target.removed || std::count(block.successors.begin(), block.successors.end(), successor) !=
+                std::count(target.predecessors.begin(), target.predecessors.end(), b)) {
+                return fail(b, "edge to bb" + std::to_string(successor) + " is inconsistent");
+            }
+        }
+        for (uint32_t predecessor : block.predecessors) {
+            const std::vector<uint32_t>& successors = function.blocks[predecessor].successors;
+            if (function.blocks[predecessor].removed || std::find(successors.begin(), successors.end(), b) == successors.end()) {
+                return fail(b, "predecessor bb" + std::to_string(predecessor) + " does not branch here");
+            }
+        }
+        bool phis = true;
+        for (uint32_t i = 0; i < block.instructions.size(); i++) {
+            const IrInstruction& instruction = function.values[block.instructions[i]];
+            bool last = i + 1 == block.instructions.size();
+            bool terminator = (irOpFlags(instruction.op) & IrTerminator) != 0;
+            if (terminator != last) {
+                return fail(b, last ? "block does not end with a terminator" : "terminator in the middle of the block");
+            }
+            if (instruction.op == IrOp::Phi) {
+                if (!phis) {
+                    return fail(b, "phi after a non-phi instruction");
+                }
+                if (instruction.operands.size() != block.predecessors.size()) {
+                    return fail(b, "phi %" + std::to_string(block.instructions[i]) + " does not match the predecessors");
+                }
+            }
+            else {
+                phis = false;
+            }
+            size_t successors = instruction.op == IrOp::Jump ? 1 : instruction.op == IrOp::Branch ? 2 : 0;
+            if (terminator && block.successors.size() != successors) {
+                return fail(b, "terminator does not match the successors");
+            }
+            for (size_t k = 0; k < instruction.operands.size(); k++) {
+                uint32_t operand = instruction.operands[k];
+                if (operand >= function.values.size() || position[operand] == none) {
+                    return fail(b, "use of undefined value %" + std::to_string(operand));
+                }
+                if (instruction.op == IrOp::Phi && function.values[operand].type != instruction.type) {
+                    return fail(b, "phi %" + std::to_string(block.instructions[i]) + " mixes types");
+                }
+                // 不可达的块和来自不可达前驱的Phi操作数不检查支配关系，它们会被SimplifyCFG删除
+                if (!reachable[b] || (instruction.op == IrOp::Phi && !reachable[block.predecessors[k]])) {
+                    continue;
+                }
+                uint32_t definition = function.values[operand].block;
+                bool ok = instruction.op == IrOp::Phi
+                    ? dominates(definition, block.predecessors[k])
+                    : (definition == b ? position[operand] < i : dominates(definition, b));
+                if (!ok) {
+                    return fail(b, "%" + std::to_string(operand) + " does not dominate its use");
+                }
+            }
+        }
+    }
+    return true;
+}
+
+void printIr(const IrModule& module, const IrFunction& function, std::ostream& os) {
+    os << "function " << function.name << "(";
+    for (size_t i = 0; i < function.parameters.size(); i++) {
+        os << (i != 0 ? ", " : "") << irTypeName(function.parameters[i]);
+    }
+    os << ") -> " << irTypeName(function.returnType) << "\n";
+    for (uint32_t b = 0; b < function.blocks.size(); b++) {
+        const IrBlock& block = function.blocks[b];
+        if (block.removed) {
+            continue;
+        }
+        os << "bb" << b << ":";
+        if (!block.predecessors.empty()) {
+            os << "  ; preds";
+            for (uint32_t predecessor : block.predecessors) {
+                os << " bb" << predecessor;
+            }
+        }
+        os << "\n";
+        for (uint32_t value : block.instructions) {
+            const IrInstruction& instruction = function.values[value];
+            os << "  ";
+            if (instruction.type != IrType::Void) {
+                printValue(os, value);
+                os << ":" << irTypeName(instruction.type) << " = ";
+            }
+            os << irOpName(instruction.op);
+            switch (instruction.op) {
+            case IrOp::Const:
+                if (instruction.type == IrType::Double) {
+                    os << " " << instruction.doubleValue;
+                }
+                else {
+                    os << " " << instruction.intValue;
+                }
+                break;
+            case IrOp::Param:
+            case IrOp::PrintChar:
+                os << " " << instruction.immediate;
+                break;
+            case IrOp::LoadGlobal:
+            case IrOp::StoreGlobal:
+                os << " g" << instruction.immediate;
+                break;
+            case IrOp::Call:
+                os << " " << module.functions[instruction.immediate].name;
+                break;
+            default:
+                break;
+            }
+            for (size_t k = 0; k < instruction.operands.size(); k++) {
+                os << (k == 0 && instruction.op != IrOp::StoreGlobal ? " " : ", ");
+                if (instruction.op == IrOp::Phi) {
+                    os << "[";
+                    printValue(os, instruction.operands[k]);
+                    os << ", bb" << block.predecessors[k] << "]";
+                }
+                else {
+                    printValue(os, instruction.operands[k]);
+                }
+            }
+            for (size_t k = 0; k < block.successors.size() && value == block.instructions.back(); k++) {
+                os << (k == 0 && instruction.operands.empty() ? " " : ", ") << "bb" << block.successors[k];
+            }
+            os << "\n";
+        }
+    }
+}
+
+void printIr(const IrModule& module, std::ostream& os) {
+    for (size_t i = 0; i < module.functions.size(); i++) {
+        if (i != 0) {
+            os << "\n";
+        }
+        printIr(module, module.functions[i], os);
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// 指令属性，见ir.def
+enum : uint8_t {
+    IrPure = 1,
+    IrTrap = 2,
+    IrRead = 4,
+    IrEffect = 8,
+    IrTerminator = 16,
+    IrCommutative = 32
+};
+
+enum class IrOp : uint8_t
+{
+#define IR_OP(name, mnemonic, flags) name,
+#include "ir.def"
+#undef IR_OP
+    Count
+};
+
+// 虚拟寄存器的类型；Mark是数组栈顶位置，只用于ArrayMark和ArrayRelease
+enum class IrType : uint8_t
+{
+    Void,
+    Int,
+    Double,
+    Array,
+    Mark
+};
+
+// SSA值：每条指令定义一个值，值编号就是指令在IrFunction::values中的下标
+struct IrInstruction {
+    IrOp op;
+    IrType type;
+    bool removed = false;
+    uint32_t block = 0;
+    uint32_t immediate = 0;           // 参数、全局变量、函数编号或字符
+    int32_t intValue = 0;
+    double doubleValue = 0.0;
+    std::vector<uint32_t> operands;
+};
+
+struct IrBlock {
+    bool removed = false;
+    std::vector<uint32_t> instructions;   // Phi在最前面，终结指令在最后
+    std::vector<uint32_t> predecessors;   // 与Phi的操作数一一对应
+    std::vector<uint32_t> successors;     // Branch的真、假后继，或Jump的目标
+};
+
+// 基本块0是入口
+struct IrFunction {
+    std::string name;
+    IrType returnType = IrType::Int;
+    std::vector<IrType> parameters;
+    std::vector<IrInstruction> values;
+    std::vector<IrBlock> blocks;
+
+    uint32_t addBlock();
+    // 在block末尾追加指令，返回值编号
+    uint32_t append(uint32_t block, IrOp op, IrType type, std::vector<uint32_t> operands = {}, uint32_t immediate = 0);
+    void addEdge(uint32_t from, uint32_t to);
+    // 删除from到to的一条边以及to中Phi的对应操作数
+    void removeEdge(uint32_t from, uint32_t to);
+    uint32_t terminator(uint32_t block) const;
+    // 按替换表改写所有操作数，replacement[v] == v表示不替换；替换链会被追到底
+    void replaceUses(std::vector<uint32_t>& replacement);
+    // 删除标记为removed的指令和基本块，重新编号
+    void compact();
+    // 从入口出发的逆后序，不可达的基本块不在其中
+    std::vector<uint32_t> reversePostorder() const;
+    // 直接支配者，入口和不可达的块为自身
+    std::vector<uint32_t> dominators(const std::vector<uint32_t>& order) const;
+    size_t instructionCount() const;
+};
+
+struct IrModule {
+    std::vector<IrFunction> functions;    // 按函数符号的槽位编号，最后一个是<init>
+    std::vector<IrType> globals;
+    uint32_t initFunction = 0;
+    uint32_t mainFunction = 0;
+};
+
+uint8_t irOpFlags(IrOp op);
+const char* irOpName(IrOp op);
+const char* irTypeName(IrType type);
+// 检查SSA形式：操作数有定义且支配使用、Phi与前驱对应、每个块以终结指令结束、前驱后继一致；
+// 出错时返回false并写入error
+bool verifyIr(const IrFunction& function, std::string& error);
+void printIr(const IrModule& module, std::ostream& os);
+void printIr(const IrModule& module, const IrFunction& function, std::ostream& os);
@@ -0,0 +1,1030 @@
+#include <memory>
+#include <string>
+#include "irBuilder.hpp"
+
+namespace {
+    const ASTNode* childAt(const ASTNode* node, size_t index) {
+        return node != nullptr && index < node->children.size() ? node->children[index] : nullptr;
+    }
+
+    const char* const printBuiltin = "print";
+    constexpr uint32_t none = UINT32_MAX;
+
+    bool declaresArray(const ASTNode* declaration) {
+        const ASTNode* list = childAt(declaration, 1);
+        if (declaration == nullptr || declaration->type != "DeclarationNode" || list == nullptr) {
+            return false;
+        }
+        for (const ASTNode* initDeclarator : list->children) {
+            const ASTNode* marker = childAt(childAt(initDeclarator, 0), 0);
+            if (marker != nullptr && marker->type == "ArrayDeclarator") {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+IrType irTypeOf(ValueType type) {
+    switch (type) {
+    case ValueType::Float:
+    case ValueType::Double:
+        return IrType::Double;
+    case ValueType::Array:
+        return IrType::Array;
+    case ValueType::Void:
+        return IrType::Void;
+    default:
+        return IrType::Int;
+    }
+}
+
+IrBuilder::IrBuilder()
+    : resolver_(nullptr), checker_(nullptr), module_(nullptr), function_(nullptr), returnType_(ValueType::Int), current_(0) {
+}
+
+IrModule IrBuilder::build(const ASTNode* root) {
+    ParallelPassManager sequential;
+    return build(root, sequential);
+}
+
+IrModule IrBuilder::build(const ASTNode* root, ParallelPassManager& passes) {
+    IrModule module;
+    module_ = &module;
+    if (root == nullptr) {
+        throw RuntimeError("no program to compile");
+    }
+    NameResolver resolver;
+    resolver.resolve(root);
+    if (!resolver.redeclarations().empty()) {
+        throw RuntimeError("redeclared identifier '" + resolver.redeclarations().front().declarator->value + "'");
+    }
+    resolver_ = &resolver;
+    // 表达式的类型和数组长度都从类型检查的结果中读取
+    TypeChecker checker(resolver);
+    checker.check(root);
+    if (!checker.errors().empty()) {
+        throw RuntimeError(checker.errors().front().message);
+    }
+    checker_ = &checker;
+
+    // 函数按符号槽位编号，最后一个是初始化全局变量的函数
+    module_->functions.resize(resolver.functionCount() + 1);
+    module_->initFunction = resolver.functionCount();
+    module_->functions[module_->initFunction].name = "<init>";
+    module_->globals.assign(resolver.globalCount(), IrType::Int);
+    signatures_.assign(resolver.functionCount(), { ValueType::Int, {}, false });
+    bool hasMain = false;
+    for (const Symbol& symbol : resolver.symbols()) {
+        if (symbol.depth == 0 && symbol.kind == SymbolKind::Variable) {
+            module_->globals[symbol.slot] = irTypeOf(typeOf(symbol.type));
+        }
+        else if (symbol.depth == 0 && symbol.kind == SymbolKind::Array) {
+            module_->globals[symbol.slot] = IrType::Array;
+        }
+        if (symbol.kind != SymbolKind::Function) {
+            continue;
+        }
+        Signature& signature = signatures_[symbol.slot];
+        IrFunction& function = module_->functions[symbol.slot];
+        function.name = resolver.names().name(symbol.name);
+        signature.returnType = typeOf(symbol.type);
+        signature.defined = symbol.definition != nullptr;
+        const ASTNode* parameters = childAt(childAt(symbol.definition, 1), 2);
+        if (parameters != nullptr) {
+            for (const ASTNode* parameter : parameters->children) {
+                signature.parameters.push_back(typeOf(childAt(parameter, 0)));
+                function.parameters.push_back(irTypeOf(signature.parameters.back()));
+            }
+        }
+        function.returnType = irTypeOf(signature.returnType);
+        if (symbol.depth == 0 && function.name == "main" && signature.defined) {
+            if (!signature.parameters.empty()) {
+                throw RuntimeError("main must not take parameters");
+            }
+            module_->mainFunction = symbol.slot;
+            hasMain = true;
+        }
+    }
+    if (!hasMain) {
+        throw RuntimeError("program has no main function");
+    }
+
+    // 函数各自构造，只读取上面的结果并写自己槽位上的IrFunction；
+    // 每个外部声明是一个任务，出错时报告的是源程序中第一个出错的声明
+    std::vector<std::unique_ptr<IrBuilder>> workers;
+    for (size_t i = 0; i < passes.jobs(); i++) {
+        workers.push_back(std::make_unique<IrBuilder>());
+        workers.back()->resolver_ = &resolver;
+        workers.back()->checker_ = &checker;
+        workers.back()->module_ = &module;
+        workers.back()->signatures_ = signatures_;
+    }
+    passes.run(root->children.size(), [&](size_t index, size_t worker) {
+        const ASTNode* declaration = root->children[index];
+        if (declaration == nullptr || declaration->type == "DeclarationNode") {
+            return;
+        }
+        if (declaration->type != "FunctionDefinitionNode") {
+            throw RuntimeError("unsupported external declaration '" + declaration->type + "'");
+        }
+        workers[worker]->buildFunction(declaration);
+    });
+
+    // 文件作用域的声明按出现顺序放进初始化函数
+    beginFunction(module_->functions[module_->initFunction], ValueType::Int);
+    for (const ASTNode* declaration : root->children) {
+        if (declaration != nullptr && declaration->type == "DeclarationNode") {
+            buildDeclaration(declaration, true);
+        }
+    }
+    endFunction();
+    resolver_ = nullptr;
+    checker_ = nullptr;
+    module_ = nullptr;
+    return module;
+}
+
+// FunctionDefinitionNode: TypeSpecifier DirectDeclarator CompoundStatement
+void IrBuilder::buildFunction(const ASTNode* node) {
+    const ASTNode* declarator = childAt(node, 1);
+    const Symbol* symbol = resolver_->declarationOf(childAt(declarator, 1));
+    if (symbol == nullptr || symbol->definition != node) {
+        throw RuntimeError("malformed function definition");
+    }
+    beginFunction(module_->functions[symbol->slot], signatures_[symbol->slot].returnType);
+    const ASTNode* parameters = childAt(declarator, 2);
+    if (parameters != nullptr) {
+        for (size_t i = 0; i < parameters->children.size(); i++) {
+            const Symbol* parameter = resolver_->declarationOf(childAt(parameters->children[i], 1));
+            if (parameter == nullptr) {
+                throw RuntimeError("malformed parameter list of '" + function_->name + "'");
+            }
+            uint32_t value = emit(IrOp::Param, function_->parameters[i], {}, static_cast<uint32_t>(i));
+            writeVariable(variableOf(*parameter), current_, value);
+        }
+    }
+    buildStatement(childAt(node, 2), true);
+    endFunction();
+}
+
+void IrBuilder::beginFunction(IrFunction& function, ValueType returnType) {
+    function_ = &function;
+    returnType_ = returnType;
+    loops_.clear();
+    arrayMarks_.clear();
+    definitions_.clear();
+    incompletePhis_.clear();
+    sealed_.clear();
+    replacement_.clear();
+    current_ = newBlock();
+    sealBlock(current_);
+}
+
+// 补上函数末尾的返回，删除剩下的平凡Phi并重新编号
+void IrBuilder::endFunction() {
+    if (!terminated()) {
+        emit(IrOp::Return, IrType::Void);
+    }
+    // 构造时删除Phi不会回头检查使用它的Phi，这里反复检查直到没有变化
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (uint32_t value = 0; value < function_->values.size(); value++) {
+            const IrInstruction& phi = function_->values[value];
+            if (phi.op == IrOp::Phi && !phi.removed && tryRemoveTrivialPhi(value) != value) {
+                changed = true;
+            }
+        }
+    }
+    while (replacement_.size() < function_->values.size()) {
+        replacement_.push_back(static_cast<uint32_t>(replacement_.size()));
+    }
+    function_->replaceUses(replacement_);
+    function_->compact();
+    function_ = nullptr;
+}
+
+void IrBuilder::buildStatement(const ASTNode* node, bool functionBody) {
+    if (node == nullptr) {
+        throw RuntimeError("incomplete syntax tree");
+    }
+    const std::string& type = node->type;
+    if (type == "CompoundStatement") {
+        // 块里声明了数组时，离开块要释放数组；函数体不需要，返回时会恢复数组栈
+        bool releases = false;
+        if (!functionBody) {
+            for (const ASTNode* child : node->children) {
+                releases = releases || declaresArray(child);
+            }
+        }
+        if (releases) {
+            arrayMarks_.push_back(emit(IrOp::ArrayMark, IrType::Mark));
+        }
+        for (const ASTNode* child : node->children) {
+            buildStatement(child);
+        }
+        if (releases) {
+            emit(IrOp::ArrayRelease, IrType::Void, { arrayMarks_.back() });
+            arrayMarks_.pop_back();
+        }
+    }
+    else if (type == "DeclarationNode") {
+        buildDeclaration(node, false);
+    }
+    else if (type == "ExpressionNode") {
+        // 空语句
+    }
+    else if (type == "SelectionStatement") {
+        // SelectionStatement: expression statement statement?
+        bool hasElse = node->children.size() > 2;
+        uint32_t thenBlock = newBlock();
+        uint32_t elseBlock = hasElse ? newBlock() : none;
+        uint32_t end = newBlock();
+        buildBranch(childAt(node, 0), thenBlock, hasElse ? elseBlock : end);
+        sealBlock(thenBlock);
+        startBlock(thenBlock);
+        buildStatement(childAt(node, 1));
+        jump(end);
+        if (hasElse) {
+            sealBlock(elseBlock);
+            startBlock(elseBlock);
+            buildStatement(node->children[2]);
+            jump(end);
+        }
+        sealBlock(end);
+        startBlock(end);
+    }
+    else if (type == "IterationStatement") {
+        bool isFor = node->value == "for";
+        const ASTNode* init = isFor ? childAt(node, 0) : nullptr;
+        const ASTNode* condition = childAt(node, isFor ? 1 : 0);
+        const ASTNode* step = isFor ? childAt(node, 2) : nullptr;
+        const ASTNode* body = childAt(node, isFor ? 3 : 1);
+
+        bool releases = declaresArray(init);
+        if (releases) {
+            arrayMarks_.push_back(emit(IrOp::ArrayMark, IrType::Mark));
+        }
+        if (init != nullptr) {
+            buildStatement(init);
+        }
+        // 循环头和continue目标要等回边、continue都出现之后才能封闭
+        uint32_t header = newBlock();
+        uint32_t bodyBlock = newBlock();
+        uint32_t continueBlock = newBlock();
+        uint32_t exit = newBlock();
+        jump(header);
+        startBlock(header);
+        if (condition != nullptr && condition->type != "ExpressionNode") {
+            buildBranch(condition, bodyBlock, exit);
+        }
+        else {
+            jump(bodyBlock);
+        }
+        sealBlock(bodyBlock);
+        startBlock(bodyBlock);
+        loops_.push_back({ exit, continueBlock, arrayMarks_.size() });
+        buildStatement(body);
+        loops_.pop_back();
+        jump(continueBlock);
+        sealBlock(continueBlock);
+        startBlock(continueBlock);
+        if (step != nullptr && step->type != "ExpressionNode") {
+            buildExpression(step);
+        }
+        jump(header);
+        sealBlock(header);
+        sealBlock(exit);
+        startBlock(exit);
+        if (releases) {
+            emit(IrOp::ArrayRelease, IrType::Void, { arrayMarks_.back() });
+            arrayMarks_.pop_back();
+        }
+    }
+    else if (type == "JumpStatement") {
+        if (node->value == "return") {
+            if (node->children.empty()) {
+                emit(IrOp::Return, IrType::Void);
+            }
+            else {
+                uint32_t value = emitConvert(buildExpression(node->children[0]), returnType_);
+                emit(IrOp::Return, IrType::Void, { value });
+            }
+            startUnreachable();
+        }
+        else {
+            buildLoopExit(node->value == "break");
+        }
+    }
+    else {
+        buildExpression(node);
+    }
+}
+
+void IrBuilder::buildLoopExit(bool isBreak) {
+    if (loops_.empty()) {
+        throw RuntimeError(std::string("'") + (isBreak ? "break" : "continue") + "' outside of a loop");
+    }
+    const Loop& loop = loops_.back();
+    // 跳出循环体内声明了数组的块时，先释放其中最外层块之后分配的数组
+    if (arrayMarks_.size() > loop.arrayBlocks) {
+        emit(IrOp::ArrayRelease, IrType::Void, { arrayMarks_[loop.arrayBlocks] });
+    }
+    jump(isBreak ? loop.breakBlock : loop.continueBlock);
+    startUnreachable();
+}
+
+// DeclarationNode: TypeSpecifier InitDeclaratorList
+// 与Interpreter相同：逗号后面的名字是同一类型的标量，初始化表达式属于最后一个名字
+void IrBuilder::buildDeclaration(const ASTNode* node, bool global) {
+    ValueType type = typeOf(childAt(node, 0));
+    const ASTNode* list = childAt(node, 1);
+    if (list == nullptr) {
+        return;
+    }
+    for (const ASTNode* initDeclarator : list->children) {
+        const ASTNode* declarator = childAt(initDeclarator, 0);
+        const ASTNode* initializer = childAt(initDeclarator, 1);
+        if (declarator == nullptr || declarator->children.empty() || declarator->children[0] == nullptr) {
+            throw RuntimeError("incomplete syntax tree");
+        }
+        const std::string& marker = declarator->children[0]->type;
+        std::vector<const Symbol*> scalars;
+        size_t next = 0;
+        if (marker == "ArrayDeclarator") {
+            const Symbol* symbol = resolver_->declarationOf(childAt(declarator, 1));
+            if (symbol == nullptr) {
+                throw RuntimeError("malformed declaration");
+            }
+            if (initializer != nullptr && declarator->children.size() == 3) {
+                throw RuntimeError("array initializers are not supported");
+            }
+            const ASTNode* lengthNode = childAt(declarator, 2);
+            Value length = buildExpression(lengthNode);
+            uint32_t array = emit(IrOp::NewArray, IrType::Array, { length.id });
+            if (global) {
+                emit(IrOp::StoreGlobal, IrType::Void, { array }, symbol->slot);
+            }
+            else {
+                writeVariable(variableOf(*symbol), current_, array);
+            }
+            next = 3;
+        }
+        else if (marker == "FunctionDeclarator") {
+            next = 3;
+        }
+        for (size_t i = next; i < declarator->children.size(); i++) {
+            const Symbol* symbol = resolver_->declarationOf(declarator->children[i]);
+            if (symbol == nullptr) {
+                throw RuntimeError("malformed declaration");
+            }
+            scalars.push_back(symbol);
+        }
+        if (initializer != nullptr && scalars.empty()) {
+            throw RuntimeError("initializer on a function declaration");
+        }
+        for (size_t i = 0; i < scalars.size(); i++) {
+            // 没有初值的变量置为零，与Interpreter一致
+            uint32_t value = initializer != nullptr && i + 1 == scalars.size()
+                ? emitConvert(buildExpression(initializer), type)
+                : emitConstant(RuntimeValue::zero(promotedType(type)));
+            if (global) {
+                emit(IrOp::StoreGlobal, IrType::Void, { value }, scalars[i]->slot);
+            }
+            else {
+                writeVariable(variableOf(*scalars[i]), current_, value);
+            }
+        }
+    }
+}
+
+// 条件为真时转到whenTrue，否则转到whenFalse；返回时当前块已经结束，由调用者开始新的块
+void IrBuilder::buildBranch(const ASTNode* node, uint32_t whenTrue, uint32_t whenFalse) {
+    if (node == nullptr) {
+        throw RuntimeError("incomplete syntax tree");
+    }
+    const std::string& type = node->type;
+    const ASTNode* op = childAt(node, 1);
+
+    RuntimeValue constant;
+    if (type == "PrimaryExpression" && parseConstant(node->value, constant)) {
+        jump(isTruthy(constant) ? whenTrue : whenFalse);
+        return;
+    }
+    if ((type == "LogicalAndExpression" || type == "LogicalOrExpression") && op != nullptr) {
+        // a && b 为假、a || b 为真时都可以只看左边的结果
+        uint32_t right = newBlock();
+        if (type == "LogicalAndExpression") {
+            buildBranch(childAt(node, 0), right, whenFalse);
+        }
+        else {
+            buildBranch(childAt(node, 0), whenTrue, right);
+        }
+        sealBlock(right);
+        startBlock(right);
+        buildBranch(childAt(node, 2), whenTrue, whenFalse);
+        return;
+    }
+    if (type == "UnaryExpression" && childAt(node, 0) != nullptr && node->children[0]->type == "!") {
+        buildBranch(childAt(node, 1), whenFalse, whenTrue);
+        return;
+    }
+    Value value = buildExpression(node);
+    uint32_t condition = value.type == ValueType::Int ? value.id : emit(IrOp::ToBool, IrType::Int, { value.id });
+    branch(condition, whenTrue, whenFalse);
+}
+
+IrBuilder::Value IrBuilder::buildExpression(const ASTNode* node) {
+    if (node == nullptr) {
+        throw RuntimeError("incomplete syntax tree");
+    }
+    const std::string& type = node->type;
+    if (type == "PrimaryExpression") {
+        RuntimeValue constant;
+        if (parseConstant(node->value, constant)) {
+            return { emitConstant(constant), constant.type };
+        }
+        const Symbol& symbol = symbolOf(node);
+        if (symbol.kind == SymbolKind::Function || symbol.kind == SymbolKind::Array) {
+            throw RuntimeError(std::string(symbol.kind == SymbolKind::Function ? "function '" : "array '") + node->value + "' used as a value");
+        }
+        return load(buildPlace(node));
+    }
+    if (type == "AdditiveExpression" || type == "MultiplicativeExpression") {
+        return buildBinary(node, node->value, childAt(node, 0), childAt(node, 1));
+    }
+    if (type == "LogicalAndExpression" || type == "LogicalOrExpression") {
+        return buildLogical(node);
+    }
+    if (type == "ShiftExpression" || type == "RelationalExpression" || type == "EqualityExpression" ||
+        type == "AndExpression" || type == "ExclusiveOrExpression" || type == "InclusiveOrExpression") {
+        const ASTNode* op = childAt(node, 1);
+        if (op == nullptr) {
+            throw RuntimeError("incomplete syntax tree");
+        }
+        return buildBinary(node, op->type, childAt(node, 0), childAt(node, 2));
+    }
+    if (type == "AssignmentExpression") {
+        return buildAssignment(node);
+    }
+    if (type == "ConditionalExpression") {
+        return buildConditional(node);
+    }
+    if (type == "CommaExpression") {
+        buildExpression(childAt(node, 0));
+        return buildExpression(childAt(node, 1));
+    }
+    if (type == "UnaryExpression" || type == "PostfixExpression") {
+        return buildUnary(node);
+    }
+    if (type == "CastExpression") {
+        // CastExpression: '(' TypeSpecifier ')' operand
+        ValueType castType = typeOf(childAt(node, 1));
+        Value operand = buildExpression(childAt(node, 3));
+        return { emitConvert(operand, castType), promotedType(castType) };
+    }
+    if (type == "SizeofExpression") {
+        return buildSizeof(node);
+    }
+    if (type == "ArrayAccess") {
+        return load(buildPlace(node));
+    }
+    if (type == "FunctionCall") {
+        return buildCall(node);
+    }
+    throw RuntimeError("unsupported expression '" + type + "'");
+}
+
+IrBuilder::Value IrBuilder::buildBinary(const ASTNode* node, const std::string& op, const ASTNode* left, const ASTNode* right) {
+    BinaryOp binary;
+    if (!binaryOpFromLexeme(op, binary)) {
+        throw RuntimeError("unsupported operator '" + op + "' in " + node->type);
+    }
+    Value leftValue = buildExpression(left);
+    Value rightValue = buildExpression(right);
+    return emitBinary(binary, leftValue, rightValue);
+}
+
+// &&、||的值：先按条件分支，两个出口分别是1和0，在汇合处用Phi选择
+IrBuilder::Value IrBuilder::buildLogical(const ASTNode* node) {
+    uint32_t whenTrue = newBlock();
+    uint32_t whenFalse = newBlock();
+    uint32_t end = newBlock();
+    buildBranch(node, whenTrue, whenFalse);
+    sealBlock(whenTrue);
+    sealBlock(whenFalse);
+    startBlock(whenTrue);
+    uint32_t one = emitConstant(RuntimeValue::ofInt(1));
+    jump(end);
+    startBlock(whenFalse);
+    uint32_t zero = emitConstant(RuntimeValue::ofInt(0));
+    jump(end);
+    sealBlock(end);
+    startBlock(end);
+    return { join(IrType::Int, { { whenTrue, one }, { whenFalse, zero } }), ValueType::Int };
+}
+
+// ConditionalExpression: condition ? whenTrue : whenFalse，两个分支都转换成常用算术转换之后的类型
+IrBuilder::Value IrBuilder::buildConditional(const ASTNode* node) {
+    ValueType type = checker_->valueTypeOf(node);
+    uint32_t whenTrue = newBlock();
+    uint32_t whenFalse = newBlock();
+    uint32_t end = newBlock();
+    buildBranch(childAt(node, 0), whenTrue, whenFalse);
+    sealBlock(whenTrue);
+    sealBlock(whenFalse);
+    startBlock(whenTrue);
+    uint32_t trueValue = emitConvert(buildExpression(childAt(node, 1)), type);
+    uint32_t trueEnd = current_;
+    jump(end);
+    startBlock(whenFalse);
+    uint32_t falseValue = emitConvert(buildExpression(childAt(node, 2)), type);
+    uint32_t falseEnd = current_;
+    jump(end);
+    sealBlock(end);
+    startBlock(end);
+    return { join(irTypeOf(type), { { trueEnd, trueValue }, { falseEnd, falseValue } }), type };
+}
+
+// AssignmentExpression: target operator value
+IrBuilder::Value IrBuilder::buildAssignment(const ASTNode* node) {
+    const ASTNode* op = childAt(node, 1);
+    if (op == nullptr) {
+        throw RuntimeError("incomplete syntax tree");
+    }
+    Place place = buildPlace(childAt(node, 0));
+    uint32_t result;
+    if (op->type == "=") {
+        result = emitConvert(buildExpression(childAt(node, 2)), place.type);
+    }
+    else {
+        BinaryOp binary;
+        if (!binaryOpFromLexeme(op->type, binary)) {
+            throw RuntimeError("unsupported assignment operator '" + op->type + "'");
+        }
+        // 和解释器一样先求右边再读目标的当前值
+        Value value = buildExpression(childAt(node, 2));
+        Value current = load(place);
+        result = emitConvert(emitBinary(binary, current, value), place.type);
+    }
+    store(place, result);
+    return { result, promotedType(place.type) };
+}
+
+IrBuilder::Value IrBuilder::buildIncrement(const ASTNode* operand, int32_t delta, bool postfix) {
+    RuntimeValue constant;
+    if (operand == nullptr || (operand->type != "PrimaryExpression" && operand->type != "ArrayAccess") ||
+        (operand->type == "PrimaryExpression" && parseConstant(operand->value, constant))) {
+        throw RuntimeError(std::string("operand of '") + (delta > 0 ? "++" : "--") + "' is not assignable");
+    }
+    Place place = buildPlace(operand);
+    Value current = load(place);
+    Value result;
+    if (current.type == ValueType::Int) {
+        result = { emit(IrOp::Add, IrType::Int, { current.id, emitConstant(RuntimeValue::ofInt(delta)) }), ValueType::Int };
+    }
+    else {
+        Value step = { emitConstant(RuntimeValue::ofDouble(delta)), ValueType::Double };
+        result = emitBinary(BinaryOp::Add, current, step);
+        if (current.type == ValueType::Float) {
+            result = { emit(IrOp::RoundFloat, IrType::Double, { result.id }), ValueType::Float };
+        }
+    }
+    uint32_t updated = emitConvert(result, place.type);
+    store(place, updated);
+    return postfix ? current : Value{ updated, promotedType(place.type) };
+}
+
+// UnaryExpression: op operand；PostfixExpression: operand op
+IrBuilder::Value IrBuilder::buildUnary(const ASTNode* node) {
+    bool postfix = node->type == "PostfixExpression";
+    const ASTNode* op = childAt(node, postfix ? 1 : 0);
+    const ASTNode* operandNode = childAt(node, postfix ? 0 : 1);
+    if (op == nullptr) {
+        throw RuntimeError("incomplete syntax tree");
+    }
+    if (op->type == "++" || op->type == "--") {
+        return buildIncrement(operandNode, op->type == "++" ? 1 : -1, postfix);
+    }
+    if (op->type == "+") {
+        return buildExpression(operandNode);
+    }
+    Value operand = buildExpression(operandNode);
+    if (op->type == "-") {
+        return { emit(IrOp::Neg, irTypeOf(operand.type), { operand.id }), operand.type };
+    }
+    if (op->type == "!") {
+        return { emit(IrOp::Not, IrType::Int, { operand.id }), ValueType::Int };
+    }
+    if (op->type == "~") {
+        if (operand.type != ValueType::Int) {
+            throw RuntimeError("invalid operand of floating type to '~'");
+        }
+        return { emit(IrOp::BitNot, IrType::Int, { operand.id }), ValueType::Int };
+    }
+    throw RuntimeError("unsupported operator '" + op->type + "'");
+}
+
+// FunctionCall: callee '(' ArgumentExpressionList? ')'
+IrBuilder::Value IrBuilder::buildCall(const ASTNode* node) {
+    const ASTNode* callee = childAt(node, 0);
+    if (callee == nullptr || callee->type != "PrimaryExpression") {
+        throw RuntimeError("unsupported function call");
+    }
+    const ASTNode* list = node->children.size() == 4 ? node->children[2] : nullptr;
+    size_t count = list != nullptr ? list->children.size() : 0;
+    const Symbol* symbol = resolver_->bindingOf(callee);
+
+    if (symbol == nullptr && callee->value == printBuiltin) {
+        for (size_t i = 0; i < count; i++) {
+            Value value = buildExpression(list->children[i]);
+            if (i != 0) {
+                emit(IrOp::PrintChar, IrType::Void, {}, ' ');
+            }
+            emit(IrOp::Print, IrType::Void, { value.id });
+        }
+        emit(IrOp::PrintChar, IrType::Void, {}, '\n');
+        return { emitConstant(RuntimeValue::ofInt(0)), ValueType::Int };
+    }
+    if (symbol == nullptr) {
+        throw RuntimeError("undeclared function '" + callee->value + "'");
+    }
+    if (symbol->kind != SymbolKind::Function) {
+        throw RuntimeError("'" + callee->value + "' is not a function");
+    }
+    const Signature& signature = signatures_[symbol->slot];
+    const std::string& name = module_->functions[symbol->slot].name;
+    if (!signature.defined) {
+        throw RuntimeError("function '" + name + "' is declared but never defined");
+    }
+    if (count != signature.parameters.size()) {
+        throw RuntimeError("function '" + name + "' expects " + std::to_string(signature.parameters.size()) +
+            " argument(s), " + std::to_string(count) + " given");
+    }
+    std::vector<uint32_t> arguments;
+    for (size_t i = 0; i < count; i++) {
+        arguments.push_back(emitConvert(buildExpression(list->children[i]), signature.parameters[i]));
+    }
+    uint32_t result = emit(IrOp::Call, irTypeOf(signature.returnType), std::move(arguments), symbol->slot);
+    return { result, promotedType(signature.returnType) };
+}
+
+// sizeof不对操作数求值，只需要它的类型
+IrBuilder::Value IrBuilder::buildSizeof(const ASTNode* node) {
+    size_t size;
+    const ASTNode* operand = childAt(node, 1);
+    const Symbol* symbol = operand != nullptr && operand->type == "PrimaryExpression" ? resolver_->bindingOf(operand) : nullptr;
+    if (operand != nullptr && operand->type == "(") {
+        // SizeofExpression: sizeof '(' TypeSpecifier ')'
+        size = sizeOfType(typeOf(childAt(node, 2)));
+    }
+    else if (symbol != nullptr && symbol->kind == SymbolKind::Array) {
+        int32_t length = checker_->types().info(checker_->symbolType(*symbol)).length;
+        if (length < 0) {
+            throw RuntimeError("sizeof of array '" + operand->value + "' with a non-constant length");
+        }
+        size = static_cast<size_t>(length) * sizeOfType(typeOf(symbol->type));
+    }
+    else {
+        // 按未提升的类型计算，char变量是1个字节，与Interpreter一致
+        size = sizeOfType(checker_->types().info(checker_->typeOf(operand)).scalar);
+    }
+    return { emitConstant(RuntimeValue::ofInt(static_cast<int32_t>(size))), ValueType::Int };
+}
+
+IrBuilder::Place IrBuilder::buildPlace(const ASTNode* node) {
+    RuntimeValue constant;
+    if (node != nullptr && node->type == "PrimaryExpression" && !parseConstant(node->value, constant)) {
+        const Symbol& symbol = symbolOf(node);
+        if (symbol.kind == SymbolKind::Variable || symbol.kind == SymbolKind::Parameter) {
+            ValueType type = typeOf(symbol.type);
+            if (symbol.depth == 0) {
+                return { Place::Kind::Global, symbol.slot, none, none, type };
+            }
+            return { Place::Kind::Local, variableOf(symbol), none, none, type };
+        }
+    }
+    else if (node != nullptr && node->type == "ArrayAccess") {
+        // ArrayAccess: array '[' index ']'，数组只能通过名字访问
+        const ASTNode* base = childAt(node, 0);
+        if (base == nullptr || base->type != "PrimaryExpression") {
+            throw RuntimeError("unsupported array access");
+        }
+        const Symbol& symbol = symbolOf(base);
+        if (symbol.kind != SymbolKind::Array) {
+            throw RuntimeError("'" + base->value + "' is not an array");
+        }
+        uint32_t array = symbol.depth == 0
+            ? emit(IrOp::LoadGlobal, IrType::Array, {}, symbol.slot)
+            : readVariable(variableOf(symbol), current_);
+        Value index = buildExpression(childAt(node, 2));
+        if (index.type != ValueType::Int) {
+            throw RuntimeError("array subscript is not an integer");
+        }
+        return { Place::Kind::Element, none, array, index.id, typeOf(symbol.type) };
+    }
+    throw RuntimeError("expression is not assignable");
+}
+
+IrBuilder::Value IrBuilder::load(const Place& place) {
+    ValueType type = promotedType(place.type);
+    switch (place.kind) {
+    case Place::Kind::Local:
+        return { readVariable(place.variable, current_), type };
+    case Place::Kind::Global:
+        return { emit(IrOp::LoadGlobal, irTypeOf(type), {}, place.variable), type };
+    default:
+        return { emit(IrOp::LoadElement, irTypeOf(type), { place.array, place.index }), type };
+    }
+}
+
+void IrBuilder::store(const Place& place, uint32_t value) {
+    switch (place.kind) {
+    case Place::Kind::Local:
+        writeVariable(place.variable, current_, value);
+        break;
+    case Place::Kind::Global:
+        emit(IrOp::StoreGlobal, IrType::Void, { value }, place.variable);
+        break;
+    default:
+        emit(IrOp::StoreElement, IrType::Void, { place.array, place.index, value });
+        break;
+    }
+}
+
+// 按常用算术转换计算left op right
+IrBuilder::Value IrBuilder::emitBinary(BinaryOp op, Value left, Value right) {
+    ValueType type = arithmeticType(left.type, right.type);
+    bool comparison = op >= BinaryOp::Less;
+    if (type != ValueType::Int) {
+        if (op > BinaryOp::Div && !comparison) {
+            throw RuntimeError("invalid operands of floating type to an integer operator");
+        }
+        if (left.type == ValueType::Int) {
+            left = { emit(IrOp::IntToDouble, IrType::Double, { left.id }), ValueType::Double };
+        }
+        if (right.type == ValueType::Int) {
+            right = { emit(IrOp::IntToDouble, IrType::Double, { right.id }), ValueType::Double };
+        }
+    }
+    uint32_t a = left.id;
+    uint32_t b = right.id;
+    if (op == BinaryOp::Greater || op == BinaryOp::GreaterEqual) {
+        std::swap(a, b);
+    }
+    static const IrOp ops[] = {
+        IrOp::Add, IrOp::Sub, IrOp::Mul, IrOp::Div, IrOp::Mod, IrOp::Shl, IrOp::Shr,
+        IrOp::And, IrOp::Or, IrOp::Xor, IrOp::Lt, IrOp::Lt, IrOp::Le, IrOp::Le, IrOp::Eq, IrOp::Ne
+    };
+    uint32_t result = emit(ops[static_cast<size_t>(op)], comparison ? IrType::Int : irTypeOf(type), { a, b });
+    if (comparison) {
+        return { result, ValueType::Int };
+    }
+    if (type == ValueType::Float) {
+        result = emit(IrOp::RoundFloat, IrType::Double, { result });
+    }
+    return { result, type };
+}
+
+// 把source转换成存储类型type
+uint32_t IrBuilder::emitConvert(Value source, ValueType type) {
+    bool floating = source.type != ValueType::Int;
+    switch (type) {
+    case ValueType::Int:
+        return floating ? emit(IrOp::DoubleToInt, IrType::Int, { source.id }) : source.id;
+    case ValueType::Char: {
+        uint32_t integer = floating ? emit(IrOp::DoubleToInt, IrType::Int, { source.id }) : source.id;
+        return emit(IrOp::TruncChar, IrType::Int, { integer });
+    }
+    case ValueType::Bool:
+        return emit(IrOp::ToBool, IrType::Int, { source.id });
+    case ValueType::Float:
+        if (!floating) {
+            return emit(IrOp::RoundFloat, IrType::Double, { emit(IrOp::IntToDouble, IrType::Double, { source.id }) });
+        }
+        return source.type == ValueType::Double ? emit(IrOp::RoundFloat, IrType::Double, { source.id }) : source.id;
+    case ValueType::Double:
+        return floating ? source.id : emit(IrOp::IntToDouble, IrType::Double, { source.id });
+    default:
+        throw RuntimeError(std::string("cannot convert to ") + valueTypeName(type));
+    }
+}
+
+uint32_t IrBuilder::emitConstant(const RuntimeValue& value) {
+    bool floating = isFloatingType(value.type);
+    uint32_t constant = emit(IrOp::Const, floating ? IrType::Double : IrType::Int);
+    if (floating) {
+        function_->values[constant].doubleValue = value.doubleValue;
+    }
+    else {
+        function_->values[constant].intValue = value.intValue;
+    }
+    return constant;
+}
+
+uint32_t IrBuilder::emit(IrOp op, IrType type, std::vector<uint32_t> operands, uint32_t immediate) {
+    return function_->append(current_, op, type, std::move(operands), immediate);
+}
+
+uint32_t IrBuilder::newBlock() {
+    definitions_.emplace_back();
+    incompletePhis_.emplace_back();
+    sealed_.push_back(false);
+    return function_->addBlock();
+}
+
+// 块的前驱已经全部确定：给不完整的Phi补上操作数
+void IrBuilder::sealBlock(uint32_t block) {
+    std::unordered_map<uint32_t, uint32_t> phis = std::move(incompletePhis_[block]);
+    incompletePhis_[block].clear();
+    for (const auto& [variable, phi] : phis) {
+        addPhiOperands(variable, phi);
+    }
+    sealed_[block] = true;
+}
+
+// 不可达的块以ret结束，不给目标增加前驱，目标因此也不可达，也不会为它们的值生成Phi
+void IrBuilder::jump(uint32_t target) {
+    if (unreachable()) {
+        emit(IrOp::Return, IrType::Void);
+        return;
+    }
+    emit(IrOp::Jump, IrType::Void);
+    function_->addEdge(current_, target);
+}
+
+void IrBuilder::branch(uint32_t condition, uint32_t whenTrue, uint32_t whenFalse) {
+    if (unreachable()) {
+        emit(IrOp::Return, IrType::Void);
+        return;
+    }
+    emit(IrOp::Branch, IrType::Void, { condition });
+    function_->addEdge(current_, whenTrue);
+    function_->addEdge(current_, whenFalse);
+}
+
+void IrBuilder::startBlock(uint32_t block) {
+    current_ = block;
+}
+
+// return、break、continue之后的语句放在没有前驱的块里，仍然检查错误，由SimplifyCFG删除
+void IrBuilder::startUnreachable() {
+    uint32_t block = newBlock();
+    sealBlock(block);
+    startBlock(block);
+}
+
+// 除入口外没有前驱的块；循环头开始构造时已经有了来自循环前的边，之后只会增加回边
+bool IrBuilder::unreachable() const {
+    return current_ != 0 && function_->blocks[current_].predecessors.empty();
+}
+
+bool IrBuilder::terminated() const {
+    uint32_t last = function_->terminator(current_);
+    return last != none && (irOpFlags(function_->values[last].op) & IrTerminator) != 0;
+}
+
+void IrBuilder::writeVariable(uint32_t variable, uint32_t block, uint32_t value) {
+    definitions_[block][variable] = value;
+}
+
+uint32_t IrBuilder::readVariable(uint32_t variable, uint32_t block) {
+    auto definition = definitions_[block].find(variable);
+    if (definition != definitions_[block].end()) {
+        return resolve(definition->second);
+    }
+    return readVariableRecursive(variable, block);
+}
+
+uint32_t IrBuilder::readVariableRecursive(uint32_t variable, uint32_t block) {
+    IrType type = variableType(variable);
+    const std::vector<uint32_t>& predecessors = function_->blocks[block].predecessors;
+    uint32_t value;
+    if (!sealed_[block]) {
+        value = newPhi(block, type);
+        incompletePhis_[block][variable] = value;
+    }
+    else if (predecessors.empty()) {
+        // 入口或不可达的块
+        value = undefined(type);
+    }
+    else if (predecessors.size() == 1) {
+        value = readVariable(variable, predecessors[0]);
+    }
+    else {
+        // 先记下Phi再读前驱，打断经过循环的递归
+        value = newPhi(block, type);
+        writeVariable(variable, block, value);
+        value = addPhiOperands(variable, value);
+    }
+    writeVariable(variable, block, value);
+    return value;
+}
+
+uint32_t IrBuilder::addPhiOperands(uint32_t variable, uint32_t phi) {
+    uint32_t block = function_->values[phi].block;
+    for (size_t i = 0; i < function_->blocks[block].predecessors.size(); i++) {
+        uint32_t operand = readVariable(variable, function_->blocks[block].predecessors[i]);
+        function_->values[phi].operands.push_back(operand);
+    }
+    return tryRemoveTrivialPhi(phi);
+}
+
+// 除自身以外只有一个不同操作数的Phi可以用这个操作数代替
+uint32_t IrBuilder::tryRemoveTrivialPhi(uint32_t phi) {
+    uint32_t same = none;
+    for (uint32_t operand : function_->values[phi].operands) {
+        operand = resolve(operand);
+        if (operand == same || operand == phi) {
+            continue;
+        }
+        if (same != none) {
+            return phi;
+        }
+        same = operand;
+    }
+    if (same == none) {
+        same = undefined(function_->values[phi].type);
+    }
+    function_->values[phi].removed = true;
+    while (replacement_.size() < function_->values.size()) {
+        replacement_.push_back(static_cast<uint32_t>(replacement_.size()));
+    }
+    replacement_[phi] = same;
+    return same;
+}
+
+// Phi放在块的开头
+uint32_t IrBuilder::newPhi(uint32_t block, IrType type) {
+    uint32_t phi = function_->append(block, IrOp::Phi, type);
+    std::vector<uint32_t>& instructions = function_->blocks[block].instructions;
+    instructions.pop_back();
+    instructions.insert(instructions.begin(), phi);
+    return phi;
+}
+
+// 没有定义就读到的变量取零值，常量放在入口块的开头，支配所有使用
+uint32_t IrBuilder::undefined(IrType type) {
+    uint32_t constant = function_->append(0, IrOp::Const, type);
+    std::vector<uint32_t>& instructions = function_->blocks[0].instructions;
+    instructions.pop_back();
+    instructions.insert(instructions.begin(), constant);
+    return constant;
+}
+
+// 在当前块汇合各前驱带来的值；前驱可能因为条件是常量而不可达，按实际的前驱构造Phi
+uint32_t IrBuilder::join(IrType type, const std::vector<std::pair<uint32_t, uint32_t>>& incoming) {
+    const std::vector<uint32_t>& predecessors = function_->blocks[current_].predecessors;
+    std::vector<uint32_t> operands;
+    for (uint32_t predecessor : predecessors) {
+        for (const auto& [block, value] : incoming) {
+            if (block == predecessor) {
+                operands.push_back(value);
+                break;
+            }
+        }
+    }
+    if (operands.empty()) {
+        return undefined(type);
+    }
+    if (operands.size() == 1) {
+        return operands[0];
+    }
+    uint32_t phi = newPhi(current_, type);
+    function_->values[phi].operands = std::move(operands);
+    return phi;
+}
+
+// 被删除的Phi追到最终代替它的值
+uint32_t IrBuilder::resolve(uint32_t value) {
+    while (value < replacement_.size() && function_->values[value].removed && replacement_[value] != value) {
+        value = replacement_[value];
+    }
+    return value;
+}
+
+IrType IrBuilder::variableType(uint32_t variable) const {
+    const Symbol& symbol = resolver_->symbols()[variable];
+    return symbol.kind == SymbolKind::Array ? IrType::Array : irTypeOf(typeOf(symbol.type));
+}
+
+const Symbol& IrBuilder::symbolOf(const ASTNode* use) const {
+    const Symbol* symbol = resolver_->bindingOf(use);
+    if (symbol == nullptr) {
+        throw RuntimeError("undeclared identifier '" + use->value + "'");
+    }
+    return *symbol;
+}
+
+uint32_t IrBuilder::variableOf(const Symbol& symbol) const {
+    return static_cast<uint32_t>(&symbol - resolver_->symbols().data());
+}
+
+ValueType IrBuilder::typeOf(const ASTNode* typeSpecifier) const {
+    ValueType type;
+    if (typeSpecifier == nullptr || !valueTypeFromName(typeSpecifier->value, type)) {
+        throw RuntimeError("unsupported type '" + (typeSpecifier == nullptr ? std::string() : typeSpecifier->value) + "'");
+    }
+    return type;
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "ast.hpp"
+#include "ir.hpp"
+#include "nameResolver.hpp"
+#include "parallelPasses.hpp"
+#include "typeChecker.hpp"
+#include "runtimeValue.hpp"
+
+// 把AST翻译成SSA形式的IR
+// 局部标量和局部数组是SSA变量（按符号编号），读写时直接按Braun等人的算法构造Phi：
+// 每个基本块记录变量的当前定义，前驱还不完整的块（循环头、continue目标）先放不完整的Phi，
+// 所有前驱确定之后再补操作数；只有一个不同操作数的Phi会被替换掉。
+// 全局变量通过LoadGlobal/StoreGlobal访问。表达式的类型取自TypeChecker，类型规则、转换和报错与BytecodeCompiler一致
+class IrBuilder {
+public:
+    IrBuilder();
+
+    IrBuilder(const IrBuilder&) = delete;
+    IrBuilder& operator=(const IrBuilder&) = delete;
+
+    // 程序使用了不支持的结构或类型不匹配时抛出RuntimeError
+    IrModule build(const ASTNode* root);
+    // 名字解析、类型检查和函数签名在调用线程上完成，然后每个函数定义作为一个任务构造，
+    // 每个工作线程有自己的IrBuilder；全局变量的初始化函数在所有函数之后构造
+    IrModule build(const ASTNode* root, ParallelPassManager& passes);
+
+private:
+    // type只会是Int、Float或Double（char和bool已经提升为int）
+    struct Value {
+        uint32_t id;
+        ValueType type;
+    };
+
+    struct Place {
+        enum class Kind : uint8_t { Local, Global, Element } kind;
+        uint32_t variable;   // 局部变量的符号编号，或全局变量的槽位
+        uint32_t array;
+        uint32_t index;
+        ValueType type;      // 存储类型
+    };
+
+    struct Loop {
+        uint32_t breakBlock;
+        uint32_t continueBlock;
+        size_t arrayBlocks;  // 进入循环时arrayMarks_的大小
+    };
+
+    struct Signature {
+        ValueType returnType;
+        std::vector<ValueType> parameters;
+        bool defined;
+    };
+
+    const NameResolver* resolver_;
+    const TypeChecker* checker_;
+    IrModule* module_;                      // 正在构造的模块，各工作线程的IrBuilder共用，只写自己的函数
+    std::vector<Signature> signatures_;     // 按函数符号的槽位编号
+
+    // 当前函数的构造状态
+    IrFunction* function_;
+    ValueType returnType_;
+    uint32_t current_;                      // 正在追加指令的基本块
+    std::vector<Loop> loops_;
+    std::vector<uint32_t> arrayMarks_;      // 声明了数组的块保存的数组栈顶
+    std::vector<std::unordered_map<uint32_t, uint32_t>> definitions_;     // 按块：变量 -> 当前定义
+    std::vector<std::unordered_map<uint32_t, uint32_t>> incompletePhis_;  // 按块：变量 -> 待补操作数的Phi
+    std::vector<bool> sealed_;              // 块的前驱是否已经全部确定
+    std::vector<uint32_t> replacement_;     // 被删除的平凡Phi -> 代替它的值
+
+    void buildFunction(const ASTNode* node);
+    void beginFunction(IrFunction& function, ValueType returnType);
+    void endFunction();
+    void buildStatement(const ASTNode* node, bool functionBody = false);
+    void buildDeclaration(const ASTNode* node, bool global);
+    void buildLoopExit(bool isBreak);
+    void buildBranch(const ASTNode* node, uint32_t whenTrue, uint32_t whenFalse);
+
+    Value buildExpression(const ASTNode* node);
+    Value buildBinary(const ASTNode* node, const std::string& op, const ASTNode* left, const ASTNode* right);
+    Value buildLogical(const ASTNode* node);
+    Value buildConditional(const ASTNode* node);
+    Value buildAssignment(const ASTNode* node);
+    Value buildIncrement(const ASTNode* operand, int32_t delta, bool postfix);
+    Value buildUnary(const ASTNode* node);
+    Value buildCall(const ASTNode* node);
+    Value buildSizeof(const ASTNode* node);
+
+    Place buildPlace(const ASTNode* node);
+    Value load(const Place& place);
+    void store(const Place& place, uint32_t value);
+    Value emitBinary(BinaryOp op, Value left, Value right);
+    uint32_t emitConvert(Value source, ValueType type);
+    uint32_t emitConstant(const RuntimeValue& value);
+    uint32_t emit(IrOp op, IrType type, std::vector<uint32_t> operands = {}, uint32_t immediate = 0);
+
+    // 基本块和SSA构造
+    uint32_t newBlock();
+    void sealBlock(uint32_t block);
+    void jump(uint32_t target);
+    void branch(uint32_t condition, uint32_t whenTrue, uint32_t whenFalse);
+    void startBlock(uint32_t block);
+    void startUnreachable();
+    bool unreachable() const;
+    bool terminated() const;
+    void writeVariable(uint32_t variable, uint32_t block, uint32_t value);
+    uint32_t readVariable(uint32_t variable, uint32_t block);
+    uint32_t readVariableRecursive(uint32_t variable, uint32_t block);
+    uint32_t addPhiOperands(uint32_t variable, uint32_t phi);
+    uint32_t tryRemoveTrivialPhi(uint32_t phi);
+    uint32_t newPhi(uint32_t block, IrType type);
+    uint32_t undefined(IrType type);
+    uint32_t join(IrType type, const std::vector<std::pair<uint32_t, uint32_t>>& incoming);
+    uint32_t resolve(uint32_t value);
+    IrType variableType(uint32_t variable) const;
+
+    const Symbol& symbolOf(const ASTNode* use) const;
+    uint32_t variableOf(const Symbol& symbol) const;
+    ValueType typeOf(const ASTNode* typeSpecifier) const;
+};
+
+// 值类型到IR类型：float和double都是Double，其余标量是Int
+IrType irTypeOf(ValueType type);
@@ -0,0 +1,731 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <unordered_map>
+#include "irPasses.hpp"
+
+namespace {
+    constexpr uint32_t none = UINT32_MAX;
+
+    std::vector<uint32_t> identityReplacement(const IrFunction& function) {
+        std::vector<uint32_t> replacement(function.values.size());
+        for (uint32_t value = 0; value < replacement.size(); value++) {
+            replacement[value] = value;
+        }
+        return replacement;
+    }
+
+    bool live(const IrFunction& function, uint32_t value) {
+        const IrInstruction& instruction = function.values[value];
+        return !instruction.removed && !function.blocks[instruction.block].removed;
+    }
+
+    void removeBlock(IrFunction& function, uint32_t block) {
+        std::vector<uint32_t> successors = function.blocks[block].successors;
+        for (uint32_t successor : successors) {
+            function.removeEdge(block, successor);
+        }
+        for (uint32_t value : function.blocks[block].instructions) {
+            function.values[value].removed = true;
+        }
+        function.blocks[block].removed = true;
+    }
+
+    // 把分支改成转到第taken个后继的jump
+    void foldBranch(IrFunction& function, uint32_t block, size_t taken) {
+        IrInstruction& branch = function.values[function.terminator(block)];
+        branch.op = IrOp::Jump;
+        branch.operands.clear();
+        // removeEdge删除第一条到目标的边，两个后继相同时留下的也是同一个块
+        function.removeEdge(block, function.blocks[block].successors[1 - taken]);
+    }
+
+    bool hasPhis(const IrFunction& function, uint32_t block) {
+        for (uint32_t value : function.blocks[block].instructions) {
+            const IrInstruction& instruction = function.values[value];
+            if (instruction.op != IrOp::Phi) {
+                return false;
+            }
+            if (!instruction.removed) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void replaceAll(std::vector<uint32_t>& list, uint32_t from, uint32_t to) {
+        std::replace(list.begin(), list.end(), from, to);
+    }
+
+    RuntimeValue constantOf(const IrInstruction& instruction) {
+        return instruction.type == IrType::Double ? RuntimeValue::ofDouble(instruction.doubleValue) : RuntimeValue::ofInt(instruction.intValue);
+    }
+
+    void makeConstant(IrInstruction& instruction, const RuntimeValue& value) {
+        instruction.op = IrOp::Const;
+        instruction.operands.clear();
+        instruction.immediate = 0;
+        instruction.intValue = 0;
+        instruction.doubleValue = 0.0;
+        if (value.type == ValueType::Double) {
+            instruction.doubleValue = value.doubleValue;
+        }
+        else {
+            instruction.intValue = value.intValue;
+        }
+    }
+
+    // 稀疏条件常量传播的格：Unknown（还没有算出来）> Constant > Overdefined
+    struct Lattice {
+        enum class State : uint8_t { Unknown, Constant, Overdefined } state = State::Unknown;
+        RuntimeValue value = RuntimeValue::ofInt(0);
+
+        bool operator==(const Lattice& other) const {
+            if (state != other.state) {
+                return false;
+            }
+            // double按位比较，NaN也是同一个常量
+            return state != State::Constant || (value.type == other.value.type &&
+                (value.type == ValueType::Double ? std::memcmp(&value.doubleValue, &other.value.doubleValue, sizeof(double)) == 0
+                    : value.intValue == other.value.intValue));
+        }
+    };
+
+    Lattice meet(const Lattice& a, const Lattice& b) {
+        if (a.state == Lattice::State::Unknown) {
+            return b;
+        }
+        if (b.state == Lattice::State::Unknown || a == b) {
+            return a;
+        }
+        return { Lattice::State::Overdefined };
+    }
+
+    // 值编号的键：操作码、类型、立即数、常量和（规范化之后的）操作数
+    struct ValueKey {
+        IrOp op;
+        IrType type;
+        uint32_t immediate;
+        uint64_t bits;
+        std::vector<uint32_t> operands;
+
+        bool operator==(const ValueKey& other) const {
+            return op == other.op && type == other.type && immediate == other.immediate &&
+                bits == other.bits && operands == other.operands;
+        }
+    };
+
+    struct ValueKeyHash {
+        size_t operator()(const ValueKey& key) const {
+            uint64_t hash = (static_cast<uint64_t>(key.op) << 8 | static_cast<uint64_t>(key.type)) * 0x9E3779B97F4A7C15ull;
+            hash ^= (key.immediate + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2));
+            hash ^= (key.bits + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2));
+            for (uint32_t operand : key.operands) {
+                hash ^= (operand + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2));
+            }
+            return static_cast<size_t>(hash);
+        }
+    };
+}
+
+bool foldIrOperation(IrOp op, const std::vector<RuntimeValue>& operands, RuntimeValue& result) {
+    static const BinaryOp binaryOps[] = {
+        BinaryOp::Add, BinaryOp::Sub, BinaryOp::Mul, BinaryOp::Div, BinaryOp::Mod, BinaryOp::Shl, BinaryOp::Shr,
+        BinaryOp::BitAnd, BinaryOp::BitOr, BinaryOp::BitXor, BinaryOp::Less, BinaryOp::LessEqual, BinaryOp::Equal, BinaryOp::NotEqual
+    };
+    try {
+        if (op >= IrOp::Add && op <= IrOp::Ne) {
+            if (operands.size() != 2) {
+                return false;
+            }
+            result = applyBinary(binaryOps[static_cast<size_t>(op) - static_cast<size_t>(IrOp::Add)], operands[0], operands[1]);
+            return true;
+        }
+        if (operands.size() != 1) {
+            return false;
+        }
+        const RuntimeValue& operand = operands[0];
+        bool floating = operand.type == ValueType::Double;
+        switch (op) {
+        case IrOp::Neg:
+            result = floating ? RuntimeValue::ofDouble(-operand.doubleValue)
+                : RuntimeValue::ofInt(static_cast<int32_t>(0u - static_cast<uint32_t>(operand.intValue)));
+            return true;
+        case IrOp::Not:
+            result = RuntimeValue::ofInt(isTruthy(operand) ? 0 : 1);
+            return true;
+        case IrOp::ToBool:
+            result = RuntimeValue::ofInt(isTruthy(operand) ? 1 : 0);
+            return true;
+        case IrOp::BitNot:
+            result = RuntimeValue::ofInt(~operand.intValue);
+            return !floating;
+        case IrOp::IntToDouble:
+            result = RuntimeValue::ofDouble(operand.intValue);
+            return !floating;
+        case IrOp::DoubleToInt:
+            result = RuntimeValue::ofInt(doubleToInt(operand.doubleValue));
+            return floating;
+        case IrOp::RoundFloat:
+            result = RuntimeValue::ofDouble(static_cast<float>(operand.doubleValue));
+            return floating;
+        case IrOp::TruncChar:
+            result = RuntimeValue::ofInt(static_cast<int8_t>(static_cast<uint8_t>(operand.intValue)));
+            return !floating;
+        default:
+            return false;
+        }
+    }
+    catch (const RuntimeError&) {
+        // 运行时才报错，不能在编译期折叠
+        return false;
+    }
+}
+
+bool simplifyCfg(IrFunction& function) {
+    bool changed = false;
+    bool progress = true;
+    while (progress) {
+        progress = false;
+        // 条件是常量或两个后继相同的分支改成jump
+        for (uint32_t block = 0; block < function.blocks.size(); block++) {
+            if (function.blocks[block].removed || function.values[function.terminator(block)].op != IrOp::Branch) {
+                continue;
+            }
+            const std::vector<uint32_t>& successors = function.blocks[block].successors;
+            const IrInstruction& condition = function.values[function.values[function.terminator(block)].operands[0]];
+            if (successors[0] == successors[1]) {
+                foldBranch(function, block, 0);
+                progress = true;
+            }
+            else if (condition.op == IrOp::Const) {
+                foldBranch(function, block, condition.intValue != 0 ? 0 : 1);
+                progress = true;
+            }
+        }
+
+        // 不可达的块
+        std::vector<bool> reachable(function.blocks.size(), false);
+        for (uint32_t block : function.reversePostorder()) {
+            reachable[block] = true;
+        }
+        for (uint32_t block = 0; block < function.blocks.size(); block++) {
+            if (!function.blocks[block].removed && !reachable[block]) {
+                removeBlock(function, block);
+                progress = true;
+            }
+        }
+
+        // 只有一个前驱，或者除自身以外所有操作数都相同的Phi
+        std::vector<uint32_t> replacement = identityReplacement(function);
+        auto resolve = [&](uint32_t value) {
+            while (replacement[value] != value) {
+                value = replacement[value];
+            }
+            return value;
+        };
+        for (uint32_t block = 0; block < function.blocks.size(); block++) {
+            if (function.blocks[block].removed) {
+                continue;
+            }
+            for (uint32_t value : function.blocks[block].instructions) {
+                IrInstruction& phi = function.values[value];
+                if (phi.op != IrOp::Phi) {
+                    break;
+                }
+                if (phi.removed) {
+                    continue;
+                }
+                uint32_t same = none;
+                bool trivial = true;
+                for (uint32_t operand : phi.operands) {
+                    operand = resolve(operand);
+                    if (operand == value || operand == same) {
+                        continue;
+                    }
+                    trivial = trivial && same == none;
+                    same = operand;
+                }
+                if (trivial && same != none) {
+                    replacement[value] = same;
+                    phi.removed = true;
+                    progress = true;
+                }
+            }
+        }
+
+        // 块只有一个后继、后继只有这一个前驱时合并成一个块
+        for (uint32_t block = 0; block < function.blocks.size(); block++) {
+            while (!function.blocks[block].removed && function.values[function.terminator(block)].op == IrOp::Jump) {
+                uint32_t successor = function.blocks[block].successors[0];
+                IrBlock& next = function.blocks[successor];
+                if (successor == block || successor == 0 || next.predecessors.size() != 1) {
+                    break;
+                }
+                for (uint32_t value : next.instructions) {
+                    IrInstruction& phi = function.values[value];
+                    if (phi.op == IrOp::Phi && !phi.removed) {
+                        replacement[value] = phi.operands[0];
+                        phi.removed = true;
+                    }
+                }
+                IrBlock& current = function.blocks[block];
+                function.values[current.instructions.back()].removed = true;
+                current.instructions.pop_back();
+                for (uint32_t value : next.instructions) {
+                    if (!function.values[value].removed) {
+                        function.values[value].block = block;
+                        current.instructions.push_back(value);
+                    }
+                }
+                current.successors = std::move(next.successors);
+                for (uint32_t target : current.successors) {
+                    replaceAll(function.blocks[target].predecessors, successor, block);
+                }
+                next = IrBlock();
+                next.removed = true;
+                progress = true;
+            }
+        }
+
+        // 只有一条jump的块：前驱直接转到它的后继
+        for (uint32_t block = 1; block < function.blocks.size(); block++) {
+            IrBlock& empty = function.blocks[block];
+            if (empty.removed || empty.instructions.size() != 1 || empty.predecessors.empty() ||
+                function.values[empty.instructions[0]].op != IrOp::Jump) {
+                continue;
+            }
+            uint32_t successor = empty.successors[0];
+            if (successor == block || successor == 0) {
+                continue;
+            }
+            IrBlock& target = function.blocks[successor];
+            bool phis = hasPhis(function, successor);
+            if (phis) {
+                // 前驱已经是后继的前驱时，Phi在这条边上会有两个不同的值
+                bool conflict = false;
+                for (uint32_t predecessor : empty.predecessors) {
+                    conflict = conflict || std::find(target.predecessors.begin(), target.predecessors.end(), predecessor) != target.predecessors.end();
+                }
+                if (conflict) {
+                    continue;
+                }
+            }
+            size_t index = static_cast<size_t>(std::find(target.predecessors.begin(), target.predecessors.end(), block) - target.predecessors.begin());
+            target.predecessors.erase(target.predecessors.begin() + static_cast<std::ptrdiff_t>(index));
+            for (uint32_t predecessor : empty.predecessors) {
+                target.predecessors.push_back(predecessor);
+            }
+            for (uint32_t value : target.instructions) {
+                IrInstruction& phi = function.values[value];
+                if (phi.op != IrOp::Phi) {
+                    break;
+                }
+                if (phi.removed) {
+                    continue;
+                }
+                uint32_t incoming = phi.operands[index];
+                phi.operands.erase(phi.operands.begin() + static_cast<std::ptrdiff_t>(index));
+                phi.operands.insert(phi.operands.end(), empty.predecessors.size(), incoming);
+            }
+            std::vector<uint32_t> predecessors = empty.predecessors;
+            std::sort(predecessors.begin(), predecessors.end());
+            predecessors.erase(std::unique(predecessors.begin(), predecessors.end()), predecessors.end());
+            for (uint32_t predecessor : predecessors) {
+                replaceAll(function.blocks[predecessor].successors, block, successor);
+            }
+            function.values[empty.instructions[0]].removed = true;
+            empty = IrBlock();
+            empty.removed = true;
+            progress = true;
+        }
+
+        function.replaceUses(replacement);
+        changed = changed || progress;
+    }
+    return changed;
+}
+
+bool sparseConditionalConstantPropagation(IrFunction& function) {
+    using State = Lattice::State;
+    size_t count = function.values.size();
+    std::vector<Lattice> lattice(count);
+    std::vector<std::vector<uint32_t>> users(count);
+    for (uint32_t value = 0; value < count; value++) {
+        if (live(function, value)) {
+            for (uint32_t operand : function.values[value].operands) {
+                users[operand].push_back(value);
+            }
+        }
+    }
+    std::vector<bool> executableBlock(function.blocks.size(), false);
+    std::vector<std::vector<bool>> executableEdge(function.blocks.size());
+    for (uint32_t block = 0; block < function.blocks.size(); block++) {
+        executableEdge[block].assign(function.blocks[block].successors.size(), false);
+    }
+    std::vector<std::pair<uint32_t, size_t>> edgeWork;
+    std::vector<uint32_t> valueWork;
+
+    auto markEdge = [&](uint32_t block, size_t index) {
+        if (!executableEdge[block][index]) {
+            executableEdge[block][index] = true;
+            edgeWork.push_back({ block, index });
+        }
+    };
+    auto edgeExecutable = [&](uint32_t from, uint32_t to) {
+        const std::vector<uint32_t>& successors = function.blocks[from].successors;
+        for (size_t i = 0; i < successors.size(); i++) {
+            if (successors[i] == to && executableEdge[from][i]) {
+                return true;
+            }
+        }
+        return false;
+    };
+    auto update = [&](uint32_t value, const Lattice& result) {
+        if (!(lattice[value] == result)) {
+            lattice[value] = result;
+            valueWork.insert(valueWork.end(), users[value].begin(), users[value].end());
+        }
+    };
+    auto visit = [&](uint32_t value) {
+        const IrInstruction& instruction = function.values[value];
+        if (instruction.removed) {
+            return;
+        }
+        uint32_t block = instruction.block;
+        uint8_t flags = irOpFlags(instruction.op);
+        switch (instruction.op) {
+        case IrOp::Const:
+            update(value, { State::Constant, constantOf(instruction) });
+            return;
+        case IrOp::Phi: {
+            Lattice result;
+            const std::vector<uint32_t>& predecessors = function.blocks[block].predecessors;
+            for (size_t i = 0; i < instruction.operands.size(); i++) {
+                if (edgeExecutable(predecessors[i], block)) {
+                    result = meet(result, lattice[instruction.operands[i]]);
+                }
+            }
+            update(value, result);
+            return;
+        }
+        case IrOp::Jump:
+            markEdge(block, 0);
+            return;
+        case IrOp::Branch: {
+            const Lattice& condition = lattice[instruction.operands[0]];
+            if (condition.state == State::Constant) {
+                markEdge(block, isTruthy(condition.value) ? 0 : 1);
+            }
+            else if (condition.state == State::Overdefined) {
+                markEdge(block, 0);
+                markEdge(block, 1);
+            }
+            return;
+        }
+        default:
+            break;
+        }
+        if (instruction.type == IrType::Void) {
+            return;
+        }
+        if (instruction.op == IrOp::Param || (flags & (IrRead | IrEffect)) != 0) {
+            update(value, { State::Overdefined });
+            return;
+        }
+        std::vector<RuntimeValue> operands;
+        for (uint32_t operand : instruction.operands) {
+            const Lattice& input = lattice[operand];
+            if (input.state == State::Overdefined) {
+                update(value, { State::Overdefined });
+                return;
+            }
+            if (input.state == State::Unknown) {
+                return;
+            }
+            operands.push_back(input.value);
+        }
+        RuntimeValue result;
+        if (foldIrOperation(instruction.op, operands, result)) {
+            update(value, { State::Constant, result });
+        }
+        else {
+            update(value, { State::Overdefined });
+        }
+    };
+
+    executableBlock[0] = true;
+    for (uint32_t value : function.blocks[0].instructions) {
+        visit(value);
+    }
+    while (!edgeWork.empty() || !valueWork.empty()) {
+        while (!edgeWork.empty()) {
+            auto [from, index] = edgeWork.back();
+            edgeWork.pop_back();
+            uint32_t block = function.blocks[from].successors[index];
+            if (!executableBlock[block]) {
+                // 第一次到达的块：所有指令都要计算
+                executableBlock[block] = true;
+                for (uint32_t value : function.blocks[block].instructions) {
+                    visit(value);
+                }
+            }
+            else {
+                // 新的可执行边只影响Phi
+                for (uint32_t value : function.blocks[block].instructions) {
+                    if (function.values[value].op != IrOp::Phi) {
+                        break;
+                    }
+                    visit(value);
+                }
+            }
+        }
+        while (!valueWork.empty() && edgeWork.empty()) {
+            uint32_t value = valueWork.back();
+            valueWork.pop_back();
+            if (executableBlock[function.values[value].block]) {
+                visit(value);
+            }
+        }
+    }
+
+    // 改写：常量值就地变成Const（Phi另建常量放在Phi之后），常量条件的分支变成jump
+    bool changed = false;
+    std::vector<uint32_t> replacement = identityReplacement(function);
+    for (uint32_t block = 0; block < function.blocks.size(); block++) {
+        if (function.blocks[block].removed || !executableBlock[block]) {
+            continue;
+        }
+        size_t firstNonPhi = 0;
+        while (function.values[function.blocks[block].instructions[firstNonPhi]].op == IrOp::Phi) {
+            firstNonPhi++;
+        }
+        for (size_t i = 0; i < function.blocks[block].instructions.size(); i++) {
+            uint32_t value = function.blocks[block].instructions[i];
+            if (function.values[value].removed || function.values[value].op == IrOp::Const ||
+                lattice[value].state != State::Constant) {
+                continue;
+            }
+            if (function.values[value].op == IrOp::Phi) {
+                uint32_t constant = function.append(block, IrOp::Const, function.values[value].type);
+                std::vector<uint32_t>& instructions = function.blocks[block].instructions;
+                instructions.pop_back();
+                instructions.insert(instructions.begin() + static_cast<std::ptrdiff_t>(firstNonPhi), constant);
+                makeConstant(function.values[constant], lattice[value].value);
+                replacement.push_back(constant);
+                replacement[value] = constant;
+                function.values[value].removed = true;
+            }
+            else {
+                makeConstant(function.values[value], lattice[value].value);
+            }
+            changed = true;
+        }
+        IrInstruction& terminator = function.values[function.terminator(block)];
+        if (terminator.op == IrOp::Branch && lattice[terminator.operands[0]].state == State::Constant) {
+            foldBranch(function, block, isTruthy(lattice[terminator.operands[0]].value) ? 0 : 1);
+            changed = true;
+        }
+    }
+    function.replaceUses(replacement);
+    return changed;
+}
+
+bool globalValueNumbering(IrFunction& function) {
+    std::vector<uint32_t> order = function.reversePostorder();
+    std::vector<uint32_t> idom = function.dominators(order);
+    std::vector<std::vector<uint32_t>> children(function.blocks.size());
+    for (size_t i = 1; i < order.size(); i++) {
+        children[idom[order[i]]].push_back(order[i]);
+    }
+    std::vector<uint32_t> replacement = identityReplacement(function);
+    std::unordered_map<ValueKey, uint32_t, ValueKeyHash> table;
+    // 每个块加入表中的键，离开它在支配树中的子树时删除
+    std::vector<std::vector<ValueKey>> scopes(function.blocks.size());
+    bool changed = false;
+
+    // 显式栈上的先序遍历：第二次遇到块时退出它的作用域
+    std::vector<std::pair<uint32_t, bool>> stack;
+    if (!order.empty()) {
+        stack.push_back({ order[0], false });
+    }
+    while (!stack.empty()) {
+        auto [block, leaving] = stack.back();
+        stack.pop_back();
+        if (leaving) {
+            for (const ValueKey& key : scopes[block]) {
+                table.erase(key);
+            }
+            scopes[block].clear();
+            continue;
+        }
+        for (uint32_t value : function.blocks[block].instructions) {
+            IrInstruction& instruction = function.values[value];
+            uint8_t flags = irOpFlags(instruction.op);
+            if (instruction.removed || (flags & (IrPure | IrTrap)) == 0 || (flags & (IrRead | IrEffect)) != 0 ||
+                instruction.op == IrOp::Param) {
+                continue;
+            }
+            ValueKey key{ instruction.op, instruction.type, instruction.immediate, 0, instruction.operands };
+            for (uint32_t& operand : key.operands) {
+                while (replacement[operand] != operand) {
+                    operand = replacement[operand];
+                }
+            }
+            if (instruction.op == IrOp::Const) {
+                if (instruction.type == IrType::Double) {
+                    std::memcpy(&key.bits, &instruction.doubleValue, sizeof(double));
+                }
+                else {
+                    key.bits = static_cast<uint32_t>(instruction.intValue);
+                }
+            }
+            else if (instruction.op == IrOp::Phi) {
+                // 不同块中操作数相同的Phi不一定相等
+                key.immediate = block;
+            }
+            else if ((flags & IrCommutative) != 0 && key.operands.size() == 2 && key.operands[0] > key.operands[1]) {
+                std::swap(key.operands[0], key.operands[1]);
+            }
+            auto found = table.find(key);
+            if (found != table.end()) {
+                replacement[value] = found->second;
+                instruction.removed = true;
+                changed = true;
+            }
+            else {
+                table.emplace(key, value);
+                scopes[block].push_back(std::move(key));
+            }
+        }
+        stack.push_back({ block, true });
+        for (uint32_t child : children[block]) {
+            stack.push_back({ child, false });
+        }
+    }
+    function.replaceUses(replacement);
+    return changed;
+}
+
+bool deadCodeElimination(IrFunction& function) {
+    std::vector<bool> used(function.values.size(), false);
+    std::vector<uint32_t> work;
+    for (uint32_t value = 0; value < function.values.size(); value++) {
+        if (live(function, value) && (irOpFlags(function.values[value].op) & (IrTrap | IrEffect | IrTerminator)) != 0) {
+            used[value] = true;
+            work.push_back(value);
+        }
+    }
+    while (!work.empty()) {
+        uint32_t value = work.back();
+        work.pop_back();
+        for (uint32_t operand : function.values[value].operands) {
+            if (!used[operand]) {
+                used[operand] = true;
+                work.push_back(operand);
+            }
+        }
+    }
+    bool changed = false;
+    for (uint32_t value = 0; value < function.values.size(); value++) {
+        if (!used[value] && live(function, value)) {
+            function.values[value].removed = true;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+void IrPassManager::add(const IrPass& pass) {
+    passes_.push_back(pass);
+    auto existing = std::find_if(statistics_.begin(), statistics_.end(), [&](const IrPassStatistics& entry) {
+        return entry.name == pass.name;
+    });
+    if (existing == statistics_.end()) {
+        statistics_.push_back({ pass.name });
+    }
+}
+
+void IrPassManager::addDefaultPipeline() {
+    add({ "simplifycfg", simplifyCfg });
+    add({ "sccp", sparseConditionalConstantPropagation });
+    add({ "simplifycfg", simplifyCfg });
+    add({ "gvn", globalValueNumbering });
+    add({ "dce", deadCodeElimination });
+    add({ "simplifycfg", simplifyCfg });
+}
+
+void IrPassManager::run(IrModule& module) {
+    for (IrFunction& function : module.functions) {
+        run(function);
+    }
+}
+
+void IrPassManager::run(IrModule& module, ParallelPassManager& passes) {
+    std::vector<IrPassManager> workers(passes.jobs(), *this);
+    for (IrPassManager& worker : workers) {
+        for (IrPassStatistics& entry : worker.statistics_) {
+            entry = { entry.name };
+        }
+    }
+    passes.run(module.functions.size(), [&](size_t index, size_t worker) {
+        workers[worker].run(module.functions[index]);
+    });
+    for (const IrPassManager& worker : workers) {
+        for (size_t i = 0; i < statistics_.size(); i++) {
+            const IrPassStatistics& entry = worker.statistics_[i];
+            statistics_[i].runs += entry.runs;
+            statistics_[i].changes += entry.changes;
+            statistics_[i].removed += entry.removed;
+            statistics_[i].milliseconds += entry.milliseconds;
+        }
+    }
+}
+
+void IrPassManager::run(IrFunction& function) {
+    for (size_t round = 0; round < maxRounds; round++) {
+        bool changed = false;
+        for (const IrPass& pass : passes_) {
+            IrPassStatistics& entry = *std::find_if(statistics_.begin(), statistics_.end(), [&](const IrPassStatistics& statistics) {
+                return statistics.name == pass.name;
+            });
+            size_t before = function.instructionCount();
+            auto start = std::chrono::steady_clock::now();
+            bool modified = pass.run(function);
+            if (modified) {
+                function.compact();
+            }
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            size_t after = function.instructionCount();
+            entry.runs++;
+            entry.changes += modified ? 1 : 0;
+            entry.removed += before > after ? before - after : 0;
+            entry.milliseconds += elapsed.count();
+            if (verifyEach_) {
+                std::string error;
+                if (!verifyIr(function, error)) {
+                    throw RuntimeError(std::string("IR verification failed after ") + pass.name + ": " + error);
+                }
+            }
+            changed = changed || modified;
+        }
+        if (!changed) {
+            break;
+        }
+    }
+}
+
+void IrPassManager::printTimes(std::ostream& os) const {
+    double total = 0.0;
+    os << "IR pass timing:\n";
+    os << std::left << std::setw(14) << "pass" << std::right << std::setw(8) << "runs" << std::setw(10) << "changed"
+        << std::setw(10) << "removed" << std::setw(12) << "ms" << "\n";
+    for (const IrPassStatistics& entry : statistics_) {
+        os << std::left << std::setw(14) << entry.name << std::right << std::setw(8) << entry.runs << std::setw(10) << entry.changes
+            << std::setw(10) << entry.removed << std::setw(12) << std::fixed << std::setprecision(3) << entry.milliseconds << "\n";
+        total += entry.milliseconds;
+    }
+    os << std::left << std::setw(42) << "total" << std::right << std::setw(12) << std::fixed << std::setprecision(3) << total << "\n";
+    os.unsetf(std::ios::floatfield);
+}
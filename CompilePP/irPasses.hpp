@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "ir.hpp"
+#include "parallelPasses.hpp"
+#include "runtimeValue.hpp"
+
+// IR上的优化；每个Pass返回是否修改了函数，只把删除的指令和块标记为removed，由IrPassManager统一compact
+struct IrPass {
+    const char* name;
+    bool (*run)(IrFunction& function);
+};
+
+// 删除不可达的块，折叠条件为常量或两个后继相同的分支，合并只有一条边相连的块，跳过只含jump的块，删除平凡的Phi
+bool simplifyCfg(IrFunction& function);
+// 稀疏条件常量传播（Wegman-Zadeck）：只沿可能执行的边传播常量，折叠常量和常量条件的分支
+bool sparseConditionalConstantPropagation(IrFunction& function);
+// 沿支配树的全局值编号：被支配的相同纯计算用支配它的那一条代替
+bool globalValueNumbering(IrFunction& function);
+// 从有副作用、可能出错的指令和终结指令出发标记用到的值，删除其余指令
+bool deadCodeElimination(IrFunction& function);
+
+// 在编译期计算op；操作数不全是常量或者运行时会出错（例如除数为零）时返回false
+bool foldIrOperation(IrOp op, const std::vector<RuntimeValue>& operands, RuntimeValue& result);
+
+struct IrPassStatistics {
+    std::string name;
+    size_t runs = 0;
+    size_t changes = 0;          // 修改了函数的次数
+    size_t removed = 0;          // 删除的指令数
+    double milliseconds = 0.0;
+};
+
+// 对模块中的每个函数按顺序运行Pass，整条流水线重复到没有修改为止（最多maxRounds轮）
+class IrPassManager {
+public:
+    static constexpr size_t maxRounds = 4;
+
+    void add(const IrPass& pass);
+    // simplifycfg、sccp、simplifycfg、gvn、dce、simplifycfg
+    void addDefaultPipeline();
+    // 每个Pass之后检查SSA形式，出错时抛出RuntimeError并指出是哪个Pass
+    void setVerifyEach(bool verify) {
+        verifyEach_ = verify;
+    }
+
+    void run(IrModule& module);
+    // 每个函数作为一个任务优化，每个工作线程用自己的一份统计，最后按Pass累加
+    void run(IrModule& module, ParallelPassManager& passes);
+    void run(IrFunction& function);
+
+    const std::vector<IrPassStatistics>& statistics() const {
+        return statistics_;
+    }
+    // 每个Pass的累计时间和修改次数
+    void printTimes(std::ostream& os) const;
+
+private:
+    std::vector<IrPass> passes_;
+    std::vector<IrPassStatistics> statistics_;
+    bool verifyEach_ = false;
+};
@@ -0,0 +1,754 @@
+#include <cstring>
+#include <initializer_list>
+#include <new>
+#include "jit.hpp"
+
+#ifdef JIT_SUPPORTED
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+    enum Reg {
+        RAX = 0, RCX = 1, RDX = 2, RBX = 3, RSP = 4, RBP = 5, RSI = 6, RDI = 7,
+        R12 = 12, R13 = 13, R14 = 14, R15 = 15
+    };
+
+    // 固定寄存器：rbx = 当前栈帧的虚拟寄存器，r12 = JitContext，r13 = 全局变量，r14 = 数组栈
+    constexpr int32_t contextArrays = static_cast<int32_t>(offsetof(JitContext, arrays));
+    constexpr int32_t contextArrayTop = static_cast<int32_t>(offsetof(JitContext, arrayTop));
+    constexpr int32_t contextGlobals = static_cast<int32_t>(offsetof(JitContext, globals));
+    constexpr int32_t contextRegisterEnd = static_cast<int32_t>(offsetof(JitContext, registerEnd));
+    constexpr int32_t contextDepth = static_cast<int32_t>(offsetof(JitContext, depth));
+    constexpr int32_t contextDepthLimit = static_cast<int32_t>(offsetof(JitContext, depthLimit));
+    constexpr int32_t contextError = static_cast<int32_t>(offsetof(JitContext, error));
+    constexpr int32_t contextErrorIndex = static_cast<int32_t>(offsetof(JitContext, errorIndex));
+    constexpr int32_t contextErrorLength = static_cast<int32_t>(offsetof(JitContext, errorLength));
+    constexpr int32_t contextErrorFunction = static_cast<int32_t>(offsetof(JitContext, errorFunction));
+
+    // 条件码，用于jcc（0F 80+cc）和setcc（0F 90+cc）
+    enum Condition {
+        CondAbove = 0x7, CondAboveEqual = 0x3, CondEqual = 0x4, CondNotEqual = 0x5,
+        CondLess = 0xC, CondGreaterEqual = 0xD, CondLessEqual = 0xE, CondGreater = 0xF,
+        CondParity = 0xA, CondNoParity = 0xB
+    };
+
+    // 只包含这个JIT需要的指令编码
+    class Assembler {
+    public:
+        std::vector<uint8_t> code;
+
+        void byte(uint8_t value) {
+            code.push_back(value);
+        }
+
+        void bytes(std::initializer_list<uint8_t> values) {
+            code.insert(code.end(), values);
+        }
+
+        void dword(uint32_t value) {
+            for (int i = 0; i < 4; i++) {
+                code.push_back(static_cast<uint8_t>(value >> (i * 8)));
+            }
+        }
+
+        void qword(uint64_t value) {
+            for (int i = 0; i < 8; i++) {
+                code.push_back(static_cast<uint8_t>(value >> (i * 8)));
+            }
+        }
+
+        // [base + disp]形式的内存操作数，prefix是SSE指令的强制前缀（放在REX之前）
+        void memory(uint8_t prefix, bool wide, std::initializer_list<uint8_t> opcode, int reg, int base, int32_t disp) {
+            if (prefix != 0) {
+                byte(prefix);
+            }
+            uint8_t rex = 0x40 | (wide ? 8 : 0) | ((reg & 8) ? 4 : 0) | ((base & 8) ? 1 : 0);
+            if (rex != 0x40) {
+                byte(rex);
+            }
+            bytes(opcode);
+            int mod = disp == 0 && (base & 7) != RBP ? 0 : (disp >= -128 && disp <= 127 ? 1 : 2);
+            byte(static_cast<uint8_t>(mod << 6 | (reg & 7) << 3 | (base & 7)));
+            if ((base & 7) == RSP) {
+                byte(0x24);
+            }
+            if (mod == 1) {
+                byte(static_cast<uint8_t>(disp));
+            }
+            else if (mod == 2) {
+                dword(static_cast<uint32_t>(disp));
+            }
+        }
+
+        // [base + index * 8]
+        void indexed(bool wide, uint8_t opcode, int reg, int base, int index) {
+            byte(0x40 | (wide ? 8 : 0) | ((reg & 8) ? 4 : 0) | ((index & 8) ? 2 : 0) | ((base & 8) ? 1 : 0));
+            byte(opcode);
+            byte(static_cast<uint8_t>((reg & 7) << 3 | RSP));
+            byte(static_cast<uint8_t>(3 << 6 | (index & 7) << 3 | (base & 7)));
+        }
+
+        void movImm64(int reg, uint64_t value) {
+            byte(0x48 | ((reg & 8) ? 1 : 0));
+            byte(0xB8 + (reg & 7));
+            qword(value);
+        }
+
+        // mov rax, imm64; call rax
+        void callAbsolute(const void* target) {
+            movImm64(RAX, reinterpret_cast<uint64_t>(target));
+            bytes({ 0xFF, 0xD0 });
+        }
+
+        int newLabel() {
+            labels_.push_back(SIZE_MAX);
+            return static_cast<int>(labels_.size() - 1);
+        }
+
+        void bind(int label) {
+            labels_[label] = code.size();
+        }
+
+        void jump(int label) {
+            byte(0xE9);
+            fixup(label);
+        }
+
+        void jumpIf(Condition condition, int label) {
+            bytes({ 0x0F, static_cast<uint8_t>(0x80 + condition) });
+            fixup(label);
+        }
+
+        // setcc al; movzx eax, al
+        void setFlag(Condition condition) {
+            bytes({ 0x0F, static_cast<uint8_t>(0x90 + condition), 0xC0, 0x0F, 0xB6, 0xC0 });
+        }
+
+        void resolveLabels() {
+            for (const auto& [position, label] : fixups_) {
+                int32_t relative = static_cast<int32_t>(labels_[label] - (position + 4));
+                std::memcpy(code.data() + position, &relative, 4);
+            }
+            fixups_.clear();
+        }
+
+    private:
+        std::vector<size_t> labels_;
+        std::vector<std::pair<size_t, int>> fixups_;
+
+        void fixup(int label) {
+            fixups_.push_back({ code.size(), label });
+            dword(0);
+        }
+    };
+
+    int32_t slot(uint16_t reg) {
+        return static_cast<int32_t>(reg) * 8;
+    }
+
+    // 以下函数由本机代码调用，不能抛出异常
+
+    uint64_t jitNewArray(JitContext* context, int32_t length) {
+        if (length <= 0) {
+            context->error = JitError::ArrayLength;
+            context->errorIndex = length;
+            return 0;
+        }
+        std::vector<BytecodeValue>& storage = *context->arrayStorage;
+        size_t offset = context->arrayTop;
+        size_t top = offset + static_cast<size_t>(length);
+        try {
+            if (top > storage.size()) {
+                storage.resize(top > storage.size() * 2 ? top : storage.size() * 2);
+            }
+        }
+        catch (const std::bad_alloc&) {
+            context->error = JitError::OutOfMemory;
+            return 0;
+        }
+        for (size_t i = offset; i < top; i++) {
+            storage[i].bits = 0;
+        }
+        context->arrays = storage.data();
+        context->arrayTop = top;
+        BytecodeValue value;
+        value.array = { static_cast<uint32_t>(offset), static_cast<uint32_t>(length) };
+        return value.bits;
+    }
+
+    void jitPrintInt(JitContext* context, int32_t value) {
+        *context->out << value;
+    }
+
+    void jitPrintDouble(JitContext* context, double value) {
+        *context->out << value;
+    }
+
+    void jitPrintChar(JitContext* context, int32_t value) {
+        *context->out << static_cast<char>(value);
+    }
+
+    // 编译一批函数到同一块代码中
+    class FunctionEmitter {
+    public:
+        FunctionEmitter(Assembler& assembler, const std::vector<BytecodeValue>& constants, std::vector<std::pair<size_t, uint32_t>>& calls)
+            : as_(assembler), constants_(constants), calls_(calls) {
+        }
+
+        void emit(const BytecodeFunction& function, uint32_t index) {
+            const std::vector<Instruction>& code = function.code;
+            labels_.clear();
+            for (size_t i = 0; i <= code.size(); i++) {
+                labels_.push_back(as_.newLabel());
+            }
+            epilogue_ = as_.newLabel();
+            int divisionByZero = as_.newLabel();
+            int divisionOverflow = as_.newLabel();
+            int shiftCount = as_.newLabel();
+            int arrayIndex = as_.newLabel();
+            int callDepth = as_.newLabel();
+            int registerStack = as_.newLabel();
+
+            // push rbx; mov rbx, rdi; push [r12+arrayTop]; sub rsp, 8
+            // 栈帧共32字节（含返回地址），调用辅助函数时rsp保持16字节对齐
+            as_.byte(0x53);
+            as_.bytes({ 0x48, 0x89, 0xFB });
+            as_.memory(0, false, { 0xFF }, 6, R12, contextArrayTop);
+            as_.bytes({ 0x48, 0x83, 0xEC, 0x08 });
+            // 调用深度：先加一，出错时由尾声统一减一
+            as_.memory(0, false, { 0x8B }, RAX, R12, contextDepth);
+            as_.bytes({ 0x83, 0xC0, 0x01 });
+            as_.memory(0, false, { 0x89 }, RAX, R12, contextDepth);
+            as_.memory(0, false, { 0x3B }, RAX, R12, contextDepthLimit);
+            as_.jumpIf(CondAbove, callDepth);
+            // 寄存器栈空间
+            as_.memory(0, true, { 0x8D }, RAX, RBX, static_cast<int32_t>(function.registerCount) * 8);
+            as_.memory(0, true, { 0x3B }, RAX, R12, contextRegisterEnd);
+            as_.jumpIf(CondAbove, registerStack);
+
+            for (size_t i = 0; i < code.size(); i++) {
+                as_.bind(labels_[i]);
+                const Instruction& ins = code[i];
+                switch (ins.op) {
+                case Opcode::Move:
+                    loadQword(RAX, ins.b);
+                    storeQword(RAX, ins.a);
+                    break;
+                case Opcode::LoadInt:
+                    as_.byte(0xB8);
+                    as_.dword(static_cast<uint32_t>(static_cast<int32_t>(static_cast<int16_t>(ins.b))));
+                    storeQword(RAX, ins.a);
+                    break;
+                case Opcode::LoadConst:
+                    as_.movImm64(RAX, programConstant(ins.b));
+                    storeQword(RAX, ins.a);
+                    break;
+                case Opcode::LoadGlobal:
+                    as_.memory(0, true, { 0x8B }, RAX, R13, slot(ins.b));
+                    storeQword(RAX, ins.a);
+                    break;
+                case Opcode::StoreGlobal:
+                    loadQword(RAX, ins.b);
+                    as_.memory(0, true, { 0x89 }, RAX, R13, slot(ins.a));
+                    break;
+
+                case Opcode::AddI: intBinary(ins, { 0x03 }); break;
+                case Opcode::SubI: intBinary(ins, { 0x2B }); break;
+                case Opcode::MulI: intBinary(ins, { 0x0F, 0xAF }); break;
+                case Opcode::AndI: intBinary(ins, { 0x23 }); break;
+                case Opcode::OrI: intBinary(ins, { 0x0B }); break;
+                case Opcode::XorI: intBinary(ins, { 0x33 }); break;
+                case Opcode::DivI:
+                case Opcode::ModI: {
+                    int divide = as_.newLabel();
+                    loadInt(RAX, ins.b);
+                    loadInt(RCX, ins.c);
+                    as_.bytes({ 0x85, 0xC9 });                       // test ecx, ecx
+                    as_.jumpIf(CondEqual, divisionByZero);
+                    as_.bytes({ 0x83, 0xF9, 0xFF });                 // cmp ecx, -1
+                    as_.jumpIf(CondNotEqual, divide);
+                    as_.byte(0x3D);                                  // cmp eax, INT32_MIN
+                    as_.dword(0x80000000u);
+                    as_.jumpIf(CondEqual, divisionOverflow);
+                    as_.bind(divide);
+                    as_.bytes({ 0x99, 0xF7, 0xF9 });                 // cdq; idiv ecx
+                    if (ins.op == Opcode::ModI) {
+                        as_.bytes({ 0x89, 0xD0 });                   // mov eax, edx
+                    }
+                    storeQword(RAX, ins.a);
+                    break;
+                }
+                case Opcode::ShlI:
+                case Opcode::ShrI:
+                    loadInt(RCX, ins.c);
+                    as_.bytes({ 0x83, 0xF9, 0x1F });                 // cmp ecx, 31（无符号比较同时排除负数）
+                    as_.jumpIf(CondAbove, shiftCount);
+                    loadInt(RAX, ins.b);
+                    as_.bytes({ 0xD3, static_cast<uint8_t>(ins.op == Opcode::ShlI ? 0xE0 : 0xF8) });
+                    storeQword(RAX, ins.a);
+                    break;
+                case Opcode::LtI: intCompare(ins, CondLess); break;
+                case Opcode::LeI: intCompare(ins, CondLessEqual); break;
+                case Opcode::EqI: intCompare(ins, CondEqual); break;
+                case Opcode::NeI: intCompare(ins, CondNotEqual); break;
+                case Opcode::NegI:
+                    loadInt(RAX, ins.b);
+                    as_.bytes({ 0xF7, 0xD8 });
+                    storeQword(RAX, ins.a);
+                    break;
+                case Opcode::BitNotI:
+                    loadInt(RAX, ins.b);
+                    as_.bytes({ 0xF7, 0xD0 });
+                    storeQword(RAX, ins.a);
+                    break;
+                case Opcode::NotI:
+                case Opcode::IntToBool:
+                    loadInt(RAX, ins.b);
+                    as_.bytes({ 0x85, 0xC0 });
+                    as_.setFlag(ins.op == Opcode::NotI ? CondEqual : CondNotEqual);
+                    storeQword(RAX, ins.a);
+                    break;
+
+                case Opcode::AddD: doubleBinary(ins, 0x58); break;
+                case Opcode::SubD: doubleBinary(ins, 0x5C); break;
+                case Opcode::MulD: doubleBinary(ins, 0x59); break;
+                case Opcode::DivD: doubleBinary(ins, 0x5E); break;
+                case Opcode::LtD:
+                case Opcode::LeD:
+                    // b < c 即 c > b，无序（NaN）时CF=1，结果为假
+                    loadDouble(0, ins.c);
+                    as_.memory(0x66, false, { 0x0F, 0x2E }, 0, RBX, slot(ins.b));
+                    as_.setFlag(ins.op == Opcode::LtD ? CondAbove : CondAboveEqual);
+                    storeQword(RAX, ins.a);
+                    break;
+                case Opcode::EqD:
+                case Opcode::NeD:
+                    loadDouble(0, ins.b);
+                    as_.memory(0x66, false, { 0x0F, 0x2E }, 0, RBX, slot(ins.c));
+                    doubleEquality(ins.op == Opcode::EqD);
+                    storeQword(RAX, ins.a);
+                    break;
+                case Opcode::NotD:
+                case Opcode::DoubleToBool:
+                    loadDouble(0, ins.b);
+                    as_.bytes({ 0x66, 0x0F, 0x57, 0xC9 });           // xorpd xmm1, xmm1
+                    as_.bytes({ 0x66, 0x0F, 0x2E, 0xC1 });           // ucomisd xmm0, xmm1
+                    doubleEquality(ins.op == Opcode::NotD);
+                    storeQword(RAX, ins.a);
+                    break;
+                case Opcode::NegD:
+                    loadQword(RAX, ins.b);
+                    as_.bytes({ 0x48, 0x0F, 0xBA, 0xF8, 0x3F });     // btc rax, 63
+                    storeQword(RAX, ins.a);
+                    break;
+
+                case Opcode::IntToDouble:
+                    // cvtsi2sd只写xmm0的低64位，先清零打断对上一次xmm0结果的依赖
+                    as_.bytes({ 0x0F, 0x57, 0xC0 });                 // xorps xmm0, xmm0
+                    as_.memory(0xF2, false, { 0x0F, 0x2A }, 0, RBX, slot(ins.b));
+                    storeDouble(0, ins.a);
+                    break;
+                case Opcode::DoubleToInt:
+                    // 越界和NaN的处理与解释器一致，直接调用doubleToInt
+                    loadDouble(0, ins.b);
+                    as_.callAbsolute(reinterpret_cast<const void*>(&doubleToInt));
+                    as_.bytes({ 0x89, 0xC0 });                       // mov eax, eax
+                    storeQword(RAX, ins.a);
+                    break;
+                case Opcode::RoundFloat:
+                    loadDouble(0, ins.b);
+                    as_.bytes({ 0xF2, 0x0F, 0x5A, 0xC0 });           // cvtsd2ss xmm0, xmm0
+                    as_.bytes({ 0xF3, 0x0F, 0x5A, 0xC0 });           // cvtss2sd xmm0, xmm0
+                    storeDouble(0, ins.a);
+                    break;
+                case Opcode::TruncChar:
+                    as_.memory(0, false, { 0x0F, 0xBE }, RAX, RBX, slot(ins.b));
+                    storeQword(RAX, ins.a);
+                    break;
+
+                case Opcode::Jump:
+                    as_.jump(labels_[ins.c]);
+                    break;
+                case Opcode::JumpIfFalse:
+                case Opcode::JumpIfTrue:
+                    as_.memory(0, false, { 0x83 }, 7, RBX, slot(ins.a));
+                    as_.byte(0);
+                    as_.jumpIf(ins.op == Opcode::JumpIfFalse ? CondEqual : CondNotEqual, labels_[ins.c]);
+                    break;
+                case Opcode::JumpUnlessLtI: compareAndBranch(ins, CondGreaterEqual); break;
+                case Opcode::JumpUnlessLeI: compareAndBranch(ins, CondGreater); break;
+                case Opcode::JumpUnlessEqI: compareAndBranch(ins, CondNotEqual); break;
+                case Opcode::JumpUnlessNeI: compareAndBranch(ins, CondEqual); break;
+                case Opcode::IncI:
+                case Opcode::AddImmI:
+                    loadInt(RAX, ins.op == Opcode::IncI ? ins.a : ins.b);
+                    as_.byte(0x05);
+                    as_.dword(static_cast<uint32_t>(static_cast<int32_t>(static_cast<int16_t>(ins.op == Opcode::IncI ? ins.b : ins.c))));
+                    storeQword(RAX, ins.a);
+                    break;
+
+                case Opcode::NewArray:
+                    as_.bytes({ 0x4C, 0x89, 0xE7 });                 // mov rdi, r12
+                    loadInt(RSI, ins.b);
+                    as_.callAbsolute(reinterpret_cast<const void*>(&jitNewArray));
+                    checkError();
+                    storeQword(RAX, ins.a);
+                    break;
+                case Opcode::LoadElement:
+                    elementAddress(ins.b, ins.c, arrayIndex);
+                    as_.indexed(true, 0x8B, RAX, R14, RAX);
+                    storeQword(RAX, ins.a);
+                    break;
+                case Opcode::StoreElement:
+                    elementAddress(ins.a, ins.b, arrayIndex);
+                    loadQword(RCX, ins.c);
+                    as_.indexed(true, 0x89, RCX, R14, RAX);
+                    break;
+                case Opcode::ArrayMark:
+                    as_.memory(0, true, { 0x8B }, RAX, R12, contextArrayTop);
+                    storeQword(RAX, ins.a);
+                    break;
+                case Opcode::ArrayRelease:
+                    loadQword(RAX, ins.a);
+                    as_.memory(0, true, { 0x89 }, RAX, R12, contextArrayTop);
+                    break;
+
+                case Opcode::Call:
+                    // 被调函数的栈帧从rbx+c开始，目标地址在整批代码安装后修补
+                    as_.memory(0, true, { 0x8D }, RDI, RBX, slot(ins.c));
+                    as_.byte(0x48);
+                    as_.byte(0xB8);
+                    calls_.push_back({ as_.code.size(), ins.b });
+                    as_.qword(0);
+                    as_.bytes({ 0xFF, 0xD0 });
+                    checkError();
+                    storeQword(RAX, ins.a);
+                    break;
+                case Opcode::Return:
+                    loadQword(RAX, ins.a);
+                    as_.jump(epilogue_);
+                    break;
+                case Opcode::ReturnVoid:
+                    as_.bytes({ 0x31, 0xC0 });
+                    as_.jump(epilogue_);
+                    break;
+
+                case Opcode::PrintInt:
+                    as_.bytes({ 0x4C, 0x89, 0xE7 });
+                    loadInt(RSI, ins.a);
+                    as_.callAbsolute(reinterpret_cast<const void*>(&jitPrintInt));
+                    break;
+                case Opcode::PrintDouble:
+                    as_.bytes({ 0x4C, 0x89, 0xE7 });
+                    loadDouble(0, ins.a);
+                    as_.callAbsolute(reinterpret_cast<const void*>(&jitPrintDouble));
+                    break;
+                case Opcode::PrintSpace:
+                case Opcode::PrintNewline:
+                    as_.bytes({ 0x4C, 0x89, 0xE7 });
+                    as_.byte(0xBE);                                  // mov esi, imm32
+                    as_.dword(ins.op == Opcode::PrintSpace ? ' ' : '\n');
+                    as_.callAbsolute(reinterpret_cast<const void*>(&jitPrintChar));
+                    break;
+                case Opcode::Count:
+                    break;
+                }
+            }
+            as_.bind(labels_[code.size()]);
+            as_.bytes({ 0x31, 0xC0 });
+
+            // 尾声：恢复调用深度和进入函数时的数组栈顶
+            as_.bind(epilogue_);
+            as_.memory(0, false, { 0x83 }, 5, R12, contextDepth);
+            as_.byte(1);
+            as_.memory(0, true, { 0x8B }, RCX, RSP, 8);
+            as_.memory(0, true, { 0x89 }, RCX, R12, contextArrayTop);
+            as_.bytes({ 0x48, 0x83, 0xC4, 0x10, 0x5B, 0xC3 });     // add rsp, 16; pop rbx; ret
+
+            errorStub(divisionByZero, JitError::DivisionByZero);
+            errorStub(divisionOverflow, JitError::DivisionOverflow);
+            errorStub(shiftCount, JitError::ShiftCount);
+            as_.bind(arrayIndex);
+            as_.memory(0, false, { 0x89 }, RCX, R12, contextErrorIndex);
+            as_.memory(0, false, { 0x89 }, RDX, R12, contextErrorLength);
+            errorStub(-1, JitError::ArrayIndex);
+            as_.bind(callDepth);
+            setErrorFunction(index);
+            errorStub(-1, JitError::CallDepth);
+            as_.bind(registerStack);
+            setErrorFunction(index);
+            errorStub(-1, JitError::RegisterStack);
+        }
+
+    private:
+        Assembler& as_;
+        const std::vector<BytecodeValue>& constants_;
+        std::vector<std::pair<size_t, uint32_t>>& calls_;
+        std::vector<int> labels_;
+        int epilogue_ = 0;
+
+        uint64_t programConstant(uint16_t index) const {
+            return constants_[index].bits;
+        }
+
+        void loadInt(int reg, uint16_t source) {
+            as_.memory(0, false, { 0x8B }, reg, RBX, slot(source));
+        }
+
+        void loadQword(int reg, uint16_t source) {
+            as_.memory(0, true, { 0x8B }, reg, RBX, slot(source));
+        }
+
+        // 32位运算已经把高32位清零，整个64位写回，与虚拟机的寄存器内容一致
+        void storeQword(int reg, uint16_t target) {
+            as_.memory(0, true, { 0x89 }, reg, RBX, slot(target));
+        }
+
+        void loadDouble(int xmm, uint16_t source) {
+            as_.memory(0xF2, false, { 0x0F, 0x10 }, xmm, RBX, slot(source));
+        }
+
+        void storeDouble(int xmm, uint16_t target) {
+            as_.memory(0xF2, false, { 0x0F, 0x11 }, xmm, RBX, slot(target));
+        }
+
+        void intBinary(const Instruction& ins, std::initializer_list<uint8_t> opcode) {
+            loadInt(RAX, ins.b);
+            as_.memory(0, false, opcode, RAX, RBX, slot(ins.c));
+            storeQword(RAX, ins.a);
+        }
+
+        void intCompare(const Instruction& ins, Condition condition) {
+            loadInt(RAX, ins.b);
+            as_.memory(0, false, { 0x3B }, RAX, RBX, slot(ins.c));
+            as_.setFlag(condition);
+            storeQword(RAX, ins.a);
+        }
+
+        void compareAndBranch(const Instruction& ins, Condition jumpCondition) {
+            loadInt(RAX, ins.a);
+            as_.memory(0, false, { 0x3B }, RAX, RBX, slot(ins.b));
+            as_.jumpIf(jumpCondition, labels_[ins.c]);
+        }
+
+        void doubleBinary(const Instruction& ins, uint8_t opcode) {
+            loadDouble(0, ins.b);
+            as_.memory(0xF2, false, { 0x0F, opcode }, 0, RBX, slot(ins.c));
+            storeDouble(0, ins.a);
+        }
+
+        // ucomisd之后：相等要求ZF=1且PF=0，不等是ZF=0或PF=1
+        void doubleEquality(bool equal) {
+            if (equal) {
+                as_.bytes({ 0x0F, 0x94, 0xC0, 0x0F, 0x9B, 0xC1, 0x20, 0xC8 });  // sete al; setnp cl; and al, cl
+            }
+            else {
+                as_.bytes({ 0x0F, 0x95, 0xC0, 0x0F, 0x9A, 0xC1, 0x08, 0xC8 });  // setne al; setp cl; or al, cl
+            }
+            as_.bytes({ 0x0F, 0xB6, 0xC0 });
+        }
+
+        // 检查下标后rax = 元素在数组栈中的位置；越界时ecx = 下标，edx = 长度
+        void elementAddress(uint16_t array, uint16_t index, int outOfBounds) {
+            loadInt(RCX, index);
+            as_.memory(0, false, { 0x8B }, RDX, RBX, slot(array) + 4);
+            as_.bytes({ 0x39, 0xD1 });                               // cmp ecx, edx
+            as_.jumpIf(CondAboveEqual, outOfBounds);
+            loadInt(RAX, array);
+            as_.bytes({ 0x01, 0xC8 });                               // add eax, ecx
+        }
+
+        // 调用返回后检查错误，并重新读取可能移动过的数组栈
+        void checkError() {
+            as_.memory(0, false, { 0x83 }, 7, R12, contextError);
+            as_.byte(0);
+            as_.jumpIf(CondNotEqual, epilogue_);
+            as_.memory(0, true, { 0x8B }, R14, R12, contextArrays);
+        }
+
+        void setErrorFunction(uint32_t index) {
+            as_.memory(0, false, { 0xC7 }, 0, R12, contextErrorFunction);
+            as_.dword(index);
+        }
+
+        void errorStub(int label, JitError error) {
+            if (label >= 0) {
+                as_.bind(label);
+            }
+            as_.memory(0, false, { 0xC7 }, 0, R12, contextError);
+            as_.dword(static_cast<uint32_t>(error));
+            as_.jump(epilogue_);
+        }
+    };
+
+    // 寄存器栈只保留地址空间，用到的页才会分配
+    constexpr size_t registerStackBytes = size_t(64) << 20;
+}
+
+JitCompiler::JitCompiler(const BytecodeProgram& program)
+    : program_(program), entries_(program.functions.size(), nullptr), thunk_(nullptr),
+    registerStack_(nullptr), registerStackSize_(0) {
+    void* stack = mmap(nullptr, registerStackBytes, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (stack == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    registerStack_ = static_cast<BytecodeValue*>(stack);
+    registerStackSize_ = registerStackBytes / sizeof(BytecodeValue);
+
+    // thunk(regs, context, code)：保存被调用者保存的寄存器，设置固定寄存器后调用code
+    Assembler as;
+    as.bytes({ 0x53, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57 });  // push rbx, r12, r13, r14, r15
+    as.bytes({ 0x49, 0x89, 0xF4 });                                       // mov r12, rsi
+    as.memory(0, true, { 0x8B }, R13, R12, contextGlobals);
+    as.memory(0, true, { 0x8B }, R14, R12, contextArrays);
+    as.bytes({ 0xFF, 0xD2 });                                             // call rdx
+    as.bytes({ 0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5B, 0xC3 });
+    CodeBlock& block = allocate(as.code.size());
+    std::memcpy(block.memory, as.code.data(), as.code.size());
+    seal(block);
+    thunk_ = block.memory;
+}
+
+JitCompiler::~JitCompiler() {
+    for (const CodeBlock& block : blocks_) {
+        munmap(block.memory, block.size);
+    }
+    munmap(registerStack_, registerStackBytes);
+}
+
+bool JitCompiler::supported() {
+    return true;
+}
+
+void JitCompiler::compile(uint32_t function) {
+    // 收集还没有编译的被调函数闭包
+    std::vector<uint32_t> batch;
+    std::vector<bool> queued(program_.functions.size(), false);
+    std::vector<uint32_t> pending{ function };
+    queued[function] = true;
+    while (!pending.empty()) {
+        uint32_t current = pending.back();
+        pending.pop_back();
+        if (entries_[current] != nullptr) {
+            continue;
+        }
+        batch.push_back(current);
+        for (const Instruction& ins : program_.functions[current].code) {
+            if (ins.op == Opcode::Call && !queued[ins.b]) {
+                queued[ins.b] = true;
+                pending.push_back(ins.b);
+            }
+        }
+    }
+    if (batch.empty()) {
+        return;
+    }
+
+    Assembler as;
+    std::vector<std::pair<size_t, uint32_t>> calls;
+    std::vector<size_t> offsets(program_.functions.size(), SIZE_MAX);
+    FunctionEmitter emitter(as, program_.constants, calls);
+    for (uint32_t index : batch) {
+        // 函数入口按16字节对齐
+        while (as.code.size() % 16 != 0) {
+            as.byte(0xCC);
+        }
+        offsets[index] = as.code.size();
+        emitter.emit(program_.functions[index], index);
+    }
+    as.resolveLabels();
+
+    // 先分配可写内存确定地址，修补调用目标后再改为可执行
+    CodeBlock& block = allocate(as.code.size());
+    uint8_t* base = static_cast<uint8_t*>(block.memory);
+    for (const auto& [position, callee] : calls) {
+        uint64_t target = offsets[callee] != SIZE_MAX ? reinterpret_cast<uint64_t>(base + offsets[callee])
+            : reinterpret_cast<uint64_t>(entries_[callee]);
+        std::memcpy(as.code.data() + position, &target, 8);
+    }
+    std::memcpy(base, as.code.data(), as.code.size());
+    seal(block);
+    for (uint32_t index : batch) {
+        entries_[index] = base + offsets[index];
+    }
+}
+
+size_t JitCompiler::compiledCount() const {
+    size_t count = 0;
+    for (void* entry : entries_) {
+        count += entry != nullptr ? 1 : 0;
+    }
+    return count;
+}
+
+size_t JitCompiler::codeSize() const {
+    size_t size = 0;
+    for (const CodeBlock& block : blocks_) {
+        size += block.size;
+    }
+    return size;
+}
+
+BytecodeValue JitCompiler::invoke(uint32_t function, const BytecodeValue* args, JitContext& context) {
+    const BytecodeFunction& callee = program_.functions[function];
+    for (uint32_t i = 0; i < callee.parameterCount; i++) {
+        registerStack_[i] = args[i];
+    }
+    context.registerEnd = registerStack_ + registerStackSize_;
+    using Thunk = uint64_t (*)(BytecodeValue*, JitContext*, void*);
+    BytecodeValue result;
+    result.bits = reinterpret_cast<Thunk>(thunk_)(registerStack_, &context, entries_[function]);
+    return result;
+}
+
+JitCompiler::CodeBlock& JitCompiler::allocate(size_t bytes) {
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t size = (bytes + page - 1) / page * page;
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    blocks_.push_back({ memory, size });
+    return blocks_.back();
+}
+
+void JitCompiler::seal(const CodeBlock& block) {
+    if (mprotect(block.memory, block.size, PROT_READ | PROT_EXEC) != 0) {
+        throw std::bad_alloc();
+    }
+}
+
+#else
+
+// 不支持的平台上没有本机代码，虚拟机不会创建JitCompiler
+JitCompiler::JitCompiler(const BytecodeProgram& program)
+    : program_(program), entries_(program.functions.size(), nullptr), thunk_(nullptr),
+    registerStack_(nullptr), registerStackSize_(0) {
+}
+
+JitCompiler::~JitCompiler() {
+}
+
+bool JitCompiler::supported() {
+    return false;
+}
+
+void JitCompiler::compile(uint32_t) {
+}
+
+size_t JitCompiler::compiledCount() const {
+    return 0;
+}
+
+size_t JitCompiler::codeSize() const {
+    return 0;
+}
+
+BytecodeValue JitCompiler::invoke(uint32_t, const BytecodeValue*, JitContext&) {
+    BytecodeValue result;
+    result.bits = 0;
+    return result;
+}
+
+#endif
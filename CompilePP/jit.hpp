@@ -0,0 +1,84 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "bytecode.hpp"
+
+// 只在Linux x86-64上生成本机代码（System V调用约定、mmap），其他平台虚拟机不会升级到JIT
+#if defined(__x86_64__) && defined(__linux__)
+#define JIT_SUPPORTED 1
+#endif
+
+// 本机代码不能抛出C++异常，出错时记录错误并逐层返回，由虚拟机转换成RuntimeError
+enum class JitError : uint32_t {
+    None,
+    DivisionByZero,
+    DivisionOverflow,
+    ShiftCount,
+    ArrayIndex,     // errorIndex、errorLength
+    ArrayLength,    // errorIndex为申请的长度
+    CallDepth,      // errorFunction
+    RegisterStack,  // errorFunction
+    OutOfMemory
+};
+
+// 本机代码和虚拟机共享的状态，生成的代码按偏移直接访问这些字段
+struct JitContext {
+    BytecodeValue* arrays;        // 数组栈，分配数组时可能移动
+    uint64_t arrayTop;
+    BytecodeValue* globals;
+    BytecodeValue* registerEnd;   // JIT寄存器栈的末尾
+    uint32_t depth;               // 当前调用深度，包括虚拟机中的栈帧
+    uint32_t depthLimit;
+    JitError error;
+    int32_t errorIndex;
+    uint32_t errorLength;
+    uint32_t errorFunction;
+    std::vector<BytecodeValue>* arrayStorage;
+    std::ostream* out;
+};
+
+// 把字节码函数编译成x86-64本机代码的模板JIT
+// 字节码由BytecodeCompiler从FunctionDefinitionNode生成，每条指令展开成固定的机器码序列，
+// 虚拟寄存器仍在内存中（rbx指向当前栈帧），int和double运算分别用通用寄存器和SSE2完成。
+// 一个函数和它直接或间接调用的函数一起编译，本机代码之间直接call，不会回到虚拟机。
+// 代码先写入可写内存，修补完调用地址后再改成只读可执行（W^X）
+class JitCompiler {
+public:
+    explicit JitCompiler(const BytecodeProgram& program);
+    ~JitCompiler();
+
+    JitCompiler(const JitCompiler&) = delete;
+    JitCompiler& operator=(const JitCompiler&) = delete;
+
+    static bool supported();
+
+    // 编译function以及它调用的所有还没有编译的函数
+    void compile(uint32_t function);
+    bool compiled(uint32_t function) const {
+        return entries_[function] != nullptr;
+    }
+    size_t compiledCount() const;
+    size_t codeSize() const;
+
+    // 在JIT寄存器栈上执行已编译的函数，参数从args复制；出错时context.error不为None
+    BytecodeValue invoke(uint32_t function, const BytecodeValue* args, JitContext& context);
+
+private:
+    struct CodeBlock {
+        void* memory;
+        size_t size;
+    };
+
+    const BytecodeProgram& program_;
+    std::vector<void*> entries_;       // 按函数编号的入口地址，nullptr表示还没有编译
+    std::vector<CodeBlock> blocks_;
+    void* thunk_;                      // 从C++进入本机代码的入口，保存和设置固定寄存器
+    BytecodeValue* registerStack_;
+    size_t registerStackSize_;         // 寄存器个数
+
+    // 分配可写的代码内存，写完后用seal改为只读可执行
+    CodeBlock& allocate(size_t bytes);
+    void seal(const CodeBlock& block);
+};
@@ -0,0 +1,320 @@
+#include <algorithm>
+#include <array>
+#include <string_view>
+#include "lalrParser.hpp"
+#include "newVector.cpp"
+#include "tokenSet.hpp"
+
+namespace {
+#include "lalrTables.inc"
+
+    // 语义动作，$n表示产生式右部第n个符号的语义值
+    enum class LalrAction {
+        Pass1,                 // $1
+        Pass2,                 // $2
+        Empty,                 // 没有子节点的新节点
+        Leaf,                  // 值为$1词素的新节点
+        LeafWrap,              // 值为$1词素的新节点，子节点$2
+        Wrap,                  // 子节点$1
+        WrapNull,              // 子节点$1和一个空指针（没有初值的InitDeclarator）
+        Append2,               // 把$2追加到$1
+        Append3,               // 把$3追加到$1
+        Node12,
+        Node13,
+        Node123,
+        Node135,
+        Node35,
+        Node357,
+        NodeOp,                // 子节点$1、运算符$2、$3
+        NodeValueOp,           // 值为运算符$2，子节点$1、$3
+        Declarator,            // 子节点Identifier($1)
+        ArrayDeclarator,       // ArrayDeclarator、Identifier($1)、$3
+        FunctionDeclarator,    // FunctionDeclarator、Identifier($1)、参数列表
+        AppendIdentifier,      // 把Identifier($3)追加到$1
+        ParameterDeclaration,  // 子节点$1、Identifier($2)
+        ForStatement,          // 值为$1词素，子节点$3、$4、$5、$7
+        Cast,                  // 子节点'('、$2、')'、$4
+        PrefixOp,              // 子节点运算符$1、$2
+        PostfixOp,             // 子节点$1、运算符$2
+        SizeofType,            // 子节点sizeof、'('、$3、')'
+        Bracketed,             // 子节点$1、左括号、中间的$3（可选）、右括号
+        MemberAccess           // 子节点$1、运算符$2、成员名$3
+    };
+
+    // 归约时嵌套层数的算法，与Parser中NestingScope所在的位置对应：
+    // Parser在assignmentExpression和statement处各加一层，链用循环分析，不加层
+    enum class LalrNesting {
+        Max,       // 子符号层数的最大值
+        Level,     // 最大值加一层
+        Chain,     // 赋值链：右操作数已经算过这一层，其余子符号加一层
+        ElseChain  // if-else：else分支本身是if语句时与外层的if在同一层
+    };
+
+    constexpr LalrNesting nestingOf(std::string_view lhs, std::string_view rhs) {
+        if (lhs == "Statement" || lhs == "StatementNoIdent") {
+            return LalrNesting::Level;
+        }
+        if (lhs == "AssignmentExpression" || lhs == "AssignmentNoIdent") {
+            return rhs.find(' ') == std::string_view::npos ? LalrNesting::Level : LalrNesting::Chain;
+        }
+        if (lhs == "KeywordStatement" && rhs.find(" Else ") != std::string_view::npos) {
+            return LalrNesting::ElseChain;
+        }
+        return LalrNesting::Max;
+    }
+
+    struct RuleInfo {
+        LalrAction action;
+        const char* nodeType;
+        LalrNesting nesting;
+    };
+
+    const RuleInfo ruleInfo[] = {
+        { LalrAction::Pass1, "", LalrNesting::Max },  // 0号增广产生式
+#define LALR_RULE(lhs, rhs, action, nodeType) { LalrAction::action, nodeType, nestingOf(#lhs, rhs) },
+#include "lalrGrammar.def"
+#undef LALR_RULE
+    };
+
+    enum LalrTerminal {
+#define LALR_TERMINAL(name) Terminal##name,
+#include "lalrGrammar.def"
+#undef LALR_TERMINAL
+        TerminalCount
+    };
+
+    static_assert(sizeof(ruleInfo) / sizeof(ruleInfo[0]) == lalrRuleCount, "lalrTables.inc is out of date, rerun LalrGen");
+    static_assert(TerminalCount == lalrTerminalCount, "lalrTables.inc is out of date, rerun LalrGen");
+
+    constexpr std::array<unsigned char, tokenTypeCount> makeTerminalMap() {
+        std::array<unsigned char, tokenTypeCount> map{};
+        for (unsigned char& terminal : map) {
+            terminal = TerminalOther;
+        }
+#define LALR_TOKEN(type, terminal) map[static_cast<size_t>(TokenType::type)] = Terminal##terminal;
+#include "lalrGrammar.def"
+#undef LALR_TOKEN
+        return map;
+    }
+
+    // Token类型到终结符编号
+    constexpr std::array<unsigned char, tokenTypeCount> terminalOf = makeTerminalMap();
+
+    ASTNode* makeNode(const char* type, ASTNode* first = nullptr, ASTNode* second = nullptr, ASTNode* third = nullptr) {
+        ASTNode* node = new ASTNode(type, "");
+        if (first != nullptr) {
+            node->addChild(first);
+        }
+        if (second != nullptr) {
+            node->addChild(second);
+        }
+        if (third != nullptr) {
+            node->addChild(third);
+        }
+        return node;
+    }
+
+    ASTNode* makeIdentifier(const Token* token) {
+        return new ASTNode("Identifier", token->lexeme);
+    }
+
+    // 以词素为节点类型的叶子，Parser用它表示运算符和括号
+    ASTNode* makeLexeme(const Token* token) {
+        return new ASTNode(token->lexeme, "");
+    }
+
+    // 归约得到的符号的嵌套层数，词法单元的层数为0
+    size_t reducedNesting(int rule, const LalrStackEntry* values, size_t length) {
+        size_t nesting = 0;
+        switch (ruleInfo[rule].nesting) {
+        case LalrNesting::Max:
+        case LalrNesting::Level:
+            for (size_t i = 0; i < length; i++) {
+                nesting = std::max(nesting, values[i].nesting);
+            }
+            return ruleInfo[rule].nesting == LalrNesting::Level ? nesting + 1 : nesting;
+        case LalrNesting::Chain:
+            for (size_t i = 0; i + 1 < length; i++) {
+                nesting = std::max(nesting, values[i].nesting + 1);
+            }
+            return std::max(nesting, values[length - 1].nesting);
+        case LalrNesting::ElseChain: {
+            // If ( Expression ) Statement Else Statement
+            for (size_t i = 0; i + 1 < length; i++) {
+                nesting = std::max(nesting, values[i].nesting);
+            }
+            const LalrStackEntry& elseBranch = values[length - 1];
+            bool elseIf = elseBranch.node != nullptr && elseBranch.node->type == "SelectionStatement";
+            return std::max(nesting, elseIf ? elseBranch.nesting - 1 : elseBranch.nesting);
+        }
+        }
+        return nesting;
+    }
+
+    // 按产生式执行语义动作，构建的节点与Parser中对应的函数完全相同
+    ASTNode* reduce(int rule, const LalrStackEntry* values) {
+        const RuleInfo& info = ruleInfo[rule];
+        ASTNode* node = nullptr;
+        switch (info.action) {
+        case LalrAction::Pass1:
+            return values[0].node;
+        case LalrAction::Pass2:
+            return values[1].node;
+        case LalrAction::Empty:
+            return makeNode(info.nodeType);
+        case LalrAction::Leaf:
+            return new ASTNode(info.nodeType, values[0].token->lexeme);
+        case LalrAction::LeafWrap:
+            node = new ASTNode(info.nodeType, values[0].token->lexeme);
+            node->addChild(values[1].node);
+            return node;
+        case LalrAction::Wrap:
+            return makeNode(info.nodeType, values[0].node);
+        case LalrAction::WrapNull:
+            node = makeNode(info.nodeType, values[0].node);
+            node->addChild(nullptr);
+            return node;
+        case LalrAction::Append2:
+            values[0].node->addChild(values[1].node);
+            return values[0].node;
+        case LalrAction::Append3:
+            values[0].node->addChild(values[2].node);
+            return values[0].node;
+        case LalrAction::Node12:
+            return makeNode(info.nodeType, values[0].node, values[1].node);
+        case LalrAction::Node13:
+            return makeNode(info.nodeType, values[0].node, values[2].node);
+        case LalrAction::Node123:
+            return makeNode(info.nodeType, values[0].node, values[1].node, values[2].node);
+        case LalrAction::Node135:
+            return makeNode(info.nodeType, values[0].node, values[2].node, values[4].node);
+        case LalrAction::Node35:
+            return makeNode(info.nodeType, values[2].node, values[4].node);
+        case LalrAction::Node357:
+            return makeNode(info.nodeType, values[2].node, values[4].node, values[6].node);
+        case LalrAction::NodeOp:
+            return makeNode(info.nodeType, values[0].node, new ASTNode(values[1].token->lexeme, ""), values[2].node);
+        case LalrAction::NodeValueOp:
+            node = new ASTNode(info.nodeType, values[1].token->lexeme);
+            node->addChild(values[0].node);
+            node->addChild(values[2].node);
+            return node;
+        case LalrAction::Declarator:
+            return makeNode(info.nodeType, makeIdentifier(values[0].token));
+        case LalrAction::ArrayDeclarator:
+            return makeNode(info.nodeType, makeNode("ArrayDeclarator"), makeIdentifier(values[0].token), values[2].node);
+        case LalrAction::FunctionDeclarator:
+            // Identifier '(' ')' 没有参数，Parser会补一个空的ParameterList
+            return makeNode(info.nodeType, makeNode("FunctionDeclarator"), makeIdentifier(values[0].token),
+                lalrRuleLength[rule] == 4 ? values[2].node : makeNode("ParameterList"));
+        case LalrAction::AppendIdentifier:
+            values[0].node->addChild(makeIdentifier(values[2].token));
+            return values[0].node;
+        case LalrAction::ParameterDeclaration:
+            return makeNode(info.nodeType, values[0].node, makeIdentifier(values[1].token));
+        case LalrAction::ForStatement:
+            node = new ASTNode(info.nodeType, values[0].token->lexeme);
+            node->addChild(values[2].node);
+            node->addChild(values[3].node);
+            node->addChild(values[4].node);
+            node->addChild(values[6].node);
+            return node;
+        case LalrAction::Cast:
+            node = makeNode(info.nodeType, makeLexeme(values[0].token), values[1].node, makeLexeme(values[2].token));
+            node->addChild(values[3].node);
+            return node;
+        case LalrAction::PrefixOp:
+            return makeNode(info.nodeType, makeLexeme(values[0].token), values[1].node);
+        case LalrAction::PostfixOp:
+            return makeNode(info.nodeType, values[0].node, makeLexeme(values[1].token));
+        case LalrAction::SizeofType:
+            node = makeNode(info.nodeType, makeLexeme(values[0].token), makeLexeme(values[1].token), values[2].node);
+            node->addChild(makeLexeme(values[3].token));
+            return node;
+        case LalrAction::Bracketed:
+            node = makeNode(info.nodeType, values[0].node, makeLexeme(values[1].token));
+            if (lalrRuleLength[rule] == 4) {
+                node->addChild(values[2].node);
+            }
+            node->addChild(makeLexeme(values[lalrRuleLength[rule] - 1].token));
+            return node;
+        case LalrAction::MemberAccess:
+            return makeNode(info.nodeType, values[0].node, makeLexeme(values[1].token), makeLexeme(values[2].token));
+        }
+        return nullptr;
+    }
+}
+
+void LalrParser::parse() {
+    // 词法错误已经达到上限时Parser不会分析任何声明，交给它处理
+    if (!diagnostics.limitReached()) {
+        ast = buildAST();
+    }
+    if (ast == nullptr) {
+        // 有语法错误或嵌套过深，由递归下降Parser负责错误恢复和报告
+        Parser parser(tokens, diagnostics);
+        parser.setNestingLimit(nestingLimit);
+        parser.parse();
+        ast = parser.getAST();
+    }
+}
+
+ASTNode* LalrParser::buildAST() {
+    ast = nullptr;
+    maxDepth = 0;
+    if (tokens.size() == 0) {
+        return nullptr;
+    }
+
+    stack.clear();
+    stack.reserve(64);
+    stack.push_back({ 0, nullptr, nullptr, 0 });
+    size_t index = 0;
+    while (true) {
+        const Token& token = tokens[index];
+        int state = stack.back().state;
+        int slot = lalrActionBase[state] + terminalOf[static_cast<size_t>(token.type)];
+        int action = lalrActionCheck[slot] == state ? lalrActionValue[slot] : lalrActionDefault[state];
+
+        if (action > 0) {
+            // 移进；EOF只会触发接受，不会被移进
+            stack.push_back({ action - 1, nullptr, &token, 0 });
+            index++;
+        }
+        else if (action < 0) {
+            int rule = -action - 1;
+            size_t length = lalrRuleLength[rule];
+            const LalrStackEntry* values = stack.data() + stack.size() - length;
+            if (rule == 0) {
+                // 接受
+                ast = values[0].node;
+                stack.clear();
+                return ast;
+            }
+            size_t nesting = reducedNesting(rule, values, length);
+            if (nesting > nestingLimit) {
+                break;
+            }
+            ASTNode* node = reduce(rule, values);
+            stack.resize(stack.size() - length);
+
+            int lhs = lalrRuleLhs[rule];
+            int from = stack.back().state;
+            int gotoSlot = lalrGotoBase[lhs] + from;
+            int target = lalrGotoCheck[gotoSlot] == lhs ? lalrGotoValue[gotoSlot] : lalrGotoDefault[lhs];
+            stack.push_back({ target, node, nullptr, nesting });
+        }
+        else {
+            break;
+        }
+        if (stack.size() > maxDepth) {
+            maxDepth = stack.size();
+        }
+    }
+    // 语法错误或嵌套过深：释放栈上已经构建的子树
+    for (LalrStackEntry& entry : stack) {
+        delete entry.node;
+    }
+    stack.clear();
+    return nullptr;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <vector>
+#include "lexer.hpp"
+#include "astParser.hpp"
+#include "diagnostics.hpp"
+
+// LALR分析栈的一项：状态以及对应符号的语义值（非终结符是子树，终结符是Token）
+// nesting是这个符号内按Parser的算法计入的嵌套层数，用于与Parser相同的嵌套上限
+struct LalrStackEntry {
+    int state;
+    ASTNode* node;
+    const Token* token;
+    size_t nesting;
+};
+
+// 表驱动的LALR(1)语法分析器，分析与递归下降Parser相同的文法并构建相同的AST
+// 分析表由LalrGen根据lalrGrammar.def离线生成，见lalrTables.inc
+// 遇到语法错误时退回递归下降Parser，错误恢复和诊断信息与默认后端完全一致
+class LalrParser {
+public:
+    LalrParser(const newVector<Token>& tokens, DiagnosticEngine& diagnostics)
+        : tokens(tokens), diagnostics(diagnostics), ast(nullptr), maxDepth(0), nestingLimit(Parser::defaultNestingLimit) {
+    }
+
+    // 嵌套层数的上限，含义和默认值与Parser::setNestingLimit相同；超过时由Parser报告错误
+    void setNestingLimit(size_t limit) {
+        nestingLimit = limit;
+    }
+
+    // 公共接口，启动语法分析；是否成功由调用者根据诊断信息报告
+    void parse();
+    // 只用分析表构建AST，不报告任何信息；有语法错误或嵌套超过上限时返回nullptr
+    ASTNode* buildAST();
+    // 获取构建的AST
+    ASTNode* getAST() const {
+        return ast;
+    }
+    // 上一次分析时分析栈的最大深度
+    size_t maxStackDepth() const {
+        return maxDepth;
+    }
+
+private:
+    const newVector<Token>& tokens;  // 词法分析器产生的标记序列
+    DiagnosticEngine& diagnostics;  // 诊断信息收集器
+    ASTNode* ast;  // 抽象语法树的根节点
+    std::vector<LalrStackEntry> stack;  // 显式分析栈，不使用递归
+    size_t maxDepth;
+    size_t nestingLimit;
+};
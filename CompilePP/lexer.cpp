@@ -1,10 +1,16 @@
 #include "Lexer.hpp"
 #include "newVector.cpp"
+#include "memoryAccounting.hpp"
 
-Lexer::Lexer(const std::string& source) : source_(source), current_(0), line_(1), column_(0) {}
+Lexer::Lexer(const std::string& source, DiagnosticEngine& diagnostics)
+    : source_(source), current_(0), start_(0), end_(source.size()), line_(1), column_(0), diagnostics_(diagnostics), batchSize_(0) {}
+
+Lexer::Lexer(const std::string& source, DiagnosticEngine& diagnostics, size_t begin, size_t end, size_t line, size_t column)
+    : source_(source), current_(begin), start_(begin), end_(end), line_(line), column_(column), diagnostics_(diagnostics), batchSize_(0) {}
 
 newVector<Token> Lexer::lex() {
     while (!is_at_end()) {
+        start_ = current_;
         char c = advance();
 
         switch (c) {
@@ -35,7 +41,7 @@ newVector<Token> Lexer::lex() {
                     // TODO: Pointer
                 	else add_token(TokenType::MULTIPLY,"*");
                 break;
-            case '/': if (match('=')) add_token(TokenType::DIVIDE_ASSIGN, " /= ");
+            case '/': if (match('=')) add_token(TokenType::DIVIDE_ASSIGN, "/=");
                     else if (match('/')) skip_comment();
 					else add_token(TokenType::DIVIDE, "/");
                 break;
@@ -48,8 +54,14 @@ newVector<Token> Lexer::lex() {
             case ':': add_token(TokenType::COLON,":"); break;
             case '=': add_token(match('=') ? std::tuple(TokenType::EQUAL,"==") : std::tuple(TokenType::ASSIGN,"=")); break;
             case '!': add_token(match('=') ? std::tuple(TokenType::NOT_EQUAL,"!=") : std::tuple(TokenType::NOT,"!")); break;
-            case '<': add_token(match('=') ? std::tuple(TokenType::LESS_THAN_OR_EQUAL_TO,"<=") : std::tuple(TokenType::LESS_THAN,"<")); break;
-            case '>': add_token(match('=') ? std::tuple(TokenType::GREATER_THAN_OR_EQUAL_TO,">=") : std::tuple(TokenType::GREATER_THAN,">")); break;
+            case '<': if (match('=')) add_token(TokenType::LESS_THAN_OR_EQUAL_TO,"<=");
+                    else if (match('<')) add_token(TokenType::SHIFT_LEFT,"<<");
+                    else add_token(TokenType::LESS_THAN,"<");
+                    break;
+            case '>': if (match('=')) add_token(TokenType::GREATER_THAN_OR_EQUAL_TO,">=");
+                    else if (match('>')) add_token(TokenType::SHIFT_RIGHT,">>");
+                    else add_token(TokenType::GREATER_THAN,">");
+                    break;
 
             // Whitespace
             case ' ':
@@ -73,18 +85,34 @@ newVector<Token> Lexer::lex() {
                 } else if (is_alpha(c)) {
                     identifier();
                 } else {
-                    std::cerr << "Unexpected character: " << c << " at line " << line_ << ", column " << column_ << "\n";
+                    error("L001", std::string("Unexpected character: ") + c);
                 }
                 break;
         }
     }
 
-    tokens_.push_back({ TokenType::END_OF_FILE, "EOF", line_, column_ });
+    tokens_.push_back({ TokenType::END_OF_FILE, "EOF", line_, column_, end_ });
+    if (sink_) {
+        flush_tokens();
+    }
     return tokens_;
 }
 
+void Lexer::set_token_sink(std::function<void(newVector<Token>&)> sink, size_t batchSize) {
+    sink_ = std::move(sink);
+    batchSize_ = batchSize == 0 ? 1 : batchSize;
+    tokens_.reserve(batchSize_);
+}
+
+void Lexer::flush_tokens() {
+    sink_(tokens_);
+    // sink通常会把整批Token移走，这里重新预留一批的空间
+    tokens_.clear();
+    tokens_.reserve(batchSize_);
+}
+
 bool Lexer::is_at_end() const {
-    return current_ >= source_.size();
+    return current_ >= end_;
 }
 
 char Lexer::advance() {
@@ -109,7 +137,11 @@ void Lexer::add_token(std::tuple<TokenType,std::string> TokenTuple) {
 
 void Lexer::add_token(TokenType type, const std::string& lexeme) {
     // TODO: 太长的StringLiteral导致line_错误, column_为负数
-    tokens_.push_back({ type, lexeme, line_, column_ - lexeme.size() + 1 });
+    AllocationScope site(AllocationSite::TokenLexeme);
+    tokens_.push_back({ type, lexeme, line_, column_ - lexeme.size() + 1, start_ });
+    if (sink_ && tokens_.size() >= batchSize_) {
+        flush_tokens();
+    }
 }
 // void Lexer::add_token(TokenType type, double value){
 //     tokens_.push_back({ type, value, line_, column_ - lexeme.size() });
@@ -183,6 +215,12 @@ void Lexer::identifier() {
     else if (lexeme == "return") {
         type = TokenType::RETURN;
     } 
+    else if (lexeme == "break") {
+        type = TokenType::BREAK;
+    }
+    else if (lexeme == "continue") {
+        type = TokenType::CONTINUE;
+    }
     else if (lexeme == "int") {
         type = TokenType::INTEGER;
     }
@@ -216,7 +254,7 @@ void Lexer::string_literal() {
     }
 
     if (is_at_end()) {
-        std::cerr << "Unterminated string literal at line " << line_ << ", column " << column_ << "\n";
+        error("L002", "Unterminated string literal.");
         return;
     }
 
@@ -229,7 +267,7 @@ char Lexer::peek() const {
 }
 
 char Lexer::peek_next() const {
-    return current_ + 1 >= source_.size() ? '\0' : source_[current_ + 1];
+    return current_ + 1 >= end_ ? '\0' : source_[current_ + 1];
 }
 
 void Lexer::skip_whitespace(){
@@ -243,7 +281,10 @@ void Lexer::skip_comment(){
     }
 }
 
-void Lexer::error(const std::string& message) {
-    std::cerr << message << "\n";
-    exit(1);
+void Lexer::error(const std::string& code, const std::string& message, Severity severity) {
+    diagnostics_.report(severity, code, { line_, column_, line_, column_ + 1 }, message);
+    if (severity == Severity::Fatal) {
+        // 不再直接exit，跳到输入末尾结束分析，由调用方统一输出诊断
+        current_ = end_;
+    }
 }
\ No newline at end of file
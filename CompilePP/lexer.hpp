@@ -3,12 +3,14 @@
 #include <vector>
 #include <cctype>
 #include <string>
+#include <functional>
 #include "newVector.hpp"
 #include "astParser.hpp"
+#include "diagnostics.hpp"
 
 enum class TokenType {
     // Keywords
-    IF, ELSE, WHILE, FOR, RETURN, //BREAK, CONTINUE, SWITCH, CASE, DEFAULT, DO, GOTO, CONST, STATIC, EXTERN, SIZEOF, TYPEDEF, //STRUCT, UNION, ENUM, VOID, CHAR, SHORT, INT, LONG, FLOAT, DOUBLE, SIGNED, UNSIGNED, AUTO, REGISTER, VOLATILE, INLINE, RESTRICT, BOOL, COMPLEX, IMAGINARY, ATOMIC, THREAD_LOCAL,
+    IF, ELSE, WHILE, FOR, RETURN, BREAK, CONTINUE, //SWITCH, CASE, DEFAULT, DO, GOTO, CONST, STATIC, EXTERN, SIZEOF, TYPEDEF, //STRUCT, UNION, ENUM, VOID, CHAR, SHORT, INT, LONG, FLOAT, DOUBLE, SIGNED, UNSIGNED, AUTO, REGISTER, VOLATILE, INLINE, RESTRICT, BOOL, COMPLEX, IMAGINARY, ATOMIC, THREAD_LOCAL,
 
     // Operators
     PLUS, MINUS, MULTIPLY, DIVIDE, MODULO, NOT, SIZEOF, ASSIGN, EQUAL, NOT_EQUAL, LESS_THAN, GREATER_THAN,
@@ -38,6 +40,7 @@ struct Token {
     std::string lexeme;     // 词法单元的字符串值
     size_t line;               // 词法单元所在行号
     size_t column;             // 词法单元所在列号
+    size_t offset;             // 词法单元在源码中的起始偏移
     ~Token() {
         if (!lexeme.empty()) {
             lexeme.clear();
@@ -51,13 +54,22 @@ public:
     newVector<Token> tokens_;
     size_t current_;
     size_t start_;
+    size_t end_;
     size_t line_;
     size_t column_;
+    DiagnosticEngine& diagnostics_;
+    std::function<void(newVector<Token>&)> sink_;
+    size_t batchSize_;
 
-    Lexer(const std::string& source);
+    Lexer(const std::string& source, DiagnosticEngine& diagnostics);
+    // 只分析源码的 [begin, end) 部分，line/column为begin处的行号和列号状态，用于增量分析
+    Lexer(const std::string& source, DiagnosticEngine& diagnostics, size_t begin, size_t end, size_t line, size_t column);
 
     newVector<Token> lex();
 
+    // 流水线模式：每攒够batchSize个Token就交给sink，lex()返回时全部Token（含EOF）都已交出
+    void set_token_sink(std::function<void(newVector<Token>&)> sink, size_t batchSize);
+
 private:
     bool is_at_end() const;
     bool is_digit(char c) const;
@@ -73,13 +85,15 @@ private:
     void skip_comment();
     void add_token(std::tuple<TokenType,std::string>);
     void add_token(TokenType type, const std::string& lexeme);
+    void flush_tokens();
     // void add_token(TokenType type, double value);
     // void add_token(TokenType type, int value);
     // void add_token(TokenType type, const std::string& lexeme, double value);
     // void add_token(TokenType type, const std::string& lexeme, int value);
     // void add_token(TokenType type, const std::string& lexeme, char value);
     // void add_token(TokenType type, const std::string& lexeme, const std::string& value);
-    void error(const std::string& message);
+    // 记录诊断信息；Fatal级别会终止本次词法分析
+    void error(const std::string& code, const std::string& message, Severity severity = Severity::Error);
 
 
 };
\ No newline at end of file
@@ -1,79 +1,50 @@
 #include <iostream>
-#include <filesystem>
-#include <fstream>
-#include <sstream>
 #include <string>
-#include "lexer.hpp"
-#include "newVector.hpp"
-#include "newVector.cpp"
+#include <vector>
+#include "driver.hpp"
+#include "compileServer.hpp"
 // Cpp 20 Standard
 // Cpp Source File Encoding: UTF-8 (with BOM)
 // BNF 参考自 https://blog.csdn.net/Alexabc3000/article/details/126789474
-void printASTNode(ASTNode* node, int indent = 0) {
-    if (node == nullptr) {
-        return;
-    }
-
-    // 打印缩进
-    for (int i = 0; i < indent; ++i) {
-        std::cout << "  ";
-    }
-
-    // 打印节点类型和值
-    std::cout << node->type << ": " << node->value << std::endl;
-
-    // 打印子节点
-    for (auto child : node->children) {
-        printASTNode(child, indent + 1);
-    }
-}
 int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <file_path>\n";
-        return 1;
-    }
-
-    std::filesystem::path file_path(argv[1]);
-    if (!std::filesystem::exists(file_path)) {
-        std::cerr << "File not found: " << file_path << "\n";
-        return 1;
-    }
-
-    file_path = std::filesystem::absolute(file_path);
-
-    std::cout << "Reading file: " << file_path << "\n";
-
-    //Read file contents
-    std::ifstream file_stream(file_path);
-    if (!file_stream.is_open()) {
-        std::cerr << "Failed to open file: " << file_path << "\n";
+    // 命令行参数：<file_path>... | @FILE [--diagnostics-format=text|json] [--error-limit=N] [--parse-threads=N] [--max-nesting=N] [--pipeline] [--parser=rd|lalr] [--output=none|tokens|ast|text|json|binary] [--output-file=FILE] [--bench-parsers[=N]] [--bench-visitors[=N]] [--fold] [--resolve] [--typecheck] [--run[=ast|vm|jit]] [--jit-threshold=N] [--dump-bytecode] [--emit-ir] [--optimize] [--time-passes] [--time-report] [--mem-report] [--profile-parser] [--verify-ir] [--emit-asm[=FILE]] [--compile=EXE] [--codegen=linear|stack] [-j N] [--bench-interp[=N]] [--bench-aot[=N]] [--bench-workload[=N]] [--generate-workload] [--workload-seed=N] [--workload-size=BYTES] [--workload-depth=N] [--workload-expr=N] [--workload-comments=P] [--workload-idents=N] [--bench-scaling[=N]] [--scaling-margin=X] [--bench-incremental[=N]]
+    // 编译服务器：--serve=SOCKET [-j N] 启动服务器，--stop-server=SOCKET 停止它，
+    // --client=SOCKET 之后的参数原样转发给服务器，效果与直接运行相同
+    std::vector<std::string> args(argv + 1, argv + argc);
+    if (!args.empty() && args.front().rfind("--client=", 0) == 0) {
+        std::string socketPath = args.front().substr(9);
+        args.erase(args.begin());
+        return runCompileClient(socketPath, args, std::cout, std::cerr);
+    }
+    if (!args.empty() && args.front().rfind("--stop-server=", 0) == 0) {
+        return stopCompileServer(args.front().substr(14), std::cerr);
+    }
+    if (!args.empty() && args.front().rfind("--serve=", 0) == 0) {
+        std::string socketPath = args.front().substr(8);
+        args.erase(args.begin());
+        // 服务器只接受线程数，其余选项由每个请求自己给出
+        size_t jobs = 0;
+        if (args.size() == 2 && args[0] == "-j") {
+            if (!parseFlagValue("-j", args[1], jobs, std::cerr)) {
+                return 1;
+            }
+        }
+        else if (args.size() == 1 && args[0].rfind("-j", 0) == 0 && args[0].size() > 2) {
+            if (!parseFlagValue("-j", args[0].substr(2), jobs, std::cerr)) {
+                return 1;
+            }
+        }
+        else if (!args.empty()) {
+            std::cerr << "--serve only accepts -j N\n";
+            return 1;
+        }
+        return runCompileServer(socketPath, jobs, std::cout);
+    }
+
+    CommandLine commandLine;
+    commandLine.programName = argv[0];
+    if (!parseCommandLine(args, "", commandLine, std::cerr)) {
         return 1;
     }
-
-    std::stringstream buffer;
-    buffer << file_stream.rdbuf();
-    std::string file_contents = buffer.str();
-
-    Lexer lexer(file_contents);
-    newVector<Token> tokens = lexer.lex();
-
-    for (const Token& token : tokens) {
-        std::cout << "Token: " << static_cast<int>(token.type) << ", Lexeme: " << token.lexeme << ", Line: " << token.line << ", Column: " << token.column << "\n";
-    }
-    // 创建Parser对象并启动语法分析
-    Parser parser(tokens);
-    parser.parse();
-
-    // 获取构建的AST
-    ASTNode* ast = parser.getAST();
-    if (ast != nullptr) {
-        // 打印AST或执行其他操作
-        std::cout << "AST constructed." << std::endl;
-        printASTNode(ast);
-    }
-
-    // 释放AST内存
-    delete ast;
-
-    return 0;
-}
\ No newline at end of file
+    return runCommandLine(commandLine, std::cout, std::cerr);
+}
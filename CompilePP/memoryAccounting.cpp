@@ -0,0 +1,152 @@
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include "memoryAccounting.hpp"
+
+#if defined(__APPLE__)
+#include <malloc/malloc.h>
+#define USABLE_SIZE(memory) malloc_size(memory)
+#elif defined(_WIN32)
+#include <malloc.h>
+#define USABLE_SIZE(memory) _msize(memory)
+#elif defined(__GLIBC__)
+#include <malloc.h>
+#define USABLE_SIZE(memory) malloc_usable_size(memory)
+#endif
+
+thread_local constinit AllocationSite currentAllocationSite = AllocationSite::Other;
+constinit std::atomic<bool> memoryAccountingFlag{ false };
+
+namespace {
+    std::mutex enableMutex;
+    size_t enableCount = 0;
+    std::atomic<uint64_t> allocations{ 0 };
+    std::atomic<uint64_t> allocatedBytes{ 0 };
+    std::atomic<int64_t> liveBytes{ 0 };
+    std::atomic<int64_t> peakBytes{ 0 };
+    std::atomic<uint64_t> siteAllocations[static_cast<size_t>(AllocationSite::Count)];
+    std::atomic<uint64_t> siteBytes[static_cast<size_t>(AllocationSite::Count)];
+
+    void raisePeak(int64_t value) {
+        int64_t peak = peakBytes.load(std::memory_order_relaxed);
+        while (value > peak && !peakBytes.compare_exchange_weak(peak, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    // 没有办法得到块大小的平台上按请求的大小计，释放时不计
+    void recordAllocation(void* memory, size_t size) {
+#ifdef USABLE_SIZE
+        size = USABLE_SIZE(memory);
+#else
+        (void)memory;
+#endif
+        size_t site = static_cast<size_t>(currentAllocationSite);
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+        siteAllocations[site].fetch_add(1, std::memory_order_relaxed);
+        siteBytes[site].fetch_add(size, std::memory_order_relaxed);
+        raisePeak(liveBytes.fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed) + static_cast<int64_t>(size));
+    }
+
+    void recordFree(void* memory) {
+#ifdef USABLE_SIZE
+        liveBytes.fetch_sub(static_cast<int64_t>(USABLE_SIZE(memory)), std::memory_order_relaxed);
+#else
+        (void)memory;
+#endif
+    }
+
+    void* allocate(size_t size) {
+        if (size == 0) {
+            size = 1;
+        }
+        for (;;) {
+            if (void* memory = std::malloc(size)) {
+                if (memoryAccountingEnabled()) {
+                    recordAllocation(memory, size);
+                }
+                return memory;
+            }
+            std::new_handler handler = std::get_new_handler();
+            if (handler == nullptr) {
+                throw std::bad_alloc();
+            }
+            handler();
+        }
+    }
+
+    void release(void* memory) {
+        if (memory != nullptr && memoryAccountingEnabled()) {
+            recordFree(memory);
+        }
+        std::free(memory);
+    }
+}
+
+// 替换全局的operator new/delete，分配本身仍交给malloc
+void* operator new(std::size_t size) {
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size) {
+    return allocate(size);
+}
+
+void operator delete(void* memory) noexcept {
+    release(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    release(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    release(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    release(memory);
+}
+
+const char* allocationSiteName(AllocationSite site) {
+    static const char* const names[] = { "Other", "Source text", "Token lexemes", "newVector growth", "AST nodes", "AST child arrays" };
+    static_assert(sizeof(names) / sizeof(names[0]) == static_cast<size_t>(AllocationSite::Count), "allocation site names are out of date");
+    return names[static_cast<size_t>(site)];
+}
+
+void setMemoryAccounting(bool on) {
+    std::lock_guard<std::mutex> lock(enableMutex);
+    if (on) {
+        enableCount++;
+    }
+    else if (enableCount != 0) {
+        enableCount--;
+    }
+    memoryAccountingFlag.store(enableCount != 0, std::memory_order_relaxed);
+}
+
+MemoryCounters memoryCounters() {
+    MemoryCounters counters;
+    counters.allocations = allocations.load(std::memory_order_relaxed);
+    counters.bytes = allocatedBytes.load(std::memory_order_relaxed);
+    counters.liveBytes = liveBytes.load(std::memory_order_relaxed);
+    return counters;
+}
+
+SiteCounters siteCounters(AllocationSite site) {
+    size_t index = static_cast<size_t>(site);
+    return SiteCounters{ siteAllocations[index].load(std::memory_order_relaxed), siteBytes[index].load(std::memory_order_relaxed) };
+}
+
+int64_t resetPeakLiveBytes() {
+    return peakBytes.exchange(liveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+int64_t peakLiveBytes() {
+    return peakBytes.load(std::memory_order_relaxed);
+}
+
+void raisePeakLiveBytes(int64_t value) {
+    raisePeak(value);
+}
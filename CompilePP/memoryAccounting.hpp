@@ -0,0 +1,76 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// 内存统计（--mem-report）：全局的operator new/delete在打开统计时记录分配次数、字节数和存活字节数的峰值，
+// 字节数按分配器实际给出的块大小计算。关闭时只多一次原子标志的读取。
+// 统计是整个进程的，多个线程同时编译时各阶段的数字包含其他线程的分配
+
+// 分配点：热点代码用AllocationScope标记接下来的分配属于哪一类，未标记的记为Other
+enum class AllocationSite : uint8_t {
+    Other,
+    SourceText,     // 读入的源码
+    TokenLexeme,    // Token的lexeme字符串
+    VectorGrowth,   // newVector扩容
+    AstNode,        // ASTNode对象和它的type、value字符串
+    AstChildren,    // ASTNode的子节点数组
+    Count
+};
+
+const char* allocationSiteName(AllocationSite site);
+
+// 当前线程正在进行的分配属于哪个分配点；常量初始化，访问时不经过线程局部变量的包装函数
+extern thread_local constinit AllocationSite currentAllocationSite;
+
+// 统计是否打开，由setMemoryAccounting维护；放在头文件里是为了让下面的检查内联成一次普通的读取
+extern std::atomic<bool> memoryAccountingFlag;
+
+inline bool memoryAccountingEnabled() {
+    return memoryAccountingFlag.load(std::memory_order_relaxed);
+}
+
+// 作用域内当前线程的分配记到site，可以嵌套；统计关闭时不写线程局部变量
+class AllocationScope {
+public:
+    explicit AllocationScope(AllocationSite site) : active_(memoryAccountingEnabled()), previous_(AllocationSite::Other) {
+        if (active_) {
+            previous_ = currentAllocationSite;
+            currentAllocationSite = site;
+        }
+    }
+    ~AllocationScope() {
+        if (active_) {
+            currentAllocationSite = previous_;
+        }
+    }
+
+    AllocationScope(const AllocationScope&) = delete;
+    AllocationScope& operator=(const AllocationScope&) = delete;
+
+private:
+    bool active_;
+    AllocationSite previous_;
+};
+
+struct MemoryCounters {
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;         // 分配的字节数
+    int64_t liveBytes = 0;      // 打开统计之前分配、之后释放的内存会让它偏小
+};
+
+struct SiteCounters {
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+};
+
+// 打开和关闭按次数配对，最后一次关闭才真正停止统计，并发的请求不会关掉彼此的统计
+void setMemoryAccounting(bool enabled);
+MemoryCounters memoryCounters();
+SiteCounters siteCounters(AllocationSite site);
+
+// 把存活字节数的峰值重置为当前值并返回原来的峰值，用于测量一段代码内的峰值
+int64_t resetPeakLiveBytes();
+int64_t peakLiveBytes();
+// 峰值至少为value，与resetPeakLiveBytes配对恢复外层的峰值
+void raisePeakLiveBytes(int64_t value);
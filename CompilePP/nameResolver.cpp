@@ -0,0 +1,277 @@
+#include <cctype>
+#include "nameResolver.hpp"
+
+namespace {
+    // PrimaryExpression的值既可能是标识符也可能是常量
+    bool isIdentifier(const std::string& text) {
+        return !text.empty() && (std::isalpha(static_cast<unsigned char>(text[0])) || text[0] == '_');
+    }
+
+    const ASTNode* childAt(const ASTNode* node, size_t index) {
+        return node != nullptr && index < node->children.size() ? node->children[index] : nullptr;
+    }
+}
+
+NameResolver::NameResolver()
+    : globalCount_(0), functionCount_(0), nextSlot_(0), frameSize_(0), depth_(0), tooDeep_(nullptr) {
+}
+
+void NameResolver::resolve(const ASTNode* root) {
+    visit(root);
+}
+
+const Symbol* NameResolver::bindingOf(const ASTNode* use) const {
+    uint32_t symbol = bindings_.find(use);
+    return symbol == NodeMap::npos ? nullptr : &symbols_[symbol];
+}
+
+const Symbol* NameResolver::declarationOf(const ASTNode* identifier) const {
+    uint32_t symbol = declarations_.find(identifier);
+    return symbol == NodeMap::npos ? nullptr : &symbols_[symbol];
+}
+
+const StringInterner& NameResolver::names() const {
+    return names_;
+}
+
+const std::vector<Symbol>& NameResolver::symbols() const {
+    return symbols_;
+}
+
+size_t NameResolver::bindingCount() const {
+    return bindings_.size();
+}
+
+const std::vector<const ASTNode*>& NameResolver::unresolved() const {
+    return unresolved_;
+}
+
+const std::vector<Redeclaration>& NameResolver::redeclarations() const {
+    return redeclarations_;
+}
+
+const ASTNode* NameResolver::tooDeep() const {
+    return tooDeep_;
+}
+
+uint32_t NameResolver::globalCount() const {
+    return globalCount_;
+}
+
+uint32_t NameResolver::functionCount() const {
+    return functionCount_;
+}
+
+void NameResolver::visit(const ASTNode* node) {
+    if (node == nullptr) {
+        return;
+    }
+    // 超过上限的子树不再深入，递归的层数与AST的深度相同
+    if (depth_ >= astDepthLimit) {
+        if (tooDeep_ == nullptr) {
+            tooDeep_ = node;
+        }
+        return;
+    }
+    depth_++;
+    visitNode(node);
+    depth_--;
+}
+
+void NameResolver::visitNode(const ASTNode* node) {
+    // 绝大多数节点都不是这里关心的类型，先按长度分流，避免逐个比较字符串
+    const std::string& type = node->type;
+    switch (type.size()) {
+    case 15:
+        if (type == "DeclarationNode") {
+            visitDeclaration(node);
+            return;
+        }
+        break;
+    case 17:
+        if (type == "PrimaryExpression") {
+            resolveUse(node);
+            return;
+        }
+        if (type == "CompoundStatement") {
+            enterScope();
+            visitChildren(node);
+            leaveScope();
+            return;
+        }
+        break;
+    case 18:
+        if (type == "SelectionStatement" || type == "IterationStatement") {
+            enterScope();
+            visitChildren(node);
+            leaveScope();
+            return;
+        }
+        break;
+    case 22:
+        if (type == "FunctionDefinitionNode") {
+            visitFunctionDefinition(node);
+            return;
+        }
+        break;
+    }
+    visitChildren(node);
+}
+
+void NameResolver::visitChildren(const ASTNode* node) {
+    for (const ASTNode* child : node->children) {
+        visit(child);
+    }
+}
+
+// FunctionDefinitionNode: TypeSpecifier DirectDeclarator CompoundStatement
+void NameResolver::visitFunctionDefinition(const ASTNode* node) {
+    const ASTNode* type = childAt(node, 0);
+    const ASTNode* declarator = childAt(node, 1);
+    const ASTNode* body = childAt(node, 2);
+
+    // 先声明函数名，函数体内可以递归调用
+    uint32_t function = declareDirectDeclarator(declarator, type, node);
+
+    nextSlot_ = 0;
+    frameSize_ = 0;
+    enterScope();
+    // DirectDeclarator: FunctionDeclarator Identifier ParameterList
+    if (childAt(declarator, 0) != nullptr && declarator->children[0]->type == "FunctionDeclarator") {
+        const ASTNode* parameters = childAt(declarator, 2);
+        if (parameters != nullptr) {
+            for (const ASTNode* parameter : parameters->children) {
+                // ParameterDeclaration: TypeSpecifier Identifier
+                const ASTNode* identifier = childAt(parameter, 1);
+                if (identifier != nullptr) {
+                    declare(identifier, SymbolKind::Parameter, childAt(parameter, 0), nullptr);
+                }
+            }
+        }
+    }
+    // 函数体的最外层与参数同属一个作用域
+    if (body != nullptr) {
+        visitChildren(body);
+    }
+    leaveScope();
+
+    if (function != SymbolTable::npos) {
+        symbols_[function].frameSize = frameSize_;
+    }
+}
+
+// DeclarationNode: TypeSpecifier InitDeclaratorList
+void NameResolver::visitDeclaration(const ASTNode* node) {
+    const ASTNode* type = childAt(node, 0);
+    const ASTNode* list = childAt(node, 1);
+    if (list == nullptr) {
+        return;
+    }
+    for (const ASTNode* initDeclarator : list->children) {
+        // InitDeclarator: DirectDeclarator initializer?
+        declareDirectDeclarator(childAt(initDeclarator, 0), type, nullptr);
+        // 名字从声明符结束处开始可见，初始化表达式里已经可以引用它
+        visit(childAt(initDeclarator, 1));
+    }
+}
+
+// 声明DirectDeclarator中的所有名字，返回第一个名字对应的符号
+// DirectDeclarator: Identifier
+//                 | ArrayDeclarator Identifier constant_expression
+//                 | FunctionDeclarator Identifier ParameterList
+// 后面可能还跟着逗号分隔的若干Identifier
+uint32_t NameResolver::declareDirectDeclarator(const ASTNode* declarator, const ASTNode* type, const ASTNode* definition) {
+    if (declarator == nullptr || declarator->children.empty() || declarator->children[0] == nullptr) {
+        return SymbolTable::npos;
+    }
+    const std::string& marker = declarator->children[0]->type;
+    uint32_t first = SymbolTable::npos;
+    size_t next = 0;
+    if (marker == "ArrayDeclarator") {
+        // 数组长度在名字可见之前求值
+        visit(childAt(declarator, 2));
+        first = declare(childAt(declarator, 1), SymbolKind::Array, type, nullptr);
+        next = 3;
+    }
+    else if (marker == "FunctionDeclarator") {
+        // 函数原型的参数属于原型作用域，对外不可见，不需要声明
+        first = declare(childAt(declarator, 1), SymbolKind::Function, type, definition);
+        next = 3;
+    }
+    for (size_t i = next; i < declarator->children.size(); i++) {
+        uint32_t symbol = declare(declarator->children[i], SymbolKind::Variable, type, nullptr);
+        if (first == SymbolTable::npos) {
+            first = symbol;
+        }
+    }
+    return first;
+}
+
+uint32_t NameResolver::declare(const ASTNode* identifier, SymbolKind kind, const ASTNode* type, const ASTNode* definition) {
+    if (identifier == nullptr || !isIdentifier(identifier->value)) {
+        return SymbolTable::npos;
+    }
+    uint32_t name = names_.intern(identifier->value);
+    uint32_t symbol = static_cast<uint32_t>(symbols_.size());
+    uint32_t existing = scopes_.declare(name, symbol);
+    if (existing != SymbolTable::npos) {
+        Symbol& previous = symbols_[existing];
+        // 文件作用域内同类实体的重复声明（函数原型、暂定定义）指向同一个符号，
+        // 只有同一个函数被定义两次才算冲突
+        if (previous.depth == 0 && previous.kind == kind && (definition == nullptr || previous.definition == nullptr)) {
+            if (definition != nullptr) {
+                previous.definition = definition;
+            }
+        }
+        else {
+            redeclarations_.push_back({ identifier, existing });
+        }
+        declarations_.insert(identifier, existing);
+        return existing;
+    }
+
+    uint32_t depth = scopes_.depth();
+    uint32_t slot;
+    if (kind == SymbolKind::Function) {
+        slot = functionCount_++;
+    }
+    else if (depth == 0) {
+        slot = globalCount_++;
+    }
+    else {
+        slot = nextSlot_++;
+        if (nextSlot_ > frameSize_) {
+            frameSize_ = nextSlot_;
+        }
+    }
+    symbols_.push_back({ name, kind, depth, slot, 0, type, identifier, definition });
+    declarations_.insert(identifier, symbol);
+    return symbol;
+}
+
+void NameResolver::resolveUse(const ASTNode* node) {
+    if (!isIdentifier(node->value)) {
+        return;
+    }
+    // 驻留表里没有的名字一定没有被声明过
+    uint32_t name = names_.find(node->value);
+    uint32_t symbol = name == StringInterner::npos ? SymbolTable::npos : scopes_.lookup(name);
+    if (symbol == SymbolTable::npos) {
+        unresolved_.push_back(node);
+    }
+    else {
+        bindings_.insert(node, symbol);
+    }
+}
+
+void NameResolver::enterScope() {
+    scopes_.pushScope();
+    slotMarks_.push_back(nextSlot_);
+}
+
+void NameResolver::leaveScope() {
+    scopes_.popScope();
+    // 兄弟作用域复用已经退出的作用域的槽位
+    nextSlot_ = slotMarks_.back();
+    slotMarks_.pop_back();
+}
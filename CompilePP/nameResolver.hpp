@@ -0,0 +1,88 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "ast.hpp"
+#include "interner.hpp"
+#include "nodeMap.hpp"
+#include "symbolTable.hpp"
+
+enum class SymbolKind
+{
+    Variable, Array, Function, Parameter
+};
+
+// 一个被声明的实体
+struct Symbol {
+    uint32_t name;                // 标识符在驻留表中的编号
+    SymbolKind kind;
+    uint32_t depth;               // 声明所在的作用域深度，0为文件作用域
+    // 文件作用域的变量按声明顺序编号，函数单独按声明顺序编号；
+    // 局部变量和参数是所在函数栈帧中的槽位，兄弟作用域的槽位可以复用
+    uint32_t slot;
+    uint32_t frameSize;           // 函数栈帧需要的槽位数，只对有定义的函数有效
+    const ASTNode* type;          // TypeSpecifier节点
+    const ASTNode* declarator;    // 第一次声明该名字的Identifier节点
+    const ASTNode* definition;    // 函数的FunctionDefinitionNode，其余为nullptr
+};
+
+// 同一作用域内的重复声明
+struct Redeclaration {
+    const ASTNode* declarator;    // 重复声明的Identifier节点
+    uint32_t previous;            // 已有的符号
+};
+
+// 名字解析：在语法分析之后遍历AST，为每个标识符使用处（PrimaryExpression）找到它的声明
+// 作用域与CompoundStatement、函数体以及if/while/for语句对应，函数参数和函数体共享同一个作用域
+// 结果保存在以节点地址为键的旁路表中，AST本身不做修改
+class NameResolver {
+public:
+    NameResolver();
+
+    NameResolver(const NameResolver&) = delete;
+    NameResolver& operator=(const NameResolver&) = delete;
+
+    void resolve(const ASTNode* root);
+
+    // 使用处绑定的符号，未解析或不是标识符时返回nullptr
+    const Symbol* bindingOf(const ASTNode* use) const;
+    // 声明处的Identifier节点声明的符号，重复声明返回已有的符号
+    const Symbol* declarationOf(const ASTNode* identifier) const;
+
+    const StringInterner& names() const;
+    const std::vector<Symbol>& symbols() const;
+    size_t bindingCount() const;
+    const std::vector<const ASTNode*>& unresolved() const;
+    const std::vector<Redeclaration>& redeclarations() const;
+    // 深度超过astDepthLimit的第一个节点，它的子树没有解析；之后的各阶段据此拒绝这个程序
+    const ASTNode* tooDeep() const;
+    uint32_t globalCount() const;
+    uint32_t functionCount() const;
+
+private:
+    StringInterner names_;
+    SymbolTable scopes_;
+    std::vector<Symbol> symbols_;
+    NodeMap bindings_;        // 使用处 -> 符号编号
+    NodeMap declarations_;    // 声明处的Identifier -> 符号编号
+    std::vector<const ASTNode*> unresolved_;
+    std::vector<Redeclaration> redeclarations_;
+    uint32_t globalCount_;
+    uint32_t functionCount_;
+    // 当前函数的槽位分配状态
+    uint32_t nextSlot_;
+    uint32_t frameSize_;
+    std::vector<uint32_t> slotMarks_;
+    size_t depth_;
+    const ASTNode* tooDeep_;
+
+    void visit(const ASTNode* node);
+    void visitNode(const ASTNode* node);
+    void visitChildren(const ASTNode* node);
+    void visitFunctionDefinition(const ASTNode* node);
+    void visitDeclaration(const ASTNode* node);
+    uint32_t declareDirectDeclarator(const ASTNode* declarator, const ASTNode* type, const ASTNode* definition);
+    uint32_t declare(const ASTNode* identifier, SymbolKind kind, const ASTNode* type, const ASTNode* definition);
+    void resolveUse(const ASTNode* node);
+    void enterScope();
+    void leaveScope();
+};
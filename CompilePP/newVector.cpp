@@ -1,8 +1,49 @@
 #include "newVector.hpp"
+#include "memoryAccounting.hpp"
 
 template <typename T>
 newVector<T>::newVector() : size_(0), capacity_(0), data_(nullptr) {}
 
+template <typename T>
+newVector<T>::newVector(const newVector& other) : size_(0), capacity_(0), data_(nullptr) {
+    reserve(other.size_);
+    for (size_t i = 0; i < other.size_; i++) {
+        new (data_ + i) T(other.data_[i]);
+    }
+    size_ = other.size_;
+}
+
+template <typename T>
+newVector<T>::newVector(newVector&& other) noexcept : size_(other.size_), capacity_(other.capacity_), data_(other.data_) {
+    other.size_ = 0;
+    other.capacity_ = 0;
+    other.data_ = nullptr;
+}
+
+template <typename T>
+newVector<T>& newVector<T>::operator=(const newVector& other) {
+    if (this != &other) {
+        newVector copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+template <typename T>
+newVector<T>& newVector<T>::operator=(newVector&& other) noexcept {
+    if (this != &other) {
+        clear();
+        operator delete(data_);
+        size_ = other.size_;
+        capacity_ = other.capacity_;
+        data_ = other.data_;
+        other.size_ = 0;
+        other.capacity_ = 0;
+        other.data_ = nullptr;
+    }
+    return *this;
+}
+
 template <typename T>
 newVector<T>::~newVector() {
     clear();
@@ -19,6 +60,16 @@ void newVector<T>::push_back(const T& value) {
     size_++;
 }
 
+template <typename T>
+void newVector<T>::push_back(T&& value) {
+    if (size_ == capacity_) {
+        reserve(capacity_ == 0 ? 1 : capacity_ * 2);
+    }
+
+    new (data_ + size_) T(std::move(value));
+    size_++;
+}
+
 template <typename T>
 void newVector<T>::pop_back() {
     if (size_ > 0) {
@@ -39,7 +90,11 @@ void newVector<T>::clear() {
 template <typename T>
 void newVector<T>::reserve(size_t new_capacity) {
     if (new_capacity > capacity_) {
-        T* new_data = static_cast<T*>(operator new(new_capacity * sizeof(T)));
+        T* new_data;
+        {
+            AllocationScope site(AllocationSite::VectorGrowth);
+            new_data = static_cast<T*>(operator new(new_capacity * sizeof(T)));
+        }
 
         for (size_t i = 0; i < size_; i++) {
             new (new_data + i) T(std::move(data_[i]));
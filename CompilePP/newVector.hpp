@@ -5,10 +5,20 @@ class newVector {
 public:
     newVector();
 
+    newVector(const newVector& other);
+
+    newVector(newVector&& other) noexcept;
+
+    newVector& operator=(const newVector& other);
+
+    newVector& operator=(newVector&& other) noexcept;
+
     ~newVector();
 
     void push_back(const T& value);
 
+    void push_back(T&& value);
+
     void pop_back();
 
     void clear();
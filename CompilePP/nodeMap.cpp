@@ -0,0 +1,46 @@
+#include "nodeMap.hpp"
+
+NodeMap::NodeMap() : slots_(64, { nullptr, 0 }), mask_(63), size_(0) {
+}
+
+size_t NodeMap::indexOf(const ASTNode* node) const {
+    // 节点地址的低位总是0，乘法散列把高位混合进来
+    uint64_t key = reinterpret_cast<uintptr_t>(node);
+    size_t position = static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & mask_;
+    while (slots_[position].node != nullptr && slots_[position].node != node) {
+        position = (position + 1) & mask_;
+    }
+    return position;
+}
+
+void NodeMap::insert(const ASTNode* node, uint32_t value) {
+    if ((size_ + 1) * 2 > slots_.size()) {
+        grow();
+    }
+    size_t position = indexOf(node);
+    if (slots_[position].node == nullptr) {
+        size_++;
+    }
+    slots_[position] = { node, value };
+}
+
+uint32_t NodeMap::find(const ASTNode* node) const {
+    const Slot& slot = slots_[indexOf(node)];
+    return slot.node == nullptr ? npos : slot.value;
+}
+
+size_t NodeMap::size() const {
+    return size_;
+}
+
+void NodeMap::grow() {
+    std::vector<Slot> old;
+    old.swap(slots_);
+    slots_.assign(old.size() * 2, { nullptr, 0 });
+    mask_ = slots_.size() - 1;
+    for (const Slot& slot : old) {
+        if (slot.node != nullptr) {
+            slots_[indexOf(slot.node)] = slot;
+        }
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "ast.hpp"
+
+// 以AST节点地址为键、32位整数为值的散列表，开放寻址、线性探测
+// 各个分析的结果保存在这样的旁路表中，AST本身不做修改
+class NodeMap {
+public:
+    static constexpr uint32_t npos = UINT32_MAX;
+
+    NodeMap();
+
+    // 已有node时覆盖原来的值
+    void insert(const ASTNode* node, uint32_t value);
+    // 没有node时返回npos
+    uint32_t find(const ASTNode* node) const;
+    size_t size() const;
+
+private:
+    struct Slot {
+        const ASTNode* node;  // nullptr表示空槽
+        uint32_t value;
+    };
+    std::vector<Slot> slots_;
+    size_t mask_;
+    size_t size_;
+
+    size_t indexOf(const ASTNode* node) const;
+    void grow();
+};
@@ -0,0 +1,120 @@
+#include <utility>
+#include "parallelParser.hpp"
+#include "newVector.cpp"
+
+std::vector<TokenRange> splitExternalDeclarations(const newVector<Token>& tokens) {
+    std::vector<TokenRange> ranges;
+    size_t depth = 0;
+    size_t begin = 0;
+    // 最后一个Token是EOF，不属于任何外部声明
+    size_t count = tokens.size() == 0 ? 0 : tokens.size() - 1;
+
+    for (size_t i = 0; i < count; i++) {
+        TokenType type = tokens[i].type;
+        if (type == TokenType::LEFT_BRACE) {
+            depth++;
+        }
+        else if (type == TokenType::RIGHT_BRACE) {
+            if (depth > 0 && --depth == 0) {
+                ranges.push_back({ begin, i + 1 });
+                begin = i + 1;
+            }
+        }
+        else if (type == TokenType::SEMICOLON && depth == 0) {
+            ranges.push_back({ begin, i + 1 });
+            begin = i + 1;
+        }
+    }
+    // 不完整的尾部（例如缺少 '}'）单独作为一个范围，交给分析器报错
+    if (begin < count) {
+        ranges.push_back({ begin, count });
+    }
+    return ranges;
+}
+
+namespace {
+    // 一个并行任务负责的若干个连续外部声明
+    struct ParseTask {
+        size_t begin;
+        size_t end;
+        std::vector<ASTNode*> children = {};
+        bool failed = false;
+    };
+
+    void runTask(const newVector<Token>& tokens, ParseTask& task, size_t nestingLimit) {
+        // 子分析器只看到自己的Token，末尾补一个EOF
+        newVector<Token> slice;
+        slice.reserve(task.end - task.begin + 1);
+        for (size_t i = task.begin; i < task.end; i++) {
+            slice.push_back(tokens[i]);
+        }
+        slice.push_back(tokens[tokens.size() - 1]);
+
+        DiagnosticEngine localDiagnostics;
+        Parser parser(std::move(slice), localDiagnostics);
+        parser.setNestingLimit(nestingLimit);
+        ASTNode* root = parser.buildAST();
+
+        task.failed = localDiagnostics.hasErrors();
+        if (root != nullptr) {
+            task.children.swap(root->children);
+            delete root;
+        }
+    }
+}
+
+ASTNode* parseParallel(const newVector<Token>& tokens, DiagnosticEngine& diagnostics, ThreadPool& pool, size_t nestingLimit) {
+    std::vector<TokenRange> ranges = splitExternalDeclarations(tokens);
+
+    // 把相邻的小范围合并成一个任务，减少调度和拷贝开销
+    size_t total = tokens.size();
+    size_t grain = total / (pool.size() * 8 + 1);
+    if (grain < 2048) {
+        grain = 2048;
+    }
+    std::vector<ParseTask> tasks;
+    for (const TokenRange& range : ranges) {
+        if (tasks.empty() || tasks.back().end - tasks.back().begin >= grain) {
+            tasks.push_back({ range.begin, range.end });
+        }
+        else {
+            tasks.back().end = range.end;
+        }
+    }
+
+    for (ParseTask& task : tasks) {
+        ParseTask* taskPtr = &task;
+        pool.submit([&tokens, taskPtr, nestingLimit] { runTask(tokens, *taskPtr, nestingLimit); });
+    }
+    pool.wait();
+
+    bool failed = false;
+    for (const ParseTask& task : tasks) {
+        failed = failed || task.failed;
+    }
+
+    if (failed) {
+        // 有语法错误时各范围的错误恢复与顺序分析不同，直接退回顺序分析
+        for (ParseTask& task : tasks) {
+            for (ASTNode* child : task.children) {
+                delete child;
+            }
+        }
+        Parser parser(tokens, diagnostics);
+        parser.setNestingLimit(nestingLimit);
+        parser.parse();
+        return parser.getAST();
+    }
+
+    // 按源码顺序拼接子树
+    ASTNode* root = new ASTNode("ExternalDeclaration", "");
+    size_t childCount = 0;
+    for (const ParseTask& task : tasks) {
+        childCount += task.children.size();
+    }
+    root->children.reserve(childCount);
+    for (ParseTask& task : tasks) {
+        root->children.insert(root->children.end(), task.children.begin(), task.children.end());
+    }
+    return root;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <vector>
+#include "lexer.hpp"
+#include "astParser.hpp"
+#include "diagnostics.hpp"
+#include "threadPool.hpp"
+
+// 一个外部声明在Token序列中的范围 [begin, end)
+struct TokenRange {
+    size_t begin;
+    size_t end;
+};
+
+// 第一阶段：线性预扫描，按 '{' '}' 配对把Token序列切分为外部声明
+// 最外层的 ';' 结束一个声明，回到最外层的 '}' 结束一个函数定义
+std::vector<TokenRange> splitExternalDeclarations(const newVector<Token>& tokens);
+
+// 第二阶段：各个范围在线程池上并行分析，再按源码顺序挂到根节点下
+// 得到的AST与Parser::parse()完全相同；任一范围出错时退回顺序分析，保证诊断信息也一致
+// nestingLimit是每个Parser允许的嵌套层数，见Parser::setNestingLimit
+ASTNode* parseParallel(const newVector<Token>& tokens, DiagnosticEngine& diagnostics, ThreadPool& pool,
+    size_t nestingLimit = Parser::defaultNestingLimit);
@@ -0,0 +1,41 @@
+#include <exception>
+#include <vector>
+#include "parallelPasses.hpp"
+
+ParallelPassManager::ParallelPassManager(size_t jobs) {
+    if (jobs != 1) {
+        pool_ = std::make_unique<ThreadPool>(jobs);
+    }
+}
+
+size_t ParallelPassManager::jobs() const {
+    return pool_ ? pool_->size() : 1;
+}
+
+void ParallelPassManager::run(size_t count, const std::function<void(size_t index, size_t worker)>& task) {
+    if (!pool_) {
+        // 顺序执行时第一个异常就是下标最小的，直接传出去
+        for (size_t i = 0; i < count; i++) {
+            task(i, 0);
+        }
+        return;
+    }
+    // 线程池只保留最先抛出的异常，先后取决于调度；这里按下标记下每个任务的异常
+    std::vector<std::exception_ptr> errors(count);
+    for (size_t i = 0; i < count; i++) {
+        pool_->submit([this, &task, &errors, i] {
+            try {
+                task(i, pool_->currentWorker());
+            }
+            catch (...) {
+                errors[i] = std::current_exception();
+            }
+        });
+    }
+    pool_->wait();
+    for (const std::exception_ptr& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
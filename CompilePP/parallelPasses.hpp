@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include "threadPool.hpp"
+
+// 按函数并行的Pass调度：名字解析、类型检查等需要看到整个模块的Pass在调用线程上运行，
+// 只读取它们的结果、互不依赖的逐函数Pass（常量折叠、IR构造、IR优化、代码生成）作为任务交给工作窃取线程池。
+// 每次run()都是一道屏障，下一个模块级Pass在所有任务完成之后才开始。
+// 任务按下标把结果写到各自的位置，每个工作线程使用自己的一份可复用状态，结果与线程数无关
+class ParallelPassManager {
+public:
+    // jobs为1时不创建线程，所有任务在调用线程上按顺序执行；为0时使用硬件线程数
+    explicit ParallelPassManager(size_t jobs = 1);
+
+    ParallelPassManager(const ParallelPassManager&) = delete;
+    ParallelPassManager& operator=(const ParallelPassManager&) = delete;
+
+    // 工作线程数，也是task收到的worker的上界
+    size_t jobs() const;
+
+    // 对[0, count)中的每个下标调用task(index, worker)，全部完成后返回。
+    // 同一个worker上的任务不会同时运行，可以放心使用按worker划分的状态。
+    // 有任务抛出异常时重新抛出下标最小的那个，与顺序执行时报告的错误相同
+    void run(size_t count, const std::function<void(size_t index, size_t worker)>& task);
+
+private:
+    std::unique_ptr<ThreadPool> pool_;
+};
@@ -0,0 +1,197 @@
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <string>
+#include "parserBench.hpp"
+#include "astParser.hpp"
+#include "lalrParser.hpp"
+#include "newVector.cpp"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // 一次测量的结果，-1表示当前平台无法测量
+    struct EngineResult {
+        const char* name;
+        double secondsPerRun;
+        long long nativeStackBytes;
+        long long explicitStackBytes;
+        long long instructions;
+        ASTNode* ast;
+    };
+
+    // 两棵AST结构和内容完全相同
+    bool sameTree(const ASTNode* a, const ASTNode* b) {
+        if (a == nullptr || b == nullptr) {
+            return a == b;
+        }
+        if (a->type != b->type || a->value != b->value || a->children.size() != b->children.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < a->children.size(); i++) {
+            if (!sameTree(a->children[i], b->children[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+#ifdef __linux__
+    struct StackProbe {
+        std::function<void()>* body;
+    };
+
+    void* runProbe(void* argument) {
+        (*static_cast<StackProbe*>(argument)->body)();
+        return nullptr;
+    }
+
+    // 在预先填满标记字节的栈上运行body，返回被改写的字节数，即栈的最高水位
+    long long measureNativeStack(std::function<void()> body) {
+        const size_t stackSize = 64 * 1024 * 1024;
+        void* memory = mmap(nullptr, stackSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            return -1;
+        }
+        unsigned char* bytes = static_cast<unsigned char*>(memory);
+        std::memset(bytes, 0xA5, stackSize);
+
+        pthread_attr_t attributes;
+        pthread_attr_init(&attributes);
+        pthread_attr_setstack(&attributes, memory, stackSize);
+        StackProbe probe{ &body };
+        pthread_t thread;
+        long long used = -1;
+        if (pthread_create(&thread, &attributes, runProbe, &probe) == 0) {
+            pthread_join(thread, nullptr);
+            // 栈从高地址向低地址增长，从底部找第一个被改写的字节
+            size_t untouched = 0;
+            while (untouched < stackSize && bytes[untouched] == 0xA5) {
+                untouched++;
+            }
+            used = static_cast<long long>(stackSize - untouched);
+        }
+        pthread_attr_destroy(&attributes);
+        munmap(memory, stackSize);
+        return used;
+    }
+
+    // 用户态执行的指令数
+    long long countInstructions(const std::function<void()>& body) {
+        perf_event_attr attributes;
+        std::memset(&attributes, 0, sizeof(attributes));
+        attributes.type = PERF_TYPE_HARDWARE;
+        attributes.size = sizeof(attributes);
+        attributes.config = PERF_COUNT_HW_INSTRUCTIONS;
+        attributes.disabled = 1;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+        int fd = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+        if (fd < 0) {
+            body();
+            return -1;
+        }
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        body();
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        long long count = -1;
+        if (read(fd, &count, sizeof(count)) != sizeof(count)) {
+            count = -1;
+        }
+        close(fd);
+        return count;
+    }
+#else
+    long long measureNativeStack(std::function<void()> body) {
+        body();
+        return -1;
+    }
+
+    long long countInstructions(const std::function<void()>& body) {
+        body();
+        return -1;
+    }
+#endif
+
+    // build分析一次并返回AST，lalrDepth非空时返回LALR显式栈的最大深度
+    EngineResult measure(const char* name, size_t iterations, const std::function<ASTNode*(size_t*)>& build) {
+        EngineResult result{ name, 0.0, -1, -1, -1, nullptr };
+
+        // 预热一次，同时留下AST用于比较
+        size_t depth = 0;
+        result.ast = build(&depth);
+        if (depth != 0) {
+            result.explicitStackBytes = static_cast<long long>(depth * sizeof(LalrStackEntry));
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; i++) {
+            delete build(nullptr);
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        result.secondsPerRun = elapsed.count() / static_cast<double>(iterations);
+
+        result.nativeStackBytes = measureNativeStack([&build] { delete build(nullptr); });
+        result.instructions = countInstructions([&build] { delete build(nullptr); });
+        return result;
+    }
+
+    std::string formatCount(long long value) {
+        return value < 0 ? std::string("n/a") : std::to_string(value);
+    }
+}
+
+void runParserBenchmark(const newVector<Token>& tokens, size_t iterations, std::ostream& os) {
+    if (iterations == 0) {
+        iterations = 1;
+    }
+
+    EngineResult results[] = {
+        measure("recursive-descent", iterations, [&tokens](size_t*) {
+            DiagnosticEngine diagnostics;
+            Parser parser(tokens, diagnostics);
+            return parser.buildAST();
+        }),
+        measure("lalr", iterations, [&tokens](size_t* depth) {
+            DiagnosticEngine diagnostics;
+            LalrParser parser(tokens, diagnostics);
+            ASTNode* ast = parser.buildAST();
+            if (depth != nullptr) {
+                *depth = parser.maxStackDepth();
+            }
+            return ast;
+        }),
+    };
+
+    os << "Parser benchmark: " << tokens.size() << " tokens, " << iterations << " iteration(s)\n";
+    os << std::left << std::setw(20) << "engine" << std::right
+        << std::setw(14) << "ms/run" << std::setw(16) << "tokens/sec"
+        << std::setw(16) << "native stack" << std::setw(16) << "parse stack" << std::setw(18) << "instructions" << "\n";
+    for (const EngineResult& result : results) {
+        double tokensPerSecond = result.secondsPerRun > 0 ? static_cast<double>(tokens.size()) / result.secondsPerRun : 0.0;
+        os << std::left << std::setw(20) << result.name << std::right << std::fixed
+            << std::setw(14) << std::setprecision(3) << result.secondsPerRun * 1000.0
+            << std::setw(16) << std::setprecision(0) << tokensPerSecond
+            << std::setw(16) << formatCount(result.nativeStackBytes)
+            << std::setw(16) << formatCount(result.explicitStackBytes)
+            << std::setw(18) << formatCount(result.instructions) << "\n";
+    }
+    if (results[1].ast == nullptr) {
+        os << "LALR tables rejected the input (syntax error); lalr numbers cover error detection only\n";
+    }
+    else {
+        os << "AST identical: " << (sameTree(results[0].ast, results[1].ast) ? "yes" : "no") << "\n";
+    }
+    for (EngineResult& result : results) {
+        delete result.ast;
+    }
+}
@@ -0,0 +1,8 @@
+#pragma once
+#include <iostream>
+#include "lexer.hpp"
+
+// 比较递归下降和LALR(1)两个语法分析后端：吞吐量（Token/秒）、栈使用量和指令数
+// 每个后端分析iterations次取平均；栈使用量通过在独立线程的栈上预先填充标记测得，
+// 指令数来自Linux的perf_event，其他平台或没有权限时显示n/a
+void runParserBenchmark(const newVector<Token>& tokens, size_t iterations, std::ostream& os);
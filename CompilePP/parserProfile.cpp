@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <iomanip>
+#include <mutex>
+#include "parserProfile.hpp"
+
+namespace {
+    std::mutex processMutex;
+    ParserProfile processProfile;
+}
+
+const char* parserRuleName(ParserRule rule) {
+    static const char* const names[] = {
+#define PARSER_RULE(name) #name,
+#include "parserRule.def"
+#undef PARSER_RULE
+    };
+    return names[static_cast<size_t>(rule)];
+}
+
+ParserProfile::ParserProfile() : active_() {
+}
+
+void ParserProfile::enter(ParserRule rule, uint64_t consumed) {
+    size_t index = static_cast<size_t>(rule);
+    rules_[index].calls++;
+    active_[index]++;
+    stack_.push_back(Frame{ rule, std::chrono::steady_clock::now(), consumed, 0 });
+}
+
+void ParserProfile::exit(uint64_t consumed) {
+    Frame frame = stack_.back();
+    stack_.pop_back();
+    uint64_t elapsed = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - frame.start).count());
+    size_t index = static_cast<size_t>(frame.rule);
+    RuleCounters& counters = rules_[index];
+    // 回退可能让净前进数小于进入时
+    counters.tokens += consumed > frame.consumed ? consumed - frame.consumed : 0;
+    counters.selfNs += elapsed > frame.childNs ? elapsed - frame.childNs : 0;
+    if (--active_[index] == 0) {
+        counters.inclusiveNs += elapsed;
+    }
+    if (!stack_.empty()) {
+        stack_.back().childNs += elapsed;
+    }
+}
+
+void ParserProfile::backtrack(size_t tokens) {
+    if (stack_.empty()) {
+        return;
+    }
+    RuleCounters& counters = rules_[static_cast<size_t>(stack_.back().rule)];
+    counters.backtracks++;
+    counters.rewound += tokens;
+}
+
+void ParserProfile::merge(const ParserProfile& other) {
+    for (size_t i = 0; i < parserRuleCount; i++) {
+        rules_[i].calls += other.rules_[i].calls;
+        rules_[i].tokens += other.rules_[i].tokens;
+        rules_[i].backtracks += other.rules_[i].backtracks;
+        rules_[i].rewound += other.rules_[i].rewound;
+        rules_[i].inclusiveNs += other.rules_[i].inclusiveNs;
+        rules_[i].selfNs += other.rules_[i].selfNs;
+    }
+}
+
+bool ParserProfile::empty() const {
+    for (const RuleCounters& counters : rules_) {
+        if (counters.calls != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ParserProfile::print(std::ostream& os) const {
+    std::vector<size_t> order;
+    uint64_t total = 0;
+    for (size_t i = 0; i < parserRuleCount; i++) {
+        if (rules_[i].calls != 0) {
+            order.push_back(i);
+            total = std::max(total, rules_[i].inclusiveNs);
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+        return rules_[a].inclusiveNs > rules_[b].inclusiveNs;
+    });
+
+    std::ios_base::fmtflags flags = os.flags();
+    std::streamsize precision = os.precision();
+    os << "Parser profile:\n";
+    os << std::left << std::setw(36) << "  Rule" << std::right << std::setw(12) << "Calls" << std::setw(12) << "Tokens"
+        << std::setw(12) << "Backtracks" << std::setw(12) << "Rewound" << std::setw(14) << "Incl (ms)" << std::setw(8) << "%"
+        << std::setw(14) << "Self (ms)" << std::setw(10) << "ns/call" << "\n";
+    for (size_t i : order) {
+        const RuleCounters& counters = rules_[i];
+        os << std::left << std::setw(36) << std::string("  ") + parserRuleName(static_cast<ParserRule>(i)) << std::right
+            << std::setw(12) << counters.calls << std::setw(12) << counters.tokens
+            << std::setw(12) << counters.backtracks << std::setw(12) << counters.rewound << std::fixed
+            << std::setprecision(3) << std::setw(14) << static_cast<double>(counters.inclusiveNs) / 1e6
+            << std::setprecision(1) << std::setw(7) << (total != 0 ? static_cast<double>(counters.inclusiveNs) * 100.0 / static_cast<double>(total) : 0.0) << "%"
+            << std::setprecision(3) << std::setw(14) << static_cast<double>(counters.selfNs) / 1e6
+            << std::setprecision(0) << std::setw(10) << static_cast<double>(counters.selfNs) / static_cast<double>(counters.calls) << "\n";
+    }
+    os.flags(flags);
+    os.precision(precision);
+}
+
+void mergeParserProfile(const ParserProfile& profile) {
+    std::lock_guard<std::mutex> lock(processMutex);
+    processProfile.merge(profile);
+}
+
+ParserProfile takeParserProfile() {
+    std::lock_guard<std::mutex> lock(processMutex);
+    ParserProfile result = processProfile;
+    processProfile = ParserProfile();
+    return result;
+}
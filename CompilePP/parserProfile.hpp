@@ -0,0 +1,111 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <type_traits>
+#include <vector>
+
+// 递归下降Parser的逐产生式剖析：每个产生式的调用次数、消耗的Token数、回退次数和回退的Token数、
+// 包含子调用的时间和除去子产生式的自身时间。默认不编译进Parser，
+// 用CPP_PARSER_PROFILE=1重新编译后--profile-parser才有数据，关闭时Parser中的计数代码全部消失
+
+#ifndef CPP_PARSER_PROFILE
+#define CPP_PARSER_PROFILE 0
+#endif
+
+constexpr bool parserProfilingEnabled = CPP_PARSER_PROFILE != 0;
+
+enum class ParserRule : uint8_t
+{
+#define PARSER_RULE(name) name,
+#include "parserRule.def"
+#undef PARSER_RULE
+    Count
+};
+
+constexpr size_t parserRuleCount = static_cast<size_t>(ParserRule::Count);
+
+const char* parserRuleName(ParserRule rule);
+
+struct RuleCounters {
+    uint64_t calls = 0;
+    uint64_t tokens = 0;       // 净前进的Token数，包含子产生式
+    uint64_t backtracks = 0;   // 本产生式自己回退的次数
+    uint64_t rewound = 0;      // 回退的Token数
+    uint64_t inclusiveNs = 0;  // 递归调用只在最外层计时
+    uint64_t selfNs = 0;
+};
+
+class ParserProfile {
+public:
+    ParserProfile();
+
+    // consumed是Parser净前进的Token总数
+    void enter(ParserRule rule, uint64_t consumed);
+    void exit(uint64_t consumed);
+    void backtrack(size_t tokens);
+
+    void merge(const ParserProfile& other);
+    bool empty() const;
+    const RuleCounters& counters(ParserRule rule) const {
+        return rules_[static_cast<size_t>(rule)];
+    }
+
+    // 按包含时间从多到少，每个产生式一行；百分比相对于包含时间最多的产生式（通常是translationUnit）
+    void print(std::ostream& os) const;
+
+private:
+    struct Frame {
+        ParserRule rule;
+        std::chrono::steady_clock::time_point start;
+        uint64_t consumed;
+        uint64_t childNs;   // 直接子产生式的包含时间
+    };
+
+    RuleCounters rules_[parserRuleCount];
+    uint32_t active_[parserRuleCount];    // 每个产生式正在执行的层数
+    std::vector<Frame> stack_;
+};
+
+// 整个进程的剖析结果：每个Parser在buildAST结束时并入，可以在多个线程上同时调用
+void mergeParserProfile(const ParserProfile& profile);
+// 取出并清空到目前为止的结果
+ParserProfile takeParserProfile();
+
+// 编译时关闭的Parser持有的空剖析对象，接口与ParserProfile一致但什么都不做
+struct DisabledParserProfile {
+    void backtrack(size_t) {
+    }
+};
+
+inline void mergeParserProfile(const DisabledParserProfile&) {
+}
+
+// 产生式的作用域，consumed是Parser净前进Token数的计数器，离开时再读一次。
+// Enabled为false时是空对象，构造和析构都不产生代码
+template <bool Enabled>
+class RuleScope {
+public:
+    template <typename Profile>
+    RuleScope(Profile&, ParserRule, const uint64_t&) {
+    }
+};
+
+template <>
+class RuleScope<true> {
+public:
+    RuleScope(ParserProfile& profile, ParserRule rule, const uint64_t& consumed) : profile_(profile), consumed_(consumed) {
+        profile_.enter(rule, consumed_);
+    }
+    ~RuleScope() {
+        profile_.exit(consumed_);
+    }
+
+    RuleScope(const RuleScope&) = delete;
+    RuleScope& operator=(const RuleScope&) = delete;
+
+private:
+    ParserProfile& profile_;
+    const uint64_t& consumed_;
+};
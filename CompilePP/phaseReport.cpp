@@ -0,0 +1,206 @@
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <string>
+#include <utility>
+#include "phaseReport.hpp"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+namespace {
+    // 进程已使用的CPU时间（用户态加内核态），单位秒
+    double processCpuSeconds() {
+#if defined(_WIN32)
+        FILETIME creation, exit, kernel, user;
+        if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+            return 0.0;
+        }
+        auto seconds = [](const FILETIME& time) {
+            ULARGE_INTEGER value;
+            value.LowPart = time.dwLowDateTime;
+            value.HighPart = time.dwHighDateTime;
+            return static_cast<double>(value.QuadPart) * 1e-7;
+        };
+        return seconds(kernel) + seconds(user);
+#elif defined(CLOCK_PROCESS_CPUTIME_ID)
+        timespec now;
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+        return static_cast<double>(now.tv_sec) + static_cast<double>(now.tv_nsec) * 1e-9;
+#else
+        return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+#endif
+    }
+
+    double percent(double part, double total) {
+        return total > 0 ? part * 100.0 / total : 0.0;
+    }
+}
+
+PhaseReport::PhaseReport(bool time, bool memory)
+    : time_(time), memory_(memory) {
+    // 预留空间，阶段自己的簿记尽量不产生分配
+    phases_.reserve(32);
+    open_.reserve(16);
+    if (memory_) {
+        setMemoryAccounting(true);
+        for (size_t i = 0; i < static_cast<size_t>(AllocationSite::Count); i++) {
+            sitesStart_[i] = siteCounters(static_cast<AllocationSite>(i));
+        }
+    }
+}
+
+PhaseReport::~PhaseReport() {
+    if (memory_) {
+        setMemoryAccounting(false);
+    }
+}
+
+void PhaseReport::begin(const char* name) {
+    size_t parent = open_.empty() ? none : open_.back().phase;
+    std::vector<size_t>& siblings = parent == none ? roots_ : phases_[parent].children;
+    size_t phase = none;
+    for (size_t sibling : siblings) {
+        if (phases_[sibling].name == name || std::strcmp(phases_[sibling].name, name) == 0) {
+            phase = sibling;
+            break;
+        }
+    }
+    if (phase == none) {
+        phase = phases_.size();
+        siblings.push_back(phase);
+        phases_.push_back(Phase{ name, parent, open_.size() });
+    }
+    OpenPhase open{ phase, {}, 0.0, {}, 0 };
+    if (memory_) {
+        open.memoryStart = memoryCounters();
+        open.outerPeak = resetPeakLiveBytes();
+    }
+    if (time_) {
+        open.cpuStart = processCpuSeconds();
+        open.wallStart = std::chrono::steady_clock::now();
+    }
+    open_.push_back(open);
+}
+
+void PhaseReport::end() {
+    OpenPhase open = open_.back();
+    open_.pop_back();
+    Phase& phase = phases_[open.phase];
+    phase.count++;
+    if (time_) {
+        std::chrono::duration<double> wall = std::chrono::steady_clock::now() - open.wallStart;
+        phase.wallSeconds += wall.count();
+        phase.cpuSeconds += processCpuSeconds() - open.cpuStart;
+    }
+    if (memory_) {
+        MemoryCounters counters = memoryCounters();
+        int64_t peak = peakLiveBytes();
+        phase.allocations += counters.allocations - open.memoryStart.allocations;
+        phase.bytes += counters.bytes - open.memoryStart.bytes;
+        phase.peakLiveBytes = std::max(phase.peakLiveBytes, peak);
+        raisePeakLiveBytes(open.outerPeak);
+    }
+}
+
+void PhaseReport::print(std::ostream& os) const {
+    std::ios_base::fmtflags flags = os.flags();
+    std::streamsize precision = os.precision();
+    if (time_) {
+        printTimes(os);
+    }
+    if (memory_) {
+        printMemory(os);
+    }
+    os.flags(flags);
+    os.precision(precision);
+}
+
+void PhaseReport::printTimes(std::ostream& os) const {
+    double totalWall = 0.0;
+    double totalCpu = 0.0;
+    for (size_t root : roots_) {
+        totalWall += phases_[root].wallSeconds;
+        totalCpu += phases_[root].cpuSeconds;
+    }
+    os << "Time report:\n";
+    os << std::left << std::setw(32) << "  Phase" << std::right << std::setw(12) << "Wall (ms)" << std::setw(8) << "%"
+        << std::setw(12) << "CPU (ms)" << std::setw(8) << "%" << "\n";
+    for (size_t root : roots_) {
+        printPhaseTime(os, root, totalWall, totalCpu);
+    }
+    os << std::left << std::setw(32) << "  Total" << std::right << std::fixed << std::setprecision(3)
+        << std::setw(12) << totalWall * 1000.0 << std::setw(7) << std::setprecision(1) << 100.0 << "%"
+        << std::setprecision(3) << std::setw(12) << totalCpu * 1000.0 << std::setw(7) << std::setprecision(1) << 100.0 << "%\n";
+}
+
+void PhaseReport::printMemory(std::ostream& os) const {
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+    int64_t peak = 0;
+    for (size_t root : roots_) {
+        allocations += phases_[root].allocations;
+        bytes += phases_[root].bytes;
+        peak = std::max(peak, phases_[root].peakLiveBytes);
+    }
+    os << "Memory report:\n";
+    os << std::left << std::setw(32) << "  Phase" << std::right << std::setw(14) << "Allocations" << std::setw(16) << "Bytes"
+        << std::setw(16) << "Peak live" << "\n";
+    for (size_t root : roots_) {
+        printPhaseMemory(os, root);
+    }
+    os << std::left << std::setw(32) << "  Total" << std::right << std::setw(14) << allocations << std::setw(16) << bytes
+        << std::setw(16) << peak << "\n";
+
+    // 分配点按字节数从多到少，省略没有分配的
+    std::vector<std::pair<AllocationSite, SiteCounters>> sites;
+    for (size_t i = 0; i < static_cast<size_t>(AllocationSite::Count); i++) {
+        SiteCounters counters = siteCounters(static_cast<AllocationSite>(i));
+        counters.allocations -= sitesStart_[i].allocations;
+        counters.bytes -= sitesStart_[i].bytes;
+        if (counters.allocations != 0) {
+            sites.emplace_back(static_cast<AllocationSite>(i), counters);
+        }
+    }
+    std::stable_sort(sites.begin(), sites.end(), [](const auto& a, const auto& b) {
+        return a.second.bytes > b.second.bytes;
+    });
+    os << "Allocation sites:\n";
+    for (const auto& [site, counters] : sites) {
+        os << std::left << std::setw(32) << std::string("  ") + allocationSiteName(site) << std::right
+            << std::setw(14) << counters.allocations << std::setw(16) << counters.bytes << std::fixed << std::setprecision(1)
+            << std::setw(15) << percent(static_cast<double>(counters.bytes), static_cast<double>(bytes)) << "%\n";
+    }
+}
+
+void PhaseReport::printPhaseTime(std::ostream& os, size_t index, double totalWall, double totalCpu) const {
+    const Phase& phase = phases_[index];
+    std::string label = std::string(2 + phase.depth * 2, ' ') + phase.name;
+    if (phase.count > 1) {
+        label += " (x" + std::to_string(phase.count) + ")";
+    }
+    os << std::left << std::setw(32) << label << std::right << std::fixed
+        << std::setprecision(3) << std::setw(12) << phase.wallSeconds * 1000.0
+        << std::setprecision(1) << std::setw(7) << percent(phase.wallSeconds, totalWall) << "%"
+        << std::setprecision(3) << std::setw(12) << phase.cpuSeconds * 1000.0
+        << std::setprecision(1) << std::setw(7) << percent(phase.cpuSeconds, totalCpu) << "%\n";
+    for (size_t child : phase.children) {
+        printPhaseTime(os, child, totalWall, totalCpu);
+    }
+}
+
+void PhaseReport::printPhaseMemory(std::ostream& os, size_t index) const {
+    const Phase& phase = phases_[index];
+    std::string label = std::string(2 + phase.depth * 2, ' ') + phase.name;
+    if (phase.count > 1) {
+        label += " (x" + std::to_string(phase.count) + ")";
+    }
+    os << std::left << std::setw(32) << label << std::right << std::setw(14) << phase.allocations
+        << std::setw(16) << phase.bytes << std::setw(16) << phase.peakLiveBytes << "\n";
+    for (size_t child : phase.children) {
+        printPhaseMemory(os, child);
+    }
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "memoryAccounting.hpp"
+
+// 编译各阶段的统计（--time-report、--mem-report）：阶段可以嵌套，同一父阶段下同名的阶段累加。
+// 挂钟时间来自单调时钟，CPU时间是整个进程的（包含逐函数Pass的工作线程）；
+// 统计内存时在构造时打开全局的内存统计，记录每个阶段的分配次数、字节数和存活字节数的峰值。
+// 只在编译所在的线程上使用
+class PhaseReport {
+public:
+    PhaseReport(bool time, bool memory);
+    ~PhaseReport();
+
+    PhaseReport(const PhaseReport&) = delete;
+    PhaseReport& operator=(const PhaseReport&) = delete;
+
+    // name必须是字符串常量，同一父阶段下按指针和内容查找
+    void begin(const char* name);
+    void end();
+
+    // 时间：每个阶段一行，按嵌套缩进，挂钟时间、CPU时间和它们占顶层阶段总和的百分比；
+    // 内存：每个阶段的分配次数、字节数和峰值，再按字节数列出分配最多的分配点
+    void print(std::ostream& os) const;
+
+private:
+    static constexpr size_t none = static_cast<size_t>(-1);
+
+    struct Phase {
+        const char* name = nullptr;
+        size_t parent = none;
+        size_t depth = 0;
+        size_t count = 0;    // 进入的次数
+        double wallSeconds = 0.0;
+        double cpuSeconds = 0.0;
+        uint64_t allocations = 0;
+        uint64_t bytes = 0;
+        int64_t peakLiveBytes = 0;
+        std::vector<size_t> children = {};
+    };
+
+    struct OpenPhase {
+        size_t phase;
+        std::chrono::steady_clock::time_point wallStart;
+        double cpuStart;
+        MemoryCounters memoryStart;
+        int64_t outerPeak;   // 进入阶段前的峰值，离开时恢复
+    };
+
+    bool time_;
+    bool memory_;
+    std::vector<Phase> phases_;
+    std::vector<size_t> roots_;
+    std::vector<OpenPhase> open_;
+    SiteCounters sitesStart_[static_cast<size_t>(AllocationSite::Count)];
+
+    void printTimes(std::ostream& os) const;
+    void printMemory(std::ostream& os) const;
+    void printPhaseTime(std::ostream& os, size_t index, double totalWall, double totalCpu) const;
+    void printPhaseMemory(std::ostream& os, size_t index) const;
+};
+
+// 作用域内的一个阶段；report为空时什么都不做，两个报告都关闭时只有一次指针判断
+class PhaseTimer {
+public:
+    PhaseTimer(PhaseReport* report, const char* name) : report_(report) {
+        if (report_ != nullptr) {
+            report_->begin(name);
+        }
+    }
+    ~PhaseTimer() {
+        if (report_ != nullptr) {
+            report_->end();
+        }
+    }
+
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+private:
+    PhaseReport* report_;
+};
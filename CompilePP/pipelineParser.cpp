@@ -0,0 +1,69 @@
+#include <algorithm>
+#include <thread>
+#include "pipelineParser.hpp"
+#include "spscRing.hpp"
+#include "spscRing.cpp"
+#include "newVector.cpp"
+
+namespace {
+    // 从环形队列中按批取Token
+    class RingTokenSource : public TokenSource {
+    public:
+        explicit RingTokenSource(SpscRing<newVector<Token>>& ring) : ring_(ring) {}
+
+        bool fetch(newVector<Token>& tokens) override {
+            newVector<Token> batch;
+            if (!ring_.pop(batch)) {
+                return false;
+            }
+            if (tokens.size() == 0) {
+                tokens = std::move(batch);
+                return true;
+            }
+            // 一个很长的外部声明会跨越很多批，按倍数扩容，避免每批都复制一遍已有的Token
+            if (tokens.size() + batch.size() > tokens.capacity()) {
+                tokens.reserve(std::max(tokens.size() + batch.size(), tokens.capacity() * 2));
+            }
+            for (Token& token : batch) {
+                tokens.push_back(std::move(token));
+            }
+            return true;
+        }
+
+    private:
+        SpscRing<newVector<Token>>& ring_;
+    };
+}
+
+ASTNode* parsePipelined(const std::string& source, DiagnosticEngine& diagnostics, const PipelineOptions& options) {
+    SpscRing<newVector<Token>> ring(options.ringCapacity);
+    DiagnosticEngine lexerDiagnostics(diagnostics.errorLimit());
+    DiagnosticEngine parserDiagnostics(diagnostics.errorLimit());
+
+    std::thread lexerThread([&] {
+        Lexer lexer(source, lexerDiagnostics);
+        lexer.set_token_sink([&ring](newVector<Token>& batch) { ring.push(std::move(batch)); }, options.batchSize);
+        lexer.lex();
+        ring.close();
+    });
+
+    ASTNode* ast = nullptr;
+    try {
+        RingTokenSource tokenSource(ring);
+        Parser parser(tokenSource, parserDiagnostics);
+        parser.setNestingLimit(options.nestingLimit);
+        ast = parser.buildAST();
+    }
+    catch (...) {
+        ring.close();
+        lexerThread.join();
+        throw;
+    }
+    // 错误过多时语法分析会提前停止，通知词法分析线程不再接收，避免它阻塞在已满的队列上
+    ring.close();
+    lexerThread.join();
+
+    diagnostics.merge(lexerDiagnostics);
+    diagnostics.merge(parserDiagnostics);
+    return ast;
+}
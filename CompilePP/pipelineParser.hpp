@@ -0,0 +1,18 @@
+#pragma once
+#include <string>
+#include "lexer.hpp"
+#include "astParser.hpp"
+#include "diagnostics.hpp"
+
+// 流水线模式的参数
+struct PipelineOptions {
+    size_t batchSize = 1024;    // 每批Token的数量
+    size_t ringCapacity = 64;   // 环形队列能容纳的批数，队列满时词法分析线程等待
+    size_t nestingLimit = Parser::defaultNestingLimit;  // 语句和表达式最多嵌套的层数
+};
+
+// 词法分析在独立线程上运行，按批把Token发布到单生产者/单消费者无锁环形队列，
+// 语法分析在调用线程上边接收边分析，两个阶段的耗时相互重叠
+// 两个阶段各自收集诊断，结束后按词法、语法的顺序并入diagnostics，与顺序分析的输出一致
+// （错误数达到上限时，语法分析可能比顺序分析停得晚，被丢弃的错误计数会偏多）
+ASTNode* parsePipelined(const std::string& source, DiagnosticEngine& diagnostics, const PipelineOptions& options = PipelineOptions());
@@ -0,0 +1,266 @@
+#include <algorithm>
+#include "regAlloc.hpp"
+
+namespace {
+    constexpr uint32_t none = UINT32_MAX;
+
+    bool contains(const std::vector<uint64_t>& set, uint32_t value) {
+        return (set[value / 64] >> (value % 64)) & 1;
+    }
+
+    void insert(std::vector<uint64_t>& set, uint32_t value) {
+        set[value / 64] |= uint64_t(1) << (value % 64);
+    }
+
+    uint32_t lowestBit(uint64_t bits) {
+        uint32_t index = 0;
+        while (((bits >> index) & 1) == 0) {
+            index++;
+        }
+        return index;
+    }
+
+    // 和IrFunction::reversePostorder一样，只是后继按相反的顺序访问，
+    // 这样Branch的真后继（循环体、then分支）紧跟在块的后面，发射代码时可以直接落入
+    std::vector<uint32_t> linearOrder(const IrFunction& function) {
+        std::vector<uint32_t> order;
+        if (function.blocks.empty()) {
+            return order;
+        }
+        std::vector<bool> visited(function.blocks.size(), false);
+        std::vector<std::pair<uint32_t, size_t>> stack{ { 0, function.blocks[0].successors.size() } };
+        visited[0] = true;
+        while (!stack.empty()) {
+            auto& [block, next] = stack.back();
+            if (next != 0) {
+                uint32_t successor = function.blocks[block].successors[--next];
+                if (!visited[successor]) {
+                    visited[successor] = true;
+                    stack.push_back({ successor, function.blocks[successor].successors.size() });
+                }
+            }
+            else {
+                order.push_back(block);
+                stack.pop_back();
+            }
+        }
+        std::reverse(order.begin(), order.end());
+        return order;
+    }
+}
+
+RegisterClass registerClassOf(IrType type) {
+    return type == IrType::Double ? RegisterClass::Float : RegisterClass::General;
+}
+
+std::vector<std::vector<uint64_t>> computeLiveOut(const IrFunction& function, const std::vector<uint32_t>& order,
+    const std::vector<bool>& tracked) {
+    size_t words = (function.values.size() + 63) / 64;
+    size_t blockCount = function.blocks.size();
+    std::vector<std::vector<uint64_t>> uses(blockCount, std::vector<uint64_t>(words, 0));
+    std::vector<std::vector<uint64_t>> defs(blockCount, std::vector<uint64_t>(words, 0));
+    std::vector<std::vector<uint64_t>> phiUses(blockCount, std::vector<uint64_t>(words, 0));
+    std::vector<std::vector<uint64_t>> liveIn(blockCount, std::vector<uint64_t>(words, 0));
+    std::vector<std::vector<uint64_t>> liveOut(blockCount, std::vector<uint64_t>(words, 0));
+
+    // 块内向上暴露的使用和定义；Phi的操作数算作对应前驱出口的使用
+    for (uint32_t block : order) {
+        const IrBlock& current = function.blocks[block];
+        for (uint32_t value : current.instructions) {
+            const IrInstruction& instruction = function.values[value];
+            if (instruction.op == IrOp::Phi) {
+                for (size_t k = 0; k < instruction.operands.size(); k++) {
+                    if (tracked[instruction.operands[k]]) {
+                        insert(phiUses[current.predecessors[k]], instruction.operands[k]);
+                    }
+                }
+            }
+            else {
+                for (uint32_t operand : instruction.operands) {
+                    if (tracked[operand] && !contains(defs[block], operand)) {
+                        insert(uses[block], operand);
+                    }
+                }
+            }
+            if (tracked[value]) {
+                insert(defs[block], value);
+            }
+        }
+    }
+
+    // liveOut(b) = phiUses(b) ∪ 各后继的liveIn，liveIn(b) = uses(b) ∪ (liveOut(b) - defs(b))，逆序迭代到不动点
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = order.size(); i-- > 0;) {
+            uint32_t block = order[i];
+            std::vector<uint64_t> out = phiUses[block];
+            for (uint32_t successor : function.blocks[block].successors) {
+                for (size_t w = 0; w < words; w++) {
+                    out[w] |= liveIn[successor][w];
+                }
+            }
+            for (size_t w = 0; w < words; w++) {
+                uint64_t in = uses[block][w] | (out[w] & ~defs[block][w]);
+                if (in != liveIn[block][w]) {
+                    liveIn[block][w] = in;
+                    changed = true;
+                }
+            }
+            liveOut[block].swap(out);
+        }
+    }
+    return liveOut;
+}
+
+RegisterAllocation allocateRegisters(const IrFunction& function, const std::vector<bool>& needsLocation,
+    const std::vector<bool>& clobbers, const RegisterSet& registers, bool spillAll) {
+    RegisterAllocation result;
+    result.order = linearOrder(function);
+    size_t count = function.values.size();
+    result.position.assign(count, 0);
+    result.blockEnd.assign(function.blocks.size(), 0);
+
+    // 编号：每条指令两个位置
+    std::vector<uint32_t> blockStart(function.blocks.size(), 0);
+    std::vector<uint32_t> callPositions;
+    uint32_t next = 0;
+    for (uint32_t block : result.order) {
+        blockStart[block] = 2 * next;
+        for (uint32_t value : function.blocks[block].instructions) {
+            result.position[value] = 2 * next;
+            if (clobbers[value]) {
+                callPositions.push_back(2 * next);
+            }
+            next++;
+        }
+        result.blockEnd[block] = 2 * next - 1;
+    }
+
+    // SSA中定义支配所有使用，而支配者在逆后序中排在前面，所以区间的起点就是定义的位置，
+    // 终点是最后一次使用或者最后一个出口活跃的块的末尾
+    std::vector<std::vector<uint64_t>> liveOut = computeLiveOut(function, result.order, needsLocation);
+    std::vector<uint32_t> start(count, none);
+    std::vector<uint32_t> end(count, 0);
+    for (uint32_t block : result.order) {
+        const IrBlock& current = function.blocks[block];
+        for (uint32_t value : current.instructions) {
+            const IrInstruction& instruction = function.values[value];
+            if (needsLocation[value]) {
+                if (instruction.op == IrOp::Param) {
+                    start[value] = 0;
+                }
+                else if (instruction.op == IrOp::Phi) {
+                    start[value] = blockStart[block];
+                }
+                else {
+                    start[value] = result.position[value] + 1;
+                }
+                end[value] = std::max(end[value], start[value]);
+            }
+            for (size_t k = 0; k < instruction.operands.size(); k++) {
+                uint32_t operand = instruction.operands[k];
+                if (!needsLocation[operand]) {
+                    continue;
+                }
+                uint32_t use = instruction.op == IrOp::Phi ? result.blockEnd[current.predecessors[k]] : result.position[value];
+                end[operand] = std::max(end[operand], use);
+            }
+        }
+        for (size_t w = 0; w < liveOut[block].size(); w++) {
+            for (uint64_t bits = liveOut[block][w]; bits != 0; bits &= bits - 1) {
+                uint32_t value = static_cast<uint32_t>(w * 64 + lowestBit(bits));
+                end[value] = std::max(end[value], result.blockEnd[block]);
+            }
+        }
+    }
+
+    for (uint32_t value = 0; value < count; value++) {
+        if (start[value] == none) {
+            continue;
+        }
+        auto call = std::upper_bound(callPositions.begin(), callPositions.end(), start[value]);
+        bool crossesCall = call != callPositions.end() && *call < end[value];
+        result.intervals.push_back({ value, start[value], end[value], crossesCall });
+    }
+    std::sort(result.intervals.begin(), result.intervals.end(), [](const LiveInterval& a, const LiveInterval& b) {
+        return a.start != b.start ? a.start < b.start : a.value < b.value;
+    });
+
+    result.registers.assign(count, -1);
+    result.slots.assign(count, -1);
+    auto spill = [&](uint32_t value) {
+        result.registers[value] = -1;
+        result.slots[value] = static_cast<int32_t>(result.slotCount++);
+        result.spilled++;
+    };
+
+    uint32_t freeRegisters[2];
+    for (int c = 0; c < 2; c++) {
+        freeRegisters[c] = registers.count[c] >= 32 ? UINT32_MAX : (uint32_t(1) << registers.count[c]) - 1;
+    }
+    std::vector<const LiveInterval*> active;   // 按终点排序
+    for (const LiveInterval& interval : result.intervals) {
+        // 释放已经结束的区间占用的寄存器
+        size_t expired = 0;
+        while (expired < active.size() && active[expired]->end < interval.start) {
+            const LiveInterval* old = active[expired++];
+            int c = static_cast<int>(registerClassOf(function.values[old->value].type));
+            freeRegisters[c] |= uint32_t(1) << result.registers[old->value];
+        }
+        active.erase(active.begin(), active.begin() + static_cast<std::ptrdiff_t>(expired));
+
+        if (spillAll) {
+            spill(interval.value);
+            continue;
+        }
+        int c = static_cast<int>(registerClassOf(function.values[interval.value].type));
+        auto activate = [&](const LiveInterval* entry) {
+            auto at = std::upper_bound(active.begin(), active.end(), entry, [](const LiveInterval* a, const LiveInterval* b) {
+                return a->end < b->end;
+            });
+            active.insert(at, entry);
+        };
+        if (freeRegisters[c] != 0) {
+            // 跨过调用的值优先用被调用者保存的寄存器，其余的值优先用调用者保存的寄存器
+            uint32_t preferred = freeRegisters[c] & (interval.crossesCall ? registers.calleeSaved[c] : ~registers.calleeSaved[c]);
+            uint32_t chosen = lowestBit(preferred != 0 ? preferred : freeRegisters[c]);
+            freeRegisters[c] &= ~(uint32_t(1) << chosen);
+            result.registers[interval.value] = static_cast<int32_t>(chosen);
+            activate(&interval);
+            continue;
+        }
+        // 没有空闲寄存器：溢出同类中结束得最晚的区间
+        size_t victim = active.size();
+        for (size_t i = active.size(); i-- > 0;) {
+            if (registerClassOf(function.values[active[i]->value].type) == static_cast<RegisterClass>(c)) {
+                victim = i;
+                break;
+            }
+        }
+        if (victim != active.size() && active[victim]->end > interval.end) {
+            uint32_t value = active[victim]->value;
+            result.registers[interval.value] = result.registers[value];
+            spill(value);
+            active.erase(active.begin() + static_cast<std::ptrdiff_t>(victim));
+            activate(&interval);
+        }
+        else {
+            spill(interval.value);
+        }
+    }
+
+    // 跨过调用的值如果在调用者保存的寄存器中，由后端在调用前后保存到自己的栈槽
+    for (const LiveInterval& interval : result.intervals) {
+        int32_t reg = result.registers[interval.value];
+        if (reg < 0) {
+            continue;
+        }
+        int c = static_cast<int>(registerClassOf(function.values[interval.value].type));
+        result.usedRegisters[c] |= uint32_t(1) << reg;
+        if (interval.crossesCall && ((registers.calleeSaved[c] >> reg) & 1) == 0) {
+            result.slots[interval.value] = static_cast<int32_t>(result.slotCount++);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "ir.hpp"
+
+// 寄存器分配只区分两类寄存器：通用寄存器放int、数组和数组栈顶，浮点寄存器放double
+enum class RegisterClass : uint8_t
+{
+    General,
+    Float
+};
+
+RegisterClass registerClassOf(IrType type);
+
+// 后端提供的可分配寄存器：每类的个数，calleeSaved的第i位表示第i个寄存器在调用之后保持不变
+struct RegisterSet {
+    uint32_t count[2];
+    uint32_t calleeSaved[2];
+};
+
+// 基本块排成线性顺序之后，第k条指令读操作数的位置是2k，写结果的位置是2k+1。
+// Phi在块的开始定义，Phi的操作数活跃到对应前驱块的末尾，参数在函数入口（位置0）定义
+struct LiveInterval {
+    uint32_t value;
+    uint32_t start;
+    uint32_t end;
+    bool crossesCall;    // 区间内有会破坏调用者保存寄存器的指令
+};
+
+// 线性扫描（Poletto、Sarkar）的结果。溢出的值整个生命期都在栈槽中，不做区间分裂
+struct RegisterAllocation {
+    std::vector<uint32_t> order;          // 块的线性顺序：后继优先的逆后序，不可达的块不在其中
+    std::vector<uint32_t> position;       // 按值：指令的位置2k
+    std::vector<uint32_t> blockEnd;       // 按块：终结指令的位置2k+1
+    std::vector<LiveInterval> intervals;  // 按起点排序
+    std::vector<int32_t> registers;       // 按值：寄存器编号，-1表示在栈槽中或者不需要位置
+    std::vector<int32_t> slots;           // 按值：栈槽编号，溢出的值和跨过调用的调用者保存寄存器中的值才有
+    uint32_t slotCount = 0;
+    uint32_t usedRegisters[2] = { 0, 0 };  // 按类别：用到的寄存器位集
+    size_t spilled = 0;
+};
+
+// SSA形式上的活跃变量分析，返回每个块出口活跃的值（按值编号的位集，每64个值一个字）。
+// tracked[v]为false的值不参与分析
+std::vector<std::vector<uint64_t>> computeLiveOut(const IrFunction& function, const std::vector<uint32_t>& order,
+    const std::vector<bool>& tracked);
+
+// needsLocation[v]为false的值（没有结果，或者后端直接编码成立即数的常量等）不分配位置；
+// clobbers[v]为true的指令会破坏调用者保存的寄存器，跨过它的值优先放在被调用者保存的寄存器中，
+// 否则由后端在调用前后保存到栈槽。spillAll为true时所有的值都放在栈槽中
+RegisterAllocation allocateRegisters(const IrFunction& function, const std::vector<bool>& needsLocation,
+    const std::vector<bool>& clobbers, const RegisterSet& registers, bool spillAll = false);
@@ -0,0 +1,260 @@
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include "runtimeValue.hpp"
+
+RuntimeValue RuntimeValue::ofInt(int32_t value) {
+    return RuntimeValue(ValueType::Int, value);
+}
+
+RuntimeValue RuntimeValue::ofDouble(double value) {
+    return RuntimeValue(ValueType::Double, value);
+}
+
+RuntimeValue RuntimeValue::zero(ValueType type) {
+    // double的0.0各位都是0，同时也是int的0
+    return RuntimeValue(type, 0.0);
+}
+
+bool binaryOpFromLexeme(const std::string& lexeme, BinaryOp& op) {
+    std::string text = lexeme;
+    // 复合赋值运算符
+    if (text.size() == 2 && text[1] == '=' && text[0] != '=' && text[0] != '!' && text[0] != '<' && text[0] != '>') {
+        text.pop_back();
+    }
+    if (text == "+") op = BinaryOp::Add;
+    else if (text == "-") op = BinaryOp::Sub;
+    else if (text == "*") op = BinaryOp::Mul;
+    else if (text == "/") op = BinaryOp::Div;
+    else if (text == "%") op = BinaryOp::Mod;
+    else if (text == "<<") op = BinaryOp::Shl;
+    else if (text == ">>") op = BinaryOp::Shr;
+    else if (text == "&") op = BinaryOp::BitAnd;
+    else if (text == "|") op = BinaryOp::BitOr;
+    else if (text == "^") op = BinaryOp::BitXor;
+    else if (text == "<") op = BinaryOp::Less;
+    else if (text == ">") op = BinaryOp::Greater;
+    else if (text == "<=") op = BinaryOp::LessEqual;
+    else if (text == ">=") op = BinaryOp::GreaterEqual;
+    else if (text == "==") op = BinaryOp::Equal;
+    else if (text == "!=") op = BinaryOp::NotEqual;
+    else return false;
+    return true;
+}
+
+bool parseConstant(const std::string& text, RuntimeValue& value) {
+    size_t digit = !text.empty() && text[0] == '-' ? 1 : 0;
+    if (digit >= text.size() || !std::isdigit(static_cast<unsigned char>(text[digit]))) {
+        return false;
+    }
+    errno = 0;
+    if (text.find_first_of(".eE") != std::string::npos) {
+        value = RuntimeValue::ofDouble(std::strtod(text.c_str(), nullptr));
+        return true;
+    }
+    long long parsed = std::strtoll(text.c_str(), nullptr, 10);
+    if (errno != 0 || parsed < INT32_MIN || parsed > INT32_MAX) {
+        throw RuntimeError("integer constant out of range: " + text);
+    }
+    value = RuntimeValue::ofInt(static_cast<int32_t>(parsed));
+    return true;
+}
+
+bool valueTypeFromName(const std::string& name, ValueType& type) {
+    if (name == "int") type = ValueType::Int;
+    else if (name == "float") type = ValueType::Float;
+    else if (name == "double") type = ValueType::Double;
+    else if (name == "char") type = ValueType::Char;
+    else if (name == "bool") type = ValueType::Bool;
+    else return false;
+    return true;
+}
+
+const char* valueTypeName(ValueType type) {
+    switch (type) {
+    case ValueType::Int: return "int";
+    case ValueType::Float: return "float";
+    case ValueType::Double: return "double";
+    case ValueType::Char: return "char";
+    case ValueType::Bool: return "bool";
+    case ValueType::Array: return "array";
+    case ValueType::Void: return "void";
+    }
+    return "?";
+}
+
+bool isFloatingType(ValueType type) {
+    return type == ValueType::Float || type == ValueType::Double;
+}
+
+ValueType promotedType(ValueType type) {
+    return isFloatingType(type) ? type : ValueType::Int;
+}
+
+ValueType arithmeticType(ValueType left, ValueType right) {
+    if (left == ValueType::Double || right == ValueType::Double) {
+        return ValueType::Double;
+    }
+    if (left == ValueType::Float || right == ValueType::Float) {
+        return ValueType::Float;
+    }
+    return ValueType::Int;
+}
+
+size_t sizeOfType(ValueType type) {
+    switch (type) {
+    case ValueType::Char:
+    case ValueType::Bool:
+        return 1;
+    case ValueType::Double:
+        return 8;
+    default:
+        return 4;
+    }
+}
+
+namespace {
+
+    void requireScalar(const RuntimeValue& value) {
+        if (value.type == ValueType::Array) {
+            throw RuntimeError("array used as a value");
+        }
+        if (value.type == ValueType::Void) {
+            throw RuntimeError("void value used in an expression");
+        }
+    }
+}
+
+// 超出int范围的转换在C中没有定义，这里按64位截断后回绕，过大的值饱和
+int32_t doubleToInt(double value) {
+    if (std::isnan(value)) {
+        return 0;
+    }
+    if (value >= 9.2e18 || value <= -9.2e18) {
+        return value > 0 ? INT32_MAX : INT32_MIN;
+    }
+    return static_cast<int32_t>(static_cast<uint32_t>(static_cast<int64_t>(value)));
+}
+
+RuntimeValue convertValue(const RuntimeValue& value, ValueType type) {
+    requireScalar(value);
+    if (value.type == type) {
+        return value;
+    }
+    bool floating = isFloatingType(value.type);
+    switch (type) {
+    case ValueType::Int:
+        return RuntimeValue::ofInt(floating ? doubleToInt(value.doubleValue) : value.intValue);
+    case ValueType::Char: {
+        int32_t integer = floating ? doubleToInt(value.doubleValue) : value.intValue;
+        RuntimeValue result = RuntimeValue::ofInt(static_cast<int8_t>(static_cast<uint8_t>(integer)));
+        result.type = ValueType::Char;
+        return result;
+    }
+    case ValueType::Bool: {
+        RuntimeValue result = RuntimeValue::ofInt(isTruthy(value) ? 1 : 0);
+        result.type = ValueType::Bool;
+        return result;
+    }
+    case ValueType::Float: {
+        double number = floating ? value.doubleValue : static_cast<double>(value.intValue);
+        RuntimeValue result = RuntimeValue::ofDouble(static_cast<float>(number));
+        result.type = ValueType::Float;
+        return result;
+    }
+    case ValueType::Double:
+        return RuntimeValue::ofDouble(floating ? value.doubleValue : static_cast<double>(value.intValue));
+    default:
+        throw RuntimeError(std::string("cannot convert to ") + valueTypeName(type));
+    }
+}
+
+RuntimeValue applyBinary(BinaryOp op, const RuntimeValue& left, const RuntimeValue& right) {
+    requireScalar(left);
+    requireScalar(right);
+
+    bool comparison = op >= BinaryOp::Less;
+    if (isFloatingType(left.type) || isFloatingType(right.type)) {
+        double a = isFloatingType(left.type) ? left.doubleValue : left.intValue;
+        double b = isFloatingType(right.type) ? right.doubleValue : right.intValue;
+        if (comparison) {
+            bool result;
+            switch (op) {
+            case BinaryOp::Less: result = a < b; break;
+            case BinaryOp::Greater: result = a > b; break;
+            case BinaryOp::LessEqual: result = a <= b; break;
+            case BinaryOp::GreaterEqual: result = a >= b; break;
+            case BinaryOp::Equal: result = a == b; break;
+            default: result = a != b; break;
+            }
+            return RuntimeValue::ofInt(result ? 1 : 0);
+        }
+        double result;
+        switch (op) {
+        case BinaryOp::Add: result = a + b; break;
+        case BinaryOp::Sub: result = a - b; break;
+        case BinaryOp::Mul: result = a * b; break;
+        case BinaryOp::Div: result = a / b; break;
+        default:
+            throw RuntimeError("invalid operands of floating type to an integer operator");
+        }
+        // 两个操作数都不是double时按float计算
+        if (left.type != ValueType::Double && right.type != ValueType::Double) {
+            RuntimeValue value = RuntimeValue::ofDouble(static_cast<float>(result));
+            value.type = ValueType::Float;
+            return value;
+        }
+        return RuntimeValue::ofDouble(result);
+    }
+
+    int32_t a = left.intValue;
+    int32_t b = right.intValue;
+    uint32_t ua = static_cast<uint32_t>(a);
+    uint32_t ub = static_cast<uint32_t>(b);
+    switch (op) {
+    case BinaryOp::Add: return RuntimeValue::ofInt(static_cast<int32_t>(ua + ub));
+    case BinaryOp::Sub: return RuntimeValue::ofInt(static_cast<int32_t>(ua - ub));
+    case BinaryOp::Mul: return RuntimeValue::ofInt(static_cast<int32_t>(ua * ub));
+    case BinaryOp::Div:
+    case BinaryOp::Mod:
+        if (b == 0) {
+            throw RuntimeError("integer division by zero");
+        }
+        if (a == INT32_MIN && b == -1) {
+            throw RuntimeError("integer overflow in division");
+        }
+        return RuntimeValue::ofInt(op == BinaryOp::Div ? a / b : a % b);
+    case BinaryOp::Shl:
+    case BinaryOp::Shr:
+        if (b < 0 || b >= 32) {
+            throw RuntimeError("shift count out of range");
+        }
+        return RuntimeValue::ofInt(op == BinaryOp::Shl ? static_cast<int32_t>(ua << b) : a >> b);
+    case BinaryOp::BitAnd: return RuntimeValue::ofInt(a & b);
+    case BinaryOp::BitOr: return RuntimeValue::ofInt(a | b);
+    case BinaryOp::BitXor: return RuntimeValue::ofInt(a ^ b);
+    case BinaryOp::Less: return RuntimeValue::ofInt(a < b);
+    case BinaryOp::Greater: return RuntimeValue::ofInt(a > b);
+    case BinaryOp::LessEqual: return RuntimeValue::ofInt(a <= b);
+    case BinaryOp::GreaterEqual: return RuntimeValue::ofInt(a >= b);
+    case BinaryOp::Equal: return RuntimeValue::ofInt(a == b);
+    case BinaryOp::NotEqual: return RuntimeValue::ofInt(a != b);
+    }
+    return RuntimeValue::ofInt(0);
+}
+
+bool isTruthy(const RuntimeValue& value) {
+    requireScalar(value);
+    return isFloatingType(value.type) ? value.doubleValue != 0.0 : value.intValue != 0;
+}
+
+void printValue(std::ostream& os, const RuntimeValue& value) {
+    if (isFloatingType(value.type)) {
+        os << value.doubleValue;
+    }
+    else {
+        os << value.intValue;
+    }
+}
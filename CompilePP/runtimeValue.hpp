@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+// 运行时值的类型，char和bool按C的整数提升规则参与运算
+enum class ValueType : uint8_t
+{
+    Int, Float, Double, Char, Bool, Array, Void
+};
+
+// 运行时值：标量保存在intValue或doubleValue中（float以double保存，但精度按float截断）
+// 数组只保存元素的起始位置、长度和元素类型，元素本身由执行引擎管理
+struct RuntimeValue {
+    ValueType type;
+    ValueType elementType;
+    uint32_t length;
+    union {
+        int32_t intValue;
+        double doubleValue;
+        uint32_t offset;
+    };
+
+    RuntimeValue() = default;
+    // 类型为type的标量，不是数组
+    RuntimeValue(ValueType type, int32_t value) : type(type), elementType(ValueType::Void), length(0), intValue(value) {}
+    RuntimeValue(ValueType type, double value) : type(type), elementType(ValueType::Void), length(0), doubleValue(value) {}
+
+    static RuntimeValue ofInt(int32_t value);
+    static RuntimeValue ofDouble(double value);
+    // 类型为type的零值
+    static RuntimeValue zero(ValueType type);
+};
+
+// 执行期错误，例如除数为0、数组越界
+class RuntimeError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+enum class BinaryOp : uint8_t
+{
+    Add, Sub, Mul, Div, Mod, Shl, Shr, BitAnd, BitOr, BitXor,
+    Less, Greater, LessEqual, GreaterEqual, Equal, NotEqual
+};
+
+// 运算符词素到BinaryOp，复合赋值运算符（如 "+="）按去掉 '=' 后的运算符处理
+bool binaryOpFromLexeme(const std::string& lexeme, BinaryOp& op);
+// PrimaryExpression中的常量（常量折叠之后可能带负号），不是常量时返回false，超出int范围时抛出RuntimeError
+bool parseConstant(const std::string& text, RuntimeValue& value);
+// 类型说明符到ValueType，不支持的类型（如string）返回false
+bool valueTypeFromName(const std::string& name, ValueType& type);
+const char* valueTypeName(ValueType type);
+size_t sizeOfType(ValueType type);
+bool isFloatingType(ValueType type);
+// 整数提升之后的类型：char和bool提升为int
+ValueType promotedType(ValueType type);
+// 常用算术转换之后的类型
+ValueType arithmeticType(ValueType left, ValueType right);
+
+// double到int的转换
+int32_t doubleToInt(double value);
+// 按C的转换规则把value转换成type
+RuntimeValue convertValue(const RuntimeValue& value, ValueType type);
+// 按常用算术转换计算left op right，int运算按补码回绕
+RuntimeValue applyBinary(BinaryOp op, const RuntimeValue& left, const RuntimeValue& right);
+bool isTruthy(const RuntimeValue& value);
+void printValue(std::ostream& os, const RuntimeValue& value);
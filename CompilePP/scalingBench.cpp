@@ -0,0 +1,353 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "scalingBench.hpp"
+#include "lexer.hpp"
+#include "astParser.hpp"
+#include "lalrParser.hpp"
+#include "nameResolver.hpp"
+#include "typeChecker.hpp"
+#include "irBuilder.hpp"
+#include "bytecodeCompiler.hpp"
+#include "vm.hpp"
+#include "interpreter.hpp"
+#include "memoryAccounting.hpp"
+#include "newVector.cpp"
+
+namespace {
+    // 每类输入测量的规模个数，规模从firstSize开始每次翻倍
+    constexpr size_t pointCount = 4;
+    // 每轮测量至少持续的时间，小规模的输入在一轮中执行多次
+    constexpr double minimumSeconds = 0.02;
+    // 嵌套的括号和语句块最深1024层，超过Parser的默认上限，测量这两类输入时放宽；
+    // 各种链不计入嵌套层数，用默认上限测量，与驱动程序接受的输入一致
+    constexpr size_t deepNestingLimit = 2048;
+
+    std::string longIdentifier(size_t length) {
+        std::string name = "v" + std::string(length - 1, 'a');
+        return "int main() {\n    int " + name + " = 1;\n    return " + name + ";\n}\n";
+    }
+
+    // 语法分析器不接受字符串字面量，只测词法分析
+    std::string longString(size_t length) {
+        return "int main() {\n    \"" + std::string(length, 'x') + "\";\n    return 0;\n}\n";
+    }
+
+    std::string nestedParentheses(size_t depth) {
+        return "int main() {\n    return " + std::string(depth, '(') + "1" + std::string(depth, ')') + ";\n}\n";
+    }
+
+    std::string nestedBlocks(size_t depth) {
+        std::string source = "int main() {\n";
+        source.reserve(source.size() + depth * 2 + 32);
+        source.append(depth, '{');
+        source += " return 0; ";
+        source.append(depth, '}');
+        source += "\n}\n";
+        return source;
+    }
+
+    // 几种优先级的二元运算符交替出现
+    std::string expressionChain(size_t terms) {
+        static const char* const operators[] = { " + ", " * ", " - ", " / " };
+        std::string source = "int main() {\n    int x = 1;\n    return x";
+        source.reserve(source.size() + terms * 4 + 16);
+        for (size_t i = 1; i < terms; i++) {
+            source += operators[i % 4];
+            source += 'x';
+        }
+        source += ";\n}\n";
+        return source;
+    }
+
+    // 右结合的链：Parser用显式栈分析，但每个等待的节点仍计入嵌套上限，
+    // 构造出的AST与链一样深，之后的各个阶段都要逐层处理
+    std::string assignmentChain(size_t terms) {
+        std::string source = "int main() {\n    int x;\n    ";
+        source.reserve(source.size() + terms * 4 + 32);
+        for (size_t i = 0; i < terms; i++) {
+            source += "x = ";
+        }
+        source += "1;\n    return x;\n}\n";
+        return source;
+    }
+
+    std::string prefixChain(size_t terms) {
+        std::string source = "int main() {\n    int x = 1;\n    return ";
+        source.reserve(source.size() + terms + 32);
+        source.append(terms, '!');
+        source += "x;\n}\n";
+        return source;
+    }
+
+    std::string conditionalChain(size_t terms) {
+        std::string source = "int main() {\n    int x = 1;\n    return ";
+        source.reserve(source.size() + terms * 16 + 32);
+        for (size_t i = 0; i < terms; i++) {
+            source += "x == 0 ? 0 : ";
+        }
+        source += "x;\n}\n";
+        return source;
+    }
+
+    std::string elseIfChain(size_t branches) {
+        std::string source = "int main() {\n    int x = 1;\n    ";
+        source.reserve(source.size() + branches * 24 + 32);
+        for (size_t i = 0; i < branches; i++) {
+            source += "if (x == 1) x = 2; else ";
+        }
+        source += "x = 3;\n    return x;\n}\n";
+        return source;
+    }
+
+    std::string declarations(size_t count) {
+        std::string source;
+        for (size_t i = 0; i < count; i++) {
+            std::string index = std::to_string(i);
+            source += "int g" + index + " = " + index + ";\n";
+        }
+        source += "int main() {\n    return g0;\n}\n";
+        return source;
+    }
+
+    struct ScalingCase {
+        const char* name;
+        const char* unit;    // 规模的含义
+        size_t firstSize;
+        bool parse;          // 为false时只做词法分析
+        bool passes;         // 为true时还对AST执行类型检查、IR构造、字节码和解释执行
+        size_t nestingLimit; // Parser允许的嵌套层数
+        std::string (*generate)(size_t size);
+    };
+
+    const ScalingCase cases[] = {
+        { "long-identifier", "characters", 8192, true, false, Parser::defaultNestingLimit, longIdentifier },
+        { "long-string", "characters", 8192, false, false, Parser::defaultNestingLimit, longString },
+        { "nested-parentheses", "levels", 128, true, false, deepNestingLimit, nestedParentheses },
+        { "nested-blocks", "levels", 128, true, false, deepNestingLimit, nestedBlocks },
+        { "expression-chain", "terms", 131072, true, false, Parser::defaultNestingLimit, expressionChain },
+        { "assignment-chain", "terms", 128, true, true, Parser::defaultNestingLimit, assignmentChain },
+        { "prefix-chain", "terms", 128, true, true, Parser::defaultNestingLimit, prefixChain },
+        { "conditional-chain", "terms", 128, true, true, Parser::defaultNestingLimit, conditionalChain },
+        { "else-if-chain", "branches", 128, true, true, Parser::defaultNestingLimit, elseIfChain },
+        { "declarations", "declarations", 4096, true, false, Parser::defaultNestingLimit, declarations },
+    };
+
+    struct Sample {
+        size_t size;
+        double lexSeconds = 0.0;
+        double parseSeconds = 0.0;
+        double passesSeconds = 0.0;
+        double allocatedBytes = 0.0;
+        double peakLiveBytes = 0.0;
+        bool valid = true;
+    };
+
+    ASTNode* parseTokens(const newVector<Token>& tokens, DiagnosticEngine& diagnostics, size_t nestingLimit, bool useLalr) {
+        if (useLalr) {
+            LalrParser parser(tokens, diagnostics);
+            parser.setNestingLimit(nestingLimit);
+            parser.parse();
+            return parser.getAST();
+        }
+        Parser parser(tokens, diagnostics);
+        parser.setNestingLimit(nestingLimit);
+        parser.parse();
+        return parser.getAST();
+    }
+
+    // 与驱动程序的--typecheck、--emit-ir、--run=vm和--run相同的几个阶段，程序被拒绝或执行出错时返回false
+    bool runPasses(const ASTNode* ast) {
+        NameResolver resolver;
+        resolver.resolve(ast);
+        TypeChecker checker(resolver);
+        checker.check(ast);
+        if (!resolver.unresolved().empty() || !checker.errors().empty()) {
+            return false;
+        }
+        std::ostringstream output;
+        try {
+            IrBuilder().build(ast);
+            BytecodeProgram program = BytecodeCompiler().compile(ast);
+            VirtualMachine vm(program, output);
+            vm.run();
+            Interpreter interpreter(output);
+            interpreter.load(ast);
+            interpreter.run();
+        }
+        catch (const RuntimeError&) {
+            return false;
+        }
+        return true;
+    }
+
+    // 最快一次执行的时间。每轮至少执行minimumSeconds，共iterations轮；
+    // 取最小值而不是平均值，其他进程抢占和缺页造成的偶然变慢不影响结果
+    template <typename Body>
+    double fastestSeconds(size_t iterations, Body body) {
+        double fastest = 0.0;
+        for (size_t i = 0; i < iterations; i++) {
+            auto roundStart = std::chrono::steady_clock::now();
+            std::chrono::duration<double> roundElapsed{};
+            do {
+                auto start = std::chrono::steady_clock::now();
+                body();
+                auto end = std::chrono::steady_clock::now();
+                std::chrono::duration<double> elapsed = end - start;
+                fastest = fastest == 0.0 ? elapsed.count() : std::min(fastest, elapsed.count());
+                roundElapsed = end - roundStart;
+            } while (roundElapsed.count() < minimumSeconds);
+        }
+        return fastest;
+    }
+
+    Sample measure(const ScalingCase& scalingCase, size_t size, size_t iterations, bool useLalr) {
+        Sample sample;
+        sample.size = size;
+        std::string source = scalingCase.generate(size);
+
+        // 先打开内存统计完整执行一次，同时检查输入是否被接受
+        setMemoryAccounting(true);
+        MemoryCounters before = memoryCounters();
+        int64_t outerPeak = resetPeakLiveBytes();
+        {
+            DiagnosticEngine diagnostics;
+            Lexer lexer(source, diagnostics);
+            newVector<Token> tokens = lexer.lex();
+            if (scalingCase.parse) {
+                delete parseTokens(tokens, diagnostics, scalingCase.nestingLimit, useLalr);
+            }
+            sample.valid = !diagnostics.hasErrors();
+        }
+        sample.allocatedBytes = static_cast<double>(memoryCounters().bytes - before.bytes);
+        sample.peakLiveBytes = static_cast<double>(peakLiveBytes() - before.liveBytes);
+        raisePeakLiveBytes(outerPeak);
+        setMemoryAccounting(false);
+
+        DiagnosticEngine diagnostics;
+        Lexer lexer(source, diagnostics);
+        newVector<Token> tokens = lexer.lex();
+        sample.lexSeconds = fastestSeconds(iterations, [&source] {
+            DiagnosticEngine runDiagnostics;
+            Lexer runLexer(source, runDiagnostics);
+            newVector<Token> runTokens = runLexer.lex();
+        });
+        if (scalingCase.parse) {
+            sample.parseSeconds = fastestSeconds(iterations, [&tokens, &scalingCase, useLalr] {
+                DiagnosticEngine runDiagnostics;
+                delete parseTokens(tokens, runDiagnostics, scalingCase.nestingLimit, useLalr);
+            });
+        }
+        // 各个阶段在同一棵AST上重复执行，不计入内存统计
+        if (scalingCase.passes && sample.valid) {
+            ASTNode* ast = parseTokens(tokens, diagnostics, scalingCase.nestingLimit, useLalr);
+            sample.valid = runPasses(ast);
+            if (sample.valid) {
+                sample.passesSeconds = fastestSeconds(iterations, [ast] {
+                    runPasses(ast);
+                });
+            }
+            delete ast;
+        }
+        return sample;
+    }
+
+    // 相邻两个规模之间的增长指数log(v[i+1] / v[i]) / log(2)取中位数。
+    // 缓存和分配器在某个规模上的跃变只影响其中一步，平方级的增长在每一步都接近2
+    double growthExponent(const std::vector<Sample>& samples, double Sample::* value) {
+        std::vector<double> steps;
+        for (size_t i = 1; i < samples.size(); i++) {
+            double previous = std::max(samples[i - 1].*value, 1e-12);
+            double current = std::max(samples[i].*value, 1e-12);
+            steps.push_back(std::log(current / previous) / std::log(static_cast<double>(samples[i].size) / static_cast<double>(samples[i - 1].size)));
+        }
+        std::sort(steps.begin(), steps.end());
+        size_t middle = steps.size() / 2;
+        return steps.size() % 2 == 1 ? steps[middle] : (steps[middle - 1] + steps[middle]) / 2.0;
+    }
+}
+
+int runScalingBenchmark(size_t iterations, double margin, bool useLalr, std::ostream& os) {
+    double limit = 1.0 + margin;
+    std::vector<std::string> failures;
+    os << "Scaling benchmark: " << iterations << " iteration(s), " << (useLalr ? "lalr" : "rd")
+        << " parser, exponent limit " << std::fixed << std::setprecision(2) << limit << "\n";
+    for (const ScalingCase& scalingCase : cases) {
+        // 超过上限时重新测量一次，两次都超过才算失败，排除测量期间机器偶然的繁忙
+        std::vector<Sample> samples;
+        bool valid = true;
+        bool linear = false;
+        double exponents[5] = {};
+        size_t attempt = 0;
+        for (; attempt < 2 && valid && !linear; attempt++) {
+            samples.clear();
+            for (size_t i = 0; i < pointCount; i++) {
+                samples.push_back(measure(scalingCase, scalingCase.firstSize << i, iterations, useLalr));
+                valid = valid && samples.back().valid;
+            }
+            exponents[0] = growthExponent(samples, &Sample::lexSeconds);
+            exponents[1] = scalingCase.parse ? growthExponent(samples, &Sample::parseSeconds) : 0.0;
+            exponents[2] = scalingCase.passes ? growthExponent(samples, &Sample::passesSeconds) : 0.0;
+            exponents[3] = growthExponent(samples, &Sample::allocatedBytes);
+            exponents[4] = growthExponent(samples, &Sample::peakLiveBytes);
+            linear = std::all_of(std::begin(exponents), std::end(exponents), [limit](double exponent) {
+                return exponent <= limit;
+            });
+        }
+
+        os << scalingCase.name << " (" << scalingCase.unit << ")" << (attempt > 1 ? ", measured twice" : "") << "\n";
+        os << std::right << std::setw(12) << "size" << std::setw(12) << "Lex (ms)" << std::setw(12) << "Parse (ms)"
+            << std::setw(13) << "Passes (ms)" << std::setw(14) << "Allocated" << std::setw(14) << "Peak live" << "\n";
+        for (const Sample& sample : samples) {
+            os << std::setw(12) << sample.size << std::setprecision(3) << std::setw(12) << sample.lexSeconds * 1000.0;
+            if (scalingCase.parse) {
+                os << std::setw(12) << sample.parseSeconds * 1000.0;
+            }
+            else {
+                os << std::setw(12) << "-";
+            }
+            if (scalingCase.passes) {
+                os << std::setw(13) << sample.passesSeconds * 1000.0;
+            }
+            else {
+                os << std::setw(13) << "-";
+            }
+            os << std::setprecision(0) << std::setw(14) << sample.allocatedBytes << std::setw(14) << sample.peakLiveBytes
+                << (sample.valid ? "" : "  (input rejected)") << "\n";
+        }
+
+        os << std::setw(12) << "exponent" << std::setprecision(2) << std::setw(12) << exponents[0];
+        if (scalingCase.parse) {
+            os << std::setw(12) << exponents[1];
+        }
+        else {
+            os << std::setw(12) << "-";
+        }
+        if (scalingCase.passes) {
+            os << std::setw(13) << exponents[2];
+        }
+        else {
+            os << std::setw(13) << "-";
+        }
+        os << std::setw(14) << exponents[3] << std::setw(14) << exponents[4] << "  "
+            << (!valid ? "FAILED (input rejected)" : linear ? "ok" : "FAILED (superlinear)") << "\n";
+        if (!valid || !linear) {
+            failures.push_back(scalingCase.name);
+        }
+    }
+
+    if (failures.empty()) {
+        os << "All " << std::size(cases) << " inputs scale linearly\n";
+        return 0;
+    }
+    os << failures.size() << " of " << std::size(cases) << " inputs failed:";
+    for (const std::string& name : failures) {
+        os << " " << name;
+    }
+    os << "\n";
+    return 1;
+}
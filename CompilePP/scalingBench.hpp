@@ -0,0 +1,11 @@
+#pragma once
+#include <cstddef>
+#include <iostream>
+
+// 病态输入的规模测试：对每类输入（很长的标识符和字符串、很深的括号和复合语句嵌套、
+// 很长的表达式链、赋值链、前缀运算符链、条件运算符链和else if链、大量的声明）按规模成倍生成几个程序，
+// 测量词法分析和语法分析的时间、分配的字节数和存活字节数的峰值，每一项取规模每翻一倍时增长指数的中位数。
+// 赋值、前缀、条件和else if链的AST与链一样深，还测量名字解析、类型检查、IR构造、字节码执行和解释执行的时间。
+// 任何一个指数超过1 + margin时重新测量，仍然超过时该类输入判为失败，返回非0，用来发现平方级的退化。
+// 时间取iterations轮测量中最快的一次执行，每轮至少持续20毫秒
+int runScalingBenchmark(size_t iterations, double margin, bool useLalr, std::ostream& os);
@@ -0,0 +1,92 @@
+#include <thread>
+#include <utility>
+#include "spscRing.hpp"
+
+namespace spscDetail {
+    // 先自旋一小段时间，再让出CPU，单核机器上也不会卡住对端
+    inline void backoff(unsigned& spins) {
+        if (++spins < 64) {
+            return;
+        }
+        std::this_thread::yield();
+    }
+}
+
+template <typename T>
+SpscRing<T>::SpscRing(size_t capacity)
+    : mask_(0), head_(0), cachedTail_(0), tail_(0), cachedHead_(0), closed_(false) {
+    size_t size = 2;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    slots_.resize(size);
+    mask_ = size - 1;
+}
+
+template <typename T>
+bool SpscRing<T>::tryPush(T& value) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cachedHead_ > mask_) {
+        cachedHead_ = head_.load(std::memory_order_acquire);
+        if (tail - cachedHead_ > mask_) {
+            return false;
+        }
+    }
+    slots_[tail & mask_] = std::move(value);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T>
+bool SpscRing<T>::tryPop(T& value) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head == cachedTail_) {
+        cachedTail_ = tail_.load(std::memory_order_acquire);
+        if (head == cachedTail_) {
+            return false;
+        }
+    }
+    value = std::move(slots_[head & mask_]);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T>
+bool SpscRing<T>::push(T&& value) {
+    unsigned spins = 0;
+    while (!tryPush(value)) {
+        if (closed_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        spscDetail::backoff(spins);
+    }
+    return true;
+}
+
+template <typename T>
+bool SpscRing<T>::pop(T& value) {
+    unsigned spins = 0;
+    while (!tryPop(value)) {
+        if (closed_.load(std::memory_order_acquire)) {
+            // 关闭前最后写入的元素可能刚刚可见，再取一次
+            return tryPop(value);
+        }
+        spscDetail::backoff(spins);
+    }
+    return true;
+}
+
+template <typename T>
+void SpscRing<T>::close() {
+    closed_.store(true, std::memory_order_release);
+}
+
+template <typename T>
+bool SpscRing<T>::closed() const {
+    return closed_.load(std::memory_order_acquire);
+}
+
+template <typename T>
+size_t SpscRing<T>::capacity() const {
+    return slots_.size();
+}
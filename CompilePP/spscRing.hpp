@@ -0,0 +1,41 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// 单生产者/单消费者无锁环形队列
+// 生产者只写tail_，消费者只写head_，两端各自缓存对方的位置，减少跨核的缓存行同步
+// 队列满时push等待（背压），保证内存占用有上限
+template <typename T>
+class SpscRing {
+public:
+    // 容量向上取整为2的幂
+    explicit SpscRing(size_t capacity);
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // 非阻塞接口，成功时value被移走
+    bool tryPush(T& value);
+    bool tryPop(T& value);
+
+    // 队列满时等待；队列已关闭时返回false
+    bool push(T&& value);
+    // 队列空时等待；队列已关闭且没有剩余元素时返回false
+    bool pop(T& value);
+
+    // 任意一端都可以关闭：生产者表示不再有数据，消费者表示不再接收
+    void close();
+    bool closed() const;
+
+    size_t capacity() const;
+
+private:
+    std::vector<T> slots_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> head_;  // 下一个要读取的位置，消费者写
+    size_t cachedTail_;                     // 消费者缓存的tail_
+    alignas(64) std::atomic<size_t> tail_;  // 下一个要写入的位置，生产者写
+    size_t cachedHead_;                     // 生产者缓存的head_
+    alignas(64) std::atomic<bool> closed_;
+};
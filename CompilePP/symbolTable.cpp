@@ -0,0 +1,47 @@
+#include "symbolTable.hpp"
+
+SymbolTable::SymbolTable() {
+    undoLog_.reserve(256);
+    scopeMarks_.reserve(32);
+}
+
+void SymbolTable::pushScope() {
+    scopeMarks_.push_back(undoLog_.size());
+}
+
+void SymbolTable::popScope() {
+    size_t mark = scopeMarks_.back();
+    scopeMarks_.pop_back();
+    while (undoLog_.size() > mark) {
+        const UndoEntry& entry = undoLog_.back();
+        bindings_[entry.name] = entry.previous;
+        undoLog_.pop_back();
+    }
+}
+
+uint32_t SymbolTable::depth() const {
+    return static_cast<uint32_t>(scopeMarks_.size());
+}
+
+uint32_t SymbolTable::declare(uint32_t name, uint32_t symbol) {
+    if (name >= bindings_.size()) {
+        bindings_.resize(name + 1 > bindings_.size() * 2 ? name + 1 : bindings_.size() * 2, { npos, 0 });
+    }
+    Binding& binding = bindings_[name];
+    if (binding.symbol != npos && binding.depth == depth()) {
+        return binding.symbol;
+    }
+    // 文件作用域的绑定永远不会被撤销，不必记日志
+    if (depth() != 0) {
+        undoLog_.push_back({ name, binding });
+    }
+    binding = { symbol, depth() };
+    return npos;
+}
+
+uint32_t SymbolTable::lookup(uint32_t name) const {
+    if (name >= bindings_.size()) {
+        return npos;
+    }
+    return bindings_[name].symbol;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 作用域栈：记录每个标识符（驻留编号）当前可见的符号
+// 标识符编号是连续的小整数，按编号直接下标访问；
+// 声明时把被遮蔽的旧绑定记入撤销日志，退出作用域时按日志恢复，
+// 因此进入作用域是O(1)，退出作用域的开销与该作用域内的声明数成正比
+class SymbolTable {
+public:
+    static constexpr uint32_t npos = UINT32_MAX;
+
+    SymbolTable();
+
+    void pushScope();
+    void popScope();
+    // 当前作用域深度，文件作用域为0
+    uint32_t depth() const;
+
+    // 在当前作用域把name绑定到symbol
+    // 同一作用域内已有绑定时不做修改，返回已有的符号；否则返回npos
+    uint32_t declare(uint32_t name, uint32_t symbol);
+    // name当前可见的符号，没有时返回npos
+    uint32_t lookup(uint32_t name) const;
+
+private:
+    struct Binding {
+        uint32_t symbol;
+        uint32_t depth;
+    };
+    struct UndoEntry {
+        uint32_t name;
+        Binding previous;
+    };
+
+    std::vector<Binding> bindings_;     // 按标识符编号下标
+    std::vector<UndoEntry> undoLog_;
+    std::vector<size_t> scopeMarks_;    // 每个作用域开始时撤销日志的长度
+};
@@ -0,0 +1,144 @@
+#include <vector>
+#include "syntaxOutput.hpp"
+#include "astVisitor.hpp"
+#include "astVisitor.cpp"
+#include "newVector.cpp"
+
+namespace {
+    // 每个节点一行，按深度缩进
+    class TextPrinter : public AstVisitor<TextPrinter> {
+    public:
+        explicit TextPrinter(BufferedWriter& writer) : writer_(writer) {}
+
+        VisitAction enterNode(NodeKind, const ASTNode* node) {
+            writer_.fill(' ', depth() * 2);
+            writer_.write(node->type);
+            writer_.write(": ");
+            writer_.write(node->value);
+            writer_.put('\n');
+            return VisitAction::Continue;
+        }
+
+    private:
+        BufferedWriter& writer_;
+    };
+
+    // 兄弟节点之间的逗号取决于它是不是父节点的第一个非空子节点，按深度记录
+    class JsonPrinter : public AstVisitor<JsonPrinter> {
+    public:
+        explicit JsonPrinter(BufferedWriter& writer) : writer_(writer) {}
+
+        VisitAction enterNode(NodeKind, const ASTNode* node) {
+            size_t level = depth();
+            if (level + 2 > first_.size()) {
+                first_.resize(level + 2, true);
+            }
+            if (!first_[level]) {
+                writer_.put(',');
+            }
+            first_[level] = false;
+            first_[level + 1] = true;
+            writer_.write("{\"type\":");
+            writer_.writeJsonString(node->type);
+            writer_.write(",\"value\":");
+            writer_.writeJsonString(node->value);
+            writer_.write(",\"children\":[");
+            return VisitAction::Continue;
+        }
+        VisitAction leaveNode(NodeKind, const ASTNode*) {
+            writer_.write("]}");
+            return VisitAction::Continue;
+        }
+
+    private:
+        BufferedWriter& writer_;
+        std::vector<bool> first_;     // 按深度：下一个节点是否是第一个子节点
+    };
+
+    class BinaryPrinter : public AstVisitor<BinaryPrinter> {
+    public:
+        explicit BinaryPrinter(BufferedWriter& writer) : writer_(writer) {}
+
+        VisitAction enterNode(NodeKind kind, const ASTNode* node) {
+            writer_.put(static_cast<char>(kind));
+            if (kind == NodeKind::Token) {
+                writeString(node->type);
+            }
+            writeString(node->value);
+            uint64_t children = 0;
+            for (const ASTNode* child : node->children) {
+                children += child != nullptr ? 1 : 0;
+            }
+            writer_.writeVarint(children);
+            return VisitAction::Continue;
+        }
+
+    private:
+        BufferedWriter& writer_;
+
+        void writeString(const std::string& text) {
+            writer_.writeVarint(text.size());
+            writer_.write(text);
+        }
+    };
+}
+
+bool parseOutputMode(const std::string& name, OutputMode& mode) {
+    static const struct {
+        const char* name;
+        OutputMode mode;
+    } modes[] = {
+        { "none", OutputMode::None }, { "tokens", OutputMode::Tokens }, { "ast", OutputMode::Ast },
+        { "text", OutputMode::Text }, { "json", OutputMode::Json }, { "binary", OutputMode::Binary },
+    };
+    for (const auto& entry : modes) {
+        if (name == entry.name) {
+            mode = entry.mode;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool outputsTokens(OutputMode mode) {
+    return mode == OutputMode::Tokens || mode == OutputMode::Text;
+}
+
+void writeTokens(const newVector<Token>& tokens, BufferedWriter& writer) {
+    for (size_t i = 0; i < tokens.size(); i++) {
+        const Token& token = tokens[i];
+        writer.write("Token: ");
+        writer.writeUnsigned(static_cast<uint64_t>(token.type));
+        writer.write(", Lexeme: ");
+        writer.write(token.lexeme);
+        writer.write(", Line: ");
+        writer.writeUnsigned(token.line);
+        writer.write(", Column: ");
+        writer.writeUnsigned(token.column);
+        writer.put('\n');
+    }
+}
+
+void writeAstText(const ASTNode* root, BufferedWriter& writer) {
+    TextPrinter printer(writer);
+    printer.traverse(root);
+}
+
+void writeAstJson(const ASTNode* root, BufferedWriter& writer) {
+    if (root == nullptr) {
+        writer.write("null\n");
+        return;
+    }
+    JsonPrinter printer(writer);
+    printer.traverse(root);
+    writer.put('\n');
+}
+
+void writeAstBinary(const ASTNode* root, BufferedWriter& writer) {
+    writer.write("CPPAST");
+    writer.put(1);
+    if (root != nullptr) {
+        BinaryPrinter printer(writer);
+        printer.traverse(root);
+    }
+}
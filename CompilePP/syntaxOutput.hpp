@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "ast.hpp"
+#include "bufferedWriter.hpp"
+#include "lexer.hpp"
+#include "newVector.hpp"
+
+// 语法分析结果的输出方式（--output=）
+enum class OutputMode : uint8_t
+{
+    None,       // 不输出
+    Tokens,     // 每个Token一行
+    Ast,        // AST文本，每个节点一行，按深度缩进
+    Text,       // Token和AST文本（默认）
+    Json,       // AST的JSON：{"type":...,"value":...,"children":[...]}
+    Binary      // 紧凑的二进制AST，格式见writeAstBinary
+};
+
+// 解析--output=的取值：none、tokens、ast、text、json、binary
+bool parseOutputMode(const std::string& name, OutputMode& mode);
+bool outputsTokens(OutputMode mode);
+
+// 以下函数都只向writer追加，由调用者决定何时flush；AST的遍历不使用递归
+void writeTokens(const newVector<Token>& tokens, BufferedWriter& writer);
+void writeAstText(const ASTNode* root, BufferedWriter& writer);
+void writeAstJson(const ASTNode* root, BufferedWriter& writer);
+// 文件头是"CPPAST"和版本号1两个字节，之后按先序排列节点，每个节点是：
+//   节点类型（1字节，NodeKind的值）
+//   Token类型的节点再跟type字符串；字符串都是LEB128长度加字节
+//   value字符串
+//   非空子节点个数（LEB128）
+void writeAstBinary(const ASTNode* root, BufferedWriter& writer);
@@ -0,0 +1,131 @@
+#include "threadPool.hpp"
+
+namespace {
+    // 记录当前线程属于哪个线程池以及在池中的编号
+    thread_local const ThreadPool* currentPool = nullptr;
+    thread_local size_t currentIndex = 0;
+}
+
+ThreadPool::ThreadPool(size_t threadCount)
+    : queued_(0), pending_(0), nextQueue_(0), stopping_(false) {
+    if (threadCount == 0) {
+        threadCount = std::thread::hardware_concurrency();
+        if (threadCount == 0) {
+            threadCount = 1;
+        }
+    }
+    for (size_t i = 0; i < threadCount; i++) {
+        queues_.push_back(std::make_unique<WorkQueue>());
+    }
+    for (size_t i = 0; i < threadCount; i++) {
+        workers_.emplace_back([this, i] { workerLoop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    workAvailable_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::size() const {
+    return workers_.size();
+}
+
+size_t ThreadPool::currentWorker() const {
+    return currentPool == this ? currentIndex : workers_.size();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    pending_.fetch_add(1, std::memory_order_relaxed);
+
+    size_t target = currentWorker();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (target == workers_.size()) {
+            // 外部线程提交的任务轮流分配给各个队列
+            target = nextQueue_;
+            nextQueue_ = (nextQueue_ + 1) % queues_.size();
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues_[target]->mutex);
+        queues_[target]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queued_.fetch_add(1, std::memory_order_relaxed);
+    }
+    workAvailable_.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this] { return pending_.load() == 0; });
+    if (firstError_) {
+        std::exception_ptr error = firstError_;
+        firstError_ = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+bool ThreadPool::popTask(size_t self, std::function<void()>& task) {
+    // 先取自己的队尾
+    {
+        WorkQueue& own = *queues_[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    // 再从其他队列的队头窃取
+    for (size_t offset = 1; offset < queues_.size(); offset++) {
+        WorkQueue& victim = *queues_[(self + offset) % queues_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(size_t self) {
+    currentPool = this;
+    currentIndex = self;
+
+    while (true) {
+        std::function<void()> task;
+        if (popTask(self, task)) {
+            queued_.fetch_sub(1, std::memory_order_relaxed);
+            try {
+                task();
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!firstError_) {
+                    firstError_ = std::current_exception();
+                }
+            }
+            if (pending_.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                idle_.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        workAvailable_.wait(lock, [this] { return stopping_ || queued_.load() != 0; });
+        if (stopping_ && queued_.load() == 0) {
+            return;
+        }
+    }
+}
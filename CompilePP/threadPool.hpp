@@ -0,0 +1,54 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 工作窃取线程池：每个工作线程有自己的任务队列，
+// 自己的任务从队尾取（LIFO，缓存友好），空闲时从其他线程的队头窃取
+class ThreadPool {
+public:
+    // threadCount为0时使用硬件线程数
+    explicit ThreadPool(size_t threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // 提交任务；在工作线程内提交时放入本线程的队列
+    void submit(std::function<void()> task);
+
+    // 等待所有已提交的任务完成，任务抛出的第一个异常在这里重新抛出
+    // 不能在工作线程内调用
+    void wait();
+
+    size_t size() const;
+
+    // 当前线程在池中的编号，非工作线程返回size()
+    size_t currentWorker() const;
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> queues_;
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable workAvailable_;
+    std::condition_variable idle_;
+    std::atomic<size_t> queued_;   // 队列中尚未被取走的任务数
+    std::atomic<size_t> pending_;  // 尚未执行完的任务数
+    size_t nextQueue_;
+    bool stopping_;
+    std::exception_ptr firstError_;
+
+    bool popTask(size_t self, std::function<void()>& task);
+    void workerLoop(size_t self);
+};
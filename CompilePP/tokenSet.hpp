@@ -0,0 +1,75 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include "lexer.hpp"
+
+// TokenType的取值个数，END_OF_FILE必须是最后一个枚举值
+constexpr size_t tokenTypeCount = static_cast<size_t>(TokenType::END_OF_FILE) + 1;
+
+// 语法分析用到的Token类型都在预处理Token之前，集合只需要一个64位字
+static_assert(static_cast<size_t>(TokenType::HASH) <= 64, "the token types used by the parser must fit in one 64-bit word");
+
+// Token类型的集合，在编译期构造
+// 成员按名字列出，与TokenType的枚举顺序无关；成员只能是前64种TokenType（在常量求值中越界的移位是编译错误），
+// contains对更后面的类型（预处理Token和END_OF_FILE）返回false，是一次范围比较加一次对常量字的位测试
+class TokenSet {
+public:
+    constexpr TokenSet() : bits_(0) {
+    }
+
+    constexpr TokenSet(std::initializer_list<TokenType> types) : bits_(0) {
+        for (TokenType type : types) {
+            bits_ |= uint64_t(1) << static_cast<size_t>(type);
+        }
+    }
+
+    constexpr bool contains(TokenType type) const {
+        size_t index = static_cast<size_t>(type);
+        return index < 64 && ((bits_ >> index) & 1) != 0;
+    }
+
+    constexpr TokenSet operator|(const TokenSet& other) const {
+        TokenSet result;
+        result.bits_ = bits_ | other.bits_;
+        return result;
+    }
+
+private:
+    uint64_t bits_;
+};
+
+// 语法分析中用到的Token类型集合
+namespace TokenSets {
+    // 类型说明符
+    constexpr TokenSet typeSpecifiers = {
+        TokenType::INTEGER, TokenType::FLOAT, TokenType::DOUBLE, TokenType::STRING,
+        TokenType::CHARACTER, TokenType::BOOLEAN, TokenType::NULLPTR
+    };
+    // 以关键字开头的语句
+    constexpr TokenSet statementKeywords = {
+        TokenType::IF, TokenType::ELSE, TokenType::WHILE, TokenType::FOR, TokenType::RETURN,
+        TokenType::BREAK, TokenType::CONTINUE
+    };
+    // 表达式语句（包括空语句）的开头
+    constexpr TokenSet expressionStatementStarters = {
+        TokenType::IDENTIFIER, TokenType::CONSTANT, TokenType::LEFT_PAREN, TokenType::SEMICOLON,
+        TokenType::PLUS, TokenType::MINUS, TokenType::NOT, TokenType::BITWISE_NOT,
+        TokenType::INCREMENT, TokenType::DECREMENT, TokenType::SIZEOF
+    };
+    constexpr TokenSet assignmentOperators = {
+        TokenType::ASSIGN, TokenType::PLUS_ASSIGN, TokenType::MINUS_ASSIGN,
+        TokenType::MULTIPLY_ASSIGN, TokenType::DIVIDE_ASSIGN, TokenType::MODULO_ASSIGN
+    };
+    constexpr TokenSet equalityOperators = { TokenType::EQUAL, TokenType::NOT_EQUAL };
+    constexpr TokenSet relationalOperators = {
+        TokenType::LESS_THAN, TokenType::GREATER_THAN,
+        TokenType::LESS_THAN_OR_EQUAL_TO, TokenType::GREATER_THAN_OR_EQUAL_TO
+    };
+    constexpr TokenSet shiftOperators = { TokenType::SHIFT_LEFT, TokenType::SHIFT_RIGHT, TokenType::SHIFT_RIGHT_UNSIGNED };
+    constexpr TokenSet additiveOperators = { TokenType::PLUS, TokenType::MINUS };
+    constexpr TokenSet multiplicativeOperators = { TokenType::MULTIPLY, TokenType::DIVIDE, TokenType::MODULO };
+    constexpr TokenSet unaryOperators = { TokenType::PLUS, TokenType::MINUS, TokenType::NOT, TokenType::BITWISE_NOT };
+    constexpr TokenSet memberAccessOperators = { TokenType::DOT, TokenType::ARROW };
+    constexpr TokenSet incrementOperators = { TokenType::INCREMENT, TokenType::DECREMENT };
+}
@@ -0,0 +1,649 @@
+#include <utility>
+#include "typeChecker.hpp"
+
+namespace {
+    const ASTNode* childAt(const ASTNode* node, size_t index) {
+        return node != nullptr && index < node->children.size() ? node->children[index] : nullptr;
+    }
+
+    const char* const printBuiltin = "print";
+}
+
+TypeTable::TypeTable() {
+    types_.push_back({ TypeKind::Error, ValueType::Void, -1, 0, 0 });
+    for (ValueType type : { ValueType::Int, ValueType::Float, ValueType::Double, ValueType::Char, ValueType::Bool, ValueType::Void }) {
+        scalars_[static_cast<size_t>(type)] = static_cast<TypeId>(types_.size());
+        types_.push_back({ TypeKind::Scalar, type, -1, 0, 0 });
+    }
+    scalars_[static_cast<size_t>(ValueType::Array)] = errorType;
+}
+
+TypeId TypeTable::scalar(ValueType type) const {
+    return scalars_[static_cast<size_t>(type)];
+}
+
+TypeId TypeTable::arrayOf(ValueType element, int32_t length) {
+    uint64_t key = (uint64_t(element) << 32) | static_cast<uint32_t>(length);
+    auto [it, inserted] = arrays_.try_emplace(key, static_cast<TypeId>(types_.size()));
+    if (inserted) {
+        types_.push_back({ TypeKind::Array, element, length, 0, 0 });
+    }
+    return it->second;
+}
+
+TypeId TypeTable::function(ValueType returnType, const std::vector<ValueType>& parameters) {
+    std::vector<ValueType> key;
+    key.reserve(parameters.size() + 1);
+    key.push_back(returnType);
+    key.insert(key.end(), parameters.begin(), parameters.end());
+    auto [it, inserted] = functions_.try_emplace(std::move(key), static_cast<TypeId>(types_.size()));
+    if (inserted) {
+        types_.push_back({ TypeKind::Function, returnType, -1, static_cast<uint32_t>(parameters_.size()),
+            static_cast<uint32_t>(parameters.size()) });
+        parameters_.insert(parameters_.end(), parameters.begin(), parameters.end());
+    }
+    return it->second;
+}
+
+const TypeInfo& TypeTable::info(TypeId type) const {
+    return types_[type];
+}
+
+ValueType TypeTable::parameter(TypeId function, size_t index) const {
+    return parameters_[types_[function].firstParameter + index];
+}
+
+std::string TypeTable::name(TypeId type) const {
+    const TypeInfo& info = types_[type];
+    switch (info.kind) {
+    case TypeKind::Scalar:
+        return valueTypeName(info.scalar);
+    case TypeKind::Array:
+        return std::string(valueTypeName(info.scalar)) + "[" + (info.length >= 0 ? std::to_string(info.length) : "") + "]";
+    case TypeKind::Function: {
+        std::string text = std::string(valueTypeName(info.scalar)) + "(";
+        for (uint32_t i = 0; i < info.parameterCount; i++) {
+            text += (i != 0 ? ", " : "");
+            text += valueTypeName(parameters_[info.firstParameter + i]);
+        }
+        return text + ")";
+    }
+    default:
+        return "<error>";
+    }
+}
+
+size_t TypeTable::size() const {
+    return types_.size();
+}
+
+TypeChecker::TypeChecker(const NameResolver& resolver)
+    : resolver_(resolver), function_(nullptr), returnType_(ValueType::Int) {
+}
+
+void TypeChecker::check(const ASTNode* root) {
+    symbolTypes_.assign(resolver_.symbols().size(), TypeTable::errorType);
+    if (root == nullptr) {
+        return;
+    }
+    // 名字解析没有访问过深的子树，这里的递归也会耗尽栈
+    if (resolver_.tooDeep() != nullptr) {
+        error(resolver_.tooDeep(), "program is nested more than " + std::to_string(astDepthLimit) + " levels deep");
+        return;
+    }
+    for (const ASTNode* declaration : root->children) {
+        if (declaration == nullptr) {
+            continue;
+        }
+        if (declaration->type == "FunctionDefinitionNode") {
+            visitFunctionDefinition(declaration);
+        }
+        else if (declaration->type == "DeclarationNode") {
+            visitDeclaration(declaration);
+        }
+        else {
+            error(declaration, "unsupported external declaration '" + declaration->type + "'");
+        }
+    }
+}
+
+TypeId TypeChecker::typeOf(const ASTNode* expression) const {
+    uint32_t type = nodeTypes_.find(expression);
+    return type == NodeMap::npos ? TypeTable::errorType : type;
+}
+
+ValueType TypeChecker::valueTypeOf(const ASTNode* expression) const {
+    const TypeInfo& info = types_.info(typeOf(expression));
+    switch (info.kind) {
+    case TypeKind::Scalar:
+        return info.scalar == ValueType::Void ? ValueType::Void : promotedType(info.scalar);
+    case TypeKind::Array:
+        return ValueType::Array;
+    default:
+        return ValueType::Int;
+    }
+}
+
+TypeId TypeChecker::symbolType(const Symbol& symbol) const {
+    size_t index = static_cast<size_t>(&symbol - resolver_.symbols().data());
+    return index < symbolTypes_.size() ? symbolTypes_[index] : TypeTable::errorType;
+}
+
+const TypeTable& TypeChecker::types() const {
+    return types_;
+}
+
+size_t TypeChecker::typedCount() const {
+    return nodeTypes_.size();
+}
+
+const std::vector<TypeError>& TypeChecker::errors() const {
+    return errors_;
+}
+
+void TypeChecker::visitStatement(const ASTNode* node) {
+    if (node == nullptr) {
+        return;
+    }
+    const std::string& type = node->type;
+    if (type == "CompoundStatement") {
+        for (const ASTNode* child : node->children) {
+            visitStatement(child);
+        }
+    }
+    else if (type == "DeclarationNode") {
+        visitDeclaration(node);
+    }
+    else if (type == "ExpressionNode") {
+        // 空语句
+    }
+    else if (type == "SelectionStatement") {
+        // SelectionStatement: expression statement statement?
+        visitCondition(childAt(node, 0));
+        visitStatement(childAt(node, 1));
+        visitStatement(childAt(node, 2));
+    }
+    else if (type == "IterationStatement") {
+        bool isFor = node->value == "for";
+        const ASTNode* condition = childAt(node, isFor ? 1 : 0);
+        const ASTNode* step = isFor ? childAt(node, 2) : nullptr;
+        if (isFor) {
+            visitStatement(childAt(node, 0));
+        }
+        if (condition != nullptr && condition->type != "ExpressionNode") {
+            visitCondition(condition);
+        }
+        if (step != nullptr && step->type != "ExpressionNode") {
+            visitExpression(step);
+        }
+        visitStatement(childAt(node, isFor ? 3 : 1));
+    }
+    else if (type == "JumpStatement") {
+        if (node->value != "return" || node->children.empty()) {
+            return;
+        }
+        const ASTNode* value = node->children[0];
+        TypeId result = visitExpression(value);
+        if (function_ != nullptr && returnType_ == ValueType::Void) {
+            error(value, "void function '" + resolver_.names().name(function_->name) + "' should not return a value");
+        }
+        else {
+            requireArithmetic(result, value, "return");
+        }
+    }
+    else {
+        visitExpression(node);
+    }
+}
+
+// FunctionDefinitionNode: TypeSpecifier DirectDeclarator CompoundStatement
+void TypeChecker::visitFunctionDefinition(const ASTNode* node) {
+    const ASTNode* declarator = childAt(node, 1);
+    TypeId type = declareFunction(childAt(node, 0), declarator);
+    function_ = resolver_.declarationOf(childAt(declarator, 1));
+    returnType_ = types_.info(type).kind == TypeKind::Function ? types_.info(type).scalar : ValueType::Int;
+    const ASTNode* parameters = childAt(declarator, 2);
+    if (parameters != nullptr) {
+        for (const ASTNode* parameter : parameters->children) {
+            // ParameterDeclaration: TypeSpecifier Identifier
+            declareSymbol(childAt(parameter, 1), typeFromSpecifier(childAt(parameter, 0), false));
+        }
+    }
+    visitStatement(childAt(node, 2));
+    function_ = nullptr;
+}
+
+// DeclarationNode: TypeSpecifier InitDeclaratorList
+// 与各执行引擎一致：逗号后面的名字是同一类型的标量，初始化表达式属于最后一个名字
+void TypeChecker::visitDeclaration(const ASTNode* node) {
+    const ASTNode* typeSpecifier = childAt(node, 0);
+    const ASTNode* list = childAt(node, 1);
+    if (list == nullptr) {
+        return;
+    }
+    TypeId base = typeFromSpecifier(typeSpecifier, true);
+    bool isVoid = base == types_.scalar(ValueType::Void);
+    for (const ASTNode* initDeclarator : list->children) {
+        // InitDeclarator: DirectDeclarator initializer?
+        const ASTNode* declarator = childAt(initDeclarator, 0);
+        const ASTNode* initializer = childAt(initDeclarator, 1);
+        if (declarator == nullptr || declarator->children.empty() || declarator->children[0] == nullptr) {
+            error(initDeclarator, "incomplete syntax tree");
+            continue;
+        }
+        const std::string& marker = declarator->children[0]->type;
+        size_t next = 0;
+        if (marker == "ArrayDeclarator") {
+            // DirectDeclarator: ArrayDeclarator Identifier constant_expression
+            const ASTNode* identifier = childAt(declarator, 1);
+            const ASTNode* lengthNode = childAt(declarator, 2);
+            TypeId lengthType = visitExpression(lengthNode);
+            int32_t length = -1;
+            RuntimeValue constant;
+            if (lengthType != TypeTable::errorType && (!isArithmetic(lengthType) || isFloatingType(types_.info(lengthType).scalar))) {
+                error(lengthNode, "array length must be an integer");
+                lengthType = TypeTable::errorType;
+            }
+            else if (lengthType != TypeTable::errorType && lengthNode->type == "PrimaryExpression" && parseConstant(lengthNode->value, constant)) {
+                length = constant.intValue;
+            }
+            TypeId type = TypeTable::errorType;
+            if (isVoid) {
+                error(identifier, "array '" + (identifier != nullptr ? identifier->value : std::string()) + "' declared void");
+            }
+            else if (base != TypeTable::errorType && lengthType != TypeTable::errorType) {
+                type = types_.arrayOf(types_.info(base).scalar, length);
+            }
+            declareSymbol(identifier, type);
+            next = 3;
+        }
+        else if (marker == "FunctionDeclarator") {
+            declareFunction(typeSpecifier, declarator);
+            next = 3;
+        }
+        for (size_t i = next; i < declarator->children.size(); i++) {
+            const ASTNode* identifier = declarator->children[i];
+            if (isVoid && identifier != nullptr) {
+                error(identifier, "variable '" + identifier->value + "' declared void");
+            }
+            declareSymbol(identifier, isVoid ? TypeTable::errorType : base);
+        }
+        if (initializer != nullptr) {
+            TypeId value = visitExpression(initializer);
+            if (next == declarator->children.size()) {
+                error(initializer, marker == "ArrayDeclarator" ? "array initializers are not supported" : "initializer on a function declaration");
+            }
+            else {
+                requireArithmetic(value, initializer, "=");
+            }
+        }
+    }
+}
+
+// DirectDeclarator: FunctionDeclarator Identifier ParameterList
+// 原型和定义声明同一个符号，两者的类型必须相同
+TypeId TypeChecker::declareFunction(const ASTNode* typeSpecifier, const ASTNode* declarator) {
+    TypeId returnType = typeFromSpecifier(typeSpecifier, true);
+    std::vector<ValueType> parameters;
+    bool valid = returnType != TypeTable::errorType;
+    const ASTNode* list = childAt(declarator, 2);
+    if (list != nullptr) {
+        for (const ASTNode* parameter : list->children) {
+            TypeId type = typeFromSpecifier(childAt(parameter, 0), false);
+            valid = valid && type != TypeTable::errorType;
+            parameters.push_back(types_.info(type).scalar);
+        }
+    }
+    TypeId type = valid ? types_.function(types_.info(returnType).scalar, parameters) : TypeTable::errorType;
+    declareSymbol(childAt(declarator, 1), type);
+    return type;
+}
+
+void TypeChecker::declareSymbol(const ASTNode* identifier, TypeId type) {
+    const Symbol* symbol = identifier != nullptr ? resolver_.declarationOf(identifier) : nullptr;
+    if (symbol == nullptr) {
+        return;
+    }
+    TypeId& declared = symbolTypes_[static_cast<size_t>(symbol - resolver_.symbols().data())];
+    if (declared != TypeTable::errorType && type != TypeTable::errorType && declared != type) {
+        error(identifier, "conflicting types for '" + identifier->value + "': '" + types_.name(declared) + "' and '" + types_.name(type) + "'");
+        return;
+    }
+    if (type != TypeTable::errorType) {
+        declared = type;
+    }
+}
+
+void TypeChecker::visitCondition(const ASTNode* node) {
+    TypeId type = visitExpression(node);
+    if (type != TypeTable::errorType && !isArithmetic(type)) {
+        error(node, "invalid condition of type '" + types_.name(type) + "'");
+    }
+}
+
+TypeId TypeChecker::visitExpression(const ASTNode* node) {
+    if (node == nullptr) {
+        error(nullptr, "incomplete syntax tree");
+        return TypeTable::errorType;
+    }
+    const std::string& type = node->type;
+    TypeId result = TypeTable::errorType;
+    if (type == "PrimaryExpression") {
+        result = visitPrimary(node);
+    }
+    else if (type == "AdditiveExpression" || type == "MultiplicativeExpression") {
+        result = visitBinary(node, node->value, childAt(node, 0), childAt(node, 1));
+    }
+    else if (type == "LogicalAndExpression" || type == "LogicalOrExpression") {
+        result = visitLogical(node);
+    }
+    else if (type == "ShiftExpression" || type == "RelationalExpression" || type == "EqualityExpression" ||
+        type == "AndExpression" || type == "ExclusiveOrExpression" || type == "InclusiveOrExpression") {
+        const ASTNode* op = childAt(node, 1);
+        result = visitBinary(node, op != nullptr ? op->type : std::string(), childAt(node, 0), childAt(node, 2));
+    }
+    else if (type == "AssignmentExpression") {
+        result = visitAssignment(node);
+    }
+    else if (type == "ConditionalExpression") {
+        // ConditionalExpression: condition ? whenTrue : whenFalse，结果是两个分支常用算术转换之后的类型
+        visitCondition(childAt(node, 0));
+        TypeId whenTrue = visitExpression(childAt(node, 1));
+        TypeId whenFalse = visitExpression(childAt(node, 2));
+        bool valid = requireArithmetic(whenTrue, childAt(node, 1), "?:");
+        if (requireArithmetic(whenFalse, childAt(node, 2), "?:") && valid) {
+            result = types_.scalar(arithmeticType(types_.info(whenTrue).scalar, types_.info(whenFalse).scalar));
+        }
+    }
+    else if (type == "CommaExpression") {
+        visitExpression(childAt(node, 0));
+        result = visitExpression(childAt(node, 1));
+    }
+    else if (type == "UnaryExpression" || type == "PostfixExpression") {
+        result = visitUnary(node);
+    }
+    else if (type == "CastExpression") {
+        // CastExpression: '(' TypeSpecifier ')' operand
+        TypeId target = typeFromSpecifier(childAt(node, 1), false);
+        TypeId operand = visitExpression(childAt(node, 3));
+        if (requireArithmetic(operand, childAt(node, 3), "cast")) {
+            result = target;
+        }
+    }
+    else if (type == "SizeofExpression") {
+        result = visitSizeof(node);
+    }
+    else if (type == "ArrayAccess") {
+        result = visitArrayAccess(node);
+    }
+    else if (type == "FunctionCall") {
+        result = visitCall(node);
+    }
+    else {
+        error(node, "unsupported expression '" + type + "'");
+    }
+    nodeTypes_.insert(node, result);
+    return result;
+}
+
+TypeId TypeChecker::visitPrimary(const ASTNode* node) {
+    RuntimeValue constant;
+    try {
+        if (parseConstant(node->value, constant)) {
+            return types_.scalar(constant.type);
+        }
+    }
+    catch (const RuntimeError& problem) {
+        error(node, problem.what());
+        return TypeTable::errorType;
+    }
+    const Symbol* symbol = resolver_.bindingOf(node);
+    if (symbol == nullptr) {
+        error(node, "undeclared identifier '" + node->value + "'");
+        return TypeTable::errorType;
+    }
+    return symbolType(*symbol);
+}
+
+TypeId TypeChecker::visitBinary(const ASTNode* node, const std::string& op, const ASTNode* left, const ASTNode* right) {
+    TypeId leftType = visitExpression(left);
+    TypeId rightType = visitExpression(right);
+    BinaryOp binary;
+    if (!binaryOpFromLexeme(op, binary)) {
+        error(node, "unsupported operator '" + op + "' in " + node->type);
+        return TypeTable::errorType;
+    }
+    // %、移位和位运算只接受整数
+    bool integer = binary >= BinaryOp::Mod && binary <= BinaryOp::BitXor;
+    bool valid = integer ? requireInteger(leftType, left, op) : requireArithmetic(leftType, left, op);
+    valid = (integer ? requireInteger(rightType, right, op) : requireArithmetic(rightType, right, op)) && valid;
+    if (!valid) {
+        return TypeTable::errorType;
+    }
+    if (binary >= BinaryOp::Less) {
+        return types_.scalar(ValueType::Int);
+    }
+    return types_.scalar(arithmeticType(types_.info(leftType).scalar, types_.info(rightType).scalar));
+}
+
+// LogicalAndExpression / LogicalOrExpression: left op right
+TypeId TypeChecker::visitLogical(const ASTNode* node) {
+    const ASTNode* op = childAt(node, 1);
+    std::string lexeme = op != nullptr ? op->type : node->type;
+    bool valid = requireArithmetic(visitExpression(childAt(node, 0)), childAt(node, 0), lexeme);
+    valid = requireArithmetic(visitExpression(childAt(node, 2)), childAt(node, 2), lexeme) && valid;
+    return valid ? types_.scalar(ValueType::Int) : TypeTable::errorType;
+}
+
+// AssignmentExpression: target operator value，结果是目标的类型
+TypeId TypeChecker::visitAssignment(const ASTNode* node) {
+    const ASTNode* target = childAt(node, 0);
+    const ASTNode* op = childAt(node, 1);
+    const ASTNode* value = childAt(node, 2);
+    TypeId targetType = visitExpression(target);
+    TypeId valueType = visitExpression(value);
+    if (op == nullptr) {
+        error(node, "incomplete syntax tree");
+        return TypeTable::errorType;
+    }
+    if (targetType == TypeTable::errorType || !requireAssignable(target, op->type)) {
+        requireArithmetic(valueType, value, op->type);
+        return TypeTable::errorType;
+    }
+    BinaryOp binary = BinaryOp::Add;
+    if (op->type != "=" && !binaryOpFromLexeme(op->type, binary)) {
+        error(op, "unsupported assignment operator '" + op->type + "'");
+        return TypeTable::errorType;
+    }
+    bool integer = binary >= BinaryOp::Mod && binary <= BinaryOp::BitXor;
+    bool valid = integer ? requireInteger(targetType, target, op->type) : requireArithmetic(targetType, target, op->type);
+    valid = (integer ? requireInteger(valueType, value, op->type) : requireArithmetic(valueType, value, op->type)) && valid;
+    return valid ? targetType : TypeTable::errorType;
+}
+
+// UnaryExpression: op operand；PostfixExpression: operand op
+TypeId TypeChecker::visitUnary(const ASTNode* node) {
+    bool postfix = node->type == "PostfixExpression";
+    const ASTNode* op = childAt(node, postfix ? 1 : 0);
+    const ASTNode* operandNode = childAt(node, postfix ? 0 : 1);
+    TypeId operand = visitExpression(operandNode);
+    if (op == nullptr) {
+        error(node, "incomplete syntax tree");
+        return TypeTable::errorType;
+    }
+    if (op->type == "++" || op->type == "--") {
+        // 自增和自减的结果保留操作数的类型
+        bool valid = operand != TypeTable::errorType && requireAssignable(operandNode, op->type);
+        return valid && requireArithmetic(operand, operandNode, op->type) ? operand : TypeTable::errorType;
+    }
+    if (op->type == "+" || op->type == "-") {
+        return requireArithmetic(operand, operandNode, op->type) ? types_.scalar(promotedType(types_.info(operand).scalar)) : TypeTable::errorType;
+    }
+    if (op->type == "!") {
+        return requireArithmetic(operand, operandNode, op->type) ? types_.scalar(ValueType::Int) : TypeTable::errorType;
+    }
+    if (op->type == "~") {
+        return requireInteger(operand, operandNode, op->type) ? types_.scalar(ValueType::Int) : TypeTable::errorType;
+    }
+    error(op, "unsupported operator '" + op->type + "'");
+    return TypeTable::errorType;
+}
+
+// ArrayAccess: array '[' index ']'
+TypeId TypeChecker::visitArrayAccess(const ASTNode* node) {
+    const ASTNode* base = childAt(node, 0);
+    const ASTNode* index = childAt(node, 2);
+    TypeId array = visitExpression(base);
+    TypeId indexType = visitExpression(index);
+    bool valid = true;
+    if (array != TypeTable::errorType && types_.info(array).kind != TypeKind::Array) {
+        error(base, "subscripted value of type '" + types_.name(array) + "' is not an array");
+        valid = false;
+    }
+    if (indexType != TypeTable::errorType && (!isArithmetic(indexType) || isFloatingType(types_.info(indexType).scalar))) {
+        error(index, "array subscript of type '" + types_.name(indexType) + "' is not an integer");
+        valid = false;
+    }
+    if (!valid || array == TypeTable::errorType) {
+        return TypeTable::errorType;
+    }
+    return types_.scalar(types_.info(array).scalar);
+}
+
+// FunctionCall: callee '(' ArgumentExpressionList? ')'
+// 实参按ParameterList的类型转换，所以只要求个数相同、每个实参都是算术类型
+TypeId TypeChecker::visitCall(const ASTNode* node) {
+    const ASTNode* callee = childAt(node, 0);
+    const ASTNode* list = node->children.size() == 4 ? node->children[2] : nullptr;
+    size_t count = list != nullptr ? list->children.size() : 0;
+    std::vector<TypeId> arguments;
+    auto visitArguments = [&]() {
+        for (size_t i = 0; i < count; i++) {
+            arguments.push_back(visitExpression(list->children[i]));
+        }
+    };
+
+    if (callee == nullptr || callee->type != "PrimaryExpression") {
+        visitArguments();
+        error(node, "unsupported function call");
+        return TypeTable::errorType;
+    }
+    if (resolver_.bindingOf(callee) == nullptr) {
+        visitArguments();
+        if (callee->value != printBuiltin) {
+            error(callee, "undeclared function '" + callee->value + "'");
+            return TypeTable::errorType;
+        }
+        // print接受任意个数的算术类型实参
+        for (size_t i = 0; i < count; i++) {
+            requireArithmetic(arguments[i], list->children[i], printBuiltin);
+        }
+        return types_.scalar(ValueType::Int);
+    }
+
+    TypeId function = visitExpression(callee);
+    visitArguments();
+    if (function == TypeTable::errorType) {
+        return TypeTable::errorType;
+    }
+    const TypeInfo& info = types_.info(function);
+    if (info.kind != TypeKind::Function) {
+        error(callee, "called object '" + callee->value + "' of type '" + types_.name(function) + "' is not a function");
+        return TypeTable::errorType;
+    }
+    if (count != info.parameterCount) {
+        error(node, "function '" + callee->value + "' expects " + std::to_string(info.parameterCount) +
+            " argument(s), " + std::to_string(count) + " given");
+    }
+    for (size_t i = 0; i < count && i < info.parameterCount; i++) {
+        if (arguments[i] != TypeTable::errorType && !isArithmetic(arguments[i])) {
+            error(list->children[i], "argument " + std::to_string(i + 1) + " of '" + callee->value + "' has type '" +
+                types_.name(arguments[i]) + "', expected '" + valueTypeName(types_.parameter(function, i)) + "'");
+        }
+    }
+    // 实参有错时调用的类型仍然是返回类型，外层表达式不必再报错
+    return types_.scalar(info.scalar);
+}
+
+// sizeof不对操作数求值，但操作数仍然要检查
+TypeId TypeChecker::visitSizeof(const ASTNode* node) {
+    const ASTNode* operand = childAt(node, 1);
+    if (operand != nullptr && operand->type == "(") {
+        // SizeofExpression: sizeof '(' TypeSpecifier ')'
+        return typeFromSpecifier(childAt(node, 2), false) != TypeTable::errorType ? types_.scalar(ValueType::Int) : TypeTable::errorType;
+    }
+    TypeId type = visitExpression(operand);
+    if (type == TypeTable::errorType) {
+        return TypeTable::errorType;
+    }
+    const TypeInfo& info = types_.info(type);
+    if (info.kind == TypeKind::Function || (info.kind == TypeKind::Scalar && info.scalar == ValueType::Void)) {
+        error(operand, "invalid application of 'sizeof' to type '" + types_.name(type) + "'");
+        return TypeTable::errorType;
+    }
+    return types_.scalar(ValueType::Int);
+}
+
+bool TypeChecker::requireArithmetic(TypeId type, const ASTNode* node, const std::string& op) {
+    if (type == TypeTable::errorType) {
+        return false;
+    }
+    if (!isArithmetic(type)) {
+        error(node, "invalid operand of type '" + types_.name(type) + "' to '" + op + "'");
+        return false;
+    }
+    return true;
+}
+
+bool TypeChecker::requireInteger(TypeId type, const ASTNode* node, const std::string& op) {
+    if (!requireArithmetic(type, node, op)) {
+        return false;
+    }
+    if (isFloatingType(types_.info(type).scalar)) {
+        error(node, "invalid operand of floating type '" + types_.name(type) + "' to '" + op + "'");
+        return false;
+    }
+    return true;
+}
+
+// 只有标量变量、参数和数组元素可以赋值
+bool TypeChecker::requireAssignable(const ASTNode* target, const std::string& op) {
+    if (target->type == "ArrayAccess") {
+        return true;
+    }
+    const Symbol* symbol = target->type == "PrimaryExpression" ? resolver_.bindingOf(target) : nullptr;
+    if (symbol != nullptr && (symbol->kind == SymbolKind::Variable || symbol->kind == SymbolKind::Parameter)) {
+        return true;
+    }
+    error(target, "operand of '" + op + "' is not assignable");
+    return false;
+}
+
+bool TypeChecker::isArithmetic(TypeId type) const {
+    const TypeInfo& info = types_.info(type);
+    return info.kind == TypeKind::Scalar && info.scalar != ValueType::Void;
+}
+
+TypeId TypeChecker::typeFromSpecifier(const ASTNode* typeSpecifier, bool allowVoid) {
+    if (typeSpecifier == nullptr) {
+        error(nullptr, "incomplete syntax tree");
+        return TypeTable::errorType;
+    }
+    ValueType type;
+    if (typeSpecifier->value == "void") {
+        if (allowVoid) {
+            return types_.scalar(ValueType::Void);
+        }
+        error(typeSpecifier, "invalid use of type 'void'");
+        return TypeTable::errorType;
+    }
+    if (!valueTypeFromName(typeSpecifier->value, type)) {
+        error(typeSpecifier, "unsupported type '" + typeSpecifier->value + "'");
+        return TypeTable::errorType;
+    }
+    return types_.scalar(type);
+}
+
+void TypeChecker::error(const ASTNode* node, std::string message) {
+    errors_.push_back({ node, std::move(message) });
+}
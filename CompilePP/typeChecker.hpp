@@ -0,0 +1,117 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ast.hpp"
+#include "nameResolver.hpp"
+#include "nodeMap.hpp"
+#include "runtimeValue.hpp"
+
+// 类型编号：结构相同的类型编号相同，比较类型只需要比较编号
+using TypeId = uint32_t;
+
+enum class TypeKind : uint8_t
+{
+    Error, Scalar, Array, Function
+};
+
+struct TypeInfo {
+    TypeKind kind;
+    ValueType scalar;           // 标量类型，数组的元素类型，函数的返回类型（可以是Void）
+    int32_t length;             // 数组长度，不是常量时为-1
+    uint32_t firstParameter;    // 函数的参数类型在参数表中的起始位置
+    uint32_t parameterCount;
+};
+
+// 类型驻留表：0号是错误类型，标量类型的编号在构造时确定，数组和函数类型第一次出现时分配编号
+class TypeTable {
+public:
+    static constexpr TypeId errorType = 0;
+
+    TypeTable();
+
+    // type不能是ValueType::Array
+    TypeId scalar(ValueType type) const;
+    TypeId arrayOf(ValueType element, int32_t length);
+    TypeId function(ValueType returnType, const std::vector<ValueType>& parameters);
+
+    const TypeInfo& info(TypeId type) const;
+    ValueType parameter(TypeId function, size_t index) const;
+    // 用于报错的类型名，例如 int、double[10]、int(char, double)
+    std::string name(TypeId type) const;
+    size_t size() const;
+
+private:
+    std::vector<TypeInfo> types_;
+    std::vector<ValueType> parameters_;
+    TypeId scalars_[7];
+    std::unordered_map<uint64_t, TypeId> arrays_;                 // 元素类型和长度 -> 编号
+    std::map<std::vector<ValueType>, TypeId> functions_;          // 返回类型和参数类型 -> 编号
+};
+
+struct TypeError {
+    const ASTNode* node;
+    std::string message;
+};
+
+// 类型检查：在名字解析之后按源程序顺序遍历一次AST，为每个表达式节点计算类型并缓存在旁路表中。
+// 每个节点的类型只由子节点已经缓存的类型和声明的类型决定，声明总是出现在使用之前，所以一次遍历就够了。
+// 检查常用算术转换的操作数、只能用于整数的运算符、赋值的目标、数组下标，以及调用时实参与ParameterList的个数和类型。
+// 一个子表达式出错之后包含它的表达式不再重复报错
+class TypeChecker {
+public:
+    explicit TypeChecker(const NameResolver& resolver);
+
+    TypeChecker(const TypeChecker&) = delete;
+    TypeChecker& operator=(const TypeChecker&) = delete;
+
+    void check(const ASTNode* root);
+
+    // 表达式的类型，赋值、自增和char变量等保留声明的类型；不是表达式时返回TypeTable::errorType
+    TypeId typeOf(const ASTNode* expression) const;
+    // 代码生成使用的值类型：char和bool提升为int，数组为ValueType::Array
+    ValueType valueTypeOf(const ASTNode* expression) const;
+    // 符号声明的类型，声明出错时返回TypeTable::errorType
+    TypeId symbolType(const Symbol& symbol) const;
+
+    const TypeTable& types() const;
+    // 缓存了类型的表达式节点数
+    size_t typedCount() const;
+    const std::vector<TypeError>& errors() const;
+
+private:
+    const NameResolver& resolver_;
+    TypeTable types_;
+    NodeMap nodeTypes_;
+    std::vector<TypeId> symbolTypes_;       // 按符号编号
+    std::vector<TypeError> errors_;
+    // 当前函数
+    const Symbol* function_;
+    ValueType returnType_;
+
+    void visitStatement(const ASTNode* node);
+    void visitFunctionDefinition(const ASTNode* node);
+    void visitDeclaration(const ASTNode* node);
+    TypeId declareFunction(const ASTNode* typeSpecifier, const ASTNode* declarator);
+    void declareSymbol(const ASTNode* identifier, TypeId type);
+    void visitCondition(const ASTNode* node);
+
+    TypeId visitExpression(const ASTNode* node);
+    TypeId visitPrimary(const ASTNode* node);
+    TypeId visitBinary(const ASTNode* node, const std::string& op, const ASTNode* left, const ASTNode* right);
+    TypeId visitLogical(const ASTNode* node);
+    TypeId visitAssignment(const ASTNode* node);
+    TypeId visitUnary(const ASTNode* node);
+    TypeId visitArrayAccess(const ASTNode* node);
+    TypeId visitCall(const ASTNode* node);
+    TypeId visitSizeof(const ASTNode* node);
+
+    bool requireArithmetic(TypeId type, const ASTNode* node, const std::string& op);
+    bool requireInteger(TypeId type, const ASTNode* node, const std::string& op);
+    bool requireAssignable(const ASTNode* target, const std::string& op);
+    bool isArithmetic(TypeId type) const;
+    TypeId typeFromSpecifier(const ASTNode* typeSpecifier, bool allowVoid);
+    void error(const ASTNode* node, std::string message);
+};
@@ -0,0 +1,278 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <string>
+#include "visitorBench.hpp"
+#include "astVisitor.cpp"
+
+namespace {
+    struct Analyses {
+        size_t statements = 0;
+        size_t nodes = 0;
+        size_t maxDepth = 0;
+        size_t identifiers = 0;
+        size_t constants = 0;
+        size_t calls = 0;
+        size_t maxArguments = 0;
+        size_t beforeFirstLoop = 0;
+        bool foundLoop = false;
+
+        bool operator==(const Analyses& other) const {
+            return statements == other.statements && nodes == other.nodes && maxDepth == other.maxDepth &&
+                identifiers == other.identifiers && constants == other.constants && calls == other.calls &&
+                maxArguments == other.maxArguments && beforeFirstLoop == other.beforeFirstLoop && foundLoop == other.foundLoop;
+        }
+    };
+
+    bool isIdentifier(const std::string& text) {
+        return !text.empty() && (std::isalpha(static_cast<unsigned char>(text[0])) || text[0] == '_');
+    }
+
+    // 对照：每个分析自己递归遍历一次，按type字符串判断节点类型
+    namespace naive {
+        void countStatements(const ASTNode* node, Analyses& result) {
+            const std::string& type = node->type;
+            if (type == "CompoundStatement" || type == "SelectionStatement" || type == "IterationStatement" || type == "JumpStatement") {
+                result.statements++;
+            }
+            for (const ASTNode* child : node->children) {
+                if (child != nullptr) {
+                    countStatements(child, result);
+                }
+            }
+        }
+
+        void measureDepth(const ASTNode* node, size_t depth, Analyses& result) {
+            result.nodes++;
+            result.maxDepth = std::max(result.maxDepth, depth);
+            for (const ASTNode* child : node->children) {
+                if (child != nullptr) {
+                    measureDepth(child, depth + 1, result);
+                }
+            }
+        }
+
+        void countUses(const ASTNode* node, Analyses& result) {
+            if (node->type == "PrimaryExpression") {
+                (isIdentifier(node->value) ? result.identifiers : result.constants)++;
+                return;
+            }
+            for (const ASTNode* child : node->children) {
+                if (child != nullptr) {
+                    countUses(child, result);
+                }
+            }
+        }
+
+        void countCalls(const ASTNode* node, Analyses& result) {
+            if (node->type == "FunctionCall") {
+                result.calls++;
+            }
+            else if (node->type == "ArgumentExpressionList") {
+                result.maxArguments = std::max(result.maxArguments, node->children.size());
+            }
+            for (const ASTNode* child : node->children) {
+                if (child != nullptr) {
+                    countCalls(child, result);
+                }
+            }
+        }
+
+        bool findLoop(const ASTNode* node, Analyses& result) {
+            if (node->type == "IterationStatement") {
+                result.foundLoop = true;
+                return true;
+            }
+            result.beforeFirstLoop++;
+            for (const ASTNode* child : node->children) {
+                if (child != nullptr && findLoop(child, result)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        Analyses run(const ASTNode* root) {
+            Analyses result;
+            countStatements(root, result);
+            measureDepth(root, 0, result);
+            countUses(root, result);
+            countCalls(root, result);
+            findLoop(root, result);
+            return result;
+        }
+    }
+
+    // 同样的分析写成Visitor，只定义关心的节点类型的钩子
+    class StatementCounter : public AstVisitor<StatementCounter> {
+    public:
+        explicit StatementCounter(Analyses& result) : result_(result) {
+        }
+        VisitAction enterCompoundStatement(const ASTNode*) {
+            return count();
+        }
+        VisitAction enterSelectionStatement(const ASTNode*) {
+            return count();
+        }
+        VisitAction enterIterationStatement(const ASTNode*) {
+            return count();
+        }
+        VisitAction enterJumpStatement(const ASTNode*) {
+            return count();
+        }
+
+    private:
+        Analyses& result_;
+
+        VisitAction count() {
+            result_.statements++;
+            return VisitAction::Continue;
+        }
+    };
+
+    class DepthMeter : public AstVisitor<DepthMeter> {
+    public:
+        explicit DepthMeter(Analyses& result) : result_(result) {
+        }
+        VisitAction enterNode(NodeKind, const ASTNode*) {
+            result_.nodes++;
+            result_.maxDepth = std::max(result_.maxDepth, depth());
+            return VisitAction::Continue;
+        }
+
+    private:
+        Analyses& result_;
+    };
+
+    class UseCounter : public AstVisitor<UseCounter> {
+    public:
+        explicit UseCounter(Analyses& result) : result_(result) {
+        }
+        VisitAction enterPrimaryExpression(const ASTNode* node) {
+            (isIdentifier(node->value) ? result_.identifiers : result_.constants)++;
+            return VisitAction::SkipChildren;
+        }
+
+    private:
+        Analyses& result_;
+    };
+
+    class CallCounter : public AstVisitor<CallCounter> {
+    public:
+        explicit CallCounter(Analyses& result) : result_(result) {
+        }
+        VisitAction enterFunctionCall(const ASTNode*) {
+            result_.calls++;
+            return VisitAction::Continue;
+        }
+        VisitAction enterArgumentExpressionList(const ASTNode* node) {
+            result_.maxArguments = std::max(result_.maxArguments, node->children.size());
+            return VisitAction::Continue;
+        }
+
+    private:
+        Analyses& result_;
+    };
+
+    class LoopFinder : public AstVisitor<LoopFinder> {
+    public:
+        explicit LoopFinder(Analyses& result) : result_(result) {
+        }
+        VisitAction enterIterationStatement(const ASTNode*) {
+            result_.foundLoop = true;
+            return VisitAction::Stop;
+        }
+        VisitAction enterNode(NodeKind, const ASTNode*) {
+            result_.beforeFirstLoop++;
+            return VisitAction::Continue;
+        }
+
+    private:
+        Analyses& result_;
+    };
+
+    Analyses runSeparate(const ASTNode* root) {
+        Analyses result;
+        StatementCounter statements(result);
+        DepthMeter depth(result);
+        UseCounter uses(result);
+        CallCounter calls(result);
+        LoopFinder loop(result);
+        statements.traverse(root);
+        depth.traverse(root);
+        uses.traverse(root);
+        calls.traverse(root);
+        loop.traverse(root);
+        return result;
+    }
+
+    Analyses runFused(const ASTNode* root) {
+        Analyses result;
+        StatementCounter statements(result);
+        DepthMeter depth(result);
+        UseCounter uses(result);
+        CallCounter calls(result);
+        LoopFinder loop(result);
+        FusedVisitor<StatementCounter, DepthMeter, UseCounter, CallCounter, LoopFinder> fused(statements, depth, uses, calls, loop);
+        fused.traverse(root);
+        return result;
+    }
+
+    struct Measurement {
+        const char* name;
+        double secondsPerRun;
+        Analyses result;
+    };
+
+    Measurement measure(const char* name, const ASTNode* root, size_t iterations, const std::function<Analyses(const ASTNode*)>& run) {
+        Measurement measurement{ name, 0.0, run(root) };
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; i++) {
+            Analyses result = run(root);
+            if (!(result == measurement.result)) {
+                measurement.result = Analyses();
+            }
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        measurement.secondsPerRun = elapsed.count() / static_cast<double>(iterations);
+        return measurement;
+    }
+}
+
+void runVisitorBenchmark(const ASTNode* root, size_t iterations, std::ostream& os) {
+    if (root == nullptr) {
+        os << "Visitor benchmark: no syntax tree\n";
+        return;
+    }
+    if (iterations == 0) {
+        iterations = 1;
+    }
+    Measurement results[] = {
+        measure("string compares", root, iterations, naive::run),
+        measure("visitor, separate", root, iterations, runSeparate),
+        measure("visitor, fused", root, iterations, runFused),
+    };
+    const Analyses& expected = results[0].result;
+
+    os << "Visitor benchmark: " << expected.nodes << " nodes, depth " << expected.maxDepth << ", " << iterations << " iteration(s)\n";
+    os << "  " << expected.statements << " statements, " << expected.identifiers << " identifier uses, " << expected.constants
+        << " constants, " << expected.calls << " calls (at most " << expected.maxArguments << " arguments), "
+        << expected.beforeFirstLoop << " nodes before the first loop\n";
+    os << std::left << std::setw(20) << "traversal" << std::right
+        << std::setw(8) << "walks" << std::setw(14) << "ms/run" << std::setw(16) << "nodes/sec" << std::setw(10) << "speedup" << "\n";
+    for (size_t i = 0; i < 3; i++) {
+        const Measurement& measurement = results[i];
+        double nodesPerSecond = measurement.secondsPerRun > 0 ? static_cast<double>(expected.nodes) / measurement.secondsPerRun : 0.0;
+        os << std::left << std::setw(20) << measurement.name << std::right << std::fixed
+            << std::setw(8) << (i == 2 ? 1 : 5)
+            << std::setw(14) << std::setprecision(3) << measurement.secondsPerRun * 1000.0
+            << std::setw(16) << std::setprecision(0) << nodesPerSecond
+            << std::setw(9) << std::setprecision(2) << (measurement.secondsPerRun > 0 ? results[1].secondsPerRun / measurement.secondsPerRun : 0.0) << "x";
+        if (!(measurement.result == expected)) {
+            os << "  (results differ)";
+        }
+        os << "\n";
+    }
+}
@@ -0,0 +1,8 @@
+#pragma once
+#include <iostream>
+#include "ast.hpp"
+
+// 比较AST遍历的三种写法：逐个比较type字符串的递归遍历、静态分派的Visitor各自遍历、
+// 同样的几个Visitor融合到一次遍历中。每种写法都运行同一组分析（语句计数、最大深度、标识符与常量、
+// 函数调用、第一个循环之前的节点数，最后一个会提前结束），重复iterations次取平均并检查结果一致
+void runVisitorBenchmark(const ASTNode* root, size_t iterations, std::ostream& os);
@@ -0,0 +1,312 @@
+#include <climits>
+#include <string>
+#include "vm.hpp"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define VM_COMPUTED_GOTO 1
+#endif
+
+namespace {
+    [[noreturn]] void fail(const char* message) {
+        throw RuntimeError(message);
+    }
+
+    [[noreturn]] void failIndex(int32_t index, uint32_t length) {
+        throw RuntimeError("array index " + std::to_string(index) + " out of bounds [0, " + std::to_string(length) + ")");
+    }
+
+    int32_t wrap(uint32_t value) {
+        return static_cast<int32_t>(value);
+    }
+
+    // 整数结果写入低32位并清零高位，同一个寄存器之后作为double读取也是确定的值
+    void setInt(BytecodeValue& reg, int32_t value) {
+        reg.bits = static_cast<uint32_t>(value);
+    }
+}
+
+VirtualMachine::VirtualMachine(const BytecodeProgram& program, std::ostream& out, size_t maxCallDepth, uint32_t jitThreshold)
+    : program_(program), out_(out), maxCallDepth_(maxCallDepth), arrayTop_(0), jitThreshold_(jitThreshold), jitContext_() {
+    if (jitThreshold_ != 0 && JitCompiler::supported()) {
+        jit_ = std::make_unique<JitCompiler>(program_);
+        callCounts_.assign(program_.functions.size(), 0);
+    }
+}
+
+size_t VirtualMachine::jitCompiledFunctions() const {
+    return jit_ != nullptr ? jit_->compiledCount() : 0;
+}
+
+bool VirtualMachine::tierUp(uint32_t function) {
+    if (jit_->compiled(function)) {
+        return true;
+    }
+    if (++callCounts_[function] < jitThreshold_) {
+        return false;
+    }
+    jit_->compile(function);
+    return true;
+}
+
+BytecodeValue VirtualMachine::invokeNative(uint32_t function, const BytecodeValue* args) {
+    jitContext_.arrays = arrays_.data();
+    jitContext_.arrayTop = arrayTop_;
+    jitContext_.globals = globals_.data();
+    jitContext_.depth = static_cast<uint32_t>(frames_.size());
+    jitContext_.depthLimit = static_cast<uint32_t>(maxCallDepth_ < UINT32_MAX ? maxCallDepth_ : UINT32_MAX);
+    jitContext_.error = JitError::None;
+    jitContext_.arrayStorage = &arrays_;
+    jitContext_.out = &out_;
+    BytecodeValue result = jit_->invoke(function, args, jitContext_);
+    arrayTop_ = static_cast<size_t>(jitContext_.arrayTop);
+
+    switch (jitContext_.error) {
+    case JitError::None:
+        return result;
+    case JitError::DivisionByZero:
+        fail("integer division by zero");
+    case JitError::DivisionOverflow:
+        fail("integer overflow in division");
+    case JitError::ShiftCount:
+        fail("shift count out of range");
+    case JitError::ArrayIndex:
+        failIndex(jitContext_.errorIndex, jitContext_.errorLength);
+    case JitError::ArrayLength:
+        fail("array length must be a positive integer");
+    case JitError::CallDepth:
+        throw RuntimeError("call depth limit (" + std::to_string(maxCallDepth_) + ") exceeded in '" +
+            program_.functions[jitContext_.errorFunction].name + "'");
+    case JitError::RegisterStack:
+        throw RuntimeError("JIT register stack exhausted in '" + program_.functions[jitContext_.errorFunction].name + "'");
+    case JitError::OutOfMemory:
+        break;
+    }
+    fail("out of memory");
+}
+
+int32_t VirtualMachine::run() {
+    BytecodeValue zero;
+    zero.bits = 0;
+    globals_.assign(program_.globalCount, zero);
+    if (registers_.size() < 4096) {
+        registers_.resize(4096);
+    }
+    arrayTop_ = 0;
+    frames_.clear();
+    execute(program_.initFunction);
+    if (jit_ != nullptr && tierUp(program_.mainFunction)) {
+        return invokeNative(program_.mainFunction, nullptr).i;
+    }
+    return execute(program_.mainFunction).i;
+}
+
+// 保证从base开始有function需要的寄存器，返回新的基址（寄存器数组可能因扩容而移动）
+size_t VirtualMachine::reserve(size_t base, const BytecodeFunction& function) {
+    size_t top = base + function.registerCount;
+    if (top > registers_.size()) {
+        registers_.resize(top > registers_.size() * 2 ? top : registers_.size() * 2);
+    }
+    return base;
+}
+
+BytecodeValue VirtualMachine::execute(uint32_t entry) {
+    const BytecodeFunction* function = &program_.functions[entry];
+    size_t base = reserve(frames_.empty() ? 0 : frames_.back().base, *function);
+    frames_.push_back({ nullptr, nullptr, base, 0, arrayTop_ });
+    BytecodeValue* regs = registers_.data() + base;
+    const Instruction* pc = function->code.data();
+    BytecodeValue* globals = globals_.data();
+
+#ifdef VM_COMPUTED_GOTO
+    static void* const dispatchTable[] = {
+#define BYTECODE_OP(name, format) &&op_##name,
+#include "bytecode.def"
+#undef BYTECODE_OP
+    };
+#define VM_CASE(name) op_##name:
+#define VM_DISPATCH() goto *dispatchTable[static_cast<size_t>(pc->op)]
+#define VM_NEXT() do { ++pc; VM_DISPATCH(); } while (0)
+#define VM_JUMP(target) do { pc = function->code.data() + (target); VM_DISPATCH(); } while (0)
+    VM_DISPATCH();
+#else
+#define VM_CASE(name) case Opcode::name:
+#define VM_NEXT() { ++pc; continue; }
+#define VM_JUMP(target) { pc = function->code.data() + (target); continue; }
+    for (;;) {
+        switch (pc->op) {
+#endif
+
+    VM_CASE(Move) regs[pc->a] = regs[pc->b]; VM_NEXT();
+    VM_CASE(LoadInt) setInt(regs[pc->a], static_cast<int16_t>(pc->b)); VM_NEXT();
+    VM_CASE(LoadConst) regs[pc->a] = program_.constants[pc->b]; VM_NEXT();
+    VM_CASE(LoadGlobal) regs[pc->a] = globals[pc->b]; VM_NEXT();
+    VM_CASE(StoreGlobal) globals[pc->a] = regs[pc->b]; VM_NEXT();
+
+    VM_CASE(AddI) setInt(regs[pc->a], wrap(static_cast<uint32_t>(regs[pc->b].i) + static_cast<uint32_t>(regs[pc->c].i))); VM_NEXT();
+    VM_CASE(SubI) setInt(regs[pc->a], wrap(static_cast<uint32_t>(regs[pc->b].i) - static_cast<uint32_t>(regs[pc->c].i))); VM_NEXT();
+    VM_CASE(MulI) setInt(regs[pc->a], wrap(static_cast<uint32_t>(regs[pc->b].i) * static_cast<uint32_t>(regs[pc->c].i))); VM_NEXT();
+    VM_CASE(DivI) {
+        int32_t left = regs[pc->b].i;
+        int32_t right = regs[pc->c].i;
+        if (right == 0) fail("integer division by zero");
+        if (left == INT32_MIN && right == -1) fail("integer overflow in division");
+        setInt(regs[pc->a], left / right);
+        VM_NEXT();
+    }
+    VM_CASE(ModI) {
+        int32_t left = regs[pc->b].i;
+        int32_t right = regs[pc->c].i;
+        if (right == 0) fail("integer division by zero");
+        if (left == INT32_MIN && right == -1) fail("integer overflow in division");
+        setInt(regs[pc->a], left % right);
+        VM_NEXT();
+    }
+    VM_CASE(ShlI) {
+        int32_t count = regs[pc->c].i;
+        if (count < 0 || count >= 32) fail("shift count out of range");
+        setInt(regs[pc->a], wrap(static_cast<uint32_t>(regs[pc->b].i) << count));
+        VM_NEXT();
+    }
+    VM_CASE(ShrI) {
+        int32_t count = regs[pc->c].i;
+        if (count < 0 || count >= 32) fail("shift count out of range");
+        setInt(regs[pc->a], regs[pc->b].i >> count);
+        VM_NEXT();
+    }
+    VM_CASE(AndI) setInt(regs[pc->a], regs[pc->b].i & regs[pc->c].i); VM_NEXT();
+    VM_CASE(OrI) setInt(regs[pc->a], regs[pc->b].i | regs[pc->c].i); VM_NEXT();
+    VM_CASE(XorI) setInt(regs[pc->a], regs[pc->b].i ^ regs[pc->c].i); VM_NEXT();
+    VM_CASE(LtI) setInt(regs[pc->a], regs[pc->b].i < regs[pc->c].i); VM_NEXT();
+    VM_CASE(LeI) setInt(regs[pc->a], regs[pc->b].i <= regs[pc->c].i); VM_NEXT();
+    VM_CASE(EqI) setInt(regs[pc->a], regs[pc->b].i == regs[pc->c].i); VM_NEXT();
+    VM_CASE(NeI) setInt(regs[pc->a], regs[pc->b].i != regs[pc->c].i); VM_NEXT();
+    VM_CASE(NegI) setInt(regs[pc->a], wrap(0u - static_cast<uint32_t>(regs[pc->b].i))); VM_NEXT();
+    VM_CASE(BitNotI) setInt(regs[pc->a], ~regs[pc->b].i); VM_NEXT();
+    VM_CASE(NotI) setInt(regs[pc->a], regs[pc->b].i == 0); VM_NEXT();
+
+    VM_CASE(AddD) regs[pc->a].d = regs[pc->b].d + regs[pc->c].d; VM_NEXT();
+    VM_CASE(SubD) regs[pc->a].d = regs[pc->b].d - regs[pc->c].d; VM_NEXT();
+    VM_CASE(MulD) regs[pc->a].d = regs[pc->b].d * regs[pc->c].d; VM_NEXT();
+    VM_CASE(DivD) regs[pc->a].d = regs[pc->b].d / regs[pc->c].d; VM_NEXT();
+    VM_CASE(LtD) setInt(regs[pc->a], regs[pc->b].d < regs[pc->c].d); VM_NEXT();
+    VM_CASE(LeD) setInt(regs[pc->a], regs[pc->b].d <= regs[pc->c].d); VM_NEXT();
+    VM_CASE(EqD) setInt(regs[pc->a], regs[pc->b].d == regs[pc->c].d); VM_NEXT();
+    VM_CASE(NeD) setInt(regs[pc->a], regs[pc->b].d != regs[pc->c].d); VM_NEXT();
+    VM_CASE(NegD) regs[pc->a].d = -regs[pc->b].d; VM_NEXT();
+    VM_CASE(NotD) setInt(regs[pc->a], regs[pc->b].d == 0.0); VM_NEXT();
+
+    VM_CASE(IntToDouble) regs[pc->a].d = regs[pc->b].i; VM_NEXT();
+    VM_CASE(DoubleToInt) setInt(regs[pc->a], doubleToInt(regs[pc->b].d)); VM_NEXT();
+    VM_CASE(RoundFloat) regs[pc->a].d = static_cast<float>(regs[pc->b].d); VM_NEXT();
+    VM_CASE(TruncChar) setInt(regs[pc->a], static_cast<int8_t>(static_cast<uint8_t>(regs[pc->b].i))); VM_NEXT();
+    VM_CASE(IntToBool) setInt(regs[pc->a], regs[pc->b].i != 0); VM_NEXT();
+    VM_CASE(DoubleToBool) setInt(regs[pc->a], regs[pc->b].d != 0.0); VM_NEXT();
+
+    VM_CASE(Jump) VM_JUMP(pc->c);
+    VM_CASE(JumpIfFalse) if (regs[pc->a].i == 0) VM_JUMP(pc->c); VM_NEXT();
+    VM_CASE(JumpIfTrue) if (regs[pc->a].i != 0) VM_JUMP(pc->c); VM_NEXT();
+    VM_CASE(JumpUnlessLtI) if (!(regs[pc->a].i < regs[pc->b].i)) VM_JUMP(pc->c); VM_NEXT();
+    VM_CASE(JumpUnlessLeI) if (!(regs[pc->a].i <= regs[pc->b].i)) VM_JUMP(pc->c); VM_NEXT();
+    VM_CASE(JumpUnlessEqI) if (regs[pc->a].i != regs[pc->b].i) VM_JUMP(pc->c); VM_NEXT();
+    VM_CASE(JumpUnlessNeI) if (regs[pc->a].i == regs[pc->b].i) VM_JUMP(pc->c); VM_NEXT();
+    VM_CASE(IncI) setInt(regs[pc->a], wrap(static_cast<uint32_t>(regs[pc->a].i) + static_cast<uint32_t>(static_cast<int16_t>(pc->b)))); VM_NEXT();
+    VM_CASE(AddImmI) setInt(regs[pc->a], wrap(static_cast<uint32_t>(regs[pc->b].i) + static_cast<uint32_t>(static_cast<int16_t>(pc->c)))); VM_NEXT();
+
+    VM_CASE(NewArray) {
+        int32_t length = regs[pc->b].i;
+        if (length <= 0) fail("array length must be a positive integer");
+        size_t offset = arrayTop_;
+        arrayTop_ += static_cast<size_t>(length);
+        if (arrayTop_ > arrays_.size()) {
+            arrays_.resize(arrayTop_ > arrays_.size() * 2 ? arrayTop_ : arrays_.size() * 2);
+        }
+        for (size_t i = offset; i < arrayTop_; i++) {
+            arrays_[i].bits = 0;
+        }
+        regs[pc->a].array = { static_cast<uint32_t>(offset), static_cast<uint32_t>(length) };
+        VM_NEXT();
+    }
+    VM_CASE(LoadElement) {
+        ArrayRef array = regs[pc->b].array;
+        int32_t index = regs[pc->c].i;
+        if (static_cast<uint32_t>(index) >= array.length) failIndex(index, array.length);
+        regs[pc->a] = arrays_[array.offset + static_cast<uint32_t>(index)];
+        VM_NEXT();
+    }
+    VM_CASE(StoreElement) {
+        ArrayRef array = regs[pc->a].array;
+        int32_t index = regs[pc->b].i;
+        if (static_cast<uint32_t>(index) >= array.length) failIndex(index, array.length);
+        arrays_[array.offset + static_cast<uint32_t>(index)] = regs[pc->c];
+        VM_NEXT();
+    }
+    VM_CASE(ArrayMark) regs[pc->a].bits = arrayTop_; VM_NEXT();
+    VM_CASE(ArrayRelease) arrayTop_ = static_cast<size_t>(regs[pc->a].bits); VM_NEXT();
+
+    VM_CASE(Call) {
+        if (jit_ != nullptr && tierUp(pc->b)) {
+            // 本机代码在自己的寄存器栈上执行，不会移动registers_
+            regs[pc->a] = invokeNative(pc->b, regs + pc->c);
+            VM_NEXT();
+        }
+        const BytecodeFunction* callee = &program_.functions[pc->b];
+        if (frames_.size() >= maxCallDepth_) {
+            throw RuntimeError("call depth limit (" + std::to_string(maxCallDepth_) + ") exceeded in '" + callee->name + "'");
+        }
+        size_t calleeBase = reserve(base + pc->c, *callee);
+        frames_.push_back({ function, pc + 1, base, pc->a, arrayTop_ });
+        function = callee;
+        base = calleeBase;
+        regs = registers_.data() + base;
+        pc = function->code.data();
+#ifdef VM_COMPUTED_GOTO
+        VM_DISPATCH();
+#else
+        continue;
+#endif
+    }
+    VM_CASE(Return) VM_CASE(ReturnVoid) {
+        BytecodeValue result;
+        if (pc->op == Opcode::Return) {
+            result = regs[pc->a];
+        }
+        else {
+            result.bits = 0;
+        }
+        Frame frame = frames_.back();
+        frames_.pop_back();
+        if (frame.function == nullptr) {
+            // 回到execute的调用者：<init>分配的全局数组要一直保留，不恢复数组栈顶
+            return result;
+        }
+        arrayTop_ = frame.arrayMark;
+        function = frame.function;
+        base = frame.base;
+        regs = registers_.data() + base;
+        regs[frame.dest] = result;
+        pc = frame.returnPc;
+#ifdef VM_COMPUTED_GOTO
+        VM_DISPATCH();
+#else
+        continue;
+#endif
+    }
+
+    VM_CASE(PrintInt) out_ << regs[pc->a].i; VM_NEXT();
+    VM_CASE(PrintDouble) out_ << regs[pc->a].d; VM_NEXT();
+    VM_CASE(PrintSpace) out_ << ' '; VM_NEXT();
+    VM_CASE(PrintNewline) out_ << '\n'; VM_NEXT();
+
+#ifndef VM_COMPUTED_GOTO
+        default:
+            fail("invalid opcode");
+        }
+    }
+#endif
+#undef VM_CASE
+#undef VM_NEXT
+#undef VM_JUMP
+#ifdef VM_COMPUTED_GOTO
+#undef VM_DISPATCH
+#endif
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "bytecode.hpp"
+#include "jit.hpp"
+
+// 执行寄存器式字节码的虚拟机
+// GCC和Clang下用computed goto做线程化分派，每条指令结尾直接跳到下一条指令的处理代码；
+// 其他编译器（MSVC）退回switch分派。函数调用不占用C++栈，调用深度只受maxCallDepth限制。
+// jitThreshold不为0且平台支持JIT时，函数被调用jitThreshold次后连同它调用的函数一起编译成本机代码，
+// 之后对它的调用直接进入本机代码；编译结果和调用计数在多次run之间保留
+class VirtualMachine {
+public:
+    VirtualMachine(const BytecodeProgram& program, std::ostream& out, size_t maxCallDepth = 100000, uint32_t jitThreshold = 0);
+
+    VirtualMachine(const VirtualMachine&) = delete;
+    VirtualMachine& operator=(const VirtualMachine&) = delete;
+
+    // 初始化全局变量并执行main，返回main的返回值；执行出错时抛出RuntimeError
+    int32_t run();
+
+    // 已经编译成本机代码的函数个数
+    size_t jitCompiledFunctions() const;
+
+private:
+    // 调用者的状态，被调函数返回时恢复
+    struct Frame {
+        const BytecodeFunction* function;  // nullptr表示返回到execute的调用者
+        const Instruction* returnPc;
+        size_t base;
+        uint16_t dest;
+        size_t arrayMark;
+    };
+
+    const BytecodeProgram& program_;
+    std::ostream& out_;
+    size_t maxCallDepth_;
+    std::vector<BytecodeValue> globals_;
+    std::vector<BytecodeValue> registers_;
+    std::vector<BytecodeValue> arrays_;
+    size_t arrayTop_;
+    std::vector<Frame> frames_;
+    uint32_t jitThreshold_;
+    std::unique_ptr<JitCompiler> jit_;
+    std::vector<uint32_t> callCounts_;
+    JitContext jitContext_;
+
+    BytecodeValue execute(uint32_t function);
+    // 计数一次调用，返回function是否已经有本机代码
+    bool tierUp(uint32_t function);
+    BytecodeValue invokeNative(uint32_t function, const BytecodeValue* args);
+    size_t reserve(size_t base, const BytecodeFunction& function);
+};
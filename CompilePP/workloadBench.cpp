@@ -0,0 +1,156 @@
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include "workloadBench.hpp"
+#include "lexer.hpp"
+#include "astParser.hpp"
+#include "lalrParser.hpp"
+#include "memoryAccounting.hpp"
+#include "newVector.cpp"
+
+namespace {
+    struct Timing {
+        double secondsPerRun;
+        size_t allocations;   // 一次执行的分配次数
+    };
+
+    // 先打开内存统计执行一次得到分配次数，再关闭统计计时执行iterations次
+    template <typename Body>
+    Timing measure(size_t iterations, Body body) {
+        setMemoryAccounting(true);
+        uint64_t before = memoryCounters().allocations;
+        body();
+        Timing timing{ 0.0, static_cast<size_t>(memoryCounters().allocations - before) };
+        setMemoryAccounting(false);
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; i++) {
+            body();
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        timing.secondsPerRun = elapsed.count() / static_cast<double>(iterations);
+        return timing;
+    }
+
+    size_t countNodes(const ASTNode* root) {
+        size_t count = 0;
+        std::vector<const ASTNode*> stack;
+        if (root != nullptr) {
+            stack.push_back(root);
+        }
+        while (!stack.empty()) {
+            const ASTNode* node = stack.back();
+            stack.pop_back();
+            count++;
+            for (const ASTNode* child : node->children) {
+                if (child != nullptr) {
+                    stack.push_back(child);
+                }
+            }
+        }
+        return count;
+    }
+
+    ASTNode* parseTokens(const newVector<Token>& tokens, DiagnosticEngine& diagnostics, bool useLalr) {
+        if (useLalr) {
+            LalrParser parser(tokens, diagnostics);
+            parser.parse();
+            return parser.getAST();
+        }
+        Parser parser(tokens, diagnostics);
+        parser.parse();
+        return parser.getAST();
+    }
+
+#ifdef __linux__
+    // 把进程的峰值常驻内存重置为当前值（Linux 4.0起支持），失败时峰值包含之前的所有阶段
+    void resetPeakResident() {
+        std::ofstream file("/proc/self/clear_refs");
+        file << "5";
+    }
+
+    long long peakResidentBytes() {
+        std::ifstream file("/proc/self/status");
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.rfind("VmHWM:", 0) == 0) {
+                return std::atoll(line.c_str() + 6) * 1024;
+            }
+        }
+        return -1;
+    }
+#else
+    void resetPeakResident() {
+    }
+
+    long long peakResidentBytes() {
+        return -1;
+    }
+#endif
+
+    double perSecond(double amount, double seconds) {
+        return seconds > 0 ? amount / seconds : 0.0;
+    }
+}
+
+void runWorkloadBenchmark(const WorkloadOptions& options, size_t iterations, bool useLalr, std::ostream& os) {
+    std::string source = generateWorkload(options);
+    size_t lines = 0;
+    for (char c : source) {
+        lines += c == '\n' ? 1 : 0;
+    }
+
+    // 峰值内存只包含一次完整的词法和语法分析，AST也计入
+    resetPeakResident();
+    DiagnosticEngine diagnostics;
+    Lexer lexer(source, diagnostics);
+    newVector<Token> tokens = lexer.lex();
+    ASTNode* ast = parseTokens(tokens, diagnostics, useLalr);
+    long long peakResident = peakResidentBytes();
+    bool valid = !diagnostics.hasErrors();
+    size_t nodes = countNodes(ast);
+    delete ast;
+
+    Timing lexing = measure(iterations, [&source] {
+        DiagnosticEngine runDiagnostics;
+        Lexer runLexer(source, runDiagnostics);
+        newVector<Token> runTokens = runLexer.lex();
+    });
+    Timing parsing = measure(iterations, [&tokens, useLalr] {
+        DiagnosticEngine runDiagnostics;
+        delete parseTokens(tokens, runDiagnostics, useLalr);
+    });
+
+    double tokenCount = static_cast<double>(tokens.size());
+    double perToken = tokenCount > 0 ? 1.0 / tokenCount : 0.0;
+    os << std::fixed << std::setprecision(6);
+    os << "{\n";
+    os << "  \"workload\": {\"seed\": " << options.seed << ", \"targetBytes\": " << options.targetBytes
+        << ", \"maxDepth\": " << options.maxDepth << ", \"expressionLength\": " << options.expressionLength
+        << ", \"commentDensity\": " << options.commentDensity << ", \"identifiers\": " << options.identifiers << "},\n";
+    os << "  \"backend\": \"" << (useLalr ? "lalr" : "rd") << "\",\n";
+    os << "  \"iterations\": " << iterations << ",\n";
+    os << "  \"valid\": " << (valid ? "true" : "false") << ",\n";
+    os << "  \"bytes\": " << source.size() << ",\n";
+    os << "  \"lines\": " << lines << ",\n";
+    os << "  \"tokens\": " << tokens.size() << ",\n";
+    os << "  \"nodes\": " << nodes << ",\n";
+    os << "  \"lexer\": {\"secondsPerRun\": " << lexing.secondsPerRun
+        << ", \"megabytesPerSecond\": " << perSecond(static_cast<double>(source.size()) / 1e6, lexing.secondsPerRun)
+        << ", \"tokensPerSecond\": " << perSecond(tokenCount, lexing.secondsPerRun)
+        << ", \"allocationsPerToken\": " << static_cast<double>(lexing.allocations) * perToken << "},\n";
+    os << "  \"parser\": {\"secondsPerRun\": " << parsing.secondsPerRun
+        << ", \"nodesPerSecond\": " << perSecond(static_cast<double>(nodes), parsing.secondsPerRun)
+        << ", \"tokensPerSecond\": " << perSecond(tokenCount, parsing.secondsPerRun)
+        << ", \"allocationsPerToken\": " << static_cast<double>(parsing.allocations) * perToken << "},\n";
+    os << "  \"peakResidentBytes\": ";
+    if (peakResident < 0) {
+        os << "null";
+    }
+    else {
+        os << peakResident;
+    }
+    os << "\n}\n";
+}
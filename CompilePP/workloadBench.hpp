@@ -0,0 +1,10 @@
+#pragma once
+#include <cstddef>
+#include <iostream>
+#include "workloadGenerator.hpp"
+
+// 合成负载的吞吐量基准：按options生成程序，词法分析和语法分析各执行iterations次，
+// 以JSON输出负载的参数和规模、词法分析的MB/秒和Token/秒、语法分析的节点/秒和Token/秒、
+// 每个Token的内存分配次数和分析期间的峰值常驻内存，便于保存下来比较不同版本。
+// 峰值常驻内存只在Linux上测量，其他平台为null
+void runWorkloadBenchmark(const WorkloadOptions& options, size_t iterations, bool useLalr, std::ostream& os);
@@ -0,0 +1,227 @@
+#include <unordered_set>
+#include <vector>
+#include "workloadGenerator.hpp"
+
+namespace {
+    class WorkloadWriter {
+    public:
+        explicit WorkloadWriter(const WorkloadOptions& options) : options_(options), state_(options.seed), functions_(0), locals_(0) {}
+
+        std::string generate() {
+            size_t globals = options_.identifiers == 0 ? 1 : options_.identifiers;
+            std::unordered_set<std::string> used;
+            for (size_t i = 0; i < globals; i++) {
+                std::string name = identifier();
+                if (!used.insert(name).second) {
+                    name += std::to_string(i);
+                    used.insert(name);
+                }
+                globals_.push_back(name);
+                text_ += "int " + name + " = " + std::to_string(below(1000)) + ";\n";
+            }
+            do {
+                function();
+            } while (text_.size() < options_.targetBytes);
+            text_ += "int main() {\n    return f" + std::to_string(functions_ - 1) + "(1, 2);\n}\n";
+            return std::move(text_);
+        }
+
+    private:
+        const WorkloadOptions& options_;
+        uint64_t state_;
+        std::string text_;
+        std::vector<std::string> globals_;
+        std::vector<std::string> scope_;   // 当前可见的参数和局部变量
+        size_t functions_;
+        size_t locals_;    // 当前函数中已声明的局部变量个数，用于命名
+
+        // splitmix64：输出只由种子决定，不依赖标准库的分布实现
+        uint64_t next() {
+            uint64_t z = (state_ += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+        size_t below(size_t bound) {
+            return bound == 0 ? 0 : static_cast<size_t>(next() % bound);
+        }
+        bool chance(double probability) {
+            return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0) < probability;
+        }
+
+        // 两到四个辅音加元音的音节，不会与关键字和生成的fN、tN等名字冲突
+        std::string identifier() {
+            static const char consonants[] = "bcdfghjklmnpqrstvxz";
+            static const char vowels[] = "aeiou";
+            std::string name;
+            size_t syllables = 2 + below(3);
+            for (size_t i = 0; i < syllables; i++) {
+                name.push_back(consonants[below(sizeof(consonants) - 1)]);
+                name.push_back(vowels[below(sizeof(vowels) - 1)]);
+            }
+            return name;
+        }
+
+        const std::string& variable() {
+            if (!scope_.empty() && chance(0.5)) {
+                return scope_[below(scope_.size())];
+            }
+            return globals_[below(globals_.size())];
+        }
+
+        void indent(size_t depth) {
+            text_.append(depth * 4, ' ');
+        }
+
+        void comment(size_t depth) {
+            static const char* const words[] = { "update", "the", "running", "total", "check", "bounds", "before", "loop",
+                "index", "value", "keep", "state", "for", "next", "pass", "result" };
+            indent(depth);
+            text_ += "//";
+            size_t count = 2 + below(6);
+            for (size_t i = 0; i < count; i++) {
+                text_.push_back(' ');
+                text_ += words[below(sizeof(words) / sizeof(words[0]))];
+            }
+            text_.push_back('\n');
+        }
+
+        void leaf(size_t budget) {
+            size_t kind = below(10);
+            if (kind < 2) {
+                text_ += std::to_string(below(100));
+            }
+            else if (kind == 2 && functions_ != 0 && budget != 0) {
+                // 只调用已经定义的函数，实参表达式不计入运算符个数
+                text_ += "f" + std::to_string(below(functions_)) + "(";
+                expression(below(2));
+                text_ += ", ";
+                expression(below(2));
+                text_.push_back(')');
+            }
+            else if (kind == 3) {
+                text_ += chance(0.5) ? "-" : "!";
+                text_ += variable();
+            }
+            else {
+                text_ += variable();
+            }
+        }
+
+        // 恰好operators个二元运算符；除数和模数都是非0常量
+        void expression(size_t operators) {
+            static const char* const binary[] = { " + ", " - ", " * ", " & ", " | ", " ^ ", " << ", " >> ",
+                " < ", " > ", " <= ", " >= ", " == ", " != ", " && ", " || " };
+            if (operators == 0) {
+                leaf(1);
+                return;
+            }
+            size_t left = below(operators);
+            bool parenthesized = chance(0.3);
+            if (parenthesized) {
+                text_.push_back('(');
+            }
+            expression(left);
+            if (left + 1 == operators && chance(0.15)) {
+                text_ += chance(0.5) ? " / " : " % ";
+                text_ += std::to_string(1 + below(9));
+            }
+            else {
+                text_ += binary[below(sizeof(binary) / sizeof(binary[0]))];
+                expression(operators - 1 - left);
+            }
+            if (parenthesized) {
+                text_.push_back(')');
+            }
+        }
+
+        void expressionStatement() {
+            expression(below(options_.expressionLength * 2 + 1));
+        }
+
+        void block(size_t depth) {
+            size_t visible = scope_.size();
+            size_t count = 1 + below(4);
+            for (size_t i = 0; i < count; i++) {
+                statement(depth);
+            }
+            scope_.resize(visible);
+        }
+
+        void statement(size_t depth) {
+            size_t kind = below(depth < options_.maxDepth ? 8 : 4);
+            indent(depth);
+            if (kind == 0) {
+                std::string name = "t" + std::to_string(locals_++);
+                text_ += "int " + name + " = ";
+                expressionStatement();
+                text_ += ";\n";
+                scope_.push_back(name);
+            }
+            else if (kind < 4) {
+                static const char* const assignments[] = { " = ", " += ", " -= ", " *= " };
+                text_ += variable();
+                text_ += assignments[below(sizeof(assignments) / sizeof(assignments[0]))];
+                expressionStatement();
+                text_ += ";\n";
+            }
+            else if (kind < 6) {
+                text_ += "if (";
+                expressionStatement();
+                text_ += ") {\n";
+                block(depth + 1);
+                indent(depth);
+                if (chance(0.5)) {
+                    text_ += "}\n";
+                }
+                else {
+                    text_ += "} else {\n";
+                    block(depth + 1);
+                    indent(depth);
+                    text_ += "}\n";
+                }
+            }
+            else if (kind == 6) {
+                const std::string name = variable();
+                text_ += "while (" + name + " < " + std::to_string(below(1000)) + ") {\n";
+                indent(depth + 1);
+                text_ += name + " = " + name + " + 1;\n";
+                block(depth + 1);
+                indent(depth);
+                text_ += "}\n";
+            }
+            else {
+                std::string name = "i" + std::to_string(locals_++);
+                text_ += "for (int " + name + " = 0; " + name + " < " + std::to_string(1 + below(16)) + "; " + name + "++) {\n";
+                scope_.push_back(name);
+                block(depth + 1);
+                scope_.pop_back();
+                indent(depth);
+                text_ += "}\n";
+            }
+            if (chance(options_.commentDensity)) {
+                comment(depth);
+            }
+        }
+
+        void function() {
+            scope_ = { "a", "b" };
+            locals_ = 0;
+            text_ += "int f" + std::to_string(functions_) + "(int a, int b) {\n";
+            size_t count = 3 + below(6);
+            for (size_t i = 0; i < count; i++) {
+                statement(1);
+            }
+            indent(1);
+            text_ += "return ";
+            expressionStatement();
+            text_ += ";\n}\n";
+            functions_++;
+        }
+    };
+}
+
+std::string generateWorkload(const WorkloadOptions& options) {
+    WorkloadWriter writer(options);
+    return writer.generate();
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 合成负载的形状，对应--workload-*参数
+struct WorkloadOptions {
+    uint64_t seed = 1;
+    size_t targetBytes = 1 << 20;   // 生成到源码达到这个长度为止，最后一个函数写完整
+    size_t maxDepth = 3;            // if/while/for语句块的最大嵌套深度
+    size_t expressionLength = 4;    // 每个表达式平均的二元运算符个数
+    double commentDensity = 0.1;    // 每条语句之后跟一行//注释的概率
+    size_t identifiers = 64;        // 全局变量的个数，即表达式中标识符的多样性
+};
+
+// 按options生成一个递归下降Parser接受的C程序，同一组options总是生成同一个程序（与平台和标准库实现无关）。
+// 程序只使用int：先声明全局变量，再定义若干函数，每个函数只调用在它之前定义的函数，最后是main。
+// 程序能通过名字解析、类型检查和IR构造，供后续阶段的基准使用；移位位数和循环次数是随机的，不保证能正常执行
+std::string generateWorkload(const WorkloadOptions& options);
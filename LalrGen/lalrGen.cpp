@@ -0,0 +1,488 @@
+// LALR(1) 语法分析表生成器
+// 读取 CompilePP/lalrGrammar.def 中的文法，构造LALR(1)自动机，
+// 把ACTION/GOTO表按行位移法（row displacement）压缩后输出为C++常量数组
+//
+// 用法：LalrGen [输出文件]，默认输出到 ../CompilePP/lalrTables.inc
+// 修改文法后需要重新运行本工具并提交生成的表
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+    struct GrammarRule {
+        std::string lhs;
+        std::string rhs;
+    };
+
+    const char* const terminalNames[] = {
+#define LALR_TERMINAL(name) #name,
+#include "../CompilePP/lalrGrammar.def"
+#undef LALR_TERMINAL
+    };
+
+    const GrammarRule grammarRules[] = {
+#define LALR_RULE(lhs, rhs, action, nodeType) { #lhs, rhs },
+#include "../CompilePP/lalrGrammar.def"
+#undef LALR_RULE
+    };
+
+    // 终结符不超过64个，向前看符号集合用一个64位掩码表示
+    typedef uint64_t TerminalSet;
+
+    struct Rule {
+        int lhs;
+        std::vector<int> rhs;
+    };
+
+    // LR项目：产生式编号和点的位置
+    struct Item {
+        int rule;
+        int dot;
+        bool operator<(const Item& other) const {
+            return rule != other.rule ? rule < other.rule : dot < other.dot;
+        }
+        bool operator==(const Item& other) const {
+            return rule == other.rule && dot == other.dot;
+        }
+    };
+
+    struct State {
+        std::vector<Item> kernel;              // 核心项目，有序
+        std::vector<TerminalSet> lookaheads;   // 与kernel一一对应
+        std::map<int, int> transitions;        // 符号 -> 目标状态
+    };
+
+    class Generator {
+    public:
+        bool build();
+        void write(std::ostream& os) const;
+
+    private:
+        std::vector<std::string> symbols_;     // 先是终结符，再是非终结符，最后是增广开始符号
+        std::map<std::string, int> symbolIds_;
+        int terminalCount_ = 0;
+        std::vector<Rule> rules_;              // 0号是增广产生式
+        std::vector<bool> nullable_;
+        std::vector<TerminalSet> first_;
+        std::vector<State> states_;
+        std::vector<std::vector<int>> actions_;  // 0错误，>0移进到(值-1)，<0归约产生式(-值-1)
+        int srConflicts_ = 0;
+        int rrConflicts_ = 0;
+
+        // 压缩后的表
+        std::vector<int> actionBase_, actionDefault_, actionCheck_, actionValue_;
+        std::vector<int> gotoBase_, gotoDefault_, gotoCheck_, gotoValue_;
+
+        bool isTerminal(int symbol) const {
+            return symbol < terminalCount_;
+        }
+        int nonterminalIndex(int symbol) const {
+            return symbol - terminalCount_;
+        }
+        bool loadGrammar();
+        void computeFirst();
+        std::map<Item, TerminalSet> closure(const State& state) const;
+        void buildAutomaton();
+        void buildActions();
+        void compress();
+    };
+
+    bool Generator::loadGrammar() {
+        for (const char* name : terminalNames) {
+            symbolIds_[name] = static_cast<int>(symbols_.size());
+            symbols_.push_back(name);
+        }
+        terminalCount_ = static_cast<int>(symbols_.size());
+        if (terminalCount_ > 64) {
+            std::cerr << "too many terminals: " << terminalCount_ << "\n";
+            return false;
+        }
+        // 非终结符按第一次作为左部出现的顺序编号
+        for (const GrammarRule& rule : grammarRules) {
+            if (symbolIds_.find(rule.lhs) == symbolIds_.end()) {
+                symbolIds_[rule.lhs] = static_cast<int>(symbols_.size());
+                symbols_.push_back(rule.lhs);
+            }
+        }
+        int start = symbolIds_[grammarRules[0].lhs];
+        int augmented = static_cast<int>(symbols_.size());
+        symbols_.push_back("$accept");
+        rules_.push_back({ augmented, { start } });
+
+        for (const GrammarRule& rule : grammarRules) {
+            Rule parsed{ symbolIds_[rule.lhs], {} };
+            std::istringstream rhs(rule.rhs);
+            std::string name;
+            while (rhs >> name) {
+                auto it = symbolIds_.find(name);
+                if (it == symbolIds_.end()) {
+                    std::cerr << "undefined symbol '" << name << "' in rule for " << rule.lhs << "\n";
+                    return false;
+                }
+                parsed.rhs.push_back(it->second);
+            }
+            rules_.push_back(parsed);
+        }
+        return true;
+    }
+
+    void Generator::computeFirst() {
+        nullable_.assign(symbols_.size(), false);
+        first_.assign(symbols_.size(), 0);
+        for (int t = 0; t < terminalCount_; t++) {
+            first_[t] = TerminalSet(1) << t;
+        }
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (const Rule& rule : rules_) {
+                TerminalSet first = first_[rule.lhs];
+                bool nullable = true;
+                for (int symbol : rule.rhs) {
+                    first |= first_[symbol];
+                    if (!nullable_[symbol]) {
+                        nullable = false;
+                        break;
+                    }
+                }
+                if (first != first_[rule.lhs] || (nullable && !nullable_[rule.lhs])) {
+                    first_[rule.lhs] = first;
+                    nullable_[rule.lhs] = nullable_[rule.lhs] || nullable;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    // 带向前看符号的闭包
+    std::map<Item, TerminalSet> Generator::closure(const State& state) const {
+        std::map<Item, TerminalSet> items;
+        std::vector<Item> work;
+        for (size_t i = 0; i < state.kernel.size(); i++) {
+            items[state.kernel[i]] = state.lookaheads[i];
+            work.push_back(state.kernel[i]);
+        }
+        while (!work.empty()) {
+            Item item = work.back();
+            work.pop_back();
+            const Rule& rule = rules_[item.rule];
+            if (item.dot >= static_cast<int>(rule.rhs.size()) || isTerminal(rule.rhs[item.dot])) {
+                continue;
+            }
+            // A -> α . B β, L  ==>  B -> . γ, FIRST(β L)
+            TerminalSet lookahead = 0;
+            bool restNullable = true;
+            for (size_t i = item.dot + 1; i < rule.rhs.size(); i++) {
+                lookahead |= first_[rule.rhs[i]];
+                if (!nullable_[rule.rhs[i]]) {
+                    restNullable = false;
+                    break;
+                }
+            }
+            if (restNullable) {
+                lookahead |= items[item];
+            }
+            int target = rule.rhs[item.dot];
+            for (int r = 0; r < static_cast<int>(rules_.size()); r++) {
+                if (rules_[r].lhs != target) {
+                    continue;
+                }
+                Item next{ r, 0 };
+                auto it = items.find(next);
+                if (it == items.end()) {
+                    items[next] = lookahead;
+                    work.push_back(next);
+                }
+                else if ((it->second | lookahead) != it->second) {
+                    it->second |= lookahead;
+                    work.push_back(next);
+                }
+            }
+        }
+        return items;
+    }
+
+    // 构造LR(1)项目集时按核心合并，合并使向前看符号增加的状态重新处理，直到不动点，得到LALR(1)自动机
+    void Generator::buildAutomaton() {
+        std::map<std::vector<Item>, int> stateIds;
+        State start;
+        start.kernel.push_back({ 0, 0 });
+        start.lookaheads.push_back(TerminalSet(1) << symbolIds_.at("EndOfFile"));
+        states_.push_back(start);
+        stateIds[start.kernel] = 0;
+
+        std::vector<int> work = { 0 };
+        std::vector<bool> queued = { true };
+        while (!work.empty()) {
+            int current = work.back();
+            work.pop_back();
+            queued[current] = false;
+
+            std::map<Item, TerminalSet> items = closure(states_[current]);
+            // 按点后面的符号分组得到后继状态的核心
+            std::map<int, std::map<Item, TerminalSet>> successors;
+            for (const auto& entry : items) {
+                const Rule& rule = rules_[entry.first.rule];
+                if (entry.first.dot < static_cast<int>(rule.rhs.size())) {
+                    successors[rule.rhs[entry.first.dot]][{ entry.first.rule, entry.first.dot + 1 }] |= entry.second;
+                }
+            }
+            for (const auto& successor : successors) {
+                std::vector<Item> kernel;
+                std::vector<TerminalSet> lookaheads;
+                for (const auto& entry : successor.second) {
+                    kernel.push_back(entry.first);
+                    lookaheads.push_back(entry.second);
+                }
+                auto it = stateIds.find(kernel);
+                int target;
+                if (it == stateIds.end()) {
+                    target = static_cast<int>(states_.size());
+                    stateIds[kernel] = target;
+                    states_.push_back({ kernel, lookaheads, {} });
+                    queued.push_back(true);
+                    work.push_back(target);
+                }
+                else {
+                    target = it->second;
+                    bool grown = false;
+                    for (size_t i = 0; i < kernel.size(); i++) {
+                        TerminalSet merged = states_[target].lookaheads[i] | lookaheads[i];
+                        if (merged != states_[target].lookaheads[i]) {
+                            states_[target].lookaheads[i] = merged;
+                            grown = true;
+                        }
+                    }
+                    if (grown && !queued[target]) {
+                        queued[target] = true;
+                        work.push_back(target);
+                    }
+                }
+                states_[current].transitions[successor.first] = target;
+            }
+        }
+    }
+
+    void Generator::buildActions() {
+        actions_.assign(states_.size(), std::vector<int>(terminalCount_, 0));
+        for (size_t s = 0; s < states_.size(); s++) {
+            std::vector<int>& row = actions_[s];
+            for (const auto& transition : states_[s].transitions) {
+                if (isTerminal(transition.first)) {
+                    row[transition.first] = transition.second + 1;
+                }
+            }
+            std::map<Item, TerminalSet> items = closure(states_[s]);
+            for (const auto& entry : items) {
+                const Rule& rule = rules_[entry.first.rule];
+                if (entry.first.dot != static_cast<int>(rule.rhs.size())) {
+                    continue;
+                }
+                for (int t = 0; t < terminalCount_; t++) {
+                    if (!(entry.second & (TerminalSet(1) << t))) {
+                        continue;
+                    }
+                    int reduce = -(entry.first.rule + 1);
+                    if (row[t] == 0) {
+                        row[t] = reduce;
+                    }
+                    else if (row[t] > 0) {
+                        // 移进/归约冲突：选择移进，与递归下降的贪心匹配一致
+                        srConflicts_++;
+                        std::cerr << "state " << s << ": shift/reduce conflict on " << symbols_[t]
+                            << ", reducing by " << symbols_[rule.lhs] << " resolved as shift\n";
+                    }
+                    else if (row[t] != reduce) {
+                        // 归约/归约冲突说明文法有歧义，保留编号较小的产生式并报错
+                        rrConflicts_++;
+                        std::cerr << "state " << s << ": reduce/reduce conflict on " << symbols_[t] << "\n";
+                        row[t] = std::max(row[t], reduce);
+                    }
+                }
+            }
+        }
+    }
+
+    // 行位移压缩：为每一行找一个起始位置，使它的非默认项落在公共数组的空位上
+    // check数组记录每个位置属于哪一行，查表时check不匹配就使用该行的默认动作
+    void packRows(const std::vector<std::vector<std::pair<int, int>>>& rows, int width,
+                  std::vector<int>& base, std::vector<int>& check, std::vector<int>& value) {
+        std::vector<size_t> order(rows.size());
+        for (size_t i = 0; i < order.size(); i++) {
+            order[i] = i;
+        }
+        // 先放项目多的行，稀疏的行更容易塞进空隙
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return rows[a].size() > rows[b].size();
+        });
+        base.assign(rows.size(), 0);
+        check.clear();
+        value.clear();
+        for (size_t index : order) {
+            const auto& row = rows[index];
+            int offset = 0;
+            while (true) {
+                bool fits = true;
+                for (const auto& entry : row) {
+                    size_t slot = static_cast<size_t>(offset + entry.first);
+                    if (slot < check.size() && check[slot] != -1) {
+                        fits = false;
+                        break;
+                    }
+                }
+                if (fits) {
+                    break;
+                }
+                offset++;
+            }
+            base[index] = offset;
+            for (const auto& entry : row) {
+                size_t slot = static_cast<size_t>(offset + entry.first);
+                if (slot >= check.size()) {
+                    check.resize(slot + 1, -1);
+                    value.resize(slot + 1, 0);
+                }
+                check[slot] = static_cast<int>(index);
+                value[slot] = entry.second;
+            }
+        }
+        // 末尾补齐一整行，查表时不需要做越界检查
+        check.resize(check.size() + width, -1);
+        value.resize(value.size() + width, 0);
+    }
+
+    void Generator::compress() {
+        // ACTION表：每个状态最常见的归约作为默认动作（没有归约时默认是错误）
+        // 默认归约可能在错误的Token上多做几次归约，但错误一定会在移进该Token之前被发现
+        std::vector<std::vector<std::pair<int, int>>> actionRows(states_.size());
+        actionDefault_.assign(states_.size(), 0);
+        for (size_t s = 0; s < states_.size(); s++) {
+            std::map<int, int> reduceCounts;
+            for (int t = 0; t < terminalCount_; t++) {
+                // 接受动作只在EOF上发生，不能作为默认动作，否则会提前接受
+                if (actions_[s][t] < -1) {
+                    reduceCounts[actions_[s][t]]++;
+                }
+            }
+            int best = 0;
+            int bestCount = 0;
+            for (const auto& entry : reduceCounts) {
+                if (entry.second > bestCount) {
+                    best = entry.first;
+                    bestCount = entry.second;
+                }
+            }
+            actionDefault_[s] = best;
+            for (int t = 0; t < terminalCount_; t++) {
+                if (actions_[s][t] != 0 && actions_[s][t] != best) {
+                    actionRows[s].push_back({ t, actions_[s][t] });
+                }
+            }
+        }
+        packRows(actionRows, terminalCount_, actionBase_, actionCheck_, actionValue_);
+
+        // GOTO表按非终结符分列压缩，每列最常见的目标状态作为默认值
+        int nonterminalCount = static_cast<int>(symbols_.size()) - terminalCount_;
+        std::vector<std::vector<std::pair<int, int>>> gotoColumns(nonterminalCount);
+        gotoDefault_.assign(nonterminalCount, 0);
+        for (int n = 0; n < nonterminalCount; n++) {
+            std::map<int, int> targetCounts;
+            std::vector<std::pair<int, int>> entries;
+            for (size_t s = 0; s < states_.size(); s++) {
+                auto it = states_[s].transitions.find(n + terminalCount_);
+                if (it != states_[s].transitions.end()) {
+                    targetCounts[it->second]++;
+                    entries.push_back({ static_cast<int>(s), it->second });
+                }
+            }
+            int best = 0;
+            int bestCount = 0;
+            for (const auto& entry : targetCounts) {
+                if (entry.second > bestCount) {
+                    best = entry.first;
+                    bestCount = entry.second;
+                }
+            }
+            gotoDefault_[n] = best;
+            for (const auto& entry : entries) {
+                if (entry.second != best) {
+                    gotoColumns[n].push_back(entry);
+                }
+            }
+        }
+        packRows(gotoColumns, static_cast<int>(states_.size()), gotoBase_, gotoCheck_, gotoValue_);
+    }
+
+    bool Generator::build() {
+        if (!loadGrammar()) {
+            return false;
+        }
+        computeFirst();
+        buildAutomaton();
+        buildActions();
+        if (rrConflicts_ != 0) {
+            std::cerr << rrConflicts_ << " reduce/reduce conflict(s), grammar is not LALR(1)\n";
+            return false;
+        }
+        compress();
+        return true;
+    }
+
+    void writeArray(std::ostream& os, const char* type, const char* name, const std::vector<int>& values) {
+        os << "static const " << type << " " << name << "[" << values.size() << "] = {";
+        for (size_t i = 0; i < values.size(); i++) {
+            os << (i % 16 == 0 ? "\n    " : " ") << values[i] << ",";
+        }
+        os << "\n};\n\n";
+    }
+
+    void Generator::write(std::ostream& os) const {
+        os << "// 由 LalrGen 根据 lalrGrammar.def 生成，不要手工修改\n";
+        os << "// " << states_.size() << " 个状态，" << rules_.size() << " 条产生式，"
+            << srConflicts_ << " 个移进/归约冲突（按移进处理）\n\n";
+        os << "static const int lalrTerminalCount = " << terminalCount_ << ";\n";
+        os << "static const int lalrStateCount = " << states_.size() << ";\n";
+        os << "static const int lalrRuleCount = " << rules_.size() << ";\n\n";
+
+        std::vector<int> ruleLhs, ruleLength;
+        for (const Rule& rule : rules_) {
+            ruleLhs.push_back(nonterminalIndex(rule.lhs));
+            ruleLength.push_back(static_cast<int>(rule.rhs.size()));
+        }
+        writeArray(os, "unsigned char", "lalrRuleLhs", ruleLhs);
+        writeArray(os, "unsigned char", "lalrRuleLength", ruleLength);
+        os << "// ACTION：0错误，>0移进到状态(值-1)，<0按产生式(-值-1)归约，按0号产生式归约即接受\n";
+        os << "// 行位移压缩：slot = base[行] + 列，check[slot]等于行号时取value[slot]，否则取该行的默认值\n";
+        writeArray(os, "short", "lalrActionBase", actionBase_);
+        writeArray(os, "short", "lalrActionDefault", actionDefault_);
+        writeArray(os, "short", "lalrActionCheck", actionCheck_);
+        writeArray(os, "short", "lalrActionValue", actionValue_);
+        os << "// GOTO：行是非终结符，列是状态，值为目标状态\n";
+        writeArray(os, "short", "lalrGotoBase", gotoBase_);
+        writeArray(os, "short", "lalrGotoDefault", gotoDefault_);
+        writeArray(os, "short", "lalrGotoCheck", gotoCheck_);
+        writeArray(os, "short", "lalrGotoValue", gotoValue_);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string output = argc > 1 ? argv[1] : "../CompilePP/lalrTables.inc";
+
+    Generator generator;
+    if (!generator.build()) {
+        return 1;
+    }
+    std::ofstream file(output, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open output file: " << output << "\n";
+        return 1;
+    }
+    generator.write(file);
+    std::cout << "Tables written to " << output << "\n";
+    return 0;
+}